@@ -1,6 +1,6 @@
 
 import os, sys
-from pyew_core import CPyew
+from pyew_core import CPyew, Cfg
 
 sys.path.append("plugins")
 
@@ -22,11 +22,22 @@ sys.path.append("plugins")
 filename = sys.argv[1]
 
 pyew = CPyew(batch=True)
+
+# The native recovery is much faster than pyew's own code analysis, skip
+# the latter when diStorm ships the former.
+if Cfg is not None:
+	pyew.codeanalysis = False
+
 pyew.loadFile(filename, "rb")
 pyew.offset = 0
 
 #pyew.pe.header
 
-for addr in pyew.basic_blocks.keys():
-	print addr
+blocks = pyew.findNativeBasicBlocks()
+if blocks is not None:
+	for block in blocks:
+		print block[0]
+else:
+	for addr in pyew.basic_blocks.keys():
+		print addr
 
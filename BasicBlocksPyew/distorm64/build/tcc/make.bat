@@ -1,2 +1,2 @@
 set tccroot=c:\tcc\
-"%tccroot%tcc\tcc.exe" "-I%tccroot%include" "-L%tccroot%lib" ../../src/x86defs.c ../../src/wstring.c ../../src/textdefs.c ../../src/prefix.c ../../src/operands.c ../../src/insts.c ../../src/instructions.c ../../src/distorm.c ../../src/decoder.c ../../linuxproj/main.c -o disasm.exe
+"%tccroot%tcc\tcc.exe" "-I%tccroot%include" "-L%tccroot%lib" ../../src/x86defs.c ../../src/wstring.c ../../src/textdefs.c ../../src/prefix.c ../../src/operands.c ../../src/insts.c ../../src/instructions.c ../../src/lengths.c ../../src/distorm.c ../../src/decoder.c ../../src/cfg.c ../../linuxproj/main.c -o disasm.exe
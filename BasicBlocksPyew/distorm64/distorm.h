@@ -68,6 +68,24 @@ typedef struct {
 	_OffsetType offset; /* Start offset of the decoded instruction. */
 } _DecodedInst;
 
+/* Flow control class of a decomposed instruction, FC_HLT stands for instructions that stop the flow (HLT, UD2). */
+typedef enum {FC_NONE = 0, FC_CALL, FC_RET, FC_SYS, FC_UNC_BRANCH, FC_CND_BRANCH, FC_INT, FC_HLT} _FlowControlType;
+
+/* Kind of a decomposed operand, O_PC is a relative branch target, O_PTR is a far SEG:OFF pointer. */
+typedef enum {O_NONE = 0, O_REG, O_IMM, O_MEM, O_PC, O_PTR} _OperandKindType;
+
+#define MAX_DECOMPOSED_OPERANDS (4)
+
+/* This structure holds the information the decomposer generates per instruction, no text is formatted. */
+typedef struct {
+	const unsigned char* mnemonic; /* Length prefixed mnemonic (first byte is the length, not null terminated), NULL for an undecodable byte. */
+	_OffsetType offset; /* Start offset of the decomposed instruction. */
+	_OffsetType target; /* Branch target of an O_PC operand or the offset of an O_PTR operand. */
+	unsigned int size; /* Size of decomposed instruction, including prefixes. */
+	unsigned char flowControl; /* _FlowControlType */
+	unsigned char ops[MAX_DECOMPOSED_OPERANDS]; /* _OperandKindType of each operand, in the same order as in the text. */
+} _DInst;
+
 /* Return code of the decoding function. */
 typedef enum {DECRES_NONE, DECRES_SUCCESS, DECRES_MEMORYERR, DECRES_INPUTERR} _DecodeResult;
 
@@ -97,6 +115,82 @@ typedef enum {DECRES_NONE, DECRES_SUCCESS, DECRES_MEMORYERR, DECRES_INPUTERR} _D
 	#define distorm_decode distorm_decode32
 #endif
 
+/* distorm_decompose
+ * Input and output are the same as distorm_decode's, except result is an array of _DInst.
+ * Decomposing runs the same decoder, but skips all text formatting, so it's the faster choice
+ * for code flow analysis (the flowControl and target fields) which doesn't need the text.
+ */
+#ifdef SUPPORT_64BIT_OFFSET
+	_DecodeResult distorm_decompose64(_OffsetType codeOffset, const unsigned char* code, int codeLen, _DecodeType dt, _DInst result[], unsigned int maxInstructions, unsigned int* usedInstructionsCount);
+	#define distorm_decompose distorm_decompose64
+#else
+	_DecodeResult distorm_decompose32(_OffsetType codeOffset, const unsigned char* code, int codeLen, _DecodeType dt, _DInst result[], unsigned int maxInstructions, unsigned int* usedInstructionsCount);
+	#define distorm_decompose distorm_decompose32
+#endif
+
+/* distorm_lengths
+ * Input:
+ *         code, codeLen, dt - Same as distorm_decode's.
+ *         sizes - Array which receives the size of every instruction, in the same order as distorm_decompose's entries.
+ *         flows - Array which receives the _FlowControlType of every instruction, or NULL when it's not needed.
+ *         maxInstructions - The maximum number of entries in the sizes and flows arrays.
+ *         usedInstructionsCount - Number of the entries that were written to the arrays.
+ * Return: Same as distorm_decompose's.
+ * Notes:  1)This is a linear sweep which only measures instructions, most of them are measured from tables without running the decoder,
+ *           so it's much faster than decomposing when only the instructions boundaries and their flow control are needed.
+ *         2)There is no minimal size for maxInstructions, since every entry is a single byte, it's enough to pass codeLen entries.
+ */
+_DecodeResult distorm_lengths(const unsigned char* code, int codeLen, _DecodeType dt, unsigned char sizes[], unsigned char flows[], unsigned int maxInstructions, unsigned int* usedInstructionsCount);
+
+/* Block flags. */
+#define CFG_BLOCK_FUNCTION (1) /* The block is the entry of a function (given entry point or a call target). */
+
+/* Kind of an edge between two blocks. */
+typedef enum {CFG_EDGE_FALLTHROUGH = 0, CFG_EDGE_BRANCH, CFG_EDGE_CALL} _CfgEdgeType;
+
+/* A basic block, it ends at any flow control instruction (calls included) or where another block starts. */
+typedef struct {
+	_OffsetType address; /* Offset of the first instruction. */
+	unsigned int size; /* Size of the block in bytes. */
+	unsigned int instructions; /* Number of instructions in the block. */
+	unsigned int flags; /* CFG_BLOCK_* */
+} _CfgBlock;
+
+typedef struct {
+	_OffsetType from; /* Offset of the block the edge leaves. */
+	_OffsetType to; /* Offset of the block the edge enters. */
+	unsigned int type; /* _CfgEdgeType */
+} _CfgEdge;
+
+/* Both arrays are sorted by offset, they are allocated by distorm_cfg and must be released with distorm_cfg_free. */
+typedef struct {
+	_CfgBlock* blocks;
+	unsigned int blocksCount;
+	_CfgEdge* edges;
+	unsigned int edgesCount;
+} _CfgResult;
+
+/* distorm_cfg
+ * Input:
+ *         codeOffset, code, codeLen, dt - Same as distorm_decode's, code should be a whole code section.
+ *         entries - Offsets of the functions to start the analysis from (entry point, exports, etc), others are ignored.
+ *         entriesCount - Number of entries in the entries array.
+ *         threads - Number of threads to analyze the functions with, 0 for a thread per processor.
+ *         result - Receives the blocks and edges which are reachable from the entries, call targets are followed as well.
+ * Return: DECRES_SUCCESS on success, DECRES_INPUTERR on input error, DECRES_MEMORYERR when out of memory.
+ * Notes:  1)Branches which leave the code buffer, indirect branches and far branches have no edges.
+ *         2)Blocks never span a call, so they match the blocks a dynamic tracer (e.g. the bblocks pin tool) records.
+ */
+#ifdef SUPPORT_64BIT_OFFSET
+	_DecodeResult distorm_cfg64(_OffsetType codeOffset, const unsigned char* code, int codeLen, _DecodeType dt, const _OffsetType entries[], unsigned int entriesCount, unsigned int threads, _CfgResult* result);
+	#define distorm_cfg distorm_cfg64
+#else
+	_DecodeResult distorm_cfg32(_OffsetType codeOffset, const unsigned char* code, int codeLen, _DecodeType dt, const _OffsetType entries[], unsigned int entriesCount, unsigned int threads, _CfgResult* result);
+	#define distorm_cfg distorm_cfg32
+#endif
+
+void distorm_cfg_free(_CfgResult* result);
+
 /*
  * distorm_version
  * Input:
@@ -0,0 +1,219 @@
+// diStorm64 decoding benchmark
+// Sweeps whole files with distorm_decode, distorm_decompose and distorm_lengths,
+// checks that the lengths match the decomposed instructions and prints the throughput of each.
+// example:   bench -b32 ../../../3rdParty/DrMemory-Windows-1.4.6-2/bin/release/*.dll
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "../distorm.h"
+
+#define EX_OK           0
+#define EX_USAGE       64
+#define EX_DATAERR     65
+#define EX_NOINPUT     66
+#define EX_OSERR       71
+
+// Entries per call, same as the sample's.
+#define MAX_INSTRUCTIONS (1000)
+
+// Every sweep is repeated for at least this long.
+#define MIN_SECONDS (1.0)
+
+typedef unsigned int (*SweepFunc)(const unsigned char* buf, int len, _DecodeType dt);
+
+static _DecodedInst decodedInstructions[MAX_INSTRUCTIONS];
+static _DInst decomposedInstructions[MAX_INSTRUCTIONS];
+static unsigned char sizes[MAX_INSTRUCTIONS], flows[MAX_INSTRUCTIONS];
+
+// Each sweep returns the number of instructions, the code is synchronized by the last instruction like in the sample.
+static unsigned int sweep_decode(const unsigned char* buf, int len, _DecodeType dt)
+{
+	unsigned int total = 0, count, next;
+	_OffsetType offset = 0;
+
+	while (len > 0) {
+		if (distorm_decode(offset, buf, len, dt, decodedInstructions, MAX_INSTRUCTIONS, &count) == DECRES_INPUTERR) break;
+		if (count == 0) break;
+		total += count;
+
+		next = (unsigned int)(decodedInstructions[count - 1].offset - offset) + decodedInstructions[count - 1].size;
+		buf += next;
+		len -= next;
+		offset += next;
+	}
+
+	return total;
+}
+
+static unsigned int sweep_decompose(const unsigned char* buf, int len, _DecodeType dt)
+{
+	unsigned int total = 0, count, next;
+	_OffsetType offset = 0;
+
+	while (len > 0) {
+		if (distorm_decompose(offset, buf, len, dt, decomposedInstructions, MAX_INSTRUCTIONS, &count) == DECRES_INPUTERR) break;
+		if (count == 0) break;
+		total += count;
+
+		next = (unsigned int)(decomposedInstructions[count - 1].offset - offset) + decomposedInstructions[count - 1].size;
+		buf += next;
+		len -= next;
+		offset += next;
+	}
+
+	return total;
+}
+
+static unsigned int sweep_lengths(const unsigned char* buf, int len, _DecodeType dt)
+{
+	unsigned int total = 0, count, i, next;
+
+	while (len > 0) {
+		if (distorm_lengths(buf, len, dt, sizes, flows, MAX_INSTRUCTIONS, &count) == DECRES_INPUTERR) break;
+		if (count == 0) break;
+		total += count;
+
+		for (i = 0, next = 0; i < count; i++) next += sizes[i];
+		buf += next;
+		len -= next;
+	}
+
+	return total;
+}
+
+// Returns the first instruction whose size or flow control differs, or -1 when both sweeps agree.
+static long verify(const unsigned char* buf, int len, _DecodeType dt)
+{
+	unsigned char *allSizes, *allFlows;
+	unsigned int count, total, i, next;
+	long index = 0, ret = -1;
+	_OffsetType offset = 0;
+
+	// An entry per byte is always enough.
+	allSizes = malloc(len + 1);
+	allFlows = malloc(len + 1);
+	if ((allSizes == NULL) || (allFlows == NULL)) {
+		free(allSizes);
+		return 0;
+	}
+
+	distorm_lengths(buf, len, dt, allSizes, allFlows, len + 1, &total);
+
+	while ((len > 0) && (ret == -1)) {
+		distorm_decompose(offset, buf, len, dt, decomposedInstructions, MAX_INSTRUCTIONS, &count);
+		if (count == 0) break;
+
+		for (i = 0; i < count; i++, index++) {
+			if ((index >= (long)total) || (allSizes[index] != decomposedInstructions[i].size) || (allFlows[index] != decomposedInstructions[i].flowControl)) {
+				ret = index;
+				break;
+			}
+		}
+
+		next = (unsigned int)(decomposedInstructions[count - 1].offset - offset) + decomposedInstructions[count - 1].size;
+		buf += next;
+		len -= next;
+		offset += next;
+	}
+
+	if ((ret == -1) && (index != (long)total)) ret = index;
+
+	free(allSizes);
+	free(allFlows);
+	return ret;
+}
+
+// Returns the throughput in MB/s.
+static double measure(SweepFunc sweep, const unsigned char* buf, int len, _DecodeType dt, unsigned int* count)
+{
+	clock_t start = clock(), now;
+	unsigned int rounds = 0;
+
+	do {
+		*count = sweep(buf, len, dt);
+		rounds++;
+		now = clock();
+	} while ((double)(now - start) / CLOCKS_PER_SEC < MIN_SECONDS);
+
+	return ((double)len * rounds / (1024 * 1024)) / ((double)(now - start) / CLOCKS_PER_SEC);
+}
+
+int main(int argc, char **argv)
+{
+	_DecodeType dt = Decode32Bits;
+	int param = 1, ret = EX_OK;
+	unsigned int count;
+	double decode, decompose, lengths;
+	long bad;
+
+	// Read files.
+	FILE* f;
+	long filesize;
+	unsigned char* buf;
+
+	if (argc > 1) {
+		if (strncmp(argv[1], "-b16", 4) == 0) {
+			dt = Decode16Bits;
+			param++;
+		} else if (strncmp(argv[1], "-b64", 4) == 0) {
+			dt = Decode64Bits;
+			param++;
+		} else if (strncmp(argv[1], "-b32", 4) == 0) {
+			param++;
+		}
+	}
+
+	if (param >= argc) {
+		printf("Usage: ./bench [-b16] [-b32] [-b64] filename...\r\nMeasures decode, decompose and lengths sweeps over whole files.\r\nDefault decoding mode is -b32.\r\n");
+		return EX_USAGE;
+	}
+
+	printf("%-32s %10s %10s %10s %10s %8s\n", "file", "insts", "decode", "decompose", "lengths", "speedup");
+
+	for (; param < argc; param++) {
+		f = fopen(argv[param], "rb");
+		if (f == NULL) {
+			perror(argv[param]);
+			return EX_NOINPUT;
+		}
+
+		fseek(f, 0, SEEK_END);
+		filesize = ftell(f);
+		fseek(f, 0, SEEK_SET);
+
+		buf = malloc(filesize > 0 ? filesize : 1);
+		if (buf == NULL) {
+			perror("malloc");
+			fclose(f);
+			return EX_OSERR;
+		}
+
+		if (fread(buf, 1, filesize, f) != (size_t)filesize) {
+			perror("fread");
+			free(buf);
+			fclose(f);
+			return EX_NOINPUT;
+		}
+		fclose(f);
+
+		bad = verify(buf, (int)filesize, dt);
+		if (bad != -1) {
+			fprintf(stderr, "%s: lengths differ from decompose at instruction %ld!\n", argv[param], bad);
+			ret = EX_DATAERR;
+		}
+
+		decode = measure(sweep_decode, buf, (int)filesize, dt, &count);
+		decompose = measure(sweep_decompose, buf, (int)filesize, dt, &count);
+		lengths = measure(sweep_lengths, buf, (int)filesize, dt, &count);
+
+		// Speedup of lengths over decompose, both are in MB/s.
+		printf("%-32s %10u %8.1fMB %8.1fMB %8.1fMB %7.2fx\n", argv[param], count, decode, decompose, lengths, lengths / decompose);
+
+		free(buf);
+	}
+
+	return ret;
+}
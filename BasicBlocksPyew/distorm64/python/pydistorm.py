@@ -9,7 +9,7 @@ Python binding for diStorm64 written by Victor Stinner
 """
 
 import platform
-from ctypes import cdll, c_long, c_ulong, c_int, c_uint, c_char, c_char_p, POINTER, c_byte, Structure, addressof, byref, c_void_p, create_string_buffer, sizeof, cast
+from ctypes import cdll, c_long, c_ulong, c_int, c_uint, c_char, c_char_p, POINTER, c_byte, c_ubyte, Structure, addressof, byref, c_void_p, create_string_buffer, sizeof, cast, string_at
 
 # Define (u)int32_t and (u)int64_t types
 int32_t = c_int
@@ -50,12 +50,60 @@ if osVer == "Windows":
 else:
     decode_func = distorm.internal_decode
 
+if osVer == "Windows":
+    if SUPPORT_64BIT_OFFSET:
+        decompose_func = distorm.distorm_decompose64
+    else:
+        decompose_func = distorm.distorm_decompose32
+else:
+    decompose_func = distorm.internal_decompose
+
+if osVer == "Windows":
+    lengths_func = distorm.distorm_lengths
+else:
+    lengths_func = distorm.internal_lengths
+
+if osVer == "Windows":
+    if SUPPORT_64BIT_OFFSET:
+        cfg_func = distorm.distorm_cfg64
+    else:
+        cfg_func = distorm.distorm_cfg32
+    cfg_free_func = distorm.distorm_cfg_free
+else:
+    cfg_func = distorm.internal_cfg
+    cfg_free_func = distorm.cfg_free
+
 DECRES_NONE = 0
 DECRES_SUCCESS = 1
 DECRES_MEMORYERR = 2
 DECRES_INPUTERR = 3
 
+# Flow control classes returned by Decompose and Lengths
+FC_NONE = 0
+FC_CALL = 1
+FC_RET = 2
+FC_SYS = 3
+FC_UNC_BRANCH = 4
+FC_CND_BRANCH = 5
+FC_INT = 6
+FC_HLT = 7
+
+# Operand kinds returned by Decompose
+O_NONE = 0
+O_REG = 1
+O_IMM = 2
+O_MEM = 3
+O_PC = 4
+O_PTR = 5
+
+# Block flags and edge types returned by Cfg
+CFG_BLOCK_FUNCTION = 1
+CFG_EDGE_FALLTHROUGH = 0
+CFG_EDGE_BRANCH = 1
+CFG_EDGE_CALL = 2
+
 MAX_INSTRUCTIONS = 100
+MAX_DECOMPOSED_OPERANDS = 4
 MAX_TEXT_SIZE = 60
 
 class _WString(Structure):
@@ -77,7 +125,57 @@ class _DecodedInst(Structure):
     def __str__(self):
         return "%s %s" % (self.mnemonic, self.operands)
 
+class _DInst(Structure):
+    _fields_ = (
+        ("mnemonic", c_void_p), # Length prefixed, NULL for an undecodable byte.
+        ("offset", _OffsetType),
+        ("target", _OffsetType),
+        ("size", c_uint),
+        ("flowControl", c_ubyte),
+        ("ops", c_ubyte * MAX_DECOMPOSED_OPERANDS),
+    )
+
+class _CfgBlock(Structure):
+    _fields_ = (
+        ("address", _OffsetType),
+        ("size", c_uint),
+        ("instructions", c_uint),
+        ("flags", c_uint),
+    )
+
+class _CfgEdge(Structure):
+    _fields_ = (
+        ("from_", _OffsetType),
+        ("to", _OffsetType),
+        ("type", c_uint),
+    )
+
+class _CfgResult(Structure):
+    _fields_ = (
+        ("blocks", POINTER(_CfgBlock)),
+        ("blocksCount", c_uint),
+        ("edges", POINTER(_CfgEdge)),
+        ("edgesCount", c_uint),
+    )
+
 decode_func.argtypes = (_OffsetType, c_void_p, c_int, c_int, c_void_p, c_uint, POINTER(c_uint))
+decompose_func.argtypes = (_OffsetType, c_void_p, c_int, c_int, c_void_p, c_uint, POINTER(c_uint))
+lengths_func.argtypes = (c_char_p, c_int, c_int, c_void_p, c_void_p, c_uint, POINTER(c_uint))
+cfg_func.argtypes = (_OffsetType, c_char_p, c_int, c_int, POINTER(_OffsetType), c_uint, c_uint, POINTER(_CfgResult))
+cfg_free_func.argtypes = (POINTER(_CfgResult),)
+
+# The mnemonics live in the library's instructions DB, read each one once
+_mnemonics = {}
+
+def _mnemonic(address):
+    if not address:
+        return None
+    try:
+        return _mnemonics[address]
+    except KeyError:
+        name = string_at(address + 1, ord(string_at(address, 1)))
+        _mnemonics[address] = name
+        return name
 
 def Decode(codeOffset, code, dt=Decode32Bits):
     """
@@ -127,3 +225,120 @@ def Decode(codeOffset, code, dt=Decode32Bits):
         codeOffset += size
         codeLen -= size
 
+def Decompose(codeOffset, code, dt=Decode32Bits):
+    """
+    Same as Decode, but no text is formatted. Yields tuples of
+    (offset, size, mnemonic, flowControl, (operand kinds), target)
+    where flowControl is one of FC_*, operand kinds are O_* and target
+    is the destination of an O_PC operand (or the offset of an O_PTR one).
+
+    Errors: TypeError, IndexError, MemoryError, ValueError
+    """
+    # Check arguments
+    if not isinstance(codeOffset, (int, long)):
+        raise TypeError("codeOffset have to be an integer")
+    if not isinstance(code, str):
+        raise TypeError("code have to be a string")
+    if dt not in DECODERS:
+        raise IndexError("Decoding-type must be either Decode16Bits, Decode32Bits or Decode64Bits.")
+
+    # Allocate memory for decomposer
+    code_buffer = create_string_buffer(code)
+    decomposedInstructionsCount = c_uint()
+    result = (_DInst * MAX_INSTRUCTIONS)()
+
+    # Prepare arguments
+    codeLen = len(code)
+    code = addressof(code_buffer)
+    while codeLen:
+        # Call internal decomposer
+        res = decompose_func(codeOffset, code, codeLen, dt, result, MAX_INSTRUCTIONS, byref(decomposedInstructionsCount))
+
+        # Check for errors
+        if res == DECRES_INPUTERR:
+            raise ValueError("Invalid argument")
+        count = decomposedInstructionsCount.value
+        if res == DECRES_MEMORYERR and not count:
+            raise MemoryError()
+
+        # No more instruction
+        if not count:
+            break
+
+        # Yield instruction and compute decomposed size
+        for index in xrange(count):
+            instr = result[index]
+            yield (instr.offset, instr.size, _mnemonic(instr.mnemonic), instr.flowControl, tuple(instr.ops), instr.target)
+
+        # Entries are in order, the last one ends the decomposed code
+        size = result[count - 1].offset + result[count - 1].size - codeOffset
+        code += size
+        codeOffset += size
+        codeLen -= size
+
+def Lengths(code, dt=Decode32Bits):
+    """
+    Measure the instructions of a code buffer without decoding them, in the
+    same linear sweep as Decompose. Returns a tuple of two strings (sizes,
+    flows) with a byte per instruction: its size and its FC_* flow control.
+
+    Errors: TypeError, IndexError, MemoryError, ValueError
+    """
+    # Check arguments
+    if not isinstance(code, str):
+        raise TypeError("code have to be a string")
+    if dt not in DECODERS:
+        raise IndexError("Decoding-type must be either Decode16Bits, Decode32Bits or Decode64Bits.")
+
+    # Every instruction takes a byte at least
+    codeLen = len(code)
+    sizes = create_string_buffer(codeLen + 1)
+    flows = create_string_buffer(codeLen + 1)
+    count = c_uint()
+
+    res = lengths_func(code, codeLen, dt, sizes, flows, codeLen + 1, byref(count))
+    if res == DECRES_INPUTERR:
+        raise ValueError("Invalid argument")
+    if res == DECRES_MEMORYERR:
+        raise MemoryError()
+
+    return sizes.raw[:count.value], flows.raw[:count.value]
+
+def Cfg(codeOffset, code, dt, entries, threads=0):
+    """
+    Recover the basic blocks and control flow graph of a code buffer,
+    following the flow from the given function entries (and every call
+    target found on the way). threads=0 uses a thread per processor.
+
+    Returns a tuple of (blocks, edges), both sorted by offset, blocks are
+    tuples of (offset, size, instructions, flags) and edges are tuples of
+    (offset of the block, offset of the target block, type) where flags
+    are CFG_BLOCK_* and type is one of CFG_EDGE_*.
+
+    Errors: TypeError, IndexError, MemoryError, ValueError
+    """
+    # Check arguments
+    if not isinstance(codeOffset, (int, long)):
+        raise TypeError("codeOffset have to be an integer")
+    if not isinstance(code, str):
+        raise TypeError("code have to be a string")
+    if dt not in DECODERS:
+        raise IndexError("Decoding-type must be either Decode16Bits, Decode32Bits or Decode64Bits.")
+
+    entries = list(entries)
+    entries_array = (_OffsetType * (len(entries) + 1))(*entries)
+    result = _CfgResult()
+
+    res = cfg_func(codeOffset, code, len(code), dt, entries_array, len(entries), threads, byref(result))
+    if res == DECRES_INPUTERR:
+        raise ValueError("Invalid argument")
+    if res == DECRES_MEMORYERR:
+        raise MemoryError()
+
+    try:
+        blocks = [(b.address, b.size, b.instructions, b.flags) for b in result.blocks[:result.blocksCount]]
+        edges = [(e.from_, e.to, e.type) for e in result.edges[:result.edgesCount]]
+    finally:
+        cfg_free_func(byref(result))
+
+    return blocks, edges
@@ -0,0 +1,448 @@
+/*
+cfg.c
+
+Copyright (C) 2003-2008 Gil Dabah, http://ragestorm.net/distorm/
+This library is licensed under the BSD license. See the file COPYING.
+*/
+
+
+#include "cfg.h"
+
+#include <stdlib.h> /* malloc, realloc, free. */
+
+#ifdef _WIN32
+	#include <windows.h>
+	typedef CRITICAL_SECTION _CfgLock;
+	typedef HANDLE _CfgThread;
+	#define CFG_LOCK_INIT(l) InitializeCriticalSection(l)
+	#define CFG_LOCK(l) EnterCriticalSection(l)
+	#define CFG_UNLOCK(l) LeaveCriticalSection(l)
+	#define CFG_LOCK_DESTROY(l) DeleteCriticalSection(l)
+#else
+	#include <pthread.h>
+	#include <unistd.h>
+	typedef pthread_mutex_t _CfgLock;
+	typedef pthread_t _CfgThread;
+	#define CFG_LOCK_INIT(l) pthread_mutex_init(l, NULL)
+	#define CFG_LOCK(l) pthread_mutex_lock(l)
+	#define CFG_UNLOCK(l) pthread_mutex_unlock(l)
+	#define CFG_LOCK_DESTROY(l) pthread_mutex_destroy(l)
+#endif
+
+/*
+ * Control flow graph recovery:
+ * Functions are analyzed in rounds, the first round holds the given entry points,
+ * every round after it holds the call targets that were found by the previous one.
+ * The functions of a round are handed out to the worker threads one by one.
+ * Each worker follows the flow of its function with the decomposer and records per byte of the code:
+ * the size and flow control of an instruction which starts there and whether a block starts there.
+ * A path stops once it reaches code which was already analyzed, so every instruction is decomposed once.
+ * When all rounds are done, the blocks are built in a single linear pass over these marks.
+ * A block ends at any flow control instruction (calls included), like the blocks the bblocks pin tool traces.
+ */
+
+/* Entries in the decomposer's result array, per call. */
+#define CFG_DECOMPOSE_ENTRIES (64)
+
+/* Upper limit for the worker threads. */
+#define CFG_MAX_THREADS (64)
+
+#define CFG_INT3 (0xcc)
+
+typedef struct {
+	unsigned int* items;
+	unsigned int count;
+	unsigned int size;
+} _CfgList;
+
+typedef struct {
+	_OffsetType codeOffset;
+	const uint8_t* code;
+	unsigned int codeLen;
+	_DecodeType dt;
+	/* Per byte marks of the code buffer, written by the workers without a lock, a byte is only ever set to a single value. */
+	uint8_t* sizes; /* Size of the instruction which starts at this byte, 0 for none. */
+	uint8_t* flows; /* _FlowControlType of the instruction which starts at this byte. */
+	uint8_t* leaders; /* Set if a block starts at this byte. */
+	/* Guarded by the lock. */
+	uint8_t* functions; /* Set if a function starts at this byte. */
+	_CfgList current; /* Functions of the current round. */
+	unsigned int nextFunction; /* Index in current of the next function to be analyzed. */
+	_CfgList found; /* Functions which were found during the current round. */
+	int failed; /* Out of memory. */
+	_CfgLock lock;
+} _CfgContext;
+
+/* Makes room for one more item in a growing array, returns FALSE when out of memory. */
+static int cfg_grow(void** items, unsigned int* size, unsigned int count, size_t itemSize)
+{
+	unsigned int newSize;
+	void* p;
+
+	if (count < *size) return TRUE;
+
+	newSize = (*size == 0) ? 64 : *size * 2;
+	p = realloc(*items, newSize * itemSize);
+	if (p == NULL) return FALSE;
+
+	*items = p;
+	*size = newSize;
+	return TRUE;
+}
+
+static int list_push(_CfgList* l, unsigned int v)
+{
+	if (!cfg_grow((void**)&l->items, &l->size, l->count, sizeof(unsigned int))) return FALSE;
+	l->items[l->count++] = v;
+	return TRUE;
+}
+
+/* Returns the position in the code buffer of the relative branch target of the instruction, or codeLen if there's none in the buffer. */
+static unsigned int cfg_target(const _CfgContext* ctx, const _DInst* di)
+{
+	int i;
+
+	for (i = 0; i < MAX_DECOMPOSED_OPERANDS; i++) {
+		if (di->ops[i] == O_PC) {
+			if ((di->target < ctx->codeOffset) || (di->target - ctx->codeOffset >= ctx->codeLen)) break;
+			return (unsigned int)(di->target - ctx->codeOffset);
+		}
+	}
+
+	return ctx->codeLen;
+}
+
+static int cfg_add_function(_CfgContext* ctx, unsigned int pos)
+{
+	int ret = TRUE;
+
+	CFG_LOCK(&ctx->lock);
+	if (!ctx->functions[pos]) {
+		ctx->functions[pos] = 1;
+		ret = list_push(&ctx->found, pos);
+	}
+	CFG_UNLOCK(&ctx->lock);
+
+	return ret;
+}
+
+/* Follows all paths of the function, call targets are queued for the next round. */
+static int cfg_function(_CfgContext* ctx, unsigned int entry, _CfgList* work, _DInst di[CFG_DECOMPOSE_ENTRIES])
+{
+	unsigned int pos, next = 0, target, count, i;
+	const _DInst* pdi;
+	int stop;
+
+	work->count = 0;
+	ctx->leaders[entry] = 1;
+	if (!list_push(work, entry)) return FALSE;
+
+	while (work->count > 0) {
+		pos = work->items[--work->count];
+		stop = FALSE;
+
+		while (!stop && (pos < ctx->codeLen) && (ctx->sizes[pos] == 0)) {
+			internal_decompose(ctx->codeOffset + pos, ctx->code + pos, ctx->codeLen - pos, ctx->dt, di, CFG_DECOMPOSE_ENTRIES, &count);
+			if (count == 0) break;
+
+			for (i = 0; i < count; i++) {
+				pdi = &di[i];
+				pos = (unsigned int)(pdi->offset - ctx->codeOffset);
+
+				/* Fell through into code which was already analyzed. */
+				if (ctx->sizes[pos] != 0) {
+					stop = TRUE;
+					break;
+				}
+
+				ctx->flows[pos] = pdi->flowControl;
+				ctx->sizes[pos] = (uint8_t)pdi->size;
+				next = pos + pdi->size;
+
+				switch (pdi->flowControl)
+				{
+					case FC_NONE:
+					break;
+					case FC_CND_BRANCH:
+						target = cfg_target(ctx, pdi);
+						if (target < ctx->codeLen) {
+							ctx->leaders[target] = 1;
+							if (!list_push(work, target)) return FALSE;
+						}
+						if (next < ctx->codeLen) ctx->leaders[next] = 1;
+					break;
+					case FC_UNC_BRANCH:
+						target = cfg_target(ctx, pdi);
+						if (target < ctx->codeLen) {
+							ctx->leaders[target] = 1;
+							if (!list_push(work, target)) return FALSE;
+						}
+						stop = TRUE;
+					break;
+					case FC_CALL:
+						target = cfg_target(ctx, pdi);
+						if ((target < ctx->codeLen) && !cfg_add_function(ctx, target)) return FALSE;
+						if (next < ctx->codeLen) ctx->leaders[next] = 1;
+					break;
+					case FC_INT:
+						/* INT3 is mostly padding between functions. */
+						if ((pdi->size == 1) && (ctx->code[pos] == CFG_INT3)) stop = TRUE;
+						else if (next < ctx->codeLen) ctx->leaders[next] = 1;
+					break;
+					case FC_SYS:
+						if (next < ctx->codeLen) ctx->leaders[next] = 1;
+					break;
+					default: /* FC_RET, FC_HLT. */
+						stop = TRUE;
+					break;
+				}
+
+				if (stop) break;
+			}
+
+			pos = next;
+		}
+	}
+
+	return TRUE;
+}
+
+static void cfg_worker(_CfgContext* ctx)
+{
+	_CfgList work = {0};
+	_DInst di[CFG_DECOMPOSE_ENTRIES];
+	unsigned int entry;
+
+	for (;;) {
+		CFG_LOCK(&ctx->lock);
+		if (ctx->failed || (ctx->nextFunction == ctx->current.count)) {
+			CFG_UNLOCK(&ctx->lock);
+			break;
+		}
+		entry = ctx->current.items[ctx->nextFunction++];
+		CFG_UNLOCK(&ctx->lock);
+
+		if (!cfg_function(ctx, entry, &work, di)) {
+			CFG_LOCK(&ctx->lock);
+			ctx->failed = TRUE;
+			CFG_UNLOCK(&ctx->lock);
+			break;
+		}
+	}
+
+	free(work.items);
+}
+
+#ifdef _WIN32
+static DWORD WINAPI cfg_worker_thread(LPVOID arg)
+{
+	cfg_worker((_CfgContext*)arg);
+	return 0;
+}
+#else
+static void* cfg_worker_thread(void* arg)
+{
+	cfg_worker((_CfgContext*)arg);
+	return NULL;
+}
+#endif
+
+static unsigned int cfg_cpus()
+{
+#ifdef _WIN32
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return si.dwNumberOfProcessors;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return (n > 0) ? (unsigned int)n : 1;
+#endif
+}
+
+/* Analyzes the functions of the current round, the calling thread is one of the workers. */
+static void cfg_round(_CfgContext* ctx, unsigned int threads)
+{
+	_CfgThread handles[CFG_MAX_THREADS];
+	unsigned int i, started = 0;
+
+	if (threads > ctx->current.count) threads = ctx->current.count;
+
+	for (i = 1; i < threads; i++) {
+#ifdef _WIN32
+		handles[started] = CreateThread(NULL, 0, cfg_worker_thread, ctx, 0, NULL);
+		if (handles[started] == NULL) break;
+#else
+		if (pthread_create(&handles[started], NULL, cfg_worker_thread, ctx) != 0) break;
+#endif
+		started++;
+	}
+
+	cfg_worker(ctx);
+
+	for (i = 0; i < started; i++) {
+#ifdef _WIN32
+		WaitForSingleObject(handles[i], INFINITE);
+		CloseHandle(handles[i]);
+#else
+		pthread_join(handles[i], NULL);
+#endif
+	}
+}
+
+static int cfg_add_edge(_CfgResult* result, unsigned int* edgesSize, _OffsetType from, _OffsetType to, unsigned int type)
+{
+	_CfgEdge* pe;
+
+	if (!cfg_grow((void**)&result->edges, edgesSize, result->edgesCount, sizeof(_CfgEdge))) return FALSE;
+
+	pe = &result->edges[result->edgesCount++];
+	pe->from = from;
+	pe->to = to;
+	pe->type = type;
+	return TRUE;
+}
+
+/* Builds the blocks and edges out of the marks the workers left, in address order. */
+static int cfg_build(_CfgContext* ctx, _CfgResult* result)
+{
+	_DInst di[CFG_DECOMPOSE_ENTRIES];
+	_CfgBlock* pb;
+	_OffsetType from;
+	unsigned int start, pos, next, target, count, fc;
+	unsigned int blocksSize = 0, edgesSize = 0;
+	int fallthrough;
+
+	for (start = 0; start < ctx->codeLen; start++) {
+		if (!ctx->leaders[start] || (ctx->sizes[start] == 0)) continue;
+
+		if (!cfg_grow((void**)&result->blocks, &blocksSize, result->blocksCount, sizeof(_CfgBlock))) return FALSE;
+		pb = &result->blocks[result->blocksCount++];
+		pb->address = from = ctx->codeOffset + start;
+		pb->instructions = 0;
+		pb->flags = ctx->functions[start] ? CFG_BLOCK_FUNCTION : 0;
+
+		/* Walk the instructions until a flow control instruction or the start of another block. */
+		for (pos = start; ; pos = next) {
+			pb->instructions++;
+			next = pos + ctx->sizes[pos];
+			if ((ctx->flows[pos] != FC_NONE) || (next >= ctx->codeLen) || (ctx->sizes[next] == 0) || ctx->leaders[next]) break;
+		}
+		pb->size = next - start;
+
+		fc = ctx->flows[pos];
+		fallthrough = (next < ctx->codeLen) && (ctx->sizes[next] != 0);
+
+		if (fc == FC_NONE) {
+			if (fallthrough && !cfg_add_edge(result, &edgesSize, from, ctx->codeOffset + next, CFG_EDGE_FALLTHROUGH)) return FALSE;
+			continue;
+		}
+
+		/* Decompose the last instruction again for its target, only flow control instructions are ever decomposed twice. */
+		target = ctx->codeLen;
+		if ((fc == FC_CND_BRANCH) || (fc == FC_UNC_BRANCH) || (fc == FC_CALL)) {
+			internal_decompose(ctx->codeOffset + pos, ctx->code + pos, ctx->sizes[pos], ctx->dt, di, CFG_DECOMPOSE_ENTRIES, &count);
+			if (count == 1) target = cfg_target(ctx, &di[0]);
+			if ((target < ctx->codeLen) && (ctx->sizes[target] == 0)) target = ctx->codeLen;
+		}
+
+		switch (fc)
+		{
+			case FC_CND_BRANCH:
+				if ((target < ctx->codeLen) && !cfg_add_edge(result, &edgesSize, from, ctx->codeOffset + target, CFG_EDGE_BRANCH)) return FALSE;
+			break;
+			case FC_UNC_BRANCH:
+				if ((target < ctx->codeLen) && !cfg_add_edge(result, &edgesSize, from, ctx->codeOffset + target, CFG_EDGE_BRANCH)) return FALSE;
+				fallthrough = FALSE;
+			break;
+			case FC_CALL:
+				if ((target < ctx->codeLen) && !cfg_add_edge(result, &edgesSize, from, ctx->codeOffset + target, CFG_EDGE_CALL)) return FALSE;
+			break;
+			case FC_INT:
+				if ((ctx->sizes[pos] == 1) && (ctx->code[pos] == CFG_INT3)) fallthrough = FALSE;
+			break;
+			case FC_SYS:
+			break;
+			default: /* FC_RET, FC_HLT. */
+				fallthrough = FALSE;
+			break;
+		}
+
+		if (fallthrough && !cfg_add_edge(result, &edgesSize, from, ctx->codeOffset + next, CFG_EDGE_FALLTHROUGH)) return FALSE;
+	}
+
+	return TRUE;
+}
+
+_DecodeResult internal_cfg(_OffsetType codeOffset, const uint8_t* code, int codeLen, _DecodeType dt, const _OffsetType entries[], unsigned int entriesCount, unsigned int threads, _CfgResult* result)
+{
+	_CfgContext ctx;
+	_CfgList tmp;
+	unsigned int i, pos;
+	uint8_t* marks;
+
+	memset(result, 0, sizeof(_CfgResult));
+	if (codeLen <= 0) return DECRES_SUCCESS;
+
+	/* All four per byte arrays in a single allocation. */
+	marks = (uint8_t*)malloc((size_t)codeLen * 4);
+	if (marks == NULL) return DECRES_MEMORYERR;
+	memset(marks, 0, (size_t)codeLen * 4);
+
+	memset(&ctx, 0, sizeof(_CfgContext));
+	ctx.codeOffset = codeOffset;
+	ctx.code = code;
+	ctx.codeLen = (unsigned int)codeLen;
+	ctx.dt = dt;
+	ctx.sizes = marks;
+	ctx.flows = marks + codeLen;
+	ctx.leaders = marks + codeLen * 2;
+	ctx.functions = marks + codeLen * 3;
+	CFG_LOCK_INIT(&ctx.lock);
+
+	if (threads == 0) threads = cfg_cpus();
+	if (threads > CFG_MAX_THREADS) threads = CFG_MAX_THREADS;
+
+	/* Entry points outside of the code are ignored. */
+	for (i = 0; i < entriesCount; i++) {
+		if ((entries[i] < codeOffset) || (entries[i] - codeOffset >= ctx.codeLen)) continue;
+		pos = (unsigned int)(entries[i] - codeOffset);
+		if (ctx.functions[pos]) continue;
+		ctx.functions[pos] = 1;
+		if (!list_push(&ctx.current, pos)) {
+			ctx.failed = TRUE;
+			break;
+		}
+	}
+
+	while (!ctx.failed && (ctx.current.count > 0)) {
+		ctx.nextFunction = 0;
+		cfg_round(&ctx, threads);
+
+		/* The functions found by this round are the next round. */
+		tmp = ctx.current;
+		ctx.current = ctx.found;
+		ctx.found = tmp;
+		ctx.found.count = 0;
+	}
+
+	if (!ctx.failed && !cfg_build(&ctx, result)) ctx.failed = TRUE;
+
+	CFG_LOCK_DESTROY(&ctx.lock);
+	free(ctx.current.items);
+	free(ctx.found.items);
+	free(marks);
+
+	if (ctx.failed) {
+		cfg_free(result);
+		return DECRES_MEMORYERR;
+	}
+
+	return DECRES_SUCCESS;
+}
+
+void cfg_free(_CfgResult* result)
+{
+	free(result->blocks);
+	free(result->edges);
+	memset(result, 0, sizeof(_CfgResult));
+}
@@ -0,0 +1,47 @@
+/*
+cfg.h
+
+Copyright (C) 2003-2008 Gil Dabah, http://ragestorm.net/distorm/
+This library is licensed under the BSD license. See the file COPYING.
+*/
+
+
+#ifndef CFG_H
+#define CFG_H
+
+#include "../config.h"
+
+#include "decoder.h"
+
+/* Block flags. */
+#define CFG_BLOCK_FUNCTION (1) /* The block is the entry of a function (given entry point or a call target). */
+
+/* Kind of an edge between two blocks. */
+typedef enum {CFG_EDGE_FALLTHROUGH = 0, CFG_EDGE_BRANCH, CFG_EDGE_CALL} _CfgEdgeType;
+
+typedef struct {
+	_OffsetType address;
+	unsigned int size; /* In bytes. */
+	unsigned int instructions;
+	unsigned int flags;
+} _CfgBlock;
+
+/* from is the address of the block the edge leaves, to is the address of the block it enters. */
+typedef struct {
+	_OffsetType from;
+	_OffsetType to;
+	unsigned int type; /* _CfgEdgeType */
+} _CfgEdge;
+
+/* Both arrays are sorted by address and allocated by internal_cfg, release them with cfg_free. */
+typedef struct {
+	_CfgBlock* blocks;
+	unsigned int blocksCount;
+	_CfgEdge* edges;
+	unsigned int edgesCount;
+} _CfgResult;
+
+_DecodeResult internal_cfg(_OffsetType codeOffset, const uint8_t* code, int codeLen, _DecodeType dt, const _OffsetType entries[], unsigned int entriesCount, unsigned int threads, _CfgResult* result);
+void cfg_free(_CfgResult* result);
+
+#endif /* CFG_H */
@@ -65,9 +65,146 @@ _DecodeType OP_SIZE_AFFECT(_DecodeType dt, _iflags totalPrefixes, unsigned int r
 	return dt;
 }
 
+/*
+ * Get the mnemonic in the DB the decoder would use for the instruction, without prefixes and size suffixes.
+ * This follows the same rules decode_inst applies when it formats the mnemonic text.
+ */
+static const int8_t* get_mnemonic(_InstInfo* ii, _DecodeType dt, _iflags totalPrefixes, unsigned int rex, unsigned int modrm)
+{
+	_InstInfoEx* iie = (_InstInfoEx*)ii;
+
+	/* JeCXZ depends on the address size. */
+	if ((ii->flags & (INST_PRE_ADDR_SIZE | INST_USE_EXMNEMONIC)) == (INST_PRE_ADDR_SIZE | INST_USE_EXMNEMONIC)) {
+		if (ADDR_SIZE_AFFECT(dt, totalPrefixes) == Decode16Bits) return ii->mnemonic;
+		else if (ADDR_SIZE_AFFECT(dt, totalPrefixes) == Decode32Bits) return iie->mnemonic2;
+		return iie->mnemonic3;
+	}
+
+	switch (OP_SIZE_AFFECT(dt, totalPrefixes, rex, ii->flags))
+	{
+		case Decode16Bits:
+			return ii->mnemonic;
+		case Decode32Bits:
+			if (~ii->flags & INST_USE_EXMNEMONIC) return ii->mnemonic;
+		break;
+		case Decode64Bits:
+			if ((ii->flags & (INST_USE_EXMNEMONIC | INST_USE_EXMNEMONIC2)) == 0) return ii->mnemonic;
+			if (((ii->flags & (INST_MODRM_BASED | INST_PSEUDO_OPCODE)) == 0) && (ii->flags & INST_USE_EXMNEMONIC2) && (rex & PREFIX_REX_W)) return iie->mnemonic3;
+		break;
+	}
+
+	/* The mod=11 form and the pseudo opcode CMP instructions use the first mnemonic. */
+	if ((ii->flags & INST_MODRM_BASED) && (modrm >= INST_DIVIDED_MODRM)) return ii->mnemonic;
+	if (ii->flags & INST_PSEUDO_OPCODE) return ii->mnemonic;
+	return iie->mnemonic2;
+}
+
+/* Classify the flow control of a decoded instruction, code points to its first opcode byte. */
+static uint8_t get_flow_control(const uint8_t* code, unsigned int modrm)
+{
+	switch (*code)
+	{
+		case 0x0f:
+			if ((code[1] >= 0x80) && (code[1] <= 0x8f)) return FC_CND_BRANCH; /* Jcc rel32 */
+			if ((code[1] == 0x05) || (code[1] == 0x07) || (code[1] == 0x34) || (code[1] == 0x35)) return FC_SYS;
+			if (code[1] == 0x0b) return FC_HLT; /* UD2 */
+		break;
+		case 0x70: case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x76: case 0x77:
+		case 0x78: case 0x79: case 0x7a: case 0x7b: case 0x7c: case 0x7d: case 0x7e: case 0x7f:
+		case 0xe0: case 0xe1: case 0xe2: case 0xe3: /* LOOPxx, JeCXZ */
+			return FC_CND_BRANCH;
+		case 0x9a: case 0xe8:
+			return FC_CALL;
+		case 0xe9: case 0xea: case 0xeb:
+			return FC_UNC_BRANCH;
+		case 0xc2: case 0xc3: case 0xca: case 0xcb: case 0xcf:
+			return FC_RET;
+		case 0xcc: case 0xcd: case 0xce: case 0xf1:
+			return FC_INT;
+		case 0xf4:
+			return FC_HLT;
+		case 0xff:
+			/* Group 5, the REG field of the ModR/M selects the instruction. */
+			switch ((modrm >> 3) & 7)
+			{
+				case 2: case 3: return FC_CALL;
+				case 4: case 5: return FC_UNC_BRANCH;
+			}
+		break;
+	}
+	return FC_NONE;
+}
+
+/* Get the kind of an operand by its type, the mod of the ModR/M tells whether an R/M operand is a register. */
+static uint8_t get_operand_kind(_OpType type, unsigned int modrm)
+{
+	switch (type)
+	{
+		case OT_NONE:
+		case OT_DUMMY:
+			return O_NONE;
+		case OT_IMM8:
+		case OT_IMM16:
+		case OT_IMM_FULL:
+		case OT_IMM32:
+		case OT_IMM_AADM:
+		case OT_SEIMM8:
+		case OT_CONST1:
+			return O_IMM;
+		case OT_RELCB:
+		case OT_RELC_FULL:
+			return O_PC;
+		case OT_PTR16_FULL:
+			return O_PTR;
+		case OT_RM8:
+		case OT_RM16:
+		case OT_RM_FULL:
+		case OT_RM32:
+		case OT_RM32_64:
+		case OT_RM16_32:
+		case OT_R32_M8:
+		case OT_R32_M16:
+		case OT_R32_64_M8:
+		case OT_R32_64_M16:
+		case OT_RFULL_M16:
+		case OT_MM32:
+		case OT_MM64:
+		case OT_XMM16:
+		case OT_XMM32:
+		case OT_XMM64:
+		case OT_XMM128:
+			return (modrm >= INST_DIVIDED_MODRM) ? O_REG : O_MEM;
+		case OT_FPUM16:
+		case OT_FPUM32:
+		case OT_FPUM64:
+		case OT_FPUM80:
+		case OT_MEM16_FULL:
+		case OT_MEM16_3264:
+		case OT_MEM:
+		case OT_MEM32:
+		case OT_MEM32_64:
+		case OT_MEM64:
+		case OT_MEM128:
+		case OT_MEM64_128:
+		case OT_MOFFS:
+		case OT_REGI_ESI:
+		case OT_REGI_EDI:
+		case OT_REGI_EBXAL:
+		case OT_REGI_EAX:
+			return O_MEM;
+		default:
+			return O_REG;
+	}
+}
+
 static int decode_inst(const uint8_t* code, int codeLen, _OffsetType codeOffset,
-                       _PrefixState* ps, _DecodeType dt, _DecodedInst* di)
+                       _PrefixState* ps, _DecodeType dt, _DecodedInst* di, _DInst* si)
 {
+	/* Text output of the instruction, these are NULL when it's decomposed (si) instead. */
+	_WString* mnemonic = NULL;
+	_WString* operands = NULL;
+	_WString* instructionHex = NULL;
+
 	/* The ModR/M byte of the current instruction. */
 	unsigned int modrm = 0;
 
@@ -109,9 +246,14 @@ static int decode_inst(const uint8_t* code, int codeLen, _OffsetType codeOffset,
 	/* Packed params to pass to extract_operand, used for optimizing. */
 	_CodeInfo ci;
 
-	memset(di, 0, sizeof(_DecodedInst));
+	if (di != NULL) {
+		memset(di, 0, sizeof(_DecodedInst));
+		mnemonic = &di->mnemonic;
+		operands = &di->operands;
+		instructionHex = &di->instructionHex;
+	} else memset(si, 0, sizeof(_DInst));
 
-	ii = locate_inst(&code, &codeLen, &codeOffset, &di->instructionHex, ps, dt);
+	ii = locate_inst(&code, &codeLen, &codeOffset, instructionHex, ps, dt);
 
 	/*
 	 * In this point we know the instruction we are about to decode and its operands (unless, it's an invalid one!),
@@ -139,7 +281,7 @@ static int decode_inst(const uint8_t* code, int codeLen, _OffsetType codeOffset,
 	/* code points to the last instruction-byte read, so if the instruction needs the ModR/M byte, we'll just read it. */
 	if (ii && (ii->d != OT_NONE) && (ii->d != OT_DUMMY) && (ii->flags & INST_INCLUDE_MODRM)) {
 		modrm = *code;
-		str_hex_b(&di->instructionHex, modrm);
+		str_hex_b(instructionHex, modrm);
 
 		if (--codeLen < 0) ii = NULL;
 		code++;
@@ -170,29 +312,30 @@ static int decode_inst(const uint8_t* code, int codeLen, _OffsetType codeOffset,
 	ci.code = code;
 	ci.codeLen = codeLen;
 	ci.codeOffset = codeOffset;
+	ci.target = 0;
 
 	if (ii && (ii->d != OT_NONE) && (ii->d != OT_DUMMY)) {
-		rc = extract_operand(&ci, &di->instructionHex, &di->operands, (_OpType)ii->d, (_OpType)ii->s, ONT_1, ii->flags, modrm, ps, dt, &lockable);
+		rc = extract_operand(&ci, instructionHex, operands, (_OpType)ii->d, (_OpType)ii->s, ONT_1, ii->flags, modrm, ps, dt, &lockable);
 		if (rc == EO_HALT) ii = NULL;
 	}
 
 	if (ii && (ii->s != OT_NONE) && (ii->s != OT_DUMMY)) {
-		strcat_WSN(&di->operands, SEP_STR);
-		rc = extract_operand(&ci, &di->instructionHex, &di->operands, (_OpType)ii->s, (_OpType)ii->d, ONT_2, ii->flags, modrm, ps, dt, &dummyLockable);
+		strcat_WSN(operands, SEP_STR);
+		rc = extract_operand(&ci, instructionHex, operands, (_OpType)ii->s, (_OpType)ii->d, ONT_2, ii->flags, modrm, ps, dt, &dummyLockable);
 		if (rc == EO_HALT) ii = NULL;
 	}
 
 	/* Use third operand, only if the flags says this InstInfo requires it. */
 	if (ii && (ii->flags & INST_USE_OP3) && (((_InstInfoEx*)ii)->op3 != OT_NONE) && (((_InstInfoEx*)ii)->op3 != OT_DUMMY)) {
-		strcat_WSN(&di->operands, SEP_STR);
-		rc = extract_operand(&ci, &di->instructionHex, &di->operands, (_OpType)((_InstInfoEx*)ii)->op3, OT_NONE, ONT_3, ii->flags, modrm, ps, dt, &dummyLockable);
+		strcat_WSN(operands, SEP_STR);
+		rc = extract_operand(&ci, instructionHex, operands, (_OpType)((_InstInfoEx*)ii)->op3, OT_NONE, ONT_3, ii->flags, modrm, ps, dt, &dummyLockable);
 		if (rc == EO_HALT) ii = NULL;
 	}
 
 	/* V 1.7.26 Support for a fourth operand is added for INSERTQ instruction. */
 	if (ii && (ii->flags & INST_USE_OP4)) {
-		strcat_WSN(&di->operands, SEP_STR);
-		rc = extract_operand(&ci, &di->instructionHex, &di->operands, (_OpType)((_InstInfoEx*)ii)->op4, OT_NONE, ONT_4, ii->flags, modrm, ps, dt, &dummyLockable);
+		strcat_WSN(operands, SEP_STR);
+		rc = extract_operand(&ci, instructionHex, operands, (_OpType)((_InstInfoEx*)ii)->op4, OT_NONE, ONT_4, ii->flags, modrm, ps, dt, &dummyLockable);
 		if (rc == EO_HALT) ii = NULL;
 	}
 
@@ -200,13 +343,13 @@ static int decode_inst(const uint8_t* code, int codeLen, _OffsetType codeOffset,
 	 * Remove extra space in operands text buffer if required.
 	 * V1.5.12 - The pos test was added to avoid memory access exceeding bounds.
 	 */
-	if ((di->operands.pos >= 2) && (di->operands.p[di->operands.pos-2] == SEP_CHR)) {
-		di->operands.p[di->operands.pos-2] = '\0';
-		di->operands.pos -= 2;
+	if ((operands != NULL) && (operands->pos >= 2) && (operands->p[operands->pos-2] == SEP_CHR)) {
+		operands->p[operands->pos-2] = '\0';
+		operands->pos -= 2;
 	}
 
 	/* If it were a 3DNow! instruction, we will have to find the instruction itself now that we got its operands extracted. */
-	if (ii && ii->flags & INST_3DNOW_FETCH) ii = locate_3dnow_inst(&ci, &di->instructionHex);
+	if (ii && ii->flags & INST_3DNOW_FETCH) ii = locate_3dnow_inst(&ci, instructionHex);
 
 	code = ci.code;
 	codeLen = ci.codeLen;
@@ -224,7 +367,7 @@ static int decode_inst(const uint8_t* code, int codeLen, _OffsetType codeOffset,
 		cmpType = *code;
 		/* Comparison type must be between 0 to 8, otherwise Reserved. */
 		if (cmpType >= INST_CMP_MAX_RANGE) ii = NULL;
-		else str_hex_b(&di->instructionHex, cmpType);
+		else str_hex_b(instructionHex, cmpType);
 
 		if (--codeLen < 0) ii = NULL;
 		code++;
@@ -242,7 +385,7 @@ static int decode_inst(const uint8_t* code, int codeLen, _OffsetType codeOffset,
 		 * If we are in 32 bits decoding mode it doesn't necessarily mean we will choose mnemonic2, alas,
 		 * it means that if there is a mnemonic2, it will be used.
 		 */
-		strclear_WS(&di->mnemonic);
+		strclear_WS(mnemonic);
 
 		/* It's time for adding prefixes' texts if needed. */
 
@@ -250,37 +393,37 @@ static int decode_inst(const uint8_t* code, int codeLen, _OffsetType codeOffset,
 		if ((lockable == 1) && (ii->flags & INST_PRE_LOCK)) {
 			ps->usedPrefixes |= INST_PRE_LOCK;
 
-			strcpy_WSN(&di->mnemonic, PREFIX_LOCK_TEXT);
+			strcpy_WSN(mnemonic, PREFIX_LOCK_TEXT);
 		} else if ((ii->flags & INST_PRE_REPNZ) && (ps->totalPrefixes & INST_PRE_REPNZ)) {
 			ps->usedPrefixes |= INST_PRE_REPNZ;
 
-			strcpy_WS(&di->mnemonic, PREFIX_REPNZ_TEXT);
+			strcpy_WS(mnemonic, PREFIX_REPNZ_TEXT);
 		} else if ((ii->flags & INST_PRE_REP) && (ps->totalPrefixes & INST_PRE_REP)) {
 			ps->usedPrefixes |= INST_PRE_REP;
 
-			strcpy_WSN(&di->mnemonic, PREFIX_REP_TEXT);
+			strcpy_WSN(mnemonic, PREFIX_REP_TEXT);
 		}
 
 		/* If it's JeCXZ the ADDR_SIZE prefix affects them. */
 		if ((ii->flags & (INST_PRE_ADDR_SIZE | INST_USE_EXMNEMONIC)) == (INST_PRE_ADDR_SIZE | INST_USE_EXMNEMONIC)) {
 			ps->usedPrefixes |= (ps->totalPrefixes & INST_PRE_ADDR_SIZE);
-			if (ADDR_SIZE_AFFECT(dt, ps->totalPrefixes) == Decode16Bits) strcatlen_WS(&di->mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
-			else if (ADDR_SIZE_AFFECT(dt, ps->totalPrefixes) == Decode32Bits) strcatlen_WS(&di->mnemonic, &((_InstInfoEx*)ii)->mnemonic2[1], ((_InstInfoEx*)ii)->mnemonic2[0]);
+			if (ADDR_SIZE_AFFECT(dt, ps->totalPrefixes) == Decode16Bits) strcatlen_WS(mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
+			else if (ADDR_SIZE_AFFECT(dt, ps->totalPrefixes) == Decode32Bits) strcatlen_WS(mnemonic, &((_InstInfoEx*)ii)->mnemonic2[1], ((_InstInfoEx*)ii)->mnemonic2[0]);
 			/* Ignore REX.W in 64bits, JECXZ is promoted. */
-			else /* Decode64Bits */ strcatlen_WS(&di->mnemonic, &((_InstInfoEx*)ii)->mnemonic3[1], ((_InstInfoEx*)ii)->mnemonic3[0]);
+			else /* Decode64Bits */ strcatlen_WS(mnemonic, &((_InstInfoEx*)ii)->mnemonic3[1], ((_InstInfoEx*)ii)->mnemonic3[0]);
 		}
 
 		/* V1.1.8 LOOPxx instructions are also native instruction, but they are special case ones, ADDR_SIZE prefix affects them. */
 		else if ((ii->flags & (INST_PRE_ADDR_SIZE | INST_NATIVE)) == (INST_PRE_ADDR_SIZE | INST_NATIVE)) {
-			strcpylen_WS(&di->mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
+			strcpylen_WS(mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
 
 			/* We only enter the next if statement if the addr-size prefix is set, this behaviour is Native's. */
 			/* Ignore REX.W in 64bits, LOOPxx is promoted. */
 			if (ps->totalPrefixes & INST_PRE_ADDR_SIZE) {
 				ps->usedPrefixes |= (ps->totalPrefixes & INST_PRE_ADDR_SIZE);
-				if (ADDR_SIZE_AFFECT(dt, ps->totalPrefixes) == Decode16Bits) chrcat_WS(&di->mnemonic, SUFFIX_SIZE_WORD);
-				else if (ADDR_SIZE_AFFECT(dt, ps->totalPrefixes) == Decode32Bits) chrcat_WS(&di->mnemonic, SUFFIX_SIZE_DWORD);
-				else /* Decode64Bits */ chrcat_WS(&di->mnemonic, SUFFIX_SIZE_QWORD);
+				if (ADDR_SIZE_AFFECT(dt, ps->totalPrefixes) == Decode16Bits) chrcat_WS(mnemonic, SUFFIX_SIZE_WORD);
+				else if (ADDR_SIZE_AFFECT(dt, ps->totalPrefixes) == Decode32Bits) chrcat_WS(mnemonic, SUFFIX_SIZE_DWORD);
+				else /* Decode64Bits */ chrcat_WS(mnemonic, SUFFIX_SIZE_QWORD);
 			}
 		}
 		/*
@@ -296,20 +439,20 @@ static int decode_inst(const uint8_t* code, int codeLen, _OffsetType codeOffset,
 			 * Note: use 16 bits mnemonic if that instruction supports 32 bit or 64 bit explicitly.
 			 */
 			if ((ii->flags & INST_USE_EXMNEMONIC) && ((ii->flags & (INST_32BITS | INST_64BITS)) == 0)) ps->usedPrefixes |= (ps->totalPrefixes & INST_PRE_OP_SIZE);
-			strcatlen_WS(&di->mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
+			strcatlen_WS(mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
 
 			/* Add a suffix letter for repeatable/xlat instructions only. */
 			if (rc == EO_SUFFIX) {
 				/* Is it a 16 bits operation? */
-				if (ii->flags & INST_16BITS) chrcat_WS(&di->mnemonic, SUFFIX_SIZE_WORD);
-				else chrcat_WS(&di->mnemonic, SUFFIX_SIZE_BYTE); /* It's 8 bits operation then. */
+				if (ii->flags & INST_16BITS) chrcat_WS(mnemonic, SUFFIX_SIZE_WORD);
+				else chrcat_WS(mnemonic, SUFFIX_SIZE_BYTE); /* It's 8 bits operation then. */
 			}
 
 			/* Add a suffix, if it's a native instruction (making it 16 bits). */
 			if ((ii->flags & INST_NATIVE) && (ps->totalPrefixes & INST_PRE_OP_SIZE)) {
 				ps->usedPrefixes |= INST_PRE_OP_SIZE;
 
-				chrcat_WS(&di->mnemonic, SUFFIX_SIZE_WORD);
+				chrcat_WS(mnemonic, SUFFIX_SIZE_WORD);
 			}
 		} else if (OP_SIZE_AFFECT(dt, ps->totalPrefixes, rex, ii->flags) == Decode32Bits) { /* Decode32Bits */
 
@@ -318,31 +461,31 @@ static int decode_inst(const uint8_t* code, int codeLen, _OffsetType codeOffset,
 				ps->usedPrefixes |= (ps->totalPrefixes & INST_PRE_OP_SIZE);
 				/* Is it a special instruction which has another mnemonic for mod=11 ? */
 				if (ii->flags & INST_MODRM_BASED) {
-					if (modrm >= INST_DIVIDED_MODRM) strcatlen_WS(&di->mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
-					else strcatlen_WS(&di->mnemonic, &((_InstInfoEx*)ii)->mnemonic2[1], ((_InstInfoEx*)ii)->mnemonic2[0]);
+					if (modrm >= INST_DIVIDED_MODRM) strcatlen_WS(mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
+					else strcatlen_WS(mnemonic, &((_InstInfoEx*)ii)->mnemonic2[1], ((_InstInfoEx*)ii)->mnemonic2[0]);
 				}
 				/* Or is it a special CMP instruction which needs a pseudo opcode suffix ? */
 				else if (ii->flags & INST_PSEUDO_OPCODE) {
 					/* So we have to read the imm8 which tells us which comparison type it is. */
-					strcpylen_WS(&di->mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
-					str_x86def(&di->mnemonic, &_CONDITIONS_PSEUDO[cmpType]);
-					strcatlen_WS(&di->mnemonic, &((_InstInfoEx*)ii)->mnemonic2[1], ((_InstInfoEx*)ii)->mnemonic2[0]);
+					strcpylen_WS(mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
+					str_x86def(mnemonic, &_CONDITIONS_PSEUDO[cmpType]);
+					strcatlen_WS(mnemonic, &((_InstInfoEx*)ii)->mnemonic2[1], ((_InstInfoEx*)ii)->mnemonic2[0]);
 
-				} else strcatlen_WS(&di->mnemonic, &((_InstInfoEx*)ii)->mnemonic2[1], ((_InstInfoEx*)ii)->mnemonic2[0]); /* Two-mnemonics instructions. */
-			} else strcatlen_WS(&di->mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
+				} else strcatlen_WS(mnemonic, &((_InstInfoEx*)ii)->mnemonic2[1], ((_InstInfoEx*)ii)->mnemonic2[0]); /* Two-mnemonics instructions. */
+			} else strcatlen_WS(mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
 
 			/* Add a suffix letter for repeatable(/xlat) instructions only. */
 			if (rc == EO_SUFFIX) {
 				/* Is it a 16 bits operation (means 32 bits in 32 bit decoding mode)? */
-				if (ii->flags & INST_16BITS) chrcat_WS(&di->mnemonic, SUFFIX_SIZE_DWORD);
-				else chrcat_WS(&di->mnemonic, SUFFIX_SIZE_BYTE); /* It's 8 bits operation then. */
+				if (ii->flags & INST_16BITS) chrcat_WS(mnemonic, SUFFIX_SIZE_DWORD);
+				else chrcat_WS(mnemonic, SUFFIX_SIZE_BYTE); /* It's 8 bits operation then. */
 			}
 			
 			/* Add a suffix, if it's a native instruction (making it 32 bits). */
 			if ((ii->flags & INST_NATIVE) && (ps->totalPrefixes & INST_PRE_OP_SIZE)) {
 				ps->usedPrefixes |= INST_PRE_OP_SIZE;
 
-				chrcat_WS(&di->mnemonic, SUFFIX_SIZE_DWORD);
+				chrcat_WS(mnemonic, SUFFIX_SIZE_DWORD);
 			}
 		} else { /* Decode64Bits */
 
@@ -350,21 +493,21 @@ static int decode_inst(const uint8_t* code, int codeLen, _OffsetType codeOffset,
 			if (ii->flags & (INST_USE_EXMNEMONIC | INST_USE_EXMNEMONIC2)) {
 				/* Is it a special instruction which has another mnemonic for mod=11 ? */
 				if (ii->flags & INST_MODRM_BASED) {
-					if (modrm >= INST_DIVIDED_MODRM) strcatlen_WS(&di->mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
-					else strcatlen_WS(&di->mnemonic, &((_InstInfoEx*)ii)->mnemonic2[1], ((_InstInfoEx*)ii)->mnemonic2[0]);
+					if (modrm >= INST_DIVIDED_MODRM) strcatlen_WS(mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
+					else strcatlen_WS(mnemonic, &((_InstInfoEx*)ii)->mnemonic2[1], ((_InstInfoEx*)ii)->mnemonic2[0]);
 				}
 				/* Or is it a special CMP instruction which needs a pseudo opcode suffix ? */
 				else if (ii->flags & INST_PSEUDO_OPCODE) {
 					/* So we have to read the imm8 which tells us which comparison type it is. */
-					strcpylen_WS(&di->mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
-					str_x86def(&di->mnemonic, &_CONDITIONS_PSEUDO[cmpType]);
-					strcatlen_WS(&di->mnemonic, &((_InstInfoEx*)ii)->mnemonic2[1], ((_InstInfoEx*)ii)->mnemonic2[0]);
+					strcpylen_WS(mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
+					str_x86def(mnemonic, &_CONDITIONS_PSEUDO[cmpType]);
+					strcatlen_WS(mnemonic, &((_InstInfoEx*)ii)->mnemonic2[1], ((_InstInfoEx*)ii)->mnemonic2[0]);
 				} else /* Use third mnemonic, for 64 bits. */
 					if ((ii->flags & INST_USE_EXMNEMONIC2) && (ps->isREXPrefixValid) && (rex & PREFIX_REX_W)) {
 						ps->usedPrefixes |= INST_PRE_REX;
-						strcatlen_WS(&di->mnemonic, &((_InstInfoEx*)ii)->mnemonic3[1], ((_InstInfoEx*)ii)->mnemonic3[0]);
-					} else strcatlen_WS(&di->mnemonic, &((_InstInfoEx*)ii)->mnemonic2[1], ((_InstInfoEx*)ii)->mnemonic2[0]); /* Use second mnemonic. */
-			} else strcatlen_WS(&di->mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
+						strcatlen_WS(mnemonic, &((_InstInfoEx*)ii)->mnemonic3[1], ((_InstInfoEx*)ii)->mnemonic3[0]);
+					} else strcatlen_WS(mnemonic, &((_InstInfoEx*)ii)->mnemonic2[1], ((_InstInfoEx*)ii)->mnemonic2[0]); /* Use second mnemonic. */
+			} else strcatlen_WS(mnemonic, &ii->mnemonic[1], ii->mnemonic[0]);
 			/* /////////////////////////////////////////////////////////////////////////////////////////// */
 
 			/* Add a suffix letter for repeatable(/xlat) instructions only. */
@@ -373,35 +516,46 @@ static int decode_inst(const uint8_t* code, int codeLen, _OffsetType codeOffset,
 				if (ii->flags & INST_16BITS) {
 					if (ii->flags & INST_64BITS) {
 						ps->usedPrefixes |= INST_PRE_REX;
-						chrcat_WS(&di->mnemonic, SUFFIX_SIZE_QWORD);
+						chrcat_WS(mnemonic, SUFFIX_SIZE_QWORD);
 					}
-					else chrcat_WS(&di->mnemonic, SUFFIX_SIZE_DWORD);
+					else chrcat_WS(mnemonic, SUFFIX_SIZE_DWORD);
 				}
-				else chrcat_WS(&di->mnemonic, SUFFIX_SIZE_BYTE); /* It's 8 bits operation then. */
+				else chrcat_WS(mnemonic, SUFFIX_SIZE_BYTE); /* It's 8 bits operation then. */
 			}
 
 			/* Add a suffix, if it's a native instruction (making it 64 bits). */
 			if (ii->flags & INST_NATIVE) {
 				if (ps->totalPrefixes & INST_PRE_OP_SIZE) {	/* Operand size. */
 					ps->usedPrefixes |= INST_PRE_OP_SIZE;
-					chrcat_WS(&di->mnemonic, SUFFIX_SIZE_WORD); /* 16 Bits. */
+					chrcat_WS(mnemonic, SUFFIX_SIZE_WORD); /* 16 Bits. */
 				}
 				/* See if a REX prefix is required, otherwise ignore it. */
 				else if ((ps->totalPrefixes & INST_PRE_REX) && (rex & PREFIX_REX_W) && ((ii->flags & (INST_64BITS | INST_PRE_REX)) == (INST_64BITS | INST_PRE_REX))) {
 					 /* REX.W is set, mark it. */
 					ps->usedPrefixes |= INST_PRE_REX;
-					chrcat_WS(&di->mnemonic, SUFFIX_SIZE_QWORD); /* 64 Bits. */
+					chrcat_WS(mnemonic, SUFFIX_SIZE_QWORD); /* 64 Bits. */
 				}
 			}
 		}
+
+		if (si != NULL) {
+			si->mnemonic = get_mnemonic(ii, dt, ps->totalPrefixes, rex, modrm);
+			si->flowControl = get_flow_control(lastCode, modrm);
+			si->target = ci.target;
+			si->ops[0] = get_operand_kind((_OpType)ii->d, modrm);
+			si->ops[1] = get_operand_kind((_OpType)ii->s, modrm);
+			if (ii->flags & INST_USE_OP3) si->ops[2] = get_operand_kind((_OpType)((_InstInfoEx*)ii)->op3, modrm);
+			if (ii->flags & INST_USE_OP4) si->ops[3] = get_operand_kind((_OpType)((_InstInfoEx*)ii)->op4, modrm);
+		}
 	}
 	else {
-		strclear_WS(&di->operands);
+		strclear_WS(operands);
 		/* Special case for WAIT instruction: If it's dropped, you have to return a valid instruction! */
 		if (*lastCode == WAIT_INSTRUCTION_CODE) {
 			codeOffset = lastCodeOffset + 1;
-			strcpy_WS(&di->instructionHex, get_hex_b(WAIT_INSTRUCTION_CODE));
-			strcpy_WSN(&di->mnemonic, WAIT_INSTRUCTION_MNEMONIC);
+			strcpy_WS(instructionHex, get_hex_b(WAIT_INSTRUCTION_CODE));
+			strcpy_WSN(mnemonic, WAIT_INSTRUCTION_MNEMONIC);
+			if (si != NULL) si->mnemonic = II_wait.mnemonic;
 			ps->usedPrefixes = 0;
 		} else {
 			/*
@@ -412,10 +566,10 @@ static int decode_inst(const uint8_t* code, int codeLen, _OffsetType codeOffset,
 			 * A fix for codeOffset is necessary because below the decoded-instruction size depends on it.
 			 */
 			codeOffset = lastCodeOffset + 1; /* + 1 for what we are DB'ing. */
-			strcpy_WS(&di->instructionHex, get_hex_b(*lastCode));
+			strcpy_WS(instructionHex, get_hex_b(*lastCode));
 
-			strcpy_WSN(&di->mnemonic, BYTE_UNDEFINED);
-			str_code_sp_hb(&di->mnemonic, *lastCode);
+			strcpy_WSN(mnemonic, BYTE_UNDEFINED);
+			str_code_sp_hb(mnemonic, *lastCode);
 
 			/* Clean operands just in case... */
 			ps->usedPrefixes = 0; /* Drop'em all. */
@@ -426,7 +580,8 @@ static int decode_inst(const uint8_t* code, int codeLen, _OffsetType codeOffset,
 	}
 
 	/* Calculate the size of the instruction we've just decoded. */
-	di->size = (unsigned int)(codeOffset - lastCodeOffset);
+	if (di != NULL) di->size = (unsigned int)(codeOffset - lastCodeOffset);
+	else si->size = (unsigned int)(codeOffset - lastCodeOffset);
 	return retCode;
 }
 
@@ -574,7 +729,7 @@ _DecodeResult internal_decode(_OffsetType codeOffset, const uint8_t* code, int c
 
 			pdi = &result[nextPos++];
 			isInstructionPopped = FALSE;
-			if (decode_inst(code, codeLen, codeOffset, &ps, dt, pdi)) {
+			if (decode_inst(code, codeLen, codeOffset, &ps, dt, pdi, NULL)) {
 
 				/*
 				 * Build a prefix string including all VALID prefixes. Maximum 5 prefixes.
@@ -668,7 +823,7 @@ _DecodeResult internal_decode(_OffsetType codeOffset, const uint8_t* code, int c
 		} else { /* No prefixes! Only instruction. */
 			/* Use the next available entry without doubt. */
 			pdi = &result[nextPos++];
-			decode_inst(code, codeLen, codeOffset, &ps, dt, pdi);
+			decode_inst(code, codeLen, codeOffset, &ps, dt, pdi, NULL);
 			pdi->offset = startCodeOffset;
 
 			/* Advance to next instruction. */
@@ -683,3 +838,116 @@ _DecodeResult internal_decode(_OffsetType codeOffset, const uint8_t* code, int c
 
 	return DECRES_SUCCESS;
 }
+
+/* Fill the entry of a byte which is skipped, a dropped prefix or a byte that couldn't be decoded. */
+static void decompose_undefined(_DInst* pdi, _OffsetType codeOffset)
+{
+	memset(pdi, 0, sizeof(_DInst));
+	pdi->size = 1;
+	pdi->offset = codeOffset;
+}
+
+/*
+ * Same as internal_decode, but fills _DInst entries and doesn't format any text.
+ * Dropped prefixes get an entry each, like in internal_decode, so both split the code into the same instructions.
+ * Unused prefixes are only part of the instruction's size, they don't get entries of their own.
+ */
+_DecodeResult internal_decompose(_OffsetType codeOffset, const uint8_t* code, int codeLen, _DecodeType dt, _DInst result[], unsigned int maxResultCount, unsigned int* usedInstructionsCount)
+{
+	_PrefixState ps;
+	unsigned int prefixSize;
+
+	/* The real offset of where the whole instruction begins, see internal_decode. */
+	_OffsetType startCodeOffset = 0;
+
+	const uint8_t* p;
+
+	/* Current working decomposed instruction. */
+	unsigned int nextPos = 0; /* in result. */
+	_DInst* pdi = NULL;
+
+	/* No entries are used yet. */
+	*usedInstructionsCount = 0;
+
+	while (codeLen > 0) {
+
+		startCodeOffset = codeOffset;
+
+		memset(&ps, 0, sizeof(_PrefixState));
+		ps.start = code;
+		ps.last = code;
+		prefixSize = 0;
+
+		if (is_prefix(*code, dt)) {
+			decode_prefixes(code, codeLen, &ps, dt);
+			prefixSize = (int)(ps.last - ps.start);
+			/* Drop extra prefixes if any. */
+			if (ps.start != code) {
+				if (nextPos + (ps.start - code) > maxResultCount) return DECRES_MEMORYERR;
+
+				for (p = code; p < ps.start; p++, codeOffset++, codeLen--, code++) decompose_undefined(&result[nextPos++], codeOffset);
+				*usedInstructionsCount = nextPos;
+
+				startCodeOffset = codeOffset;
+			}
+			codeLen -= prefixSize;
+			/* Ran out of bytes, drop all prefixes and halt. */
+			if (codeLen <= 0) {
+				if (nextPos + (ps.last - code) > maxResultCount) return DECRES_MEMORYERR;
+
+				for (p = code; p < ps.last; p++, startCodeOffset++) decompose_undefined(&result[nextPos++], startCodeOffset);
+				*usedInstructionsCount = nextPos;
+				break;
+			}
+			code += prefixSize;
+			codeOffset += prefixSize;
+		}
+
+		/* In 64 bits the REX prefix must precede the opcode, see internal_decode. */
+		if (dt == Decode64Bits) {
+			if (ps.totalPrefixes & INST_PRE_REX) {
+				if (ps.rexpos != (code-1)) ps.totalPrefixes &= ~INST_PRE_REX;
+				else {
+					ps.isREXPrefixValid = 1;
+					if (*ps.rexpos & PREFIX_REX_W) ps.totalPrefixes &= ~INST_PRE_OP_SIZE;
+				}
+			}
+			ps.totalPrefixes &= ~(INST_PRE_CS | INST_PRE_SS | INST_PRE_DS | INST_PRE_ES);
+		}
+
+		if (nextPos + 1 > maxResultCount) return DECRES_MEMORYERR;
+
+		if (prefixSize == 0) decode_inst(code, codeLen, codeOffset, &ps, dt, NULL, &result[nextPos]);
+		else if (!decode_inst(code, codeLen, codeOffset, &ps, dt, NULL, &result[nextPos])) {
+			/* No success in decoding, drop all prefixes (including a mandatory one) before the undecoded byte. */
+			ps.last += ps.specialPrefixesSize;
+
+			if (ps.last - ps.start > 0) {
+				if (nextPos + (ps.last - ps.start) + 1 > maxResultCount) return DECRES_MEMORYERR;
+
+				/* Move the undecoded byte's entry after the prefixes' entries. */
+				pdi = &result[nextPos + (ps.last - ps.start)];
+				memcpy(pdi, &result[nextPos], sizeof(_DInst));
+
+				for (p = ps.start; p < ps.last; p++, startCodeOffset++) decompose_undefined(&result[nextPos++], startCodeOffset);
+				prefixSize = 0;
+				*usedInstructionsCount = nextPos;
+			}
+		}
+
+		pdi = &result[nextPos++];
+
+		/* Advance to next instruction. */
+		codeLen -= pdi->size;
+		codeOffset += pdi->size;
+		code += pdi->size;
+
+		pdi->size += prefixSize;
+		pdi->offset = startCodeOffset;
+
+		/* Alright, the caller can read, at least, up to this one. */
+		*usedInstructionsCount = nextPos;
+	}
+
+	return DECRES_SUCCESS;
+}
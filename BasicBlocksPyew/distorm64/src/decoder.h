@@ -28,14 +28,39 @@ typedef struct {
 	_OffsetType offset;
 } _DecodedInst;
 
+/* Flow control class of a decomposed instruction. */
+/* FC_HLT stands for instructions that stop the flow (HLT, UD2). */
+typedef enum {FC_NONE = 0, FC_CALL, FC_RET, FC_SYS, FC_UNC_BRANCH, FC_CND_BRANCH, FC_INT, FC_HLT} _FlowControlType;
+
+/* Kind of a decomposed operand. */
+typedef enum {O_NONE = 0, O_REG, O_IMM, O_MEM, O_PC, O_PTR} _OperandKindType;
+
+#define MAX_DECOMPOSED_OPERANDS (4)
+
+/*
+ * Structured (non-text) form of a decoded instruction, filled by internal_decompose.
+ * mnemonic points to the length prefixed mnemonic in the instructions DB, or is NULL for a byte which couldn't be decoded.
+ * target is the branch destination of an O_PC operand or the offset part of an O_PTR operand.
+ */
+typedef struct {
+	const int8_t* mnemonic;
+	_OffsetType offset;
+	_OffsetType target;
+	unsigned int size;
+	uint8_t flowControl; /* _FlowControlType */
+	uint8_t ops[MAX_DECOMPOSED_OPERANDS]; /* _OperandKindType */
+} _DInst;
+
 typedef struct {
 	const uint8_t* code;
 	int codeLen;
 	_OffsetType codeOffset;
+	_OffsetType target; /* Set by extract_operand for relative and far pointer operands. */
 } _CodeInfo;
 
 typedef enum {DECRES_NONE, DECRES_SUCCESS, DECRES_MEMORYERR, DECRES_INPUTERR} _DecodeResult;
 _DecodeResult internal_decode(_OffsetType codeOffset, const uint8_t* code, int codeLen, _DecodeType dt, _DecodedInst result[], unsigned int maxResultCount, unsigned int* usedEntriesCount);
+_DecodeResult internal_decompose(_OffsetType codeOffset, const uint8_t* code, int codeLen, _DecodeType dt, _DInst result[], unsigned int maxResultCount, unsigned int* usedEntriesCount);
 
 _DecodeType ADDR_SIZE_AFFECT(_DecodeType dt, _iflags totalPrefixes);
 _DecodeType OP_SIZE_AFFECT(_DecodeType dt, _iflags totalPrefixes, unsigned int rex, _iflags instFlags);
@@ -10,6 +10,8 @@ This library is licensed under the BSD license. See the file COPYING.
 #include "../config.h"
 #include "decoder.h"
 #include "x86defs.h"
+#include "cfg.h"
+#include "lengths.h"
 
 /* C LIBRARY EXPORTS */
 #ifdef SUPPORT_64BIT_OFFSET
@@ -46,6 +48,96 @@ This library is licensed under the BSD license. See the file COPYING.
 	return internal_decode(codeOffset, code, codeLen, dt, result, maxInstructions, usedInstructionsCount);
 }
 
+#ifdef SUPPORT_64BIT_OFFSET
+	_DLLEXPORT_ _DecodeResult distorm_decompose64(_OffsetType codeOffset, const unsigned char* code, int codeLen, _DecodeType dt, _DInst result[], unsigned int maxInstructions, unsigned int* usedInstructionsCount)
+#else
+	_DLLEXPORT_ _DecodeResult distorm_decompose32(_OffsetType codeOffset, const unsigned char* code, int codeLen, _DecodeType dt, _DInst result[], unsigned int maxInstructions, unsigned int* usedInstructionsCount)
+#endif
+{
+	*usedInstructionsCount = 0;
+
+	/* Same input validation as distorm_decode. */
+	if (codeLen < 0) {
+		return DECRES_INPUTERR;
+	}
+
+	if ((dt != Decode16Bits) && (dt != Decode32Bits) && (dt != Decode64Bits)) {
+		return DECRES_INPUTERR;
+	}
+
+	if (code == NULL || result == NULL) {
+		return DECRES_INPUTERR;
+	}
+
+	if (codeLen == 0) {
+		return DECRES_SUCCESS;
+	}
+
+	if (maxInstructions < INST_MAXIMUM_SIZE) {
+		return DECRES_MEMORYERR;
+	}
+
+	return internal_decompose(codeOffset, code, codeLen, dt, result, maxInstructions, usedInstructionsCount);
+}
+
+_DLLEXPORT_ _DecodeResult distorm_lengths(const unsigned char* code, int codeLen, _DecodeType dt, unsigned char sizes[], unsigned char flows[], unsigned int maxInstructions, unsigned int* usedInstructionsCount)
+{
+	*usedInstructionsCount = 0;
+
+	if (codeLen < 0) {
+		return DECRES_INPUTERR;
+	}
+
+	if ((dt != Decode16Bits) && (dt != Decode32Bits) && (dt != Decode64Bits)) {
+		return DECRES_INPUTERR;
+	}
+
+	/* flows is optional. */
+	if (code == NULL || sizes == NULL) {
+		return DECRES_INPUTERR;
+	}
+
+	if (codeLen == 0) {
+		return DECRES_SUCCESS;
+	}
+
+	return internal_lengths(code, codeLen, dt, sizes, flows, maxInstructions, usedInstructionsCount);
+}
+
+#ifdef SUPPORT_64BIT_OFFSET
+	_DLLEXPORT_ _DecodeResult distorm_cfg64(_OffsetType codeOffset, const unsigned char* code, int codeLen, _DecodeType dt, const _OffsetType entries[], unsigned int entriesCount, unsigned int threads, _CfgResult* result)
+#else
+	_DLLEXPORT_ _DecodeResult distorm_cfg32(_OffsetType codeOffset, const unsigned char* code, int codeLen, _DecodeType dt, const _OffsetType entries[], unsigned int entriesCount, unsigned int threads, _CfgResult* result)
+#endif
+{
+	if (result == NULL) {
+		return DECRES_INPUTERR;
+	}
+
+	memset(result, 0, sizeof(_CfgResult));
+
+	if (codeLen < 0) {
+		return DECRES_INPUTERR;
+	}
+
+	if ((dt != Decode16Bits) && (dt != Decode32Bits) && (dt != Decode64Bits)) {
+		return DECRES_INPUTERR;
+	}
+
+	if (code == NULL || (entries == NULL && entriesCount != 0)) {
+		return DECRES_INPUTERR;
+	}
+
+	return internal_cfg(codeOffset, code, codeLen, dt, entries, entriesCount, threads, result);
+}
+
+_DLLEXPORT_ void distorm_cfg_free(_CfgResult* result)
+{
+	if (result != NULL) {
+		cfg_free(result);
+	}
+}
+
 _DLLEXPORT_ unsigned int distorm_version()
 {
 	return DISTORM_VER;
@@ -0,0 +1,797 @@
+/*
+lengths.c
+
+Copyright (C) 2003-2008 Gil Dabah, http://ragestorm.net/distorm/
+This library is licensed under the BSD license. See the file COPYING.
+*/
+
+
+#include "lengths.h"
+
+#include "prefix.h"
+
+/*
+ * Instruction lengths decoding:
+ * An instruction with at most a single 0x66, 0xf2 or 0xf3 prefix (and a REX in 64 bits) is measured straight from the tables below.
+ * Every one byte opcode and every 0x0f two bytes opcode is mapped, per prefix (and REX.W), to a class of its ModR/M and immediate operands.
+ * The tables were built by probing the decoder with every ModR/M and SIB byte of every opcode,
+ * an opcode (or a reg field of it) is in the tables only if the decoder agrees with them on all of its forms.
+ * Anything else (other prefixes, three bytes opcodes, invalid forms, the last bytes of the code) is decomposed,
+ * so the sizes and flow control are exactly the same as internal_decompose's.
+ */
+
+/* Class flags. */
+#define LEN_OK (1) /* The instruction can be measured from the tables, otherwise it's decomposed. */
+#define LEN_MODRM (2)
+#define LEN_GRP3 (4) /* Only the /0 and /1 forms (TEST) have the immediate. */
+#define LEN_GRP5 (8) /* The flow control is by the reg field (0xff group). */
+
+/* ModR/M sizes flag, the SIB's base might be a displacement too. */
+#define LEN_SIB (0x80)
+
+typedef struct {
+	uint8_t flags;
+	uint8_t immSize;
+	uint8_t flowControl; /* _FlowControlType */
+	uint8_t regsMem; /* A bit per ModR/M reg field which is in the tables, when mod != 3. */
+	uint8_t regsReg; /* Same, when mod == 3. */
+} _LenInfo;
+
+/*
+ * The opcode tables hold an index into the classes, 256 one byte opcodes followed by 256 0x0f two bytes opcodes,
+ * per prefix (and per REX.W in 64 bits).
+ */
+static const _LenInfo LenClasses[62] = {
+	/*  0 */ {0, 0, FC_NONE, 0x00, 0x00},
+	/*  1 */ {LEN_OK, 0, FC_HLT, 0xff, 0xff},
+	/*  2 */ {LEN_OK, 0, FC_INT, 0xff, 0xff},
+	/*  3 */ {LEN_OK, 0, FC_NONE, 0xff, 0xff},
+	/*  4 */ {LEN_OK, 0, FC_RET, 0xff, 0xff},
+	/*  5 */ {LEN_OK, 0, FC_SYS, 0xff, 0xff},
+	/*  6 */ {LEN_OK, 1, FC_CND_BRANCH, 0xff, 0xff},
+	/*  7 */ {LEN_OK, 1, FC_INT, 0xff, 0xff},
+	/*  8 */ {LEN_OK, 1, FC_NONE, 0xff, 0xff},
+	/*  9 */ {LEN_OK, 1, FC_UNC_BRANCH, 0xff, 0xff},
+	/* 10 */ {LEN_OK, 2, FC_CALL, 0xff, 0xff},
+	/* 11 */ {LEN_OK, 2, FC_CND_BRANCH, 0xff, 0xff},
+	/* 12 */ {LEN_OK, 2, FC_NONE, 0xff, 0xff},
+	/* 13 */ {LEN_OK, 2, FC_RET, 0xff, 0xff},
+	/* 14 */ {LEN_OK, 2, FC_UNC_BRANCH, 0xff, 0xff},
+	/* 15 */ {LEN_OK, 3, FC_NONE, 0xff, 0xff},
+	/* 16 */ {LEN_OK, 4, FC_CALL, 0xff, 0xff},
+	/* 17 */ {LEN_OK, 4, FC_CND_BRANCH, 0xff, 0xff},
+	/* 18 */ {LEN_OK, 4, FC_NONE, 0xff, 0xff},
+	/* 19 */ {LEN_OK, 4, FC_UNC_BRANCH, 0xff, 0xff},
+	/* 20 */ {LEN_OK, 8, FC_NONE, 0xff, 0xff},
+	/* 21 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0x00, 0x01},
+	/* 22 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0x00, 0x1d},
+	/* 23 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0x00, 0xcf},
+	/* 24 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0x00, 0xff},
+	/* 25 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0x01, 0x01},
+	/* 26 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0x03, 0x00},
+	/* 27 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0x03, 0x03},
+	/* 28 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0x0f, 0x00},
+	/* 29 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0x3d, 0x3d},
+	/* 30 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0x3f, 0x3f},
+	/* 31 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0x8f, 0x00},
+	/* 32 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0xaf, 0x6f},
+	/* 33 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0xc2, 0x00},
+	/* 34 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0xdf, 0x3d},
+	/* 35 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0xdf, 0x58},
+	/* 36 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0xfd, 0xc3},
+	/* 37 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0xfe, 0xfe},
+	/* 38 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0xff, 0x00},
+	/* 39 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0xff, 0x0f},
+	/* 40 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0xff, 0x60},
+	/* 41 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0xff, 0xf3},
+	/* 42 */ {LEN_OK | LEN_MODRM, 0, FC_NONE, 0xff, 0xff},
+	/* 43 */ {LEN_OK | LEN_MODRM, 1, FC_NONE, 0x00, 0x44},
+	/* 44 */ {LEN_OK | LEN_MODRM, 1, FC_NONE, 0x00, 0x54},
+	/* 45 */ {LEN_OK | LEN_MODRM, 1, FC_NONE, 0x00, 0xcc},
+	/* 46 */ {LEN_OK | LEN_MODRM, 1, FC_NONE, 0x00, 0xff},
+	/* 47 */ {LEN_OK | LEN_MODRM, 1, FC_NONE, 0x01, 0x01},
+	/* 48 */ {LEN_OK | LEN_MODRM, 1, FC_NONE, 0xf0, 0xf0},
+	/* 49 */ {LEN_OK | LEN_MODRM, 1, FC_NONE, 0xff, 0xff},
+	/* 50 */ {LEN_OK | LEN_MODRM, 2, FC_NONE, 0x00, 0xff},
+	/* 51 */ {LEN_OK | LEN_MODRM, 2, FC_NONE, 0x01, 0x01},
+	/* 52 */ {LEN_OK | LEN_MODRM, 2, FC_NONE, 0xff, 0xff},
+	/* 53 */ {LEN_OK | LEN_MODRM, 3, FC_CALL, 0x00, 0xff},
+	/* 54 */ {LEN_OK | LEN_MODRM, 3, FC_NONE, 0x00, 0xff},
+	/* 55 */ {LEN_OK | LEN_MODRM, 3, FC_UNC_BRANCH, 0x00, 0xff},
+	/* 56 */ {LEN_OK | LEN_MODRM, 4, FC_NONE, 0x01, 0x01},
+	/* 57 */ {LEN_OK | LEN_MODRM, 4, FC_NONE, 0xff, 0xff},
+	/* 58 */ {LEN_OK | LEN_MODRM | LEN_GRP3, 1, FC_NONE, 0xfd, 0xfd},
+	/* 59 */ {LEN_OK | LEN_MODRM | LEN_GRP3, 2, FC_NONE, 0xfd, 0xfd},
+	/* 60 */ {LEN_OK | LEN_MODRM | LEN_GRP3, 4, FC_NONE, 0xfd, 0xfd},
+	/* 61 */ {LEN_OK | LEN_MODRM | LEN_GRP5, 0, FC_NONE, 0x7f, 0x57}
+};
+
+static const uint8_t LenTable16[4 * 512] = {
+	/* No prefix. */
+	/* 00 */ 42, 42, 42, 42,  8, 12,  3,  3, 42, 42, 42, 42,  8, 12,  3,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 12,  3,  3, 42, 42, 42, 42,  8, 12,  3,  3,
+	/* 20 */ 42, 42, 42, 42,  8, 12,  0,  3, 42, 42, 42, 42,  8, 12,  0,  3,
+	/* 30 */ 42, 42, 42, 42,  8, 12,  0,  3, 42, 42, 42, 42,  8, 12,  0,  3,
+	/* 40 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  3,  3, 38, 42,  0,  0,  0,  0, 12, 52,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 52, 49, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3, 53,  0,  3,  3,  3,  3,
+	/* a0 */ 12, 12, 12, 12,  3,  3,  3,  3,  8, 12,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 12, 12, 12, 12, 12, 12, 12, 12,
+	/* c0 */ 49, 49, 13,  4, 38, 38, 47, 51, 15,  3, 13,  4,  2,  7,  2,  4,
+	/* d0 */ 42, 42, 42, 42,  8,  8,  3,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 10, 14, 55,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 59,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 42, 38, 42, 42, 42, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 22, 23, 22, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  5,  5,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,  0,  0, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 43, 42, 42, 42,  3, 42, 42,  0,  0,  0,  0, 42, 42,
+	/* 0f 80 */ 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42,  0,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */  0, 42, 42, 42, 42, 42,  0, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42,  0, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */  0, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0,
+	/* 0x66 prefix. */
+	/* 00 */ 42, 42, 42, 42,  8, 18,  3,  3, 42, 42, 42, 42,  8, 18,  3,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 18,  3,  3, 42, 42, 42, 42,  8, 18,  3,  3,
+	/* 20 */ 42, 42, 42, 42,  8, 18,  0,  3, 42, 42, 42, 42,  8, 18,  0,  3,
+	/* 30 */ 42, 42, 42, 42,  8, 18,  0,  3, 42, 42, 42, 42,  8, 18,  0,  3,
+	/* 40 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  3,  3, 38, 42,  0,  0,  0,  0, 18, 57,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 57, 49, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  0,  0,  3,  3,  3,  3,
+	/* a0 */ 12, 12, 12, 12,  3,  3,  3,  3,  8, 18,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 18, 18, 18, 18, 18, 18, 18, 18,
+	/* c0 */ 49, 49, 13,  4, 38, 38, 47, 56, 15,  3, 13,  4,  2,  7,  2,  4,
+	/* d0 */ 42, 42, 42, 42,  8,  8,  3,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 16, 19,  0,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 60,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 38, 38, 42, 42, 38, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 22, 23, 22, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  5,  5,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 45, 42, 42, 42,  3, 37,  8,  0,  0, 42, 42, 42, 42,
+	/* 0f 80 */ 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42,  0,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */ 42, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42, 42, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */  0, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0,
+	/* 0xf2 prefix. */
+	/* 00 */ 42, 42, 42, 42,  8, 12,  3,  3, 42, 42, 42, 42,  8, 12,  3,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 12,  3,  3, 42, 42, 42, 42,  8, 12,  3,  3,
+	/* 20 */ 42, 42, 42, 42,  8, 12,  0,  3, 42, 42, 42, 42,  8, 12,  0,  3,
+	/* 30 */ 42, 42, 42, 42,  8, 12,  0,  3, 42, 42, 42, 42,  8, 12,  0,  3,
+	/* 40 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  3,  3, 38, 42,  0,  0,  0,  0, 12, 52,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 52, 49, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3, 53,  0,  3,  3,  3,  3,
+	/* a0 */ 12, 12, 12, 12,  3,  3,  3,  3,  8, 12,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 12, 12, 12, 12, 12, 12, 12, 12,
+	/* c0 */ 49, 49, 13,  4, 38, 38, 47, 51, 15,  3, 13,  4,  2,  7,  2,  4,
+	/* d0 */ 42, 42, 42, 42,  8,  8,  3,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 10, 14, 55,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 59,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 42, 38, 42, 42, 42, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 22, 23, 22, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  5,  5,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,  0,  0, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 43, 42, 42, 42,  3, 50, 24,  0,  0, 42, 42, 42, 42,
+	/* 0f 80 */ 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42,  0,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */ 42, 42, 42, 42, 42, 42, 24, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42, 42, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */ 38, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0,
+	/* 0xf3 prefix. */
+	/* 00 */ 42, 42, 42, 42,  8, 12,  3,  3, 42, 42, 42, 42,  8, 12,  3,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 12,  3,  3, 42, 42, 42, 42,  8, 12,  3,  3,
+	/* 20 */ 42, 42, 42, 42,  8, 12,  0,  3, 42, 42, 42, 42,  8, 12,  0,  3,
+	/* 30 */ 42, 42, 42, 42,  8, 12,  0,  3, 42, 42, 42, 42,  8, 12,  0,  3,
+	/* 40 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  3,  3, 38, 42,  0,  0,  0,  0, 12, 52,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 52, 49, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3, 53,  0,  3,  3,  3,  3,
+	/* a0 */ 12, 12, 12, 12,  3,  3,  3,  3,  8, 12,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 12, 12, 12, 12, 12, 12, 12, 12,
+	/* c0 */ 49, 49, 13,  4, 38, 38, 47, 51, 15,  3, 13,  4,  2,  7,  2,  4,
+	/* d0 */ 42, 42, 42, 42,  8,  8,  3,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 10, 14, 55,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 59,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 42, 38, 42, 42, 42, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 22, 23, 22, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  5,  5,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,  0,  0, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 43, 42, 42, 42,  3, 42, 42,  0,  0,  0,  0, 42, 42,
+	/* 0f 80 */ 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42, 42,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */  0, 42, 42, 42, 42, 42, 24, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42, 42, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */  0, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0
+};
+
+static const uint8_t LenTable32[4 * 512] = {
+	/* No prefix. */
+	/* 00 */ 42, 42, 42, 42,  8, 18,  3,  3, 42, 42, 42, 42,  8, 18,  3,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 18,  3,  3, 42, 42, 42, 42,  8, 18,  3,  3,
+	/* 20 */ 42, 42, 42, 42,  8, 18,  0,  3, 42, 42, 42, 42,  8, 18,  0,  3,
+	/* 30 */ 42, 42, 42, 42,  8, 18,  0,  3, 42, 42, 42, 42,  8, 18,  0,  3,
+	/* 40 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  3,  3, 38, 42,  0,  0,  0,  0, 18, 57,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 57, 49, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  0,  0,  3,  3,  3,  3,
+	/* a0 */ 18, 18, 18, 18,  3,  3,  3,  3,  8, 18,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 18, 18, 18, 18, 18, 18, 18, 18,
+	/* c0 */ 49, 49, 13,  4, 38, 38, 47, 56, 15,  3, 13,  4,  2,  7,  2,  4,
+	/* d0 */ 42, 42, 42, 42,  8,  8,  3,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 16, 19,  0,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 60,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 42, 38, 42, 42, 42, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 22, 23, 22, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  5,  5,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,  0,  0, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 43, 42, 42, 42,  3, 42, 42,  0,  0,  0,  0, 42, 42,
+	/* 0f 80 */ 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42,  0,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */  0, 42, 42, 42, 42, 42,  0, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42,  0, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */  0, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0,
+	/* 0x66 prefix. */
+	/* 00 */ 42, 42, 42, 42,  8, 12,  3,  3, 42, 42, 42, 42,  8, 12,  3,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 12,  3,  3, 42, 42, 42, 42,  8, 12,  3,  3,
+	/* 20 */ 42, 42, 42, 42,  8, 12,  0,  3, 42, 42, 42, 42,  8, 12,  0,  3,
+	/* 30 */ 42, 42, 42, 42,  8, 12,  0,  3, 42, 42, 42, 42,  8, 12,  0,  3,
+	/* 40 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  3,  3, 38, 42,  0,  0,  0,  0, 12, 52,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 52, 49, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3, 53,  0,  3,  3,  3,  3,
+	/* a0 */ 54, 54, 54, 54,  3,  3,  3,  3,  8, 12,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 12, 12, 12, 12, 12, 12, 12, 12,
+	/* c0 */ 49, 49, 13,  4, 38, 38, 47, 51, 15,  3, 13,  4,  2,  7,  2,  4,
+	/* d0 */ 42, 42, 42, 42,  8,  8,  3,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 10, 14, 55,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 59,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 38, 38, 42, 42, 38, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 22, 23, 22, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  5,  5,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 45, 42, 42, 42,  3, 37,  8,  0,  0, 42, 42, 42, 42,
+	/* 0f 80 */ 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42,  0,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */ 42, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42, 42, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */  0, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0,
+	/* 0xf2 prefix. */
+	/* 00 */ 42, 42, 42, 42,  8, 18,  3,  3, 42, 42, 42, 42,  8, 18,  3,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 18,  3,  3, 42, 42, 42, 42,  8, 18,  3,  3,
+	/* 20 */ 42, 42, 42, 42,  8, 18,  0,  3, 42, 42, 42, 42,  8, 18,  0,  3,
+	/* 30 */ 42, 42, 42, 42,  8, 18,  0,  3, 42, 42, 42, 42,  8, 18,  0,  3,
+	/* 40 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  3,  3, 38, 42,  0,  0,  0,  0, 18, 57,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 57, 49, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  0,  0,  3,  3,  3,  3,
+	/* a0 */ 18, 18, 18, 18,  3,  3,  3,  3,  8, 18,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 18, 18, 18, 18, 18, 18, 18, 18,
+	/* c0 */ 49, 49, 13,  4, 38, 38, 47, 56, 15,  3, 13,  4,  2,  7,  2,  4,
+	/* d0 */ 42, 42, 42, 42,  8,  8,  3,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 16, 19,  0,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 60,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 42, 38, 42, 42, 42, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 22, 23, 22, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  5,  5,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,  0,  0, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 43, 42, 42, 42,  3, 50, 24,  0,  0, 42, 42, 42, 42,
+	/* 0f 80 */ 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42,  0,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */ 42, 42, 42, 42, 42, 42, 24, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42, 42, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */ 38, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0,
+	/* 0xf3 prefix. */
+	/* 00 */ 42, 42, 42, 42,  8, 18,  3,  3, 42, 42, 42, 42,  8, 18,  3,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 18,  3,  3, 42, 42, 42, 42,  8, 18,  3,  3,
+	/* 20 */ 42, 42, 42, 42,  8, 18,  0,  3, 42, 42, 42, 42,  8, 18,  0,  3,
+	/* 30 */ 42, 42, 42, 42,  8, 18,  0,  3, 42, 42, 42, 42,  8, 18,  0,  3,
+	/* 40 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  3,  3, 38, 42,  0,  0,  0,  0, 18, 57,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 57, 49, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  0,  0,  3,  3,  3,  3,
+	/* a0 */ 18, 18, 18, 18,  3,  3,  3,  3,  8, 18,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 18, 18, 18, 18, 18, 18, 18, 18,
+	/* c0 */ 49, 49, 13,  4, 38, 38, 47, 56, 15,  3, 13,  4,  2,  7,  2,  4,
+	/* d0 */ 42, 42, 42, 42,  8,  8,  3,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 16, 19,  0,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 60,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 42, 38, 42, 42, 42, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 22, 23, 22, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  5,  5,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,  0,  0, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 43, 42, 42, 42,  3, 42, 42,  0,  0,  0,  0, 42, 42,
+	/* 0f 80 */ 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42, 42,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */  0, 42, 42, 42, 42, 42, 24, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42, 42, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */  0, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0
+};
+
+static const uint8_t LenTable64[8 * 512] = {
+	/* No prefix. */
+	/* 00 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 20 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 30 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 40 */  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  0,  0,  0, 42,  0,  0,  0,  0, 18, 57,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 57,  0, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  0,  0,  3,  3,  3,  3,
+	/* a0 */  0,  0,  0,  0,  3,  3,  3,  3,  8, 18,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 18, 18, 18, 18, 18, 18, 18, 18,
+	/* c0 */ 49, 49, 13,  4,  0,  0, 47, 56, 15,  3, 13,  4,  2,  7,  0,  4,
+	/* d0 */ 42, 42, 42, 42,  0,  0,  0,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 16, 19,  0,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 60,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 42, 38, 42, 42, 42, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 21, 23, 21, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,  0,  0, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 43, 42, 42, 42,  3, 42, 42,  0,  0,  0,  0, 42, 42,
+	/* 0f 80 */ 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42,  0,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */  0, 42, 42, 42, 42, 42,  0, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42,  0, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */  0, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0,
+	/* No prefix, REX.W. */
+	/* 00 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 20 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 30 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 40 */  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  0,  0,  0, 42,  0,  0,  0,  0, 18, 57,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 57,  0, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  0,  0,  3,  3,  3,  3,
+	/* a0 */ 20, 20, 20, 20,  3,  3,  3,  3,  8, 18,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 20, 20, 20, 20, 20, 20, 20, 20,
+	/* c0 */ 49, 49, 13,  4,  0,  0, 47, 56, 15,  3, 13,  4,  2,  7,  0,  4,
+	/* d0 */ 42, 42, 42, 42,  0,  0,  0,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 16, 19,  0,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 60,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 42, 38, 42, 42, 42, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 21, 23, 21, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,  0,  0, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 43, 42, 42, 42,  3, 42, 42,  0,  0,  0,  0, 42, 42,
+	/* 0f 80 */ 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42,  0,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */  0, 42, 42, 42, 42, 42,  0, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42,  0, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */  0, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0,
+	/* 0x66 prefix. */
+	/* 00 */ 42, 42, 42, 42,  8, 12,  0,  0, 42, 42, 42, 42,  8, 12,  0,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 12,  0,  0, 42, 42, 42, 42,  8, 12,  0,  0,
+	/* 20 */ 42, 42, 42, 42,  8, 12,  0,  0, 42, 42, 42, 42,  8, 12,  0,  0,
+	/* 30 */ 42, 42, 42, 42,  8, 12,  0,  0, 42, 42, 42, 42,  8, 12,  0,  0,
+	/* 40 */  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  0,  0,  0, 42,  0,  0,  0,  0, 12, 52,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 52,  0, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  0,  0,  3,  3,  3,  3,
+	/* a0 */  0,  0,  0,  0,  3,  3,  3,  3,  8, 12,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 12, 12, 12, 12, 12, 12, 12, 12,
+	/* c0 */ 49, 49, 13,  4,  0,  0, 47, 51, 15,  3, 13,  4,  2,  7,  0,  4,
+	/* d0 */ 42, 42, 42, 42,  0,  0,  0,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 10, 14,  0,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 59,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 38, 38, 42, 42, 38, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 21, 23, 21, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 45, 42, 42, 42,  3, 37,  8,  0,  0, 42, 42, 42, 42,
+	/* 0f 80 */ 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11, 11,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42,  0,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */ 42, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42, 42, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */  0, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0,
+	/* 0x66 prefix, REX.W. */
+	/* 00 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 20 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 30 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 40 */  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  0,  0,  0, 42,  0,  0,  0,  0, 18, 57,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 57,  0, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  0,  0,  3,  3,  3,  3,
+	/* a0 */ 20, 20, 20, 20,  3,  3,  3,  3,  8, 18,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 20, 20, 20, 20, 20, 20, 20, 20,
+	/* c0 */ 49, 49, 13,  4,  0,  0, 47, 56, 15,  3, 13,  4,  2,  7,  0,  4,
+	/* d0 */ 42, 42, 42, 42,  0,  0,  0,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 16, 19,  0,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 60,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 38, 38, 42, 42, 38, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 21, 23, 21, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 45, 42, 42, 42,  3, 37,  8,  0,  0, 42, 42, 42, 42,
+	/* 0f 80 */ 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42,  0,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */ 42, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42, 42, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */  0, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0,
+	/* 0xf2 prefix. */
+	/* 00 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 20 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 30 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 40 */  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  0,  0,  0, 42,  0,  0,  0,  0, 18, 57,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 57,  0, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  0,  0,  3,  3,  3,  3,
+	/* a0 */  0,  0,  0,  0,  3,  3,  3,  3,  8, 18,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 18, 18, 18, 18, 18, 18, 18, 18,
+	/* c0 */ 49, 49, 13,  4,  0,  0, 47, 56, 15,  3, 13,  4,  2,  7,  0,  4,
+	/* d0 */ 42, 42, 42, 42,  0,  0,  0,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 16, 19,  0,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 60,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 42, 38, 42, 42, 42, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 21, 23, 21, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,  0,  0, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 43, 42, 42, 42,  3, 50, 24,  0,  0, 42, 42, 42, 42,
+	/* 0f 80 */ 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42,  0,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */ 42, 42, 42, 42, 42, 42, 24, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42, 42, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */ 38, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0,
+	/* 0xf2 prefix, REX.W. */
+	/* 00 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 20 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 30 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 40 */  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  0,  0,  0, 42,  0,  0,  0,  0, 18, 57,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 57,  0, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  0,  0,  3,  3,  3,  3,
+	/* a0 */ 20, 20, 20, 20,  3,  3,  3,  3,  8, 18,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 20, 20, 20, 20, 20, 20, 20, 20,
+	/* c0 */ 49, 49, 13,  4,  0,  0, 47, 56, 15,  3, 13,  4,  2,  7,  0,  4,
+	/* d0 */ 42, 42, 42, 42,  0,  0,  0,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 16, 19,  0,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 60,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 42, 38, 42, 42, 42, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 21, 23, 21, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,  0,  0, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 43, 42, 42, 42,  3, 50, 24,  0,  0, 42, 42, 42, 42,
+	/* 0f 80 */ 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42,  0,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */ 42, 42, 42, 42, 42, 42, 24, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42, 42, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */ 38, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0,
+	/* 0xf3 prefix. */
+	/* 00 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 20 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 30 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 40 */  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  0,  0,  0, 42,  0,  0,  0,  0, 18, 57,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 57,  0, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  0,  0,  3,  3,  3,  3,
+	/* a0 */  0,  0,  0,  0,  3,  3,  3,  3,  8, 18,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 18, 18, 18, 18, 18, 18, 18, 18,
+	/* c0 */ 49, 49, 13,  4,  0,  0, 47, 56, 15,  3, 13,  4,  2,  7,  0,  4,
+	/* d0 */ 42, 42, 42, 42,  0,  0,  0,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 16, 19,  0,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 60,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 42, 38, 42, 42, 42, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 21, 23, 21, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,  0,  0, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 43, 42, 42, 42,  3, 42, 42,  0,  0,  0,  0, 42, 42,
+	/* 0f 80 */ 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42, 42,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */  0, 42, 42, 42, 42, 42, 24, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42, 42, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */  0, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0,
+	/* 0xf3 prefix, REX.W. */
+	/* 00 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 10 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 20 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 30 */ 42, 42, 42, 42,  8, 18,  0,  0, 42, 42, 42, 42,  8, 18,  0,  0,
+	/* 40 */  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 50 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 60 */  0,  0,  0, 42,  0,  0,  0,  0, 18, 57,  8, 49,  3,  3,  3,  3,
+	/* 70 */  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,  6,
+	/* 80 */ 49, 57,  0, 49, 42, 42, 42, 42, 42, 42, 42, 42, 30, 38, 29, 25,
+	/* 90 */  3,  3,  3,  3,  3,  3,  3,  3,  3,  3,  0,  0,  3,  3,  3,  3,
+	/* a0 */ 20, 20, 20, 20,  3,  3,  3,  3,  8, 18,  3,  3,  3,  3,  3,  3,
+	/* b0 */  8,  8,  8,  8,  8,  8,  8,  8, 20, 20, 20, 20, 20, 20, 20, 20,
+	/* c0 */ 49, 49, 13,  4,  0,  0, 47, 56, 15,  3, 13,  4,  2,  7,  0,  4,
+	/* d0 */ 42, 42, 42, 42,  0,  0,  0,  3, 42, 36, 39, 32, 41, 34, 41, 40,
+	/* e0 */  6,  6,  6,  6,  8,  8,  8,  8, 16, 19,  0,  9,  3,  3,  3,  3,
+	/* f0 */  0,  2,  0,  0,  1,  3, 58, 60,  3,  3,  3,  3,  3,  3, 27, 61,
+	/* 0f 00 */ 30, 35, 42, 42,  0,  5,  3,  5,  3,  3,  0,  1,  0, 26,  3,  0,
+	/* 0f 10 */ 42, 42, 42, 38, 42, 42, 42, 38, 28,  0,  0,  0,  0,  0,  0, 25,
+	/* 0f 20 */ 21, 23, 21, 23,  0,  0,  0,  0, 42, 42, 42, 38, 42, 42, 42, 42,
+	/* 0f 30 */  3,  3,  3,  3,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,
+	/* 0f 40 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 50 */ 24, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f 60 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,  0,  0, 42, 42,
+	/* 0f 70 */ 49, 44, 44, 43, 42, 42, 42,  3, 42, 42,  0,  0,  0,  0, 42, 42,
+	/* 0f 80 */ 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17, 17,
+	/* 0f 90 */ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f a0 */  3,  3,  3, 42, 49, 42,  0,  0,  3,  3,  3, 42, 49, 42, 31, 42,
+	/* 0f b0 */ 42, 42, 38, 42, 38, 38, 42, 42, 42,  3, 48, 42, 42, 42, 42, 42,
+	/* 0f c0 */ 42, 42,  0, 38, 49, 46, 49, 33,  3,  3,  3,  3,  3,  3,  3,  3,
+	/* 0f d0 */  0, 42, 42, 42, 42, 42, 24, 24, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f e0 */ 42, 42, 42, 42, 42, 42, 42, 38, 42, 42, 42, 42, 42, 42, 42, 42,
+	/* 0f f0 */  0, 42, 42, 42, 42, 42, 42, 24, 42, 42, 42, 42, 42, 42, 42,  0
+};
+
+/* Bytes following the ModR/M byte by its value, per address size. */
+static const uint8_t LenModRM16[256] = {
+	/* 00 */ 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 2, 0,
+	/* 10 */ 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 2, 0,
+	/* 20 */ 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 2, 0,
+	/* 30 */ 0, 0, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 2, 0,
+	/* 40 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 50 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 60 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 70 */ 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	/* 80 */ 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	/* 90 */ 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	/* a0 */ 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	/* b0 */ 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+	/* c0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	/* d0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	/* e0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	/* f0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static const uint8_t LenModRM32[256] = {
+	/* 00 */ 0, 0, 0, 0, LEN_SIB | 1, 4, 0, 0, 0, 0, 0, 0, LEN_SIB | 1, 4, 0, 0,
+	/* 10 */ 0, 0, 0, 0, LEN_SIB | 1, 4, 0, 0, 0, 0, 0, 0, LEN_SIB | 1, 4, 0, 0,
+	/* 20 */ 0, 0, 0, 0, LEN_SIB | 1, 4, 0, 0, 0, 0, 0, 0, LEN_SIB | 1, 4, 0, 0,
+	/* 30 */ 0, 0, 0, 0, LEN_SIB | 1, 4, 0, 0, 0, 0, 0, 0, LEN_SIB | 1, 4, 0, 0,
+	/* 40 */ 1, 1, 1, 1, LEN_SIB | 2, 1, 1, 1, 1, 1, 1, 1, LEN_SIB | 2, 1, 1, 1,
+	/* 50 */ 1, 1, 1, 1, LEN_SIB | 2, 1, 1, 1, 1, 1, 1, 1, LEN_SIB | 2, 1, 1, 1,
+	/* 60 */ 1, 1, 1, 1, LEN_SIB | 2, 1, 1, 1, 1, 1, 1, 1, LEN_SIB | 2, 1, 1, 1,
+	/* 70 */ 1, 1, 1, 1, LEN_SIB | 2, 1, 1, 1, 1, 1, 1, 1, LEN_SIB | 2, 1, 1, 1,
+	/* 80 */ 4, 4, 4, 4, LEN_SIB | 5, 4, 4, 4, 4, 4, 4, 4, LEN_SIB | 5, 4, 4, 4,
+	/* 90 */ 4, 4, 4, 4, LEN_SIB | 5, 4, 4, 4, 4, 4, 4, 4, LEN_SIB | 5, 4, 4, 4,
+	/* a0 */ 4, 4, 4, 4, LEN_SIB | 5, 4, 4, 4, 4, 4, 4, 4, LEN_SIB | 5, 4, 4, 4,
+	/* b0 */ 4, 4, 4, 4, LEN_SIB | 5, 4, 4, 4, 4, 4, 4, 4, LEN_SIB | 5, 4, 4, 4,
+	/* c0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	/* d0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	/* e0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	/* f0 */ 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+static const uint8_t LenGrp5Flow[8] = {FC_NONE, FC_NONE, FC_CALL, FC_CALL, FC_UNC_BRANCH, FC_UNC_BRANCH, FC_NONE, FC_NONE};
+
+/* No instruction is longer than this, closer to the end of the code the decomposer takes over. */
+#define LEN_WINDOW (16)
+
+/* Most entries for decomposing an instruction whose prefixes are dropped. */
+#define LEN_DECOMPOSE_ENTRIES (64)
+
+/* Returns the size of the instruction from the tables, or 0 when it has to be decomposed. */
+static unsigned int lengths_measure(const uint8_t* code, const uint8_t* table, const uint8_t* modrmSizes, unsigned int rexTables, uint8_t* flowControl)
+{
+	const _LenInfo* li;
+	unsigned int len = 0, index = 0, reg, size;
+
+	if (code[0] == 0x66) index = 1;
+	else if ((code[0] & 0xfe) == 0xf2) index = code[0] - 0xf0;
+	if (index != 0) len = 1;
+	index *= rexTables;
+
+	/* REX.W selects its own tables in 64 bits. */
+	if ((rexTables == 2) && ((code[len] & 0xf0) == 0x40)) {
+		index += (code[len] >> 3) & 1;
+		len++;
+	}
+
+	table += index * 512;
+	if (code[len] == 0x0f) {
+		li = &LenClasses[table[256 + code[len + 1]]];
+		len += 2;
+	} else li = &LenClasses[table[code[len++]]];
+
+	if (!(li->flags & LEN_OK)) return 0;
+
+	*flowControl = li->flowControl;
+	if (!(li->flags & LEN_MODRM)) return len + li->immSize;
+
+	reg = (code[len] >> 3) & 7;
+	if (!(((code[len] >= 0xc0) ? li->regsReg : li->regsMem) & (1 << reg))) return 0;
+
+	size = modrmSizes[code[len]];
+	if (size & LEN_SIB) {
+		size &= ~LEN_SIB;
+		if ((code[len] < 0x40) && ((code[len + 1] & 7) == 5)) size += 4;
+	}
+	len += 1 + size;
+
+	if (li->flags & (LEN_GRP3 | LEN_GRP5)) {
+		if (li->flags & LEN_GRP5) *flowControl = LenGrp5Flow[reg];
+		else if (reg >= 2) return len;
+	}
+
+	return len + li->immSize;
+}
+
+_DecodeResult internal_lengths(const uint8_t* code, int codeLen, _DecodeType dt, uint8_t sizes[], uint8_t flows[], unsigned int maxResultCount, unsigned int* usedEntriesCount)
+{
+	const uint8_t* table = (dt == Decode16Bits) ? LenTable16 : ((dt == Decode32Bits) ? LenTable32 : LenTable64);
+	const uint8_t* modrmSizes = (dt == Decode16Bits) ? LenModRM16 : LenModRM32;
+	unsigned int rexTables = (dt == Decode64Bits) ? 2 : 1;
+	_DInst di[LEN_DECOMPOSE_ENTRIES];
+	unsigned int nextPos = 0, size, count, entries, i;
+	uint8_t flowControl = FC_NONE;
+
+	*usedEntriesCount = 0;
+
+	while (codeLen > 0) {
+		if (nextPos == maxResultCount) return DECRES_MEMORYERR;
+
+		size = (codeLen >= LEN_WINDOW) ? lengths_measure(code, table, modrmSizes, rexTables, &flowControl) : 0;
+		if (size != 0) {
+			sizes[nextPos] = (uint8_t)size;
+			if (flows != NULL) flows[nextPos] = flowControl;
+			*usedEntriesCount = ++nextPos;
+
+			code += size;
+			codeLen -= size;
+			continue;
+		}
+
+		/* Decompose a single instruction. */
+		internal_decompose(0, code, codeLen, dt, di, 1, &count);
+
+		/*
+		 * A prefix which didn't make it into an instruction might be one of a few dropped ones,
+		 * decompose them with more entries until the instruction they precede shows up, and take them up to it.
+		 */
+		for (entries = 2; ((count == 0) || ((di[count - 1].mnemonic == NULL) && is_prefix(*code, dt))) && (entries <= LEN_DECOMPOSE_ENTRIES); entries *= 2) {
+			internal_decompose(0, code, codeLen, dt, di, entries, &count);
+			for (i = 0; (i < count) && (di[i].mnemonic == NULL); i++);
+			if (i < count) count = i + 1;
+		}
+
+		/* More dropped prefixes than entries, drop the first one on our own. */
+		if (count == 0) {
+			di[0].size = 1;
+			di[0].flowControl = FC_NONE;
+			count = 1;
+		}
+
+		for (i = 0; i < count; i++) {
+			if (nextPos == maxResultCount) return DECRES_MEMORYERR;
+
+			sizes[nextPos] = (uint8_t)di[i].size;
+			if (flows != NULL) flows[nextPos] = di[i].flowControl;
+			*usedEntriesCount = ++nextPos;
+
+			code += di[i].size;
+			codeLen -= di[i].size;
+		}
+	}
+
+	return DECRES_SUCCESS;
+}
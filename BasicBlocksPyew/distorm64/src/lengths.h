@@ -0,0 +1,18 @@
+/*
+lengths.h
+
+Copyright (C) 2003-2008 Gil Dabah, http://ragestorm.net/distorm/
+This library is licensed under the BSD license. See the file COPYING.
+*/
+
+
+#ifndef LENGTHS_H
+#define LENGTHS_H
+
+#include "../config.h"
+
+#include "decoder.h"
+
+_DecodeResult internal_lengths(const uint8_t* code, int codeLen, _DecodeType dt, uint8_t sizes[], uint8_t flows[], unsigned int maxResultCount, unsigned int* usedEntriesCount);
+
+#endif /* LENGTHS_H */
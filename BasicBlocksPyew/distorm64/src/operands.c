@@ -1018,6 +1018,7 @@ _ExtractModRM:
 				str_code_hw(operandText, RUSHORT((code+sizeof(int16_t))));
 				chrcat_WS(operandText, SEG_OFF_CHR);
 				str_code_hw(operandText, RUSHORT(code));
+				ci->target = RUSHORT(code);
 
 				code += sizeof(int16_t)*2;
 				codeOffset += sizeof(int16_t)*2;
@@ -1033,6 +1034,7 @@ _ExtractModRM:
 				str_code_hw(operandText, RUSHORT((code+sizeof(int32_t))));
 				chrcat_WS(operandText, SEG_OFF_CHR);
 				str_code_hdw(operandText, RULONG(code));
+				ci->target = RULONG(code);
 
 				code += sizeof(int32_t) + sizeof(int16_t);
 				codeOffset += sizeof(int32_t) + sizeof(int16_t);
@@ -1048,6 +1050,7 @@ _ExtractModRM:
 
 			/* Just make sure the offset is output correctly. */
 			reloff = ((joff < 0) ? (codeOffset - abs(joff) + 1) : (codeOffset + joff + 1));
+			ci->target = reloff;
 #ifdef SUPPORT_64BIT_OFFSET
 			str_off64(operandText, reloff);
 #else
@@ -1069,6 +1072,7 @@ _ExtractModRM:
 
 				if (totalPrefixes & INST_PRE_OP_SIZE) strcat_WSN(operandText, SMALL_OPERAND);
 				reloff = ((joff < 0) ? (codeOffset - abs(joff) + 2) : (codeOffset + joff + 2));
+				ci->target = (uint16_t)reloff;
 
 				str_code_hw(operandText, (uint16_t)((joff < 0) ? (codeOffset - abs(joff) + 2) : (codeOffset + joff + 2)));
 
@@ -1085,6 +1089,7 @@ _ExtractModRM:
 				if (totalPrefixes & INST_PRE_OP_SIZE) strcat_WSN(operandText, LARGE_OPERAND);
 
 				reloff = ((joff < 0) ? (codeOffset - abs(joff) + 4) : (codeOffset + joff + 4));
+				ci->target = reloff;
 #ifdef SUPPORT_64BIT_OFFSET
 				str_off64(operandText, reloff);
 #else
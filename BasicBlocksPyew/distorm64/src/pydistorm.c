@@ -22,10 +22,61 @@ _DLLEXPORT_ void initdistorm()
 	PyModule_AddIntConstant(distormModule, "Decode32Bits", Decode32Bits);
 	PyModule_AddIntConstant(distormModule, "Decode64Bits", Decode64Bits);
 	PyModule_AddIntConstant(distormModule, "OffsetTypeSize", sizeof(_OffsetType) * 8);
+	PyModule_AddIntConstant(distormModule, "FC_NONE", FC_NONE);
+	PyModule_AddIntConstant(distormModule, "FC_CALL", FC_CALL);
+	PyModule_AddIntConstant(distormModule, "FC_RET", FC_RET);
+	PyModule_AddIntConstant(distormModule, "FC_SYS", FC_SYS);
+	PyModule_AddIntConstant(distormModule, "FC_UNC_BRANCH", FC_UNC_BRANCH);
+	PyModule_AddIntConstant(distormModule, "FC_CND_BRANCH", FC_CND_BRANCH);
+	PyModule_AddIntConstant(distormModule, "FC_INT", FC_INT);
+	PyModule_AddIntConstant(distormModule, "FC_HLT", FC_HLT);
+	PyModule_AddIntConstant(distormModule, "O_NONE", O_NONE);
+	PyModule_AddIntConstant(distormModule, "O_REG", O_REG);
+	PyModule_AddIntConstant(distormModule, "O_IMM", O_IMM);
+	PyModule_AddIntConstant(distormModule, "O_MEM", O_MEM);
+	PyModule_AddIntConstant(distormModule, "O_PC", O_PC);
+	PyModule_AddIntConstant(distormModule, "O_PTR", O_PTR);
+	PyModule_AddIntConstant(distormModule, "CFG_BLOCK_FUNCTION", CFG_BLOCK_FUNCTION);
+	PyModule_AddIntConstant(distormModule, "CFG_EDGE_FALLTHROUGH", CFG_EDGE_FALLTHROUGH);
+	PyModule_AddIntConstant(distormModule, "CFG_EDGE_BRANCH", CFG_EDGE_BRANCH);
+	PyModule_AddIntConstant(distormModule, "CFG_EDGE_CALL", CFG_EDGE_CALL);
 	PyModule_AddStringConstant(distormModule, "info", ":[diStorm64 1.7.30}:\r\nCopyright RageStorm (C) 2008, Gil Dabah \r\n\r\ndiStorm is licensed under the BSD license.\r\nhttp://ragestorm.net/distorm/\r\n");
 }
 
 #define MAX_INSTRUCTIONS 1000
+
+/* Parse the arguments Decode and Decompose share, returns FALSE with a python exception set on failure. */
+static int parse_decode_args(PyObject* pArgs, _OffsetType* codeOffset, uint8_t** code, int* codeLen, _DecodeType* dt)
+{
+	PyObject* dtObj = NULL;
+
+	if (!PyArg_ParseTuple(pArgs, _PY_OFF_INT_SIZE_ "s#|O", codeOffset, code, codeLen, &dtObj)) return FALSE;
+
+	if (*code == NULL) {
+		PyErr_SetString(PyExc_IOError, "Error while reading code buffer.");
+		return FALSE;
+	}
+
+	if (*codeLen < 0) {
+		PyErr_SetString(PyExc_OverflowError, "Code buffer is too long.");
+		return FALSE;
+	}
+
+	/* Default parameter. */
+	if (dtObj == NULL) *dt = Decode32Bits;
+	else if (!PyInt_Check(dtObj)) {
+		PyErr_SetString(PyExc_IndexError, "Third parameter must be either Decode16Bits, Decode32Bits or Decode64Bits (integer type).");
+		return FALSE;
+	} else *dt = (_DecodeType)PyInt_AsUnsignedLongMask(dtObj);
+
+	if ((*dt != Decode16Bits) && (*dt != Decode32Bits) && (*dt != Decode64Bits)) {
+		PyErr_SetString(PyExc_IndexError, "Decoding-type must be either Decode16Bits, Decode32Bits or Decode64Bits.");
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
 PyObject* distorm_Decode(PyObject* pSelf, PyObject* pArgs)
 {
 	_DecodeType dt;
@@ -39,34 +90,12 @@ PyObject* distorm_Decode(PyObject* pSelf, PyObject* pArgs)
 
 	uint8_t instructionText[MAX_TEXT_SIZE*2];
 
-	PyObject *ret = NULL, *pyObj = NULL, *dtObj = NULL;
+	PyObject *ret = NULL, *pyObj = NULL;
 
 	pSelf = pSelf; /* UNREFERENCED_PARAMETER */
 
 	/* Decode(int32/64 offset, string code, int type=Decode32Bits) */
-	if (!PyArg_ParseTuple(pArgs, _PY_OFF_INT_SIZE_ "s#|O", &codeOffset, &code, &codeLen, &dtObj)) return NULL;
-
-	if (code == NULL) {
-		PyErr_SetString(PyExc_IOError, "Error while reading code buffer.");
-		return NULL;
-	}
-
-	if (codeLen < 0) {
-		PyErr_SetString(PyExc_OverflowError, "Code buffer is too long.");
-		return NULL;
-	}
-
-	/* Default parameter. */
-	if (dtObj == NULL) dt = Decode32Bits;
-	else if (!PyInt_Check(dtObj)) {
-		PyErr_SetString(PyExc_IndexError, "Third parameter must be either Decode16Bits, Decode32Bits or Decode64Bits (integer type).");
-		return NULL;
-	} else dt = (_DecodeType)PyInt_AsUnsignedLongMask(dtObj);
-
-	if ((dt != Decode16Bits) && (dt != Decode32Bits) && (dt != Decode64Bits)) {
-		PyErr_SetString(PyExc_IndexError, "Decoding-type must be either Decode16Bits, Decode32Bits or Decode64Bits.");
-		return NULL;
-	}
+	if (!parse_decode_args(pArgs, &codeOffset, &code, &codeLen, &dt)) return NULL;
 
 	/* Construct an empty list, which later will be filled with tuples of (offset, size, mnemonic, hex). */
 	ret = PyList_New(0);
@@ -117,3 +146,234 @@ PyObject* distorm_Decode(PyObject* pSelf, PyObject* pArgs)
 	return ret;
 }
 
+PyObject* distorm_Decompose(PyObject* pSelf, PyObject* pArgs)
+{
+	_DecodeType dt;
+	uint8_t* code;
+	int codeLen;
+	_OffsetType codeOffset;
+	_DecodeResult res = DECRES_NONE;
+
+	_DInst decomposedInstructions[MAX_INSTRUCTIONS];
+	unsigned int decomposedInstructionsCount = 0, i = 0, next = 0;
+	_DInst* pdi;
+
+	PyObject *ret = NULL, *pyObj = NULL, *mnemonic = NULL;
+
+	/* Mnemonics live in the instructions DB, so each one is made into an interned python string only once. */
+	static PyObject* mnemonics = NULL;
+
+	pSelf = pSelf; /* UNREFERENCED_PARAMETER */
+
+	/* Decompose(int32/64 offset, string code, int type=Decode32Bits) */
+	if (!parse_decode_args(pArgs, &codeOffset, &code, &codeLen, &dt)) return NULL;
+
+	if ((mnemonics == NULL) && ((mnemonics = PyDict_New()) == NULL)) return NULL;
+
+	/* Construct an empty list, which later will be filled with tuples of (offset, size, mnemonic, flow control, operands, target). */
+	ret = PyList_New(0);
+	if (ret == NULL) {
+		PyErr_SetString(PyExc_MemoryError, "Not enough memory to initialize a list.");
+		return NULL;
+	}
+
+	while (res != DECRES_SUCCESS) {
+		res = internal_decompose(codeOffset, code, codeLen, dt, decomposedInstructions, MAX_INSTRUCTIONS, &decomposedInstructionsCount);
+
+		if ((res == DECRES_MEMORYERR) && (decomposedInstructionsCount == 0)) break;
+
+		for (i = 0; i < decomposedInstructionsCount; i++) {
+			pdi = &decomposedInstructions[i];
+
+			if (pdi->mnemonic != NULL) {
+				pyObj = PyLong_FromVoidPtr((void*)pdi->mnemonic);
+				if (pyObj == NULL) {
+					Py_DECREF(ret);
+					return NULL;
+				}
+				mnemonic = PyDict_GetItem(mnemonics, pyObj); /* Borrowed reference. */
+				if (mnemonic == NULL) {
+					mnemonic = PyString_FromStringAndSize((const char*)&pdi->mnemonic[1], pdi->mnemonic[0]);
+					if (mnemonic != NULL) {
+						PyString_InternInPlace(&mnemonic);
+						if (PyDict_SetItem(mnemonics, pyObj, mnemonic) == -1) Py_CLEAR(mnemonic);
+						else Py_DECREF(mnemonic); /* The dict holds it now. */
+					}
+				}
+				Py_DECREF(pyObj);
+				if (mnemonic == NULL) {
+					Py_DECREF(ret);
+					return NULL;
+				}
+			} else mnemonic = Py_None;
+
+			pyObj = Py_BuildValue("(" _PY_OFF_INT_SIZE_ "bOb(bbbb)" _PY_OFF_INT_SIZE_ ")", pdi->offset, pdi->size, mnemonic, pdi->flowControl,
+			                      pdi->ops[0], pdi->ops[1], pdi->ops[2], pdi->ops[3], pdi->target);
+			if (pyObj == NULL) {
+				Py_DECREF(ret);
+				PyErr_SetString(PyExc_MemoryError, "Not enough memory to append an item into the list.");
+				return NULL;
+			}
+			if (PyList_Append(ret, pyObj) == -1) {
+				Py_DECREF(pyObj);
+				Py_DECREF(ret);
+				PyErr_SetString(PyExc_MemoryError, "Not enough memory to append an item into the list.");
+				return NULL;
+			}
+			Py_DECREF(pyObj);
+		}
+
+		/* Get offset difference. */
+		next = (unsigned int)(decomposedInstructions[decomposedInstructionsCount-1].offset - codeOffset);
+		next += decomposedInstructions[decomposedInstructionsCount-1].size;
+
+		/* Advance ptr and recalc offset. */
+		code += next;
+		codeLen -= next;
+		codeOffset += next;
+	}
+
+	return ret;
+}
+
+PyObject* distorm_Lengths(PyObject* pSelf, PyObject* pArgs)
+{
+	_DecodeType dt = Decode32Bits;
+	uint8_t* code;
+	int codeLen;
+	unsigned int count = 0;
+
+	PyObject *sizes = NULL, *flows = NULL, *ret = NULL;
+
+	pSelf = pSelf; /* UNREFERENCED_PARAMETER */
+
+	/* Lengths(string code, int type=Decode32Bits) */
+	if (!PyArg_ParseTuple(pArgs, "s#|i", &code, &codeLen, &dt)) return NULL;
+
+	if ((code == NULL) || (codeLen < 0)) {
+		PyErr_SetString(PyExc_IOError, "Error while reading code buffer.");
+		return NULL;
+	}
+
+	if ((dt != Decode16Bits) && (dt != Decode32Bits) && (dt != Decode64Bits)) {
+		PyErr_SetString(PyExc_IndexError, "Decoding-type must be either Decode16Bits, Decode32Bits or Decode64Bits.");
+		return NULL;
+	}
+
+	/* Every instruction takes a byte at least, the strings are cut to the instructions count afterwards. */
+	sizes = PyString_FromStringAndSize(NULL, codeLen + 1);
+	flows = PyString_FromStringAndSize(NULL, codeLen + 1);
+	if ((sizes == NULL) || (flows == NULL)) {
+		Py_XDECREF(sizes);
+		Py_XDECREF(flows);
+		return NULL;
+	}
+
+	internal_lengths(code, codeLen, dt, (uint8_t*)PyString_AS_STRING(sizes), (uint8_t*)PyString_AS_STRING(flows), codeLen + 1, &count);
+
+	/* _PyString_Resize releases the string on failure. */
+	if (_PyString_Resize(&sizes, count) < 0) {
+		Py_DECREF(flows);
+		return NULL;
+	}
+	if (_PyString_Resize(&flows, count) < 0) {
+		Py_DECREF(sizes);
+		return NULL;
+	}
+
+	ret = PyTuple_Pack(2, sizes, flows);
+	Py_DECREF(sizes);
+	Py_DECREF(flows);
+	return ret;
+}
+
+PyObject* distorm_Cfg(PyObject* pSelf, PyObject* pArgs)
+{
+	_DecodeType dt;
+	uint8_t* code;
+	int codeLen;
+	_OffsetType codeOffset;
+	_DecodeResult res;
+
+	PyObject *entriesObj = NULL, *entriesSeq = NULL, *blocks = NULL, *edges = NULL, *pyObj = NULL;
+	_OffsetType* entries = NULL;
+	unsigned int entriesCount = 0, threads = 0, i = 0;
+	_CfgResult cfg;
+
+	pSelf = pSelf; /* UNREFERENCED_PARAMETER */
+
+	/* Cfg(int32/64 offset, string code, int type, list entries, int threads=0) */
+	if (!PyArg_ParseTuple(pArgs, _PY_OFF_INT_SIZE_ "s#iO|I", &codeOffset, &code, &codeLen, &dt, &entriesObj, &threads)) return NULL;
+
+	if ((code == NULL) || (codeLen < 0)) {
+		PyErr_SetString(PyExc_IOError, "Error while reading code buffer.");
+		return NULL;
+	}
+
+	if ((dt != Decode16Bits) && (dt != Decode32Bits) && (dt != Decode64Bits)) {
+		PyErr_SetString(PyExc_IndexError, "Decoding-type must be either Decode16Bits, Decode32Bits or Decode64Bits.");
+		return NULL;
+	}
+
+	entriesSeq = PySequence_Fast(entriesObj, "Fourth parameter must be a sequence of offsets.");
+	if (entriesSeq == NULL) return NULL;
+
+	entriesCount = (unsigned int)PySequence_Fast_GET_SIZE(entriesSeq);
+	entries = (_OffsetType*)PyMem_Malloc((entriesCount + 1) * sizeof(_OffsetType));
+	if (entries == NULL) {
+		Py_DECREF(entriesSeq);
+		return PyErr_NoMemory();
+	}
+
+	for (i = 0; i < entriesCount; i++) {
+#ifdef SUPPORT_64BIT_OFFSET
+		entries[i] = PyInt_AsUnsignedLongLongMask(PySequence_Fast_GET_ITEM(entriesSeq, i));
+#else
+		entries[i] = PyInt_AsUnsignedLongMask(PySequence_Fast_GET_ITEM(entriesSeq, i));
+#endif
+		if (PyErr_Occurred()) {
+			PyMem_Free(entries);
+			Py_DECREF(entriesSeq);
+			return NULL;
+		}
+	}
+	Py_DECREF(entriesSeq);
+
+	/* The analysis doesn't touch any python object, let other python threads run meanwhile. */
+	Py_BEGIN_ALLOW_THREADS
+	res = internal_cfg(codeOffset, code, codeLen, dt, entries, entriesCount, threads, &cfg);
+	Py_END_ALLOW_THREADS
+
+	PyMem_Free(entries);
+
+	if (res != DECRES_SUCCESS) return PyErr_NoMemory();
+
+	blocks = PyList_New(cfg.blocksCount);
+	edges = PyList_New(cfg.edgesCount);
+	if ((blocks == NULL) || (edges == NULL)) goto fail;
+
+	for (i = 0; i < cfg.blocksCount; i++) {
+		pyObj = Py_BuildValue("(" _PY_OFF_INT_SIZE_ "III)", cfg.blocks[i].address, cfg.blocks[i].size, cfg.blocks[i].instructions, cfg.blocks[i].flags);
+		if (pyObj == NULL) goto fail;
+		PyList_SET_ITEM(blocks, i, pyObj); /* Steals the reference. */
+	}
+
+	for (i = 0; i < cfg.edgesCount; i++) {
+		pyObj = Py_BuildValue("(" _PY_OFF_INT_SIZE_ _PY_OFF_INT_SIZE_ "I)", cfg.edges[i].from, cfg.edges[i].to, cfg.edges[i].type);
+		if (pyObj == NULL) goto fail;
+		PyList_SET_ITEM(edges, i, pyObj);
+	}
+
+	cfg_free(&cfg);
+
+	pyObj = PyTuple_Pack(2, blocks, edges);
+	Py_DECREF(blocks);
+	Py_DECREF(edges);
+	return pyObj;
+
+fail:
+	Py_XDECREF(blocks);
+	Py_XDECREF(edges);
+	cfg_free(&cfg);
+	return PyErr_NoMemory();
+}
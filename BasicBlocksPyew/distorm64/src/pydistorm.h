@@ -20,6 +20,8 @@ This library is licensed under the BSD license. See the file COPYING.
 #endif
 
 #include "decoder.h"
+#include "cfg.h"
+#include "lengths.h"
 
 #ifdef __GNUC__
  #include <python2.5/Python.h>
@@ -28,6 +30,9 @@ This library is licensed under the BSD license. See the file COPYING.
 #endif
 
 PyObject* distorm_Decode(PyObject* pSelf, PyObject* pArgs);
+PyObject* distorm_Decompose(PyObject* pSelf, PyObject* pArgs);
+PyObject* distorm_Lengths(PyObject* pSelf, PyObject* pArgs);
+PyObject* distorm_Cfg(PyObject* pSelf, PyObject* pArgs);
 
 char distorm_Decode_DOCSTR[] =
 "Disassemble a given buffer.\r\n"
@@ -42,8 +47,48 @@ char distorm_Decode_DOCSTR[] =
 "	Decode64Bits - AMD64 decoding.\r\n"
 "Returns a list of tuples of offset, size, mnemonic and hex string.\r\n";
 
+char distorm_Decompose_DOCSTR[] =
+"Decompose a given buffer, without formatting any text.\r\n"
+#ifdef SUPPORT_64BIT_OFFSET
+	"Decompose(INT64 offset, string code, int type)\r\n"
+#else
+	"Decompose(unsigned long offset, string code, int type)\r\n"
+#endif
+"type:\r\n"
+"	Decode16Bits - 16 bits decoding.\r\n"
+"	Decode32Bits - 32 bits decoding.\r\n"
+"	Decode64Bits - AMD64 decoding.\r\n"
+"Returns a list of tuples of offset, size, mnemonic, flow control (FC_*), operand kinds (O_*) and branch target.\r\n"
+"The mnemonic is None for a byte which couldn't be decoded.\r\n";
+
+char distorm_Lengths_DOCSTR[] =
+"Measure the instructions of a given buffer, without decoding them.\r\n"
+"Lengths(string code, int type)\r\n"
+"type:\r\n"
+"	Decode16Bits - 16 bits decoding.\r\n"
+"	Decode32Bits - 32 bits decoding.\r\n"
+"	Decode64Bits - AMD64 decoding.\r\n"
+"Returns a tuple of two strings with a byte per instruction, its size and its flow control (FC_*).\r\n"
+"The instructions are the same as Decompose's.\r\n";
+
+char distorm_Cfg_DOCSTR[] =
+"Recover the basic blocks and control flow graph of a given code buffer.\r\n"
+#ifdef SUPPORT_64BIT_OFFSET
+	"Cfg(INT64 offset, string code, int type, list entries, int threads)\r\n"
+#else
+	"Cfg(unsigned long offset, string code, int type, list entries, int threads)\r\n"
+#endif
+"entries - Offsets of the functions to start from, e.g: the entry point and exports.\r\n"
+"threads - Number of threads to analyze the functions with, 0 (default) for a thread per processor.\r\n"
+"Returns a tuple of the blocks and the edges lists, both sorted by offset.\r\n"
+"A block is a tuple of offset, size, instructions count and flags (CFG_BLOCK_*).\r\n"
+"An edge is a tuple of the offset of its block, the offset of the target block and type (CFG_EDGE_*).\r\n";
+
 static PyMethodDef distormModulebMethods[] = {
     {"Decode", distorm_Decode, METH_VARARGS, distorm_Decode_DOCSTR},
+    {"Decompose", distorm_Decompose, METH_VARARGS, distorm_Decompose_DOCSTR},
+    {"Lengths", distorm_Lengths, METH_VARARGS, distorm_Lengths_DOCSTR},
+    {"Cfg", distorm_Cfg, METH_VARARGS, distorm_Cfg_DOCSTR},
     {NULL, NULL, 0, NULL}
 };
 
@@ -79,6 +79,7 @@ uint8_t Nibble2ChrTable[16] = {'0', '1', '2', '3', '4', '5', '6', '7', '8', '9',
 
 void _FASTCALL_ str_hex_b(_WString* s, unsigned int x)
 {
+	if (s == NULL) return;
 	/*
 	 * Skip first character (space).
 	 * Fixed length of 4 including null terminate character. Use one word copy.
@@ -90,6 +91,7 @@ void _FASTCALL_ str_hex_b(_WString* s, unsigned int x)
 
 void _FASTCALL_ str_code_hb(_WString* s, unsigned int x)
 {
+	if (s == NULL) return;
 	x &= 255;
 	/* Skip first character (space). */
 
@@ -105,6 +107,7 @@ void _FASTCALL_ str_code_hb(_WString* s, unsigned int x)
 
 void _FASTCALL_ str_hex_sp_b(_WString* s, unsigned int x)
 {
+	if (s == NULL) return;
 	/* Fixed length of 4 including null terminate character. Use one dword copy. */
 	*(int32_t*)&s->p[s->pos] = *(int32_t*)&TextBTable[x & 255];
 	s->pos += sizeof(int32_t) - 1;
@@ -112,6 +115,7 @@ void _FASTCALL_ str_hex_sp_b(_WString* s, unsigned int x)
 
 void _FASTCALL_ str_code_sp_hb(_WString* s, unsigned int x)
 {
+	if (s == NULL) return;
 	x &= 255;
 
 	if (x < 0x10) {	/* < 0x10 has a fixed length of 5 including null terminate. */
@@ -130,6 +134,8 @@ void _FASTCALL_ str_hex_sp_w(_WString* s, unsigned int x)
 	int8_t* buf;
 	unsigned int t = (uint8_t)((x >> 4) & 0xf);
 
+	if (s == NULL) return;
+
 	buf = &s->p[s->pos];
 	s->pos += 5;
 
@@ -153,6 +159,9 @@ void _FASTCALL_ str_code_hw(_WString* s, unsigned int x)
 	int8_t* buf;
 	int i = 0;
 	unsigned int t = (uint8_t)((x >> 12) & 0xf);
+
+	if (s == NULL) return;
+
 	buf = &s->p[s->pos];
 
 	buf[0] = '0';
@@ -179,6 +188,8 @@ void _FASTCALL_ str_hex_sp_dw(_WString* s, uint32_t x)
 	int8_t* buf;
 	unsigned int t = (uint8_t)((x >> 4) & 0xf);
 
+	if (s == NULL) return;
+
 	buf = &s->p[s->pos];
 	s->pos += 9;
 
@@ -215,6 +226,8 @@ void _FASTCALL_ str_code_hdw(_WString* s, uint32_t x)
 	int i = 0, shift = 0;
 	unsigned int t = 0;
 
+	if (s == NULL) return;
+
 	buf = &s->p[s->pos];
 
 	buf[0] = '0';
@@ -238,6 +251,8 @@ void _FASTCALL_ str_hex_sp_qw(_WString* s, uint8_t src[8])
 	uint32_t x = RULONG(src);
 	int t = (uint8_t)((x >> 4) & 0xf);
 
+	if (s == NULL) return;
+
 	buf = &s->p[s->pos];
 	s->pos += 17;
 
@@ -301,6 +316,8 @@ void _FASTCALL_ str_code_hqw(_WString* s, uint8_t src[8])
 	uint32_t x = RULONG(&src[sizeof(int32_t)]);
 	int t;
 
+	if (s == NULL) return;
+
 	buf = &s->p[s->pos];
 	buf[0] = '0';
 	buf[1] = 'x';
@@ -330,6 +347,8 @@ void _FASTCALL_ str_off64(_WString* s, OFFSET_INTEGER x)
 	int i = 0, shift = 0;
 	OFFSET_INTEGER t = 0;
 
+	if (s == NULL) return;
+
 	buf = &s->p[s->pos];
 
 	buf[0] = '0';
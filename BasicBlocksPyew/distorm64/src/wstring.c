@@ -10,18 +10,21 @@ This library is licensed under the BSD license. See the file COPYING.
 
 void _FASTCALL_ strcpy_WS(_WString* s, const int8_t* buf)
 {
+	if (s == NULL) return;
 	s->pos = (unsigned int)strlen((const char*)buf);
 	memcpy((int8_t*)s->p, buf, s->pos + 1);
 }
 
 void _FASTCALL_ strcpylen_WS(_WString* s, const int8_t* buf, unsigned int len)
 {
+	if (s == NULL) return;
 	s->pos = len;
 	memcpy((int8_t*)s->p, buf, len + 1);
 }
 
 void _FASTCALL_ strcatlen_WS(_WString* s, const int8_t* buf, unsigned int len)
 {
+	if (s == NULL) return;
 	memcpy((int8_t*)&s->p[s->pos], buf, len + 1);
 	s->pos += len;
 }
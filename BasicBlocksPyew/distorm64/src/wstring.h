@@ -27,18 +27,24 @@ typedef struct {
 #define strcat_WSN(s, t) strcatlen_WS((s), (t), sizeof((t))-1)
 #define strcpy_WSN(s, t) strcpylen_WS((s), (t), sizeof((t))-1)
 
+/*
+ * All the string functions (here and in textdefs.h) ignore a NULL string.
+ * The decomposer runs the same decoding code without any text output this way.
+ */
 void _FASTCALL_ strcpy_WS(_WString* s, const int8_t* buf);
 void _FASTCALL_ strcpylen_WS(_WString* s, const int8_t* buf, unsigned int len);
 void _FASTCALL_ strcatlen_WS(_WString* s, const int8_t* buf, unsigned int len);
 
 _INLINE_ void strclear_WS(_WString* s)
 {
+	if (s == NULL) return;
 	s->p[0] = '\0';
 	s->pos = 0;
 }
 
 _INLINE_ void chrcat_WS(_WString* s, uint8_t ch)
 {
+	if (s == NULL) return;
 	s->p[s->pos] = ch;
 	s->p[s->pos + 1] = '\0';
 	s->pos += 1;
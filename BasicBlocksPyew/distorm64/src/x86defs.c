@@ -84,3 +84,6 @@ _InstInfo II_arpl = {INT_INFO, ISCT_INTEGER, OT_REG16, OT_RM16, (int8_t*) "\x04"
 _InstInfoEx II_movsxd = {INT_INFO, ISCT_INTEGER, OT_RM16_32, OT_REG64, (int8_t*) "\x07" "MOVZXDW", INST_INCLUDE_MODRM | INST_USE_EXMNEMONIC | INST_USE_EXMNEMONIC2 | INST_PRE_REX | INST_64BITS, OT_NONE, OT_NONE, (int8_t*) "\x06" "MOVZXD", (int8_t*)"\x06" "MOVSXD"};
 
 _InstInfo II_nop = {INT_INFO, ISCT_INTEGER, OT_NONE, OT_NONE, (int8_t*) "\x03" "NOP", INST_EXCLUDE_MODRM};
+
+/* A dropped WAIT is still a valid instruction, the decomposer needs its DB style mnemonic. */
+_InstInfo II_wait = {INT_INFO, ISCT_FPU, OT_NONE, OT_NONE, (int8_t*) "\x04" "WAIT", INST_EXCLUDE_MODRM};
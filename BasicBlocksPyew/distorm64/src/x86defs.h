@@ -142,6 +142,7 @@ extern _InstInfoEx II_movsxd;
  */
 #define INST_NOP_INDEX (0x90)
 extern _InstInfo II_nop;
+extern _InstInfo II_wait;
 
 _INLINE_ void str_x86def(_WString* s, _DefText* d)
 {
@@ -149,6 +150,7 @@ _INLINE_ void str_x86def(_WString* s, _DefText* d)
 	 * Copy 2 aligned dwords to speed up things.
 	 * _WString should have that extra space, most of the times it will simply copy null-termianting characters.
 	 */
+	if (s == NULL) return;
 	*(int32_t*)&s->p[s->pos] = *(int32_t*)d->p;
 	*(int32_t*)&s->p[s->pos + sizeof(int32_t)] = *(int32_t*)&d->p[sizeof(int32_t)];
 	s->pos += d->size;
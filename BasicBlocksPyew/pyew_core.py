@@ -60,6 +60,15 @@ except:
     except:
         pass
 
+# Native basic blocks recovery, only in diStorm builds which ship it
+try:
+    from pydistorm import Cfg
+except:
+    try:
+        from distorm import Cfg
+    except:
+        Cfg = None
+
 from anal.x86analyzer import CX86CodeAnalyzer
 
 from config import PLUGINS_PATH
@@ -425,6 +434,26 @@ class CPyew:
             self.log("\b"*80 + "Searching typical function's prologs..." + " "*20)
             self.createIntelFunctionsByPrologs()
 
+    def findNativeBasicBlocks(self, threads=0):
+        """ Basic blocks reachable from the entry point, the exports and the
+        functions found so far, recovered by diStorm instead of the python
+        code analyzer. Returns a list of (offset, size, instructions, flags)
+        tuples sorted by offset, or None if diStorm doesn't support it. """
+        if Cfg is None or self.processor != "intel":
+            return None
+        
+        if self.type == 64:
+            dt = Decode64Bits
+        else:
+            dt = Decode32Bits
+        
+        entries = set([self.ep])
+        entries.update(self.exports.keys())
+        entries.update(self.functions.keys())
+        
+        blocks, edges = Cfg(0, self.getBuffer(), dt, entries, threads)
+        return blocks
+
     def findFunctions(self, proc):
         if proc == "intel":
             t = time.time()
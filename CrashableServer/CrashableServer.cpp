@@ -11,23 +11,32 @@
 
 typedef int socklen_t;
 
+inline long AtomicAdd(volatile long* value, long delta) { return InterlockedExchangeAdd(value, delta); }
+
 #else
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <sys/epoll.h>
+#endif
+
 typedef int SOCKET;
 
 struct WSAData {};
 
 #define SOCKET_ERROR -1
 #define INVALID_SOCKET -1
+#define WSAEMSGSIZE EMSGSIZE
 #define _tmain main
 
 #define MAKEDWORD(a,b) (0)
@@ -38,37 +47,120 @@ struct WSAData {};
 inline int closesocket(int s) { return close(s); }
 inline void WSACleanup() {}
 inline int WSAGetLastError() { return errno; }
+inline void Sleep(int ms) { usleep(ms * 1000); }
+inline long AtomicAdd(volatile long* value, long delta) { return __sync_fetch_and_add(value, delta); }
 
 #endif
 
 const int kDefaultServerPort = 4242;
 const int kBufferSize = 1024;
+const int kDefaultBacklog = 1;
+const int kMaxThreads = 64;
+const int kMaxEvents = 64;
+
+struct Options
+{
+	const char* host;
+	int port;
+	int backlog;
+	int threads;
+	bool udp;
+	bool stats;
+	bool quiet;
+};
+
+typedef void (*WorkerFunc)(SOCKET socket);
+
+struct WorkerArgs
+{
+	WorkerFunc func;
+	SOCKET socket;
+};
+
+Options options;
 
-SOCKET SetUpListener(const char* host, int port);
+// Totals since startup, the stats thread prints the difference every second
+volatile long totalConnections = 0;
+volatile long totalPackets = 0;
+volatile long totalBytes = 0;
+
+SOCKET SetUpListener(const char* host, int port, int backlog);
+SOCKET SetUpDatagramSocket(const char* host, int port);
 SOCKET AcceptConnection(SOCKET listener, sockaddr_in* remote);
 bool EchoIncomingPackets(SOCKET socket);
-int Run(const char* host, int port);
+bool ReceiveDatagrams(SOCKET socket);
+bool StartThread(WorkerFunc func, SOCKET socket);
+void AcceptWorker(SOCKET listener);
+void DatagramWorker(SOCKET socket);
+void StatsWorker(SOCKET unused);
+int RunSingle(SOCKET listener);
+int Run();
+
+void Usage(const char* name)
+{
+	fprintf(stderr, "usage: %s <server-address> [server-port] [options]\n", name);
+	fprintf(stderr, "\tIf you don't pass server-port, it defaults to %d.\n", kDefaultServerPort);
+	fprintf(stderr, "options:\n");
+	fprintf(stderr, "\t-udp          Receive datagrams instead of tcp connections.\n");
+	fprintf(stderr, "\t-threads <n>  Serve with n threads (epoll on linux) instead of a connection at a time.\n");
+	fprintf(stderr, "\t-backlog <n>  Listen backlog, defaults to %d.\n", kDefaultBacklog);
+	fprintf(stderr, "\t-stats        Print connections, packets and bytes received per second.\n");
+	fprintf(stderr, "\t-quiet        Don't print every connection and packet.\n");
+}
 
 int main(int argc, char* argv[])
 {
 	WSAData wsaData;
 	int ret;
-	const char* host;
-	int port;
+	int arg;
 	int retval = 0;
 
 	// Do we have enough command line arguments?
 	if (argc < 2) {
-		fprintf(stderr, "usage: %s <server-address> [server-port]\n", argv[0]);
-		fprintf(stderr, "\tIf you don't pass server-port, it defaults to %d.\n", kDefaultServerPort);
+		Usage(argv[0]);
 		return 1;
 	}
 
-	host = argv[1];
-	port = (argc >= 3) ? atoi(argv[2]) : kDefaultServerPort;
+	memset(&options, 0, sizeof(options));
+	options.host = argv[1];
+	options.port = kDefaultServerPort;
+	options.backlog = kDefaultBacklog;
+
+	arg = 2;
+	if (arg < argc && argv[arg][0] != '-')
+		options.port = atoi(argv[arg++]);
+
+	for (; arg < argc; ++arg) {
+		if (strcmp(argv[arg], "-udp") == 0) {
+			options.udp = true;
+		}
+		else if (strcmp(argv[arg], "-threads") == 0 && arg + 1 < argc) {
+			options.threads = atoi(argv[++arg]);
+		}
+		else if (strcmp(argv[arg], "-backlog") == 0 && arg + 1 < argc) {
+			options.backlog = atoi(argv[++arg]);
+		}
+		else if (strcmp(argv[arg], "-stats") == 0) {
+			options.stats = true;
+		}
+		else if (strcmp(argv[arg], "-quiet") == 0) {
+			options.quiet = true;
+		}
+		else {
+			fprintf(stderr, "Unknown argument '%s'.\n", argv[arg]);
+			Usage(argv[0]);
+			return 1;
+		}
+	}
+
+	if (options.threads < 0 || options.threads > kMaxThreads) {
+		fprintf(stderr, "Threads must be between 0 and %d.\n", kMaxThreads);
+		return 1;
+	}
 
-	if (argc > 3) {
-		fprintf(stderr, "%d extra argument%s ignored.  FYI.\n", argc - 3, argc == 4 ? "" : "s");
+	if (options.backlog < 1) {
+		fprintf(stderr, "Backlog must be at least 1.\n");
+		return 1;
 	}
 
 	if ((ret = WSAStartup(MAKEWORD(1, 1), &wsaData)) != 0) {
@@ -78,7 +170,7 @@ int main(int argc, char* argv[])
 
 	__try
 	{
-		retval = Run(host, port);
+		retval = Run();
 	}
 	__except(GetExceptionCode() == EXCEPTION_ACCESS_VIOLATION)
 	{
@@ -89,23 +181,65 @@ int main(int argc, char* argv[])
 	return retval;
 }
 
-int Run(const char* host, int port)
+int Run()
 {
 	SOCKET listener;
+	int i;
+
+	printf("Establishing the %s...\n", options.udp ? "socket" : "listener");
 
-	printf("Establishing the listener...\n");
+	if (options.udp)
+		listener = SetUpDatagramSocket(options.host, htons((u_short)options.port));
+	else
+		listener = SetUpListener(options.host, htons((u_short)options.port), options.backlog);
 
-	listener = SetUpListener(host, htons((u_short)port));
 	if (listener == INVALID_SOCKET) {
 		fprintf(stderr, "\nestablish listener error: %d\n", WSAGetLastError());
 		return 3;
 	}
 
+	if (options.stats && !StartThread(StatsWorker, INVALID_SOCKET)) {
+		fprintf(stderr, "\nstart stats thread error: %d\n", WSAGetLastError());
+		return 3;
+	}
+
+	if (options.threads == 0)
+	{
+		if (options.udp) {
+			if (!ReceiveDatagrams(listener)) {
+				fprintf(stderr, "\nreceive datagrams error: %d\n", WSAGetLastError());
+				return 3;
+			}
+
+			return 0;
+		}
+
+		return RunSingle(listener);
+	}
+
+	printf("Starting %d threads...\n", options.threads);
+
+	for (i = 0; i < options.threads; ++i) {
+		if (!StartThread(options.udp ? DatagramWorker : AcceptWorker, listener)) {
+			fprintf(stderr, "\nstart thread error: %d\n", WSAGetLastError());
+			return 3;
+		}
+	}
+
+	// The workers exit the process on errors
+	for (;;)
+		Sleep(1000);
+}
+
+// Serve a connection at a time
+int RunSingle(SOCKET listener)
+{
 	for (;;) {
 		SOCKET socket;
 		sockaddr_in remote;
 
-		printf("Waiting for a connection...\n");
+		if (!options.quiet)
+			printf("Waiting for a connection...\n");
 
 		socket = AcceptConnection(listener, &remote);
 		if (socket == INVALID_SOCKET) {
@@ -113,27 +247,32 @@ int Run(const char* host, int port)
 			return 3;
 		}
 
-		printf("Accepted connection from %s:%d.\n",
-			inet_ntoa(remote.sin_addr),
-			ntohs(remote.sin_port));
+		AtomicAdd(&totalConnections, 1);
+
+		if (!options.quiet)
+			printf("Accepted connection from %s:%d.\n",
+				inet_ntoa(remote.sin_addr),
+				ntohs(remote.sin_port));
 
 		if (!EchoIncomingPackets(socket)) {
 			fprintf(stderr, "\necho incoming packets error: %d\n", WSAGetLastError());
 			return 3;
 		}
 
-		printf("Shutting connection down...\n");
+		if (!options.quiet)
+			printf("Shutting connection down...\n");
 
 		if (closesocket(socket) != 0) {
 			fprintf(stderr, "\nshutdown connection error: %d\n", WSAGetLastError());
 			return 3;
 		}
 
-		printf("Connection is down.\n");
+		if (!options.quiet)
+			printf("Connection is down.\n");
 	}
 }
 
-SOCKET SetUpListener(const char* host, int port)
+SOCKET SetUpListener(const char* host, int port, int backlog)
 {
 	SOCKET listener;
 	u_long addr;
@@ -160,12 +299,42 @@ SOCKET SetUpListener(const char* host, int port)
 	if (bind(listener, (sockaddr*)&sa, sizeof(sa)) == SOCKET_ERROR)
 		return INVALID_SOCKET;
 
-	if (listen(listener, 1) == SOCKET_ERROR)
+	if (listen(listener, backlog) == SOCKET_ERROR)
 		return INVALID_SOCKET;
 
 	return listener;
 }
 
+SOCKET SetUpDatagramSocket(const char* host, int port)
+{
+	SOCKET sock;
+	u_long addr;
+	sockaddr_in sa;
+	int optval;
+
+	addr = inet_addr(host);
+	if (addr == INADDR_NONE)
+		return INVALID_SOCKET;
+
+	sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+	if (sock == INVALID_SOCKET)
+		return INVALID_SOCKET;
+
+	optval = 1;
+	if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&optval, sizeof(optval)) == SOCKET_ERROR)
+		return INVALID_SOCKET;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sin_family = AF_INET;
+	sa.sin_addr.s_addr = addr;
+	sa.sin_port = (u_short)port;
+
+	if (bind(sock, (sockaddr*)&sa, sizeof(sa)) == SOCKET_ERROR)
+		return INVALID_SOCKET;
+
+	return sock;
+}
+
 SOCKET AcceptConnection(SOCKET listener, sockaddr_in* remote)
 {
 	socklen_t size = sizeof(*remote);
@@ -199,6 +368,20 @@ void CrashMe(char* in)
 	strcat(buff, in);
 }
 
+void OnPacket(char* buf, int len)
+{
+	AtomicAdd(&totalPackets, 1);
+	AtomicAdd(&totalBytes, len);
+
+	if (!options.quiet)
+		printf("Received %d bytes from client.\n", len);
+
+	// Add a silly stack overflow
+	if (len >= 1024) {
+		CrashMe(buf);
+	}
+}
+
 bool EchoIncomingPackets(SOCKET socket)
 {
 	char* buf = (char*)malloc(kBufferSize);
@@ -207,19 +390,227 @@ bool EchoIncomingPackets(SOCKET socket)
 	do {
 		len = recv(socket, buf, kBufferSize, 0);
 		if (len > 0) {
-			printf("Received %d bytes from client.\n", len);
-
-			// Add a silly stack overflow
-			if (len >= 1024) {
-				CrashMe(buf);
-			}
+			OnPacket(buf, len);
 		}
 		else if (len == SOCKET_ERROR) {
+			free(buf);
 			return false;
 		}
 	} while (len != 0);
 
-	printf("Connection closed by peer.\n");
+	if (!options.quiet)
+		printf("Connection closed by peer.\n");
 
+	free(buf);
 	return true;
 }
+
+bool ReceiveDatagrams(SOCKET socket)
+{
+	char* buf = (char*)malloc(kBufferSize);
+	sockaddr_in remote;
+	socklen_t size;
+	int len;
+
+	for (;;) {
+		size = sizeof(remote);
+		len = recvfrom(socket, buf, kBufferSize, 0, (sockaddr*)&remote, &size);
+
+		// Windows fails datagrams which don't fit the buffer, linux truncates them
+		if (len == SOCKET_ERROR && WSAGetLastError() == WSAEMSGSIZE)
+			len = kBufferSize;
+
+		if (len == SOCKET_ERROR) {
+			free(buf);
+			return false;
+		}
+
+		if (len > 0)
+			OnPacket(buf, len);
+	}
+}
+
+#ifdef WIN32
+
+DWORD WINAPI ThreadMain(LPVOID param)
+{
+	WorkerArgs args = *(WorkerArgs*)param;
+	delete (WorkerArgs*)param;
+	args.func(args.socket);
+	return 0;
+}
+
+bool StartThread(WorkerFunc func, SOCKET socket)
+{
+	WorkerArgs* args = new WorkerArgs;
+	HANDLE thread;
+
+	args->func = func;
+	args->socket = socket;
+
+	thread = CreateThread(NULL, 0, ThreadMain, args, 0, NULL);
+	if (thread == NULL) {
+		delete args;
+		return false;
+	}
+
+	CloseHandle(thread);
+	return true;
+}
+
+#else
+
+void* ThreadMain(void* param)
+{
+	WorkerArgs args = *(WorkerArgs*)param;
+	delete (WorkerArgs*)param;
+	args.func(args.socket);
+	return NULL;
+}
+
+bool StartThread(WorkerFunc func, SOCKET socket)
+{
+	WorkerArgs* args = new WorkerArgs;
+	pthread_t thread;
+
+	args->func = func;
+	args->socket = socket;
+
+	if (pthread_create(&thread, NULL, ThreadMain, args) != 0) {
+		delete args;
+		return false;
+	}
+
+	pthread_detach(thread);
+	return true;
+}
+
+#endif
+
+#ifdef __linux__
+
+bool SetNonBlocking(SOCKET socket)
+{
+	int flags = fcntl(socket, F_GETFL, 0);
+	return flags != -1 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) != -1;
+}
+
+// Every worker polls the shared listener and its own connections.
+// A connection gets one recv per wakeup, so packets are still read in kBufferSize chunks.
+void AcceptWorker(SOCKET listener)
+{
+	epoll_event ev;
+	epoll_event events[kMaxEvents];
+	char* buf = (char*)malloc(kBufferSize);
+	int epfd, count, i, len;
+
+	epfd = epoll_create(kMaxEvents);
+	if (epfd == -1 || !SetNonBlocking(listener)) {
+		fprintf(stderr, "\nepoll error: %d\n", errno);
+		exit(3);
+	}
+
+	memset(&ev, 0, sizeof(ev));
+	ev.events = EPOLLIN;
+	ev.data.fd = listener;
+
+	if (epoll_ctl(epfd, EPOLL_CTL_ADD, listener, &ev) == -1) {
+		fprintf(stderr, "\nepoll error: %d\n", errno);
+		exit(3);
+	}
+
+	for (;;) {
+		count = epoll_wait(epfd, events, kMaxEvents, -1);
+		if (count == -1) {
+			if (errno == EINTR)
+				continue;
+
+			fprintf(stderr, "\nepoll error: %d\n", errno);
+			exit(3);
+		}
+
+		for (i = 0; i < count; ++i) {
+			SOCKET socket = events[i].data.fd;
+
+			if (socket == listener) {
+				sockaddr_in remote;
+
+				// Other workers race for the same connections
+				while ((socket = AcceptConnection(listener, &remote)) != INVALID_SOCKET) {
+					AtomicAdd(&totalConnections, 1);
+
+					if (!options.quiet)
+						printf("Accepted connection from %s:%d.\n",
+							inet_ntoa(remote.sin_addr),
+							ntohs(remote.sin_port));
+
+					ev.events = EPOLLIN;
+					ev.data.fd = socket;
+
+					if (!SetNonBlocking(socket) || epoll_ctl(epfd, EPOLL_CTL_ADD, socket, &ev) == -1) {
+						fprintf(stderr, "\nepoll error: %d\n", errno);
+						exit(3);
+					}
+				}
+
+				if (errno != EAGAIN && errno != EWOULDBLOCK && errno != ECONNABORTED && errno != EINTR) {
+					fprintf(stderr, "\naccept connection error: %d\n", errno);
+					exit(3);
+				}
+
+				continue;
+			}
+
+			len = recv(socket, buf, kBufferSize, 0);
+			if (len > 0) {
+				OnPacket(buf, len);
+			}
+			else if (len == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+				if (!options.quiet)
+					printf("Connection closed by peer.\n");
+
+				// Closing removes it from the epoll set
+				closesocket(socket);
+			}
+		}
+	}
+}
+
+#else
+
+// Every worker blocks in accept on the shared listener and serves a connection at a time
+void AcceptWorker(SOCKET listener)
+{
+	exit(RunSingle(listener));
+}
+
+#endif
+
+void DatagramWorker(SOCKET socket)
+{
+	if (!ReceiveDatagrams(socket)) {
+		fprintf(stderr, "\nreceive datagrams error: %d\n", WSAGetLastError());
+		exit(3);
+	}
+}
+
+void StatsWorker(SOCKET unused)
+{
+	long connections = 0, packets = 0, bytes = 0;
+	long c, p, b;
+
+	for (;;) {
+		Sleep(1000);
+
+		c = totalConnections;
+		p = totalPackets;
+		b = totalBytes;
+
+		printf("%ld connections/s, %ld packets/s, %ld bytes/s\n", c - connections, p - packets, b - bytes);
+		fflush(stdout);
+
+		connections = c;
+		packets = p;
+		bytes = b;
+	}
+}
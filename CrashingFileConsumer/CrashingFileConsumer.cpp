@@ -17,28 +17,40 @@
 #include <string.h>
 #include <ctype.h>
 
-void Function2(FILE* fd)
+#include "PersistentHarness.h"
+
+void Function2(const unsigned char* buf, size_t size)
 {
 	char buffer[20];
-	int len = 0;
+	size_t len = 0;
 
-	for(; !feof(fd); len++) buffer[len] = (char)fgetc(fd);
+	for(; len < size; len++) buffer[len] = (char)buf[len];
 	buffer[len] = 0;
 
-	printf("Length of file is %d.\n", len);
+	printf("Length of file is %d.\n", (int)len);
 
 	//if(rand() % 2 == 0)
 	//	memset(buffer, 'A', sizeof(buffer)*1000);
 }
 
-void Function1(FILE* fd)
+void Function1(const unsigned char* buf, size_t size)
+{
+	if(buf != NULL)
+		Function2(buf, size);
+}
+
+int fuzz_one(const unsigned char* buf, size_t len)
 {
-	if(fd != NULL)
-		Function2(fd);
+	Function1(buf, len);
+	return 0;
 }
 
 int _tmain(int argc, char* argv[])
 {
+	// Started by the PersistentProcess monitor, inputs come from peach
+	if(persistent_loop())
+		return 0;
+
 	if(argc < 2)
 	{
 		printf("Error, please supply a filename to load.\n");
@@ -47,23 +59,38 @@ int _tmain(int argc, char* argv[])
 
 	printf("Loading file \"%s\"...\n", argv[1]);
 
-	FILE* fd = fopen(argv[1], "rb+");
+	FILE* fd = fopen(argv[1], "rb");
 	if(fd == NULL)
 	{
 		printf("Error, unable to open file \"%s\".\n", argv[1]);
 		return 0;
 	}
 
+	fseek(fd, 0, SEEK_END);
+	long size = ftell(fd);
+	fseek(fd, 0, SEEK_SET);
+
+	unsigned char* buf = (unsigned char*)malloc(size > 0 ? size : 1);
+	if(buf == NULL || fread(buf, 1, size, fd) != (size_t)size)
+	{
+		printf("Error, unable to read file \"%s\".\n", argv[1]);
+		fclose(fd);
+		free(buf);
+		return 0;
+	}
+
+	fclose(fd);
+
 	__try
 	{
-		Function1(fd);
+		fuzz_one(buf, size);
 	}
 	__except(GetExceptionCode() == EXCEPTION_ACCESS_VIOLATION)
 	{
 		fprintf(stderr, "Caught AV exception.\n");
 	}
 
-	fclose(fd);
+	free(buf);
 
 	return 0;
 }
@@ -53,6 +53,9 @@
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <map>
+#include <vector>
+#include <algorithm>
 
 #include "uthash.h"
 #include "compat.h"
@@ -80,6 +83,58 @@ static std::string MakeFileName(const std::string& fullName)
 	return fullName.substr(idx + 1);
 }
 
+// FNV-1a hash of a string, used to keep edge ids stable across runs
+static size_t HashString(const std::string& str)
+{
+	UINT32 hash = 2166136261U;
+
+	for (size_t i = 0; i < str.size(); ++i)
+	{
+		hash ^= (unsigned char)str[i];
+		hash *= 16777619U;
+	}
+
+	return hash;
+}
+
+// Match a string against a pattern containing '*' and '?' wildcards
+static bool GlobMatch(const char* pattern, const char* str)
+{
+	for (; *pattern; ++pattern, ++str)
+	{
+		if (*pattern == '*')
+		{
+			// Collapse repeated stars then try every possible suffix
+			while (*pattern == '*')
+				++pattern;
+
+			if (!*pattern)
+				return true;
+
+			for (; *str; ++str)
+			{
+				if (GlobMatch(pattern, str))
+					return true;
+			}
+
+			return false;
+		}
+
+		if (!*str)
+			return false;
+
+#ifdef TARGET_WINDOWS
+		if (*pattern != '?' && tolower(*pattern) != tolower(*str))
+			return false;
+#else
+		if (*pattern != '?' && *pattern != *str)
+			return false;
+#endif
+	}
+
+	return !*str;
+}
+
 class NonCopyable
 {
 protected:
@@ -118,6 +173,9 @@ public:
 		, fileName(MakeFileName(fullName))
 		, lowAddress(IMG_LowAddress(img))
 		, highAddress(IMG_HighAddress(img))
+		, nameHash(HashString(fileName))
+		, excluded(false)
+		, baseline(NULL)
 		, conflict(NULL)
 		, key(IMG_Id(img))
 	{
@@ -132,6 +190,9 @@ public:
 	const std::string fileName;    // Just the name of the file
 	const ADDRINT     lowAddress;
 	const ADDRINT     highAddress;
+	const size_t      nameHash;    // Hash of fileName for edge ids
+	bool              excluded;    // Don't instrument this image
+	const std::vector<ADDRINT>* baseline; // Sorted offsets already covered
 	const ImageName*  conflict;
 
 	size_t            key;
@@ -153,6 +214,10 @@ public:
 	BlockRec(ADDRINT addr)
 		: countRun(0)
 		, countAdd(1)
+		, existing(false)
+		, id(0)
+		, edgeId(0)
+		, imageId(0)
 		, key(addr)
 	{
 	}
@@ -171,6 +236,10 @@ public:
 
 	size_t             countRun; // Count of BlockExecuted()
 	size_t             countAdd; // Count of Trace()
+	bool               existing; // Block is in the baseline
+	size_t             id;       // Index into per-thread counters
+	ADDRINT            edgeId;   // Position in the edge bitmap
+	size_t             imageId;  // IMG_Id of the image containing the block, 0 if unknown
 	size_t             key;
 	UT_hash_handle     hh;
 };
@@ -275,6 +344,109 @@ private:
 	TVal*  table;
 };
 
+// Index of currently loaded images, ordered by address.
+// Loaded images never overlap, so a lookup only needs to check
+// the image with the largest low address <= the address.
+class ImageMap : NonCopyable
+{
+public:
+	void Add(const ImageRec* pImg)
+	{
+		ranges[pImg->lowAddress] = pImg;
+	}
+
+	void Remove(const ImageRec* pImg)
+	{
+		Ranges_t::iterator it = ranges.find(pImg->lowAddress);
+		if (it != ranges.end() && it->second == pImg)
+			ranges.erase(it);
+	}
+
+	const ImageRec* Find(ADDRINT addr) const
+	{
+		Ranges_t::const_iterator it = ranges.upper_bound(addr);
+		if (it == ranges.begin())
+			return NULL;
+
+		--it;
+
+		if (addr > it->second->highAddress)
+			return NULL;
+
+		return it->second;
+	}
+
+	size_t Count() const
+	{
+		return ranges.size();
+	}
+
+private:
+	typedef std::map<ADDRINT, const ImageRec*> Ranges_t;
+
+	Ranges_t ranges;
+};
+
+// Dense per-thread execution counters, indexed by BlockRec::id.
+// Counters live in fixed size pages so they can grow while the
+// analysis routine keeps a stable pointer to the page table.
+class ThreadCounts : NonCopyable
+{
+public:
+	static const size_t PageBits = 16;
+	static const size_t PageSize = 1 << PageBits;
+	static const size_t MaxPages = 4096;
+	static const size_t MaxBlocks = PageSize * MaxPages;
+
+	ThreadCounts()
+		: pages(new UINT32*[MaxPages])
+		, numPages(0)
+	{
+		memset(pages, 0, MaxPages * sizeof(UINT32*));
+	}
+
+	~ThreadCounts()
+	{
+		for (size_t i = 0; i < numPages; ++i)
+			delete [] pages[i];
+
+		delete [] pages;
+	}
+
+	// Make sure there is a counter for every block id below numBlocks
+	void Grow(size_t numBlocks)
+	{
+		for (; (numPages << PageBits) < numBlocks; ++numPages)
+		{
+			pages[numPages] = new UINT32[PageSize];
+			memset(pages[numPages], 0, PageSize * sizeof(UINT32));
+		}
+	}
+
+	// Add all counters to their blocks and start over from zero
+	template<typename TBlocks>
+	void Merge(const TBlocks& blocks)
+	{
+		for (size_t i = 0; i < blocks.size() && (i >> PageBits) < numPages; ++i)
+		{
+			UINT32& count = pages[i >> PageBits][i & (PageSize - 1)];
+			blocks[i]->countRun += count;
+			count = 0;
+		}
+	}
+
+	void Reset()
+	{
+		for (size_t i = 0; i < numPages; ++i)
+			memset(pages[i], 0, PageSize * sizeof(UINT32));
+	}
+
+	UINT32** const pages;
+
+private:
+	size_t numPages;
+};
+
 struct File : NonCopyable
 {
 public:
@@ -375,6 +547,28 @@ typedef HashTable<ImageName> ImageNames_t;
 static ImageNames_t includedImages;
 static Blocks_t blocks;
 static Images_t images;
+static ImageMap loadedImages;
+
+// Blocks by id and the counters of every live thread for -perthread
+static std::vector<BlockRec*> blocksById;
+static std::vector<ThreadCounts*> threadCounts;
+static PIN_LOCK threadLock;
+static TLS_KEY threadKey;
+
+// Cpu clock and system call state of an application thread for -cpukill
+struct IdleThread
+{
+	OS_THREAD_ID osTid;
+	uint64_t lastTime;
+	volatile BOOL blocked;
+};
+
+// Every live application thread, guarded by threadLock
+static std::vector<IdleThread*> idleThreads;
+static TLS_KEY idleKey;
+
+// Whether the OS supports reading the cpu clock of other threads
+static bool threadClocks = false;
 
 File fileDbg;
 INT pid = 0;
@@ -382,6 +576,31 @@ INT pid = 0;
 KNOB<std::string> KnobOutput(KNOB_MODE_WRITEONCE,  "pintool", "o", "bblocks", "specify base file name for output");
 KNOB<BOOL> KnobDebug(KNOB_MODE_WRITEONCE, "pintool", "debug", "0", "Enable debug logging.");
 KNOB<BOOL> KnobCpuKill(KNOB_MODE_WRITEONCE, "pintool", "cpukill", "0", "Kill process when cpu becomes idle.");
+KNOB<UINT32> KnobIdleMs(KNOB_MODE_WRITEONCE, "pintool", "idlems", "200", "Milliseconds between cpu idle checks for -cpukill.");
+KNOB<std::string> KnobInclude(KNOB_MODE_APPEND, "pintool", "include", "", "Only instrument modules matching this file name or glob, can be repeated.");
+KNOB<std::string> KnobExclude(KNOB_MODE_APPEND, "pintool", "exclude", "", "Don't instrument modules matching this file name or glob, can be repeated.");
+KNOB<BOOL> KnobNoSystem(KNOB_MODE_WRITEONCE, "pintool", "nosystem", "0", "Don't instrument modules in the system library directories.");
+KNOB<std::string> KnobBaseline(KNOB_MODE_WRITEONCE, "pintool", "baseline", "", "Trace of already covered blocks, only new blocks are instrumented and written.");
+KNOB<BOOL> KnobPerThread(KNOB_MODE_WRITEONCE, "pintool", "perthread", "0", "Count block executions per thread, for multi-threaded targets.");
+KNOB<BOOL> KnobText(KNOB_MODE_WRITEONCE, "pintool", "text", "0", "Write the trace as text instead of binary.");
+KNOB<std::string> KnobShm(KNOB_MODE_WRITEONCE, "pintool", "shm", "", "Name of shared memory edge bitmap created by Peach.");
+KNOB<UINT32> KnobShmSize(KNOB_MODE_WRITEONCE, "pintool", "shmsize", "65536", "Size of the edge bitmap, must be a power of two.");
+KNOB<std::string> KnobForkServer(KNOB_MODE_WRITEONCE, "pintool", "forksrv", "", "Base name of fork server fifos, forks a new child at main for every request.");
+
+// Shared memory edge bitmap, NULL when -shm is not specified
+UINT8* edgeMap = NULL;
+ADDRINT edgeMask = 0;
+
+// Tool register holding the previous edge id of each thread
+REG edgeReg;
+
+// Tool register holding ThreadCounts::pages of each thread
+REG countsReg;
+
+// Address of the application's fork() and whether this process is the server
+AFUNPTR appFork = NULL;
+bool isForkServer = false;
+bool isForking = false;
 
 // Full path to the output file base
 std::string OutFileBase;
@@ -396,16 +615,211 @@ void File::OpenSuccess(const std::string& name)
 	DBG(("Successfully opened file '%s'.", name.c_str()));
 }
 
-const ImageRec* FindImageByAddr(ADDRINT addr)
+// Binary trace file, see ReadMe.txt for the layout
+class BinaryTrace : NonCopyable
 {
-	for (const ImageRec* it = images.Head(); it != NULL; it = it->Next())
+public:
+	typedef std::vector<ADDRINT> Offsets_t;
+
+	static const UINT32 Version = 1;
+
+	// Load a binary or text trace, returns false if it can't be read
+	bool Load(const std::string& fileName)
+	{
+		std::ifstream fin(fileName.c_str(), std::ifstream::binary);
+		if (!fin)
+			return false;
+
+		std::string buf((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+		if (fin.bad())
+			return false;
+
+		bool ret = buf.compare(0, 4, "PTRC") == 0 ? ParseBinary(buf) : ParseText(buf);
+
+		for (Modules_t::iterator it = modules.begin(); it != modules.end(); ++it)
+		{
+			Offsets_t& offsets = it->second;
+
+			std::sort(offsets.begin(), offsets.end());
+			offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+		}
+
+		return ret;
+	}
+
+	// Sorted offsets of a module, or NULL if the module is not in the trace
+	const Offsets_t* Find(const std::string& fileName) const
 	{
-		if (it->lowAddress <= addr && addr <= it->highAddress)
-			return it;
+		Modules_t::const_iterator it = modules.find(fileName);
+		return it == modules.end() ? NULL : &it->second;
 	}
 
-	return NULL;
-}
+	size_t Count() const
+	{
+		size_t ret = 0;
+
+		for (Modules_t::const_iterator it = modules.begin(); it != modules.end(); ++it)
+			ret += it->second.size();
+
+		return ret;
+	}
+
+	void Add(const ImageRec& img, ADDRINT addr)
+	{
+		modules[img.fileName].push_back(addr - img.lowAddress);
+	}
+
+	std::string Serialize()
+	{
+		std::string buf("PTRC");
+
+		WriteUInt32(buf, Version);
+		WriteUInt32(buf, (UINT32)modules.size());
+
+		// String table, module names are sorted by std::map
+		for (Modules_t::iterator it = modules.begin(); it != modules.end(); ++it)
+		{
+			Offsets_t& offsets = it->second;
+
+			std::sort(offsets.begin(), offsets.end());
+			offsets.erase(std::unique(offsets.begin(), offsets.end()), offsets.end());
+
+			WriteUInt32(buf, (UINT32)it->first.size());
+			buf.append(it->first);
+			WriteUInt32(buf, (UINT32)offsets.size());
+		}
+
+		// Offsets of each module, delta encoded
+		for (Modules_t::iterator it = modules.begin(); it != modules.end(); ++it)
+		{
+			ADDRINT last = 0;
+
+			for (Offsets_t::iterator off = it->second.begin(); off != it->second.end(); ++off)
+			{
+				WriteVarInt(buf, *off - last);
+				last = *off;
+			}
+		}
+
+		return buf;
+	}
+
+private:
+	typedef std::map<std::string, Offsets_t> Modules_t;
+
+	static bool ReadUInt32(const std::string& buf, size_t& pos, UINT32& value)
+	{
+		if (pos + 4 > buf.size())
+			return false;
+
+		value = 0;
+		for (int i = 3; i >= 0; --i)
+			value = (value << 8) | (unsigned char)buf[pos + i];
+
+		pos += 4;
+		return true;
+	}
+
+	static bool ReadVarInt(const std::string& buf, size_t& pos, UINT64& value)
+	{
+		value = 0;
+
+		for (int shift = 0; pos < buf.size() && shift < 64; shift += 7)
+		{
+			unsigned char b = buf[pos++];
+			value |= (UINT64)(b & 0x7f) << shift;
+
+			if ((b & 0x80) == 0)
+				return true;
+		}
+
+		return false;
+	}
+
+	bool ParseBinary(const std::string& buf)
+	{
+		size_t pos = 4;
+		UINT32 version, count;
+
+		if (!ReadUInt32(buf, pos, version) || version != Version)
+			return false;
+
+		if (!ReadUInt32(buf, pos, count))
+			return false;
+
+		std::vector<std::pair<Offsets_t*, UINT32> > counts;
+
+		for (UINT32 i = 0; i < count; ++i)
+		{
+			UINT32 len, blocks;
+
+			if (!ReadUInt32(buf, pos, len) || pos + len > buf.size())
+				return false;
+
+			Offsets_t* offsets = &modules[buf.substr(pos, len)];
+			pos += len;
+
+			if (!ReadUInt32(buf, pos, blocks))
+				return false;
+
+			counts.push_back(std::make_pair(offsets, blocks));
+		}
+
+		for (size_t i = 0; i < counts.size(); ++i)
+		{
+			UINT64 offset = 0, delta;
+
+			for (UINT32 j = 0; j < counts[i].second; ++j)
+			{
+				if (!ReadVarInt(buf, pos, delta))
+					return false;
+
+				offset += delta;
+				counts[i].first->push_back((ADDRINT)offset);
+			}
+		}
+
+		return true;
+	}
+
+	bool ParseText(const std::string& buf)
+	{
+		std::istringstream sin(buf);
+		std::string line;
+
+		// Lines are "file: offset"
+		while (std::getline(sin, line))
+		{
+			size_t sep = line.rfind(": ");
+			if (sep == std::string::npos)
+				continue;
+
+			UINT64 offset = strtoull(line.c_str() + sep + 2, NULL, 10);
+			modules[line.substr(0, sep)].push_back((ADDRINT)offset);
+		}
+
+		return true;
+	}
+
+	static void WriteUInt32(std::string& buf, UINT32 value)
+	{
+		for (int i = 0; i < 4; ++i, value >>= 8)
+			buf += (char)(value & 0xff);
+	}
+
+	static void WriteVarInt(std::string& buf, UINT64 value)
+	{
+		for (; value >= 0x80; value >>= 7)
+			buf += (char)((value & 0x7f) | 0x80);
+
+		buf += (char)value;
+	}
+
+	Modules_t modules;
+};
+
+// Blocks covered by earlier runs, see -baseline
+static BinaryTrace baseline;
 
 bool ReadAllLines(const std::string& fileName, Strings_t& lines)
 {
@@ -444,15 +858,254 @@ VOID PIN_FAST_ANALYSIS_CALL BlockExecuted(BlockRec* pBlock)
 	pBlock->countRun++;
 }
 
+// Called whenever a basic block is executed with -perthread
+VOID PIN_FAST_ANALYSIS_CALL BlockExecutedThread(UINT32** pages, UINT32 page, UINT32 slot)
+{
+	// Each thread has its own counters, so no cache line
+	// is shared and no locking is needed to stay inlinable.
+
+	pages[page][slot]++;
+}
+
+// Called whenever a basic block is executed and the edge bitmap is enabled
+ADDRINT PIN_FAST_ANALYSIS_CALL EdgeExecuted(ADDRINT prev, ADDRINT cur)
+{
+	// Same as BlockExecuted, this must stay inlinable.
+	// The return value becomes 'prev' for the next block.
+
+	edgeMap[prev ^ cur]++;
+	return cur >> 1;
+}
+
+// Image a block was found in, if known. Blocks keep the image id instead
+// of a pointer so an unloaded image is never reached through a block.
+const ImageRec* FindImage(const BlockRec* pBlock)
+{
+	return pBlock->imageId ? images.Find(pBlock->imageId) : NULL;
+}
+
+// Compute the bitmap position of a basic block. Uses the image relative
+// offset when possible so ids are the same every time the target runs.
+ADDRINT MakeEdgeId(const BlockRec* pBlock)
+{
+	const ImageRec* pImg = FindImage(pBlock);
+	size_t hash = pBlock->key;
+
+	if (pImg)
+		hash = pImg->nameHash ^ ((pBlock->key - pImg->lowAddress) * 2654435761U);
+
+	hash ^= hash >> 15;
+	return hash & edgeMask;
+}
+
+// Reset all coverage so the next forked child starts from nothing
+VOID ResetCoverage()
+{
+	for (BlockRec* it = (BlockRec*)blocks.Head(); it != NULL; it = (BlockRec*)it->Next())
+		it->countRun = 0;
+
+	PIN_GetLock(&threadLock, 1);
+
+	for (size_t i = 0; i < threadCounts.size(); ++i)
+		threadCounts[i]->Reset();
+
+	PIN_ReleaseLock(&threadLock);
+
+	if (edgeMap)
+		memset(edgeMap, 0, edgeMask + 1);
+}
+
+// Replaces main() when running as a fork server.  Every request
+// on the control fifo forks a child which runs the real main, and
+// the child's pid and wait status are reported on the status fifo.
+int ForkServerMain(const CONTEXT* ctxt, THREADID tid, AFUNPTR origMain, int argc, char** argv, char** envp)
+{
+	int ret = 0;
+
+	if (appFork == NULL || !ForkServerOpen(KnobForkServer.Value()))
+	{
+		DBG(("Unable to start fork server, running main() once"));
+
+		PIN_CallApplicationFunction(ctxt, tid, CALLINGSTD_DEFAULT, origMain,
+			PIN_PARG(int), &ret,
+			PIN_PARG(int), argc,
+			PIN_PARG(char**), argv,
+			PIN_PARG(char**), envp,
+			PIN_PARG_END());
+
+		return ret;
+	}
+
+	DBG(("Fork server started, pid: %d", pid));
+
+	isForkServer = true;
+
+	// Tell peach we are ready
+	ForkServerWrite(pid);
+
+	UINT32 cmd;
+	while (ForkServerRead(&cmd))
+	{
+		ResetCoverage();
+
+		// Call the application's fork so the child keeps running under pin
+		int child = -1;
+		isForking = true;
+
+		PIN_CallApplicationFunction(ctxt, tid, CALLINGSTD_DEFAULT, appFork,
+			PIN_PARG(int), &child,
+			PIN_PARG_END());
+
+		isForking = false;
+
+		if (child == 0)
+		{
+			ForkServerClose();
+
+			PIN_CallApplicationFunction(ctxt, tid, CALLINGSTD_DEFAULT, origMain,
+				PIN_PARG(int), &ret,
+				PIN_PARG(int), argc,
+				PIN_PARG(char**), argv,
+				PIN_PARG(char**), envp,
+				PIN_PARG_END());
+
+			return ret;
+		}
+
+		if (child == -1)
+		{
+			DBG(("Fork server failed to fork child"));
+			break;
+		}
+
+		int status = WaitForChild(child, KnobCpuKill.Value() != 0, KnobIdleMs.Value());
+
+		DBG(("Fork server child %d exited, status: %d", child, status));
+
+		if (!ForkServerWrite(child) || !ForkServerWrite(status))
+			break;
+	}
+
+	DBG(("Fork server exiting"));
+
+	ForkServerClose();
+
+	return 0;
+}
+
+// Called in the child after the application forks
+VOID ForkChild(THREADID tid, const CONTEXT* ctxt, VOID* v)
+{
+	UNUSED_ARG(tid);
+	UNUSED_ARG(ctxt);
+	UNUSED_ARG(v);
+
+	// Children of the fork server own their trace output
+	if (isForking)
+	{
+		isForkServer = false;
+		pid = PIN_GetPid();
+	}
+}
+
+// Hook main() in the executable so it can be replaced with ForkServerMain()
+VOID HookMain(IMG img)
+{
+	RTN rtn = RTN_FindByName(img, "fork");
+	if (RTN_Valid(rtn) && appFork == NULL)
+		appFork = AFUNPTR(RTN_Address(rtn));
+
+	if (!IMG_IsMainExecutable(img))
+		return;
+
+	rtn = RTN_FindByName(img, "main");
+	if (!RTN_Valid(rtn))
+	{
+		DBG(("Unable to find main() in %s, fork server disabled", IMG_Name(img).c_str()));
+		return;
+	}
+
+	PROTO proto = PROTO_Allocate(PIN_PARG(int), CALLINGSTD_DEFAULT, "main",
+		PIN_PARG(int),
+		PIN_PARG(char**),
+		PIN_PARG(char**),
+		PIN_PARG_END());
+
+	RTN_ReplaceSignature(
+		rtn,
+		AFUNPTR(ForkServerMain),
+		IARG_PROTOTYPE,
+		proto,
+		IARG_CONST_CONTEXT,
+		IARG_THREAD_ID,
+		IARG_ORIG_FUNCPTR,
+		IARG_FUNCARG_ENTRYPOINT_VALUE, 0,
+		IARG_FUNCARG_ENTRYPOINT_VALUE, 1,
+		IARG_FUNCARG_ENTRYPOINT_VALUE, 2,
+		IARG_END);
+
+	PROTO_Free(proto);
+}
+
+// Returns true if the image matches any value of the knob.  Patterns
+// containing a path separator match the full name, otherwise the file name.
+bool MatchesKnob(const ImageRec* pImg, KNOB<std::string>& knob)
+{
+	for (UINT32 i = 0; i < knob.NumberOfValues(); ++i)
+	{
+		const std::string& pattern = knob.Value(i);
+		if (pattern.empty())
+			continue;
+
+		bool full = pattern.find_first_of("/\\") != std::string::npos;
+		const std::string& name = full ? pImg->fullName : pImg->fileName;
+
+		if (GlobMatch(pattern.c_str(), name.c_str()))
+			return true;
+	}
+
+	return false;
+}
+
+// Decide if an image should run uninstrumented
+bool IsExcluded(const ImageRec* pImg)
+{
+	static WinDirHelper dirs(true);
+
+	bool haveIncludes = false;
+	for (UINT32 i = 0; i < KnobInclude.NumberOfValues(); ++i)
+		haveIncludes |= !KnobInclude.Value(i).empty();
+
+	if (haveIncludes && !MatchesKnob(pImg, KnobInclude))
+		return true;
+
+	if (MatchesKnob(pImg, KnobExclude))
+		return true;
+
+	if (KnobNoSystem && dirs.IsSystem(pImg->fullName))
+		return true;
+
+	return false;
+}
+
 // Called every time a new image is loaded
 VOID Image(IMG img, VOID* v)
 {
 	UNUSED_ARG(v);
 
+	if (!KnobForkServer.Value().empty())
+		HookMain(img);
+
 	ImageRec* pImg = new ImageRec(img);
 	pImg->conflict = includedImages.Find(pImg->fileName);
+	pImg->excluded = IsExcluded(pImg);
+	pImg->baseline = baseline.Find(pImg->fileName);
+
+	if (pImg->excluded)
+		DBG(("Excluding image: %s", pImg->fullName.c_str()));
 
 	images.Add(pImg);
+	loadedImages.Add(pImg);
 
 	if (pImg->conflict)
 	{
@@ -481,11 +1134,72 @@ VOID Image(IMG img, VOID* v)
 	}
 }
 
+// Called when an application thread starts with -perthread
+VOID ThreadStart(THREADID tid, CONTEXT* ctxt, INT32 flags, VOID* v)
+{
+	UNUSED_ARG(flags);
+	UNUSED_ARG(v);
+
+	ThreadCounts* pCounts = new ThreadCounts();
+
+	PIN_GetLock(&threadLock, tid + 1);
+
+	pCounts->Grow(blocksById.size());
+	threadCounts.push_back(pCounts);
+
+	PIN_ReleaseLock(&threadLock);
+
+	PIN_SetThreadData(threadKey, pCounts, tid);
+	PIN_SetContextReg(ctxt, countsReg, (ADDRINT)pCounts->pages);
+}
+
+// Called when an application thread exits with -perthread
+VOID ThreadFini(THREADID tid, const CONTEXT* ctxt, INT32 code, VOID* v)
+{
+	UNUSED_ARG(ctxt);
+	UNUSED_ARG(code);
+	UNUSED_ARG(v);
+
+	ThreadCounts* pCounts = (ThreadCounts*)PIN_GetThreadData(threadKey, tid);
+	if (pCounts == NULL)
+		return;
+
+	PIN_GetLock(&threadLock, tid + 1);
+
+	pCounts->Merge(blocksById);
+	threadCounts.erase(std::find(threadCounts.begin(), threadCounts.end(), pCounts));
+
+	PIN_ReleaseLock(&threadLock);
+
+	PIN_SetThreadData(threadKey, NULL, tid);
+	delete pCounts;
+}
+
+// Called every time an image is unloaded
+VOID ImageUnload(IMG img, VOID* v)
+{
+	UNUSED_ARG(v);
+
+	// Keep the record around, blocks still refer to it by id
+	const ImageRec* pImg = images.Find(IMG_Id(img));
+	if (pImg)
+	{
+		loadedImages.Remove(pImg);
+		DBG(("Unloaded image: %s", pImg->fullName.c_str()));
+	}
+}
+
 // Called every time a new trace is encountered
 VOID Trace(TRACE trace, VOID *v)
 {
 	UNUSED_ARG(v);
 
+	// Traces never span images, so filtered images can be skipped
+	// here and left to run at native JIT speed.
+	const ImageRec* pImg = loadedImages.Find(TRACE_Address(trace));
+	if (pImg && pImg->excluded)
+		return;
+
 	for (BBL bbl = TRACE_BblHead(trace); BBL_Valid(bbl); bbl = BBL_Next(bbl))
 	{
 		// Grab the first instruction of the block
@@ -500,26 +1214,98 @@ VOID Trace(TRACE trace, VOID *v)
 
 		// If we have visited this basic block before, ignore
 		BlockRec* pBlock = blocks.Find(addr);
-		if (pBlock != NULL)
+		bool isNew = pBlock == NULL;
+		bool moved = false;
+
+		if (isNew)
 		{
-			//if (!pBlock->existing && !pBlock->excluded)
-			//{
-			//	DBG(("Ignoring duplicate trace for basic block '%s: %llu'",
-			//		pBlock->fileName.c_str(), (unsigned long long)pBlock->key));
-			//}
+			// Build a record for tracking this basic block
+			pBlock = new BlockRec(addr);
+
+			// Resolve the image now, while it is guaranteed to be loaded.
+			// Code outside of any image is resolved again in Fini.
+			const ImageRec* pBlockImg = loadedImages.Find(addr);
+			if (pBlockImg)
+				pBlock->imageId = pBlockImg->key;
+
+			// Blocks in the baseline are never counted, so they cost nothing
+			if (pBlockImg && pBlockImg->baseline)
+			{
+				pBlock->existing = std::binary_search(
+					pBlockImg->baseline->begin(),
+					pBlockImg->baseline->end(),
+					addr - pBlockImg->lowAddress);
+			}
 
+			// Ensure we are tracking this basic block record
+			blocks.Add(pBlock);
+		}
+		else
+		{
 			pBlock->countAdd++;
-			continue;
+
+			// The block's image was unloaded and another one loaded at
+			// the same address, the block belongs to the new image now
+			const ImageRec* pBlockImg = loadedImages.Find(addr);
+			if (pBlockImg && pBlockImg->key != pBlock->imageId)
+			{
+				pBlock->imageId = pBlockImg->key;
+				moved = true;
+			}
 		}
 
-		// We can't resolve the image this address belongs to,
-		// because there is a chance it has not been loaded yet.
+		// Edges need to be recorded for every copy of the block
+		if (edgeMap)
+		{
+			if (isNew || moved)
+				pBlock->edgeId = MakeEdgeId(pBlock);
+
+			BBL_InsertCall(
+				bbl,
+				IPOINT_ANYWHERE,
+				AFUNPTR(EdgeExecuted),
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE,
+				edgeReg,
+				IARG_ADDRINT,
+				pBlock->edgeId,
+				IARG_RETURN_REGS,
+				edgeReg,
+				IARG_END);
+		}
 
-		// Build a record for tracking this basic block
-		pBlock = new BlockRec(addr);
+		if (!isNew || pBlock->existing)
+			continue;
+
+		if (KnobPerThread && blocksById.size() < ThreadCounts::MaxBlocks)
+		{
+			pBlock->id = blocksById.size();
 
-		// Ensure we are tracking this basic block record
-		blocks.Add(pBlock);
+			PIN_GetLock(&threadLock, 1);
+
+			blocksById.push_back(pBlock);
+
+			// Every thread needs a counter before the block can run
+			for (size_t i = 0; i < threadCounts.size(); ++i)
+				threadCounts[i]->Grow(blocksById.size());
+
+			PIN_ReleaseLock(&threadLock);
+
+			BBL_InsertCall(
+				bbl,
+				IPOINT_ANYWHERE,
+				AFUNPTR(BlockExecutedThread),
+				IARG_FAST_ANALYSIS_CALL,
+				IARG_REG_VALUE,
+				countsReg,
+				IARG_UINT32,
+				(UINT32)(pBlock->id >> ThreadCounts::PageBits),
+				IARG_UINT32,
+				(UINT32)(pBlock->id & (ThreadCounts::PageSize - 1)),
+				IARG_END);
+
+			continue;
+		}
 
 		// Record basic block when it is executed
 		BBL_InsertCall(
@@ -561,41 +1347,175 @@ VOID Fini(INT32 code, VOID *v)
 		return;
 	}
 
+	// Only the forked children have anything worth reporting
+	if (isForkServer)
+	{
+		DBG(("Fork server finished, pid: %d", PIN_GetPid()));
+		return;
+	}
+
+	// Collect counters of threads that are still running
+	PIN_GetLock(&threadLock, 1);
+
+	for (size_t i = 0; i < threadCounts.size(); ++i)
+		threadCounts[i]->Merge(blocksById);
+
+	PIN_ReleaseLock(&threadLock);
+
 	// Open file to log new traces to
 	File fileOut;
 	fileOut.Open(OutFileBase + ".out", "wb");
 
-	unsigned long unresolved = 0, dupes = 0, run = 0;
+	unsigned long unresolved = 0, dupes = 0, run = 0, existing = 0;
+
+	BinaryTrace trace;
 
 	for (const BlockRec* it = blocks.Head(); it != NULL; it = it->Next())
 	{
 		if (it->countAdd > 1)
 			++dupes;
 
+		if (it->existing)
+			++existing;
+
 		if (it->countRun > 0)
 		{
 			++run;
 
-			const ImageRec* pImg = FindImageByAddr(it->key);
+			const ImageRec* pImg = it->imageId ? FindImage(it) : loadedImages.Find(it->key);
 
 			if (NULL == pImg)
 			{
 				DBG(("Could not get image for basic block: %llu", (unsigned long long)it->key));
 				++unresolved;
 			}
-			else
+			else if (KnobText)
 			{
 				fileOut.Write(it->MakeTrace(*pImg));
 			}
+			else
+			{
+				trace.Add(*pImg, it->key);
+			}
 		}
 	}
 
+	// An empty output file means nothing ran, so only write when we have blocks
+	if (!KnobText && run > unresolved)
+		fileOut.Write(trace.Serialize());
+
 	DBG(("Application finished, pid: %d", PIN_GetPid()));
 	DBG((" All Images     : %lu", (unsigned long)images.Count()));
+	DBG(("  Loaded        : %lu", (unsigned long)loadedImages.Count()));
 	DBG((" Basic Blocks   : %lu", (unsigned long)blocks.Count()));
 	DBG(("  Executed      : %lu", run));
 	DBG(("  Unresolved    : %lu", unresolved));
 	DBG(("  Duplicates    : %lu", dupes));
+	DBG(("  Baseline      : %lu", existing));
+}
+
+// Called when an application thread starts with -cpukill
+VOID IdleThreadStart(THREADID tid, CONTEXT* ctxt, INT32 flags, VOID* v)
+{
+	UNUSED_ARG(ctxt);
+	UNUSED_ARG(flags);
+	UNUSED_ARG(v);
+
+	IdleThread* pThread = new IdleThread();
+	pThread->osTid = PIN_GetTid();
+	pThread->lastTime = 0;
+	pThread->blocked = FALSE;
+
+	GetThreadCpuTime(pThread->osTid, &pThread->lastTime);
+
+	PIN_GetLock(&threadLock, tid + 1);
+	idleThreads.push_back(pThread);
+	PIN_ReleaseLock(&threadLock);
+
+	PIN_SetThreadData(idleKey, pThread, tid);
+}
+
+// Called when an application thread exits with -cpukill
+VOID IdleThreadFini(THREADID tid, const CONTEXT* ctxt, INT32 code, VOID* v)
+{
+	UNUSED_ARG(ctxt);
+	UNUSED_ARG(code);
+	UNUSED_ARG(v);
+
+	IdleThread* pThread = (IdleThread*)PIN_GetThreadData(idleKey, tid);
+	if (pThread == NULL)
+		return;
+
+	PIN_GetLock(&threadLock, tid + 1);
+	idleThreads.erase(std::find(idleThreads.begin(), idleThreads.end(), pThread));
+	PIN_ReleaseLock(&threadLock);
+
+	PIN_SetThreadData(idleKey, NULL, tid);
+	delete pThread;
+}
+
+// Only known blocking waits count, a slow read from a file or a sleep
+// could be the target doing work.
+VOID SyscallEntry(THREADID tid, CONTEXT* ctxt, SYSCALL_STANDARD std, VOID* v)
+{
+	UNUSED_ARG(v);
+
+	IdleThread* pThread = (IdleThread*)PIN_GetThreadData(idleKey, tid);
+	if (pThread == NULL)
+		return;
+
+	ADDRINT num = PIN_GetSyscallNumber(ctxt, std);
+	ADDRINT arg0 = PIN_GetSyscallArgument(ctxt, std, 0);
+
+	pThread->blocked = IsBlockingSyscall(num, arg0) ? TRUE : FALSE;
+}
+
+VOID SyscallExit(THREADID tid, CONTEXT* ctxt, SYSCALL_STANDARD std, VOID* v)
+{
+	UNUSED_ARG(ctxt);
+	UNUSED_ARG(std);
+	UNUSED_ARG(v);
+
+	IdleThread* pThread = (IdleThread*)PIN_GetThreadData(idleKey, tid);
+	if (pThread)
+		pThread->blocked = FALSE;
+}
+
+// Samples the cpu clock of every application thread.  Returns true
+// if any thread ran since the last sample.  Sets waiting when every
+// thread is parked in a blocking wait, e.g. a read from a pipe or wait4.
+static bool SampleThreads(bool& waiting)
+{
+	bool busy = false;
+
+	waiting = true;
+
+	PIN_GetLock(&threadLock, PIN_ThreadId() + 1);
+
+	// Nothing to sample until the application starts
+	if (idleThreads.empty())
+		busy = true;
+
+	for (size_t i = 0; i < idleThreads.size(); ++i)
+	{
+		IdleThread* pThread = idleThreads[i];
+		uint64_t now;
+
+		if (!GetThreadCpuTime(pThread->osTid, &now))
+			continue;
+
+		if (now != pThread->lastTime)
+			busy = true;
+
+		if (!pThread->blocked)
+			waiting = false;
+
+		pThread->lastTime = now;
+	}
+
+	PIN_ReleaseLock(&threadLock);
+
+	return busy;
 }
 
 // Internal worker thread
@@ -604,27 +1524,42 @@ VOID ThreadProc(VOID *v)
 	UNUSED_ARG(v);
 
 	uint64_t oldTicks = 0, newTicks = 0;
-	bool check = false;
 	int pid = PIN_GetPid();
+	UINT32 idle = 0;
+
+	DBG(("Starting CPU thread for pid: %d, thread clocks: %d, interval: %u ms",
+		pid, threadClocks, KnobIdleMs.Value()));
+
+	oldTicks = GetProcessTicks(pid);
 
 	while (!PIN_IsProcessExiting())
 	{
-		if (!check)
-			DBG(("Starting CPU thread for pid: %d", pid));
+		PIN_Sleep(KnobIdleMs.Value());
 
-		newTicks = GetProcessTicks(pid);
+		bool busy, waiting = false;
 
-		if (check && oldTicks == newTicks)
+		// Thread clocks leave out the cpu used by this thread
+		if (threadClocks)
 		{
-			DBG(("Detected idle CPU after %d ticks, exiting proces", (unsigned long)oldTicks));
-			PIN_ExitApplication(0);
-			break;
+			busy = SampleThreads(waiting);
+		}
+		else
+		{
+			newTicks = GetProcessTicks(pid);
+			busy = oldTicks != newTicks;
+			oldTicks = newTicks;
 		}
 
-		oldTicks = newTicks;
-		check = true;
+		idle = busy ? 0 : idle + 1;
 
-		PIN_Sleep(200);
+		// Threads that are not in a blocking wait might just not have been
+		// scheduled, so give them one more sample before giving up.
+		if (idle >= (waiting ? 1u : 2u))
+		{
+			DBG(("Detected idle CPU after %u samples, exiting process", idle));
+			PIN_ExitApplication(0);
+			break;
+		}
 	}
 
 	DBG(("CPU monitor thread exiting"));
@@ -646,18 +1581,109 @@ int main(int argc, char* argv[])
 	if (KnobDebug)
 		fileDbg.Open(OutFileBase + ".log", "wb");
 
+	if (!KnobBaseline.Value().empty())
+	{
+		if (!baseline.Load(KnobBaseline.Value()))
+		{
+			PIN_ERROR("Unable to load baseline '" + KnobBaseline.Value() + "'.\n");
+			return -1;
+		}
+
+		DBG(("Loaded %lu baseline blocks from '%s'",
+			(unsigned long)baseline.Count(), KnobBaseline.Value().c_str()));
+	}
+
 	// Must be called before IMG_AddInstrumentFunction
 	PIN_InitSymbols();
 
 	// Register callbacks
 	IMG_AddInstrumentFunction(Image, NULL);
+	IMG_AddUnloadFunction(ImageUnload, NULL);
 	TRACE_AddInstrumentFunction(Trace, NULL);
 	PIN_AddApplicationStartFunction(Start, NULL);
 	PIN_AddFiniFunction(Fini, NULL);
 
-	// Create internal thread to monitor cpu usage
-	if (KnobCpuKill.Value())
+	PIN_InitLock(&threadLock);
+
+	if (KnobPerThread)
+	{
+		countsReg = PIN_ClaimToolRegister();
+		if (!REG_valid(countsReg))
+		{
+			PIN_ERROR("Unable to claim a tool register for per-thread counters.\n");
+			return -1;
+		}
+
+		threadKey = PIN_CreateThreadDataKey(NULL);
+
+		PIN_AddThreadStartFunction(ThreadStart, NULL);
+		PIN_AddThreadFiniFunction(ThreadFini, NULL);
+	}
+
+	// Map the edge bitmap Peach created for us
+	if (!KnobShm.Value().empty())
+	{
+		UINT32 size = KnobShmSize.Value();
+		if (size == 0 || (size & (size - 1)) != 0)
+		{
+			PIN_ERROR("Edge bitmap size must be a power of two.\n");
+			return -1;
+		}
+
+		edgeReg = PIN_ClaimToolRegister();
+		if (!REG_valid(edgeReg))
+		{
+			PIN_ERROR("Unable to claim a tool register for the edge bitmap.\n");
+			return -1;
+		}
+
+		edgeMap = (UINT8*)OpenSharedMemory(KnobShm.Value(), size);
+		if (edgeMap == NULL)
+		{
+			PIN_ERROR("Unable to map edge bitmap '" + KnobShm.Value() + "'.\n");
+			return -1;
+		}
+
+		edgeMask = size - 1;
+
+		DBG(("Mapped edge bitmap '%s', size: %u", KnobShm.Value().c_str(), size));
+	}
+
+	if (!KnobForkServer.Value().empty())
+	{
+#ifdef TARGET_WINDOWS
+		PIN_ERROR("Fork server is not supported on windows.\n");
+		return -1;
+#else
+		PIN_AddForkFunction(FPOINT_AFTER_IN_CHILD, ForkChild, NULL);
+#endif
+	}
+
+	// Create internal thread to monitor cpu usage.  The fork
+	// server does this itself for each child it runs.
+	if (KnobCpuKill.Value() && KnobForkServer.Value().empty())
+	{
+		if (KnobIdleMs.Value() == 0)
+		{
+			PIN_ERROR("Idle check interval must be at least 1 ms.\n");
+			return -1;
+		}
+
+		uint64_t now;
+		threadClocks = GetThreadCpuTime(PIN_GetTid(), &now);
+
+		if (threadClocks)
+		{
+			idleKey = PIN_CreateThreadDataKey(NULL);
+
+			PIN_AddThreadStartFunction(IdleThreadStart, NULL);
+			PIN_AddThreadFiniFunction(IdleThreadFini, NULL);
+			PIN_AddSyscallEntryFunction(SyscallEntry, NULL);
+			PIN_AddSyscallExitFunction(SyscallExit, NULL);
+		}
+
 		PIN_SpawnInternalThread(ThreadProc, NULL, 0, NULL);
+	}
 
 	// Start program, never returns
 	PIN_StartProgram();
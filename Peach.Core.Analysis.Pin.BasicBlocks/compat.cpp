@@ -1,5 +1,24 @@
 #include "compat.h"
 
+// Whether fileName is inside dir, which has no trailing separator
+static bool IsUnderDir(const std::string& dir, const std::string& fileName)
+{
+	if (fileName.length() <= dir.length())
+		return false;
+
+#ifdef WIN32
+	// Only windows paths are case insensitive
+	if (0 != strncasecmp(dir.c_str(), fileName.c_str(), dir.length()))
+		return false;
+#else
+	if (0 != strncmp(dir.c_str(), fileName.c_str(), dir.length()))
+		return false;
+#endif
+
+	char sep = fileName[dir.length()];
+	return sep == '/' || sep == '\\';
+}
+
 #ifdef WIN32
 
 #define WIN32_LEAN_AND_MEAN
@@ -16,14 +35,25 @@ WinDirHelper::WinDirHelper(bool ignoreSystemDir)
 
 	hr = ::SHGetFolderPath(NULL, CSIDL_SYSTEM, NULL, 0, szPath);
 	if (SUCCEEDED(hr))
-		m_SystemDir = szPath;
+		m_SystemDirs.push_back(szPath);
 
 	hr = ::SHGetFolderPath(NULL, CSIDL_SYSTEMX86, NULL, 0, szPath);
-	if (SUCCEEDED(hr))
-		m_SystemX86Dir = szPath;
+	if (SUCCEEDED(hr) && (m_SystemDirs.empty() || m_SystemDirs[0] != szPath))
+		m_SystemDirs.push_back(szPath);
+}
+
+bool WinDirHelper::IsSystem(const std::string& fileName) const
+{
+	if (!m_IgnoreSystemDir)
+		return false;
 
-	if (m_SystemDir == m_SystemX86Dir)
-		m_SystemX86Dir.clear();
+	for (size_t i = 0; i < m_SystemDirs.size(); ++i)
+	{
+		if (IsUnderDir(m_SystemDirs[i], fileName))
+			return true;
+	}
+
+	return false;
 }
 
 void DebugWrite(const char* msg)
@@ -51,6 +81,84 @@ std::string GetFullFileName(const std::string& fileName)
 	return ret;
 }
 
+void* OpenSharedMemory(const std::string& name, size_t size)
+{
+	HANDLE hMap = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, name.c_str());
+	if (NULL == hMap)
+		return NULL;
+
+	void* ret = MapViewOfFile(hMap, FILE_MAP_ALL_ACCESS, 0, 0, size);
+
+	// The view keeps the mapping alive
+	CloseHandle(hMap);
+
+	return ret;
+}
+
+bool ForkServerOpen(const std::string& base)
+{
+	UNUSED_ARG(base);
+	return false;
+}
+
+void ForkServerClose()
+{
+}
+
+bool ForkServerRead(uint32_t* value)
+{
+	UNUSED_ARG(value);
+	return false;
+}
+
+bool ForkServerWrite(uint32_t value)
+{
+	UNUSED_ARG(value);
+	return false;
+}
+
+int WaitForChild(int pid, bool cpuKill, unsigned idleMs)
+{
+	UNUSED_ARG(pid);
+	UNUSED_ARG(cpuKill);
+	UNUSED_ARG(idleMs);
+	return -1;
+}
+
+bool GetThreadCpuTime(int tid, uint64_t* ns)
+{
+	HANDLE hThread = OpenThread(THREAD_QUERY_LIMITED_INFORMATION, FALSE, tid);
+	if (NULL == hThread)
+		return false;
+
+	FILETIME creationTime, exitTime, kernelTime, userTime;
+
+	BOOL bSuccess = GetThreadTimes(hThread, &creationTime, &exitTime, &kernelTime, &userTime);
+
+	CloseHandle(hThread);
+
+	if (!bSuccess)
+		return false;
+
+	ULARGE_INTEGER k, u;
+	k.LowPart = kernelTime.dwLowDateTime;
+	k.HighPart = kernelTime.dwHighDateTime;
+	u.LowPart = userTime.dwLowDateTime;
+	u.HighPart = userTime.dwHighDateTime;
+
+	// Thread times are in 100ns units
+	*ns = (k.QuadPart + u.QuadPart) * 100;
+	return true;
+}
+
+bool IsBlockingSyscall(unsigned long num, unsigned long arg0)
+{
+	// System call numbers change with every windows build
+	UNUSED_ARG(num);
+	UNUSED_ARG(arg0);
+	return false;
+}
+
 uint64_t GetProcessTicks(int pid)
 {
 	HANDLE hProcess = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, pid);
@@ -87,11 +195,188 @@ void DebugWrite(const char* msg)
 	msg;
 }
 
+WinDirHelper::WinDirHelper(bool ignoreSystemDir)
+	: m_IgnoreSystemDir(ignoreSystemDir)
+{
+	static const char* dirs[] =
+	{
+#if defined(__APPLE__)
+		"/usr/lib",
+		"/System/Library",
+#else
+		"/lib",
+		"/lib32",
+		"/lib64",
+		"/libx32",
+		"/usr/lib",
+		"/usr/lib32",
+		"/usr/lib64",
+		"/usr/libx32",
+#endif
+	};
+
+	for (size_t i = 0; i < sizeof(dirs) / sizeof(dirs[0]); ++i)
+		m_SystemDirs.push_back(dirs[i]);
+}
+
+bool WinDirHelper::IsSystem(const std::string& fileName) const
+{
+	if (!m_IgnoreSystemDir)
+		return false;
+
+	for (size_t i = 0; i < m_SystemDirs.size(); ++i)
+	{
+		const std::string& dir = m_SystemDirs[i];
+
+		if (!IsUnderDir(dir, fileName))
+			continue;
+
+#if defined(__APPLE__)
+		// Frameworks live in nested bundles
+		return true;
+#else
+		std::string rest = fileName.substr(dir.length() + 1);
+		size_t slash = rest.find('/');
+
+		// Directly in the directory
+		if (slash == std::string::npos)
+			return true;
+
+		// Or in a multiarch directory, e.g. /usr/lib/x86_64-linux-gnu/
+		std::string sub = rest.substr(0, slash);
+		if (sub.find("-linux-") != std::string::npos && rest.find('/', slash + 1) == std::string::npos)
+			return true;
+#endif
+	}
+
+	return false;
+}
+
 std::string GetFullFileName(const std::string& fileName)
 {
 	return fileName;
 }
 
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+void* OpenSharedMemory(const std::string& name, size_t size)
+{
+	int fd = open(name.c_str(), O_RDWR);
+	if (fd == -1)
+		return NULL;
+
+	void* ret = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+	// The mapping keeps the file alive
+	close(fd);
+
+	return ret == MAP_FAILED ? NULL : ret;
+}
+
+#include <signal.h>
+#include <sys/wait.h>
+
+static int ctlFd = -1;
+static int stFd = -1;
+
+bool ForkServerOpen(const std::string& base)
+{
+	// Peach holds both ends open, so neither of these block
+	ctlFd = open((base + ".ctl").c_str(), O_RDONLY);
+	stFd = open((base + ".st").c_str(), O_WRONLY);
+
+	if (ctlFd == -1 || stFd == -1)
+	{
+		ForkServerClose();
+		return false;
+	}
+
+	// Don't leak the control channel into anything the target runs
+	fcntl(ctlFd, F_SETFD, FD_CLOEXEC);
+	fcntl(stFd, F_SETFD, FD_CLOEXEC);
+
+	return true;
+}
+
+void ForkServerClose()
+{
+	if (ctlFd != -1)
+		close(ctlFd);
+
+	if (stFd != -1)
+		close(stFd);
+
+	ctlFd = stFd = -1;
+}
+
+bool ForkServerRead(uint32_t* value)
+{
+	char* buf = (char*)value;
+	size_t len = sizeof(*value);
+
+	while (len > 0)
+	{
+		ssize_t ret = read(ctlFd, buf, len);
+		if (ret == -1 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+
+		buf += ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
+bool ForkServerWrite(uint32_t value)
+{
+	ssize_t ret;
+
+	do
+	{
+		ret = write(stFd, &value, sizeof(value));
+	}
+	while (ret == -1 && errno == EINTR);
+
+	return ret == sizeof(value);
+}
+
+int WaitForChild(int pid, bool cpuKill, unsigned idleMs)
+{
+	int status = 0;
+
+	if (!cpuKill)
+		return waitpid(pid, &status, 0) == pid ? status : -1;
+
+	uint64_t oldTicks = 0, newTicks = 0;
+	bool check = false;
+
+	for (;;)
+	{
+		int ret = waitpid(pid, &status, WNOHANG);
+		if (ret == pid)
+			return status;
+		if (ret == -1)
+			return -1;
+
+		newTicks = GetProcessTicks(pid);
+
+		if (check && oldTicks == newTicks)
+		{
+			kill(pid, SIGKILL);
+			return waitpid(pid, &status, 0) == pid ? status : -1;
+		}
+
+		oldTicks = newTicks;
+		check = true;
+
+		usleep(idleMs * 1000);
+	}
+}
+
 #if defined(linux)
 
 #include <sys/stat.h>
@@ -99,9 +384,38 @@ std::string GetFullFileName(const std::string& fileName)
 #include <fcntl.h>
 #include <stdio.h>
 #include <string.h>
+#include <time.h>
 #include <unistd.h>
 
+// Same encoding as MAKE_THREAD_CPUCLOCK(tid, CPUCLOCK_SCHED) in the kernel
+#define THREAD_CPUCLOCK(tid) ((~(clockid_t)(tid) << 3) | 6)
+
+bool GetThreadCpuTime(int tid, uint64_t* ns)
+{
+	struct timespec ts;
+
+	if (clock_gettime(THREAD_CPUCLOCK(tid), &ts) != 0)
+		return false;
+
+	*ns = (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+	return true;
+}
+
+static uint64_t GetProcStatTicks(int pid);
+
 uint64_t GetProcessTicks(int pid)
+{
+	// The process cpu clock has nanosecond resolution, /proc only has jiffies
+	clockid_t clk;
+	struct timespec ts;
+
+	if (clock_getcpuclockid(pid, &clk) == 0 && clock_gettime(clk, &ts) == 0)
+		return (uint64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+
+	return GetProcStatTicks(pid);
+}
+
+static uint64_t GetProcStatTicks(int pid)
 {
 	char P_cmd[16];
 	char P_state;
@@ -140,12 +454,92 @@ uint64_t GetProcessTicks(int pid)
 	return P_utime + P_stime;
 }
 
+#include <sys/syscall.h>
+
+#ifdef SYS_socketcall
+#include <linux/net.h>
+#endif
+
+bool IsBlockingSyscall(unsigned long num, unsigned long arg0)
+{
+	switch (num)
+	{
+	case SYS_read:
+	case SYS_readv:
+	{
+		// Reads from files and sockets can just be slow
+		struct stat st;
+		if (fstat((int)arg0, &st) != 0)
+			return false;
+		return S_ISCHR(st.st_mode) || S_ISFIFO(st.st_mode);
+	}
+#ifdef SYS_poll
+	case SYS_poll:
+#endif
+#ifdef SYS_select
+	case SYS_select:
+#endif
+#ifdef SYS__newselect
+	case SYS__newselect:
+#endif
+#ifdef SYS_epoll_wait
+	case SYS_epoll_wait:
+#endif
+#ifdef SYS_waitpid
+	case SYS_waitpid:
+#endif
+#ifdef SYS_accept
+	case SYS_accept:
+#endif
+#ifdef SYS_accept4
+	case SYS_accept4:
+#endif
+#ifdef SYS_recv
+	case SYS_recv:
+#endif
+#ifdef SYS_recvfrom
+	case SYS_recvfrom:
+#endif
+#ifdef SYS_recvmsg
+	case SYS_recvmsg:
+#endif
+	case SYS_ppoll:
+	case SYS_pselect6:
+	case SYS_epoll_pwait:
+	case SYS_wait4:
+	case SYS_waitid:
+		return true;
+#ifdef SYS_socketcall
+	case SYS_socketcall:
+		// Older i386 kernels only have the multiplexed socket call
+		return arg0 == SYS_ACCEPT || arg0 == SYS_ACCEPT4 || arg0 == SYS_RECV ||
+			arg0 == SYS_RECVFROM || arg0 == SYS_RECVMSG;
+#endif
+	default:
+		return false;
+	}
+}
+
 #elif defined(__APPLE__)
 
+bool GetThreadCpuTime(int tid, uint64_t* ns)
+{
+	UNUSED_ARG(tid);
+	UNUSED_ARG(ns);
+	return false;
+}
+
 #include <sys/time.h>
 #include <sys/proc.h>
 #include <sys/proc_info.h>
 #include <libproc.h>
+
+bool IsBlockingSyscall(unsigned long num, unsigned long arg0)
+{
+	UNUSED_ARG(num);
+	UNUSED_ARG(arg0);
+	return false;
+}
 
 uint64_t GetProcessTicks(int pid)
 {
@@ -1,9 +1,10 @@
 #include <string>
+#include <vector>
 
 #ifdef WIN32
 #define strncasecmp _strnicmp
 #else
-#include <strings.h>
+#include <string.h>
 #endif
 
 #define UNUSED_ARG(x) x;
@@ -13,31 +14,49 @@
 
 void DebugWrite(const char* msg);
 
+// Cpu time used by a process, in platform defined units.
 uint64_t GetProcessTicks(int pid); 
 
+// Cpu time in nanoseconds used by a thread of this process, where tid
+// is the OS thread id.  Returns false if thread clocks are not supported.
+bool GetThreadCpuTime(int tid, uint64_t* ns);
+
 std::string GetFullFileName(const std::string& fileName);
 
+// Maps an existing shared memory region created by Peach.
+// On windows name is the file mapping object, otherwise it is
+// the path to the file backing the region.  Returns NULL on error.
+void* OpenSharedMemory(const std::string& name, size_t size);
+
+// Fork server control channel.  Peach creates the fifos '<base>.ctl'
+// and '<base>.st' before starting pin.  Not supported on windows.
+bool ForkServerOpen(const std::string& base);
+void ForkServerClose();
+bool ForkServerRead(uint32_t* value);
+bool ForkServerWrite(uint32_t value);
+
+// Waits for a forked child to exit, killing it once the cpu has been
+// idle for two samples idleMs apart if cpuKill is set.
+// Returns the wait status or -1 on error.
+int WaitForChild(int pid, bool cpuKill, unsigned idleMs);
+
+// Whether system call num, called with first argument arg0, is a known
+// blocking wait for input or another process, e.g. a read from a tty or
+// pipe, poll or wait4.  Always false where the calls are not known.
+bool IsBlockingSyscall(unsigned long num, unsigned long arg0);
+
 class WinDirHelper
 {
 private:
-	std::string m_SystemDir;
-	std::string m_SystemX86Dir;
+	std::vector<std::string> m_SystemDirs;
 	bool m_IgnoreSystemDir;
 
 public:
 	WinDirHelper(bool ignoreSystemDir);
 
-	bool IsSystem(const std::string& fileName) const
-	{
-		if (!m_IgnoreSystemDir)
-			return false;
-
-		if (!m_SystemDir.empty() && 0 == strncasecmp(m_SystemDir.c_str(), fileName.c_str(), m_SystemDir.length()))
-			return true;
-
-		if (!m_SystemX86Dir.empty() && 0 == strncasecmp(m_SystemX86Dir.c_str(), fileName.c_str(), m_SystemX86Dir.length()))
-			return true;
-
-		return false;
-	}
+	// Whether fileName is in one of the system library directories.
+	// Directories are matched on whole path components, on Linux only
+	// libraries directly in them or in a multiarch directory like
+	// /usr/lib/x86_64-linux-gnu/ count, not /usr/lib/<app>/.
+	bool IsSystem(const std::string& fileName) const;
 };
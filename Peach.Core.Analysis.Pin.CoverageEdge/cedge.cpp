@@ -34,7 +34,10 @@
 #include <iostream>
 #include <fstream>
 #include <stdio.h>
-#include <set>
+#include <string.h>
+#include <map>
+#include <vector>
+#include <algorithm>
 
 #if defined(_MSC_VER)
 #pragma warning(push)
@@ -53,20 +56,6 @@
 
 using namespace std;
 
-// Trace file for existing and new blocks
-static FILE* existing = NULL;
-
-// New basic blocks
-static set<ADDRINT> setKnownBlocks;
-
-// Branches not taken
-static set<ADDRINT> setUnknownBlocks;
-
-static pair<set<ADDRINT>::iterator,bool> ret;
-
-// Do we have an existing bblocks trace?
-int haveExisting = FALSE;
-
 #if defined(TARGET_IA32)
 # define FMT "%u\n"
 #elif defined(TARGET_IA32E)
@@ -79,42 +68,237 @@ int haveExisting = FALSE;
 # error TARGET_IA32 or TARGET_IA32E must be defined
 #endif
 
-VOID handleInsertCall( ADDRINT src, ADDRINT dst, INT32 taken )
+KNOB<string> KnobOutput(KNOB_MODE_WRITEONCE, "pintool", "o", "cedge", "specify base file name for .known and .unknown files");
+
+// Open addressed hash set of addresses.  Zero is used
+// to mark empty slots, it is never a valid branch target.
+class AddrSet
 {
-	src;
-	taken;
+public:
+	AddrSet()
+		: slots(16, 0)
+		, count(0)
+	{
+	}
 
-	if(!taken)
+	bool Add(ADDRINT addr)
 	{
-		// Lookup and see if we have already seen this one
-		if(setKnownBlocks.find(dst) == setKnownBlocks.end())
-			ret = setUnknownBlocks.insert(dst);
+		if (addr == 0)
+			return false;
+
+		// Keep the load factor under one half
+		if ((count + 1) * 2 > slots.size())
+			Grow();
+
+		size_t idx = Find(addr);
+		if (slots[idx] == addr)
+			return false;
+
+		slots[idx] = addr;
+		++count;
+		return true;
 	}
-	else
+
+	bool Contains(ADDRINT addr) const
+	{
+		return addr != 0 && slots[Find(addr)] == addr;
+	}
+
+	// Sorted contents, for writing out
+	vector<ADDRINT> ToVector() const
+	{
+		vector<ADDRINT> ret;
+		ret.reserve(count);
+
+		for (size_t i = 0; i < slots.size(); ++i)
+		{
+			if (slots[i] != 0)
+				ret.push_back(slots[i]);
+		}
+
+		sort(ret.begin(), ret.end());
+		return ret;
+	}
+
+private:
+	size_t Find(ADDRINT addr) const
+	{
+		size_t mask = slots.size() - 1;
+		size_t idx = (addr * 2654435761U) & mask;
+
+		while (slots[idx] != 0 && slots[idx] != addr)
+			idx = (idx + 1) & mask;
+
+		return idx;
+	}
+
+	void Grow()
+	{
+		vector<ADDRINT> old;
+		old.swap(slots);
+
+		slots.assign(old.size() * 2, 0);
+
+		for (size_t i = 0; i < old.size(); ++i)
+		{
+			if (old[i] != 0)
+				slots[Find(old[i])] = old[i];
+		}
+	}
+
+	vector<ADDRINT> slots;
+	size_t count;
+};
+
+// Number of recent targets remembered by every indirect branch site
+#define SITE_CACHE 4
+
+// State for a single branch or call instruction
+struct BranchSite
+{
+	BranchSite(ADDRINT target)
+		: target(target)
+		, lastTarget(0)
+		, nextSlot(0)
+	{
+		seen[0] = seen[1] = 0;
+
+		for (int i = 0; i < SITE_CACHE; ++i)
+			recent[i] = 0;
+	}
+
+	ADDRINT target;     // Target of a direct branch, 0 if indirect
+	ADDRINT lastTarget; // Last target of an indirect branch
+	UINT8   seen[2];    // Indexed by IARG_BRANCH_TAKEN
+
+	// Targets of an indirect branch already in indirectTargets.  Only
+	// written under indirectLock, read without it.  A stale read is a
+	// miss, which takes the lock.
+	volatile ADDRINT recent[SITE_CACHE];
+	UINT32 nextSlot;
+};
+
+// Every branch site, by instruction address
+static map<ADDRINT, BranchSite*> sites;
+
+// Targets of indirect branches and calls
+static AddrSet indirectTargets;
+static PIN_LOCK indirectLock;
+
+// Full path to the output file base
+string OutFileBase;
+
+// If guard for direct branches, true the first time a direction is seen
+ADDRINT PIN_FAST_ANALYSIS_CALL IsNewDirect(BranchSite* site, BOOL taken)
+{
+	return !site->seen[taken];
+}
+
+VOID PIN_FAST_ANALYSIS_CALL RecordDirect(BranchSite* site, BOOL taken)
+{
+	site->seen[taken] = 1;
+}
+
+// If guard for indirect branches, true when the target changes
+ADDRINT PIN_FAST_ANALYSIS_CALL IsNewIndirect(BranchSite* site, ADDRINT target)
+{
+	return site->lastTarget ^ target;
+}
+
+// Switches and virtual calls alternate between a few targets, so
+// check the targets this site has already recorded before locking.
+VOID RecordIndirect(BranchSite* site, ADDRINT target, THREADID tid)
+{
+	site->lastTarget = target;
+
+	for (int i = 0; i < SITE_CACHE; ++i)
 	{
-		// Store bblocks we have already seen
-		ret = setKnownBlocks.insert(dst);
-
-		// If we had not taken this edge some other time, lets remove
-		// it from our list.
-		set<ADDRINT>::iterator pos = setUnknownBlocks.find(dst);
-		if(pos != setUnknownBlocks.end())
-			setUnknownBlocks.erase(pos);
+		if (site->recent[i] == target)
+			return;
 	}
-} 
+
+	PIN_GetLock(&indirectLock, tid + 1);
+
+	indirectTargets.Add(target);
+
+	site->recent[site->nextSlot] = target;
+	site->nextSlot = (site->nextSlot + 1) % SITE_CACHE;
+
+	PIN_ReleaseLock(&indirectLock);
+}
 
 VOID Instruction(INS ins, void *v)
 {
 	v;
 
-	if (INS_IsBranchOrCall(ins)) 
+	if (!INS_IsBranchOrCall(ins))
+		return;
+
+	bool direct = INS_IsDirectBranchOrCall(ins);
+
+	// The same instruction can be instrumented in more than one trace
+	BranchSite*& site = sites[INS_Address(ins)];
+	if (site == NULL)
+		site = new BranchSite(direct ? INS_DirectBranchOrCallTargetAddress(ins) : 0);
+
+	// Only call out of the code cache the first time something new
+	// happens, after that the inlined guard is all that runs.
+	if (direct)
 	{
-		INS_InsertCall(ins, IPOINT_BEFORE, (AFUNPTR) handleInsertCall,
-			IARG_INST_PTR,
-			IARG_BRANCH_TARGET_ADDR,
+		INS_InsertIfCall(ins, IPOINT_BEFORE, (AFUNPTR)IsNewDirect,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_PTR, site,
+			IARG_BRANCH_TAKEN,
+			IARG_END);
+
+		INS_InsertThenCall(ins, IPOINT_BEFORE, (AFUNPTR)RecordDirect,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_PTR, site,
 			IARG_BRANCH_TAKEN,
 			IARG_END);
 	}
+	else
+	{
+		INS_InsertIfCall(ins, IPOINT_BEFORE, (AFUNPTR)IsNewIndirect,
+			IARG_FAST_ANALYSIS_CALL,
+			IARG_PTR, site,
+			IARG_BRANCH_TARGET_ADDR,
+			IARG_END);
+
+		INS_InsertThenCall(ins, IPOINT_BEFORE, (AFUNPTR)RecordIndirect,
+			IARG_PTR, site,
+			IARG_BRANCH_TARGET_ADDR,
+			IARG_THREAD_ID,
+			IARG_END);
+	}
+}
+
+static void ReadBlocks(const string& fileName, AddrSet& blocks)
+{
+	FILE* fin = fopen(fileName.c_str(), "rb");
+	if (fin == NULL)
+		return;
+
+	ADDRINT block = 0;
+
+	while (fscanf(fin, FMT, &block) == 1)
+		blocks.Add(block);
+
+	fclose(fin);
+}
+
+static void WriteBlocks(const string& fileName, const AddrSet& blocks)
+{
+	FILE* fout = fopen(fileName.c_str(), "wb");
+	if (fout == NULL)
+		return;
+
+	vector<ADDRINT> sorted = blocks.ToVector();
+
+	for (vector<ADDRINT>::iterator i = sorted.begin(); i != sorted.end(); ++i)
+		fprintf(fout, FMT, *i);
+
+	fclose(fout);
 }
 
 // Called at end of run
@@ -123,69 +307,52 @@ VOID Fini(INT32 code, VOID *v)
 	code;
 	v;
 
-	existing = fopen("cedge.known", "wb+");
-	if(existing != NULL)
+	// Start from the edges of earlier runs
+	AddrSet known, unknown, result;
+
+	ReadBlocks(OutFileBase + ".known", known);
+	ReadBlocks(OutFileBase + ".unknown", unknown);
+
+	vector<ADDRINT> indirect = indirectTargets.ToVector();
+	for (vector<ADDRINT>::iterator i = indirect.begin(); i != indirect.end(); ++i)
+		known.Add(*i);
+
+	for (map<ADDRINT, BranchSite*>::iterator i = sites.begin(); i != sites.end(); ++i)
 	{
-		for (set<ADDRINT>::iterator i = setKnownBlocks.begin(); i!=setKnownBlocks.end(); ++i)
-		{
-			fprintf(existing, FMT, *i);
-		}
+		BranchSite* site = i->second;
 
-		fclose(existing);
-		existing = NULL;
+		if (site->seen[1])
+			known.Add(site->target);
+		else if (site->seen[0])
+			unknown.Add(site->target);
 	}
 
-	existing = fopen("cedge.unknown", "wb+");
-	if(existing != NULL)
+	// An edge is only unknown if it was never taken by any run
+	vector<ADDRINT> maybe = unknown.ToVector();
+	for (vector<ADDRINT>::iterator i = maybe.begin(); i != maybe.end(); ++i)
 	{
-		for (set<ADDRINT>::iterator i = setUnknownBlocks.begin(); i != setUnknownBlocks.end(); ++i)
-		{
-			fprintf(existing, FMT, *i);
-		}
-
-		fclose(existing);
-		existing = NULL;
+		if (!known.Contains(*i))
+			result.Add(*i);
 	}
+
+	WriteBlocks(OutFileBase + ".known", known);
+	WriteBlocks(OutFileBase + ".unknown", result);
 }
 
 int main(int argc, char * argv[])
 {
-	// Load existing trace
-	ADDRINT block = 0;
-
-	// Load existing known edges
-	existing = fopen("cedge.known", "rb+");
-	if(existing != NULL)
+	// Configure Pin Tools
+	if (PIN_Init(argc, argv))
 	{
-		while(!feof(existing))
-		{
-			if(fscanf(existing, FMT, &block) < 4)
-				setKnownBlocks.insert(block);
-		}
-		
-		fclose(existing);
-		existing = NULL;
+		PIN_ERROR("This Pintool records taken and not taken branch edges\n"
+			+ KNOB_BASE::StringKnobSummary() + "\n");
+		return -1;
 	}
 
-	// Load existing unknown edges
-	existing = fopen("cedge.unknown", "rb+");
-	if(existing != NULL)
-	{
-		while(!feof(existing))
-		{
-			if(fscanf(existing, FMT, &block) < 4)
-				setUnknownBlocks.insert(block);
-		}
+	OutFileBase = KnobOutput.Value();
 
-		fclose(existing);
-		existing = NULL;
-	}
+	PIN_InitLock(&indirectLock);
 
-	//trace = fopen("bblocks.out", "wb+");
-	
-	// Configure Pin Tools
-	PIN_Init(argc, argv);
-	//TRACE_AddInstrumentFunction(Trace, 0);
 	INS_AddInstrumentFunction(Instruction, 0);
 	PIN_AddFiniFunction(Fini, 0);
 	PIN_StartProgram();
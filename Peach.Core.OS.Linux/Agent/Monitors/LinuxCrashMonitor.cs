@@ -31,7 +31,9 @@ using System.IO;
 using System.Diagnostics;
 using System.Collections.Generic;
 using System.Text;
+using System.Text.RegularExpressions;
 using System.Threading;
+using System.Reflection;
 
 using Peach.Core.Dom;
 using Peach.Core.Agent;
@@ -44,6 +46,7 @@ namespace Peach.Core.OS.Linux.Agent.Monitors
 	[Parameter("Executable", typeof(string), "Target executable used to filter crashes.", "")]
 	[Parameter("LogFolder", typeof(string), "Folder with log files. Defaults to /var/peachcrash", "/var/peachcrash")]
 	[Parameter("Mono", typeof(string), "Full path and executable for mono runtime. Defaults to /usr/bin/mono.", "/usr/bin/mono")]
+	[Parameter("NativeHandler", typeof(bool), "Collect cores with PeachCoreHandler, which keeps only the memory near the crash and classifies it", "false")]
 	public class LinuxCrashMonitor : Peach.Core.Agent.Monitor
 	{
 		protected string corePattern = "|{0} {1} -p=%p -u=%u -g=%g -s=%s -t=%t -h=%h -e=%e";
@@ -53,11 +56,20 @@ namespace Peach.Core.OS.Linux.Agent.Monitors
 		protected string origionalCorePattern = null;
 		protected string origionalSuidDumpable = null;
 		protected string linuxCrashHandlerExe = "PeachLinuxCrashHandler.exe";
+		protected string nativeCorePattern = "|{0} -p=%p -P=%P -u=%u -g=%g -s=%s -t=%t -e=%e -l={1}";
+		protected string nativeHandlerExe = "PeachCoreHandler";
+		protected bool nativeHandler = false;
 		protected bool logFolderCreated = false;
 
 		protected string data = null;
 		protected List<string> startingFiles = new List<string>();
 
+		Regex reHash = new Regex(@"^Hash: (\w+)\.(\w+)$", RegexOptions.Multiline);
+		Regex reClassification = new Regex(@"^Exploitability Classification: (.*)$", RegexOptions.Multiline);
+		Regex reDescription = new Regex(@"^Short description: (.*)$", RegexOptions.Multiline);
+		Regex reOther = new Regex(@"^Other tags: (.*)$", RegexOptions.Multiline);
+		Regex reLocation = new Regex(@"^Faulting location: (.*)\+0x([0-9a-f]+)$", RegexOptions.Multiline);
+
 		public LinuxCrashMonitor(IAgent agent, string name, Dictionary<string, Variant> args)
 			: base(agent, name, args)
 		{
@@ -66,6 +78,9 @@ namespace Peach.Core.OS.Linux.Agent.Monitors
 			
 			if (args.ContainsKey("LogFolder"))
 				logFolder = (string)args["LogFolder"];
+
+			if (args.ContainsKey("NativeHandler"))
+				nativeHandler = ((string)args["NativeHandler"]).ToLower() == "true";
 		}
 
 		public override void  StopMonitor()
@@ -77,7 +92,10 @@ namespace Peach.Core.OS.Linux.Agent.Monitors
 		public override void  SessionStarting()
 		{
 			// Ensure the crash handler has been installed at the right place
+			string handlerName = nativeHandler ? nativeHandlerExe : linuxCrashHandlerExe;
 			string handler = Path.DirectorySeparatorChar + linuxCrashHandlerExe;
+			if (nativeHandler)
+				handler = Path.Combine(Path.GetDirectoryName(Assembly.GetExecutingAssembly().Location), nativeHandlerExe);
 			if (!File.Exists(handler))
 				throw new PeachException("Error, LinuxCrashMonitor did not find crash handler located at '" + handler + "'.");
 
@@ -94,7 +112,7 @@ namespace Peach.Core.OS.Linux.Agent.Monitors
                 throw new PeachException("Error, accessing core_pattern failed",ex);
             }
 
-		    if (origionalCorePattern.IndexOf(linuxCrashHandlerExe) == -1)
+		    if (origionalCorePattern.IndexOf(handlerName) == -1)
 			{
 				// Register our crash handler via proc file system
 
@@ -102,13 +120,22 @@ namespace Peach.Core.OS.Linux.Agent.Monitors
 					monoExecutable,
 					linuxCrashHandlerExe);
 
+				if (nativeHandler)
+				{
+					corePat = string.Format(nativeCorePattern, handler, logFolder);
+
+					// The kernel truncates core_pattern to 127 characters
+					if (corePat.Length > 127)
+						throw new PeachException("Error, LinuxCrashMonitor core pattern '" + corePat + "' is too long, use a shorter LogFolder.");
+				}
+
 				File.WriteAllText(
 					"/proc/sys/kernel/core_pattern",
 					corePat,
 					System.Text.Encoding.ASCII);
 
 				var checkWrite = File.ReadAllText("/proc/sys/kernel/core_pattern", System.Text.Encoding.ASCII);
-				if (checkWrite.IndexOf(linuxCrashHandlerExe) == -1)
+				if (checkWrite.IndexOf(handlerName) == -1)
 					throw new PeachException("Error, LinuxCrashMonitor was unable to update /proc/sys/kernel/core_pattern.");
 			}
 			else
@@ -231,18 +258,14 @@ namespace Peach.Core.OS.Linux.Agent.Monitors
 				{
 					if (executable != null)
 					{
+						// The handlers write a .core and a .info for each crash
 						if (file.IndexOf(executable) != -1)
-						{
-							fault.collectedData.Add(new Fault.Data(Path.GetFileName(file), File.ReadAllBytes(file)));
-							File.Delete(file);
-							break;
-						}
+							CollectFile(fault, file);
 					}
 					else
 					{
 						// Support multiple crash files
-						fault.collectedData.Add(new Fault.Data(Path.GetFileName(file), File.ReadAllBytes(file)));
-						File.Delete(file);
+						CollectFile(fault, file);
 					}
 				}
 				catch (UnauthorizedAccessException ex)
@@ -254,6 +277,47 @@ namespace Peach.Core.OS.Linux.Agent.Monitors
 			return fault;
 		}
 
+		void CollectFile(Fault fault, string file)
+		{
+			var bytes = File.ReadAllBytes(file);
+
+			fault.collectedData.Add(new Fault.Data(Path.GetFileName(file), bytes));
+			File.Delete(file);
+
+			// PeachCoreHandler classifies the crash like gdb's exploitable
+			if (!file.EndsWith(".info"))
+				return;
+
+			string output = Encoding.UTF8.GetString(bytes);
+
+			var hash = reHash.Match(output);
+			if (!hash.Success)
+				return;
+
+			fault.majorHash = hash.Groups[1].Value;
+			fault.minorHash = hash.Groups[2].Value;
+
+			var exp = reClassification.Match(output);
+			if (exp.Success)
+				fault.exploitability = exp.Groups[1].Value;
+
+			var desc = reDescription.Match(output);
+			if (desc.Success)
+				fault.title = desc.Groups[1].Value;
+
+			var other = reOther.Match(output);
+			if (other.Success)
+				fault.title += ", " + other.Groups[1].Value;
+
+			// Only printed by the native triage
+			var loc = reLocation.Match(output);
+			if (loc.Success)
+			{
+				fault.faultingModule = loc.Groups[1].Value;
+				fault.faultingOffset = Convert.ToUInt64(loc.Groups[2].Value, 16);
+			}
+		}
+
 		public override bool  MustStop()
 		{
 			return false;
@@ -27,6 +27,7 @@ namespace Peach.Core.OS.Linux.Agent.Monitors
 	[Parameter("StartOnCall", typeof(string), "Start command on state model call", "")]
 	[Parameter("WaitForExitOnCall", typeof(string), "Wait for process to exit on state model call and fault if timeout is reached", "")]
 	[Parameter("WaitForExitTimeout", typeof(int), "Wait for exit timeout value in milliseconds (-1 is infinite)", "10000")]
+	[Parameter("NativeTriage", typeof(bool), "Run the target under PeachTriage instead of gdb", "false")]
 	public class LinuxDebugger : Peach.Core.Agent.Monitor
 	{
 		static NLog.Logger logger = LogManager.GetCurrentClassLogger();
@@ -67,6 +68,7 @@ quit
 		Fault _fault = null;
 		bool _messageExit = false;
 		string _exploitable = null;
+		string _triage = null;
 		string _tmpPath = null;
 		string _gdbCmd = null;
 		string _gdbPid = null;
@@ -76,6 +78,7 @@ quit
 		Regex reClassification = new Regex(@"^Exploitability Classification: (.*)$", RegexOptions.Multiline);
 		Regex reDescription = new Regex(@"^Short description: (.*)$", RegexOptions.Multiline);
 		Regex reOther = new Regex(@"^Other tags: (.*)$", RegexOptions.Multiline);
+		Regex reLocation = new Regex(@"^Faulting location: (.*)\+0x([0-9a-f]+)$", RegexOptions.Multiline);
 
 		public string GdbPath { get; private set; }
 		public string Executable { get; private set; }
@@ -86,19 +89,22 @@ quit
 		public string StartOnCall { get; private set; }
 		public string WaitForExitOnCall { get; private set; }
 		public int WaitForExitTimeout { get; private set; }
+		public bool NativeTriage { get; private set; }
 
 		public LinuxDebugger(IAgent agent, string name, Dictionary<string, Variant> args)
 			: base(agent, name, args)
 		{
 			ParameterParser.Parse(this, args);
 
-			_exploitable = FindExploitable();
+			// PeachTriage applies the exploitable rules itself, gdb isn't needed
+			if (NativeTriage)
+				_triage = FindFile("PeachTriage");
+			else
+				_exploitable = FindFile("gdb/exploitable/exploitable.py");
 		}
 
-		string FindExploitable()
+		string FindFile(string target)
 		{
-			var target = "gdb/exploitable/exploitable.py";
-
 			var dirs = new List<string> {
 				Path.GetDirectoryName(Assembly.GetExecutingAssembly().Location),
 				Directory.GetCurrentDirectory(),
@@ -121,10 +127,20 @@ quit
 		void _Start()
 		{
 			var si = new ProcessStartInfo();
-			si.FileName = GdbPath;
-			si.Arguments = "-batch -n -x " + _gdbCmd;
 			si.UseShellExecute = false;
 
+			if (NativeTriage)
+			{
+				// PeachTriage writes the same pid file and exploitable log as the gdb script
+				si.FileName = _triage;
+				si.Arguments = "-p \"{0}\" -o \"{1}\" -- \"{2}\" {3}".Fmt(_gdbPid, _gdbLog, Executable, Arguments);
+			}
+			else
+			{
+				si.FileName = GdbPath;
+				si.Arguments = "-batch -n -x " + _gdbCmd;
+			}
+
 			_procHandler = new System.Diagnostics.Process();
 			_procHandler.StartInfo = si;
 
@@ -143,7 +159,7 @@ quit
 			catch (Exception ex)
 			{
 				_procHandler = null;
-				throw new PeachException("Could not start debugger '" + GdbPath + "'.  " + ex.Message + ".", ex);
+				throw new PeachException("Could not start debugger '" + si.FileName + "'.  " + ex.Message + ".", ex);
 			}
 
 			// Wait for pid file to exist, open it up and read it
@@ -344,6 +360,14 @@ quit
 			if (other.Success)
 				_fault.title += ", " + other.Groups[1].Value;
 
+			// Only printed by the native triage
+			var loc = reLocation.Match(output);
+			if (loc.Success)
+			{
+				_fault.faultingModule = loc.Groups[1].Value;
+				_fault.faultingOffset = Convert.ToUInt64(loc.Groups[2].Value, 16);
+			}
+
 			_fault.collectedData.Add(new Fault.Data("StackTrace.txt", bytes));
 			_fault.description = output;
 
@@ -372,10 +396,13 @@ quit
 			_gdbPid = Path.Combine(_tmpPath, "gdb.pid");
 			_gdbLog = Path.Combine(_tmpPath, "gdb.log");
 
-			string cmd = string.Format(template, _gdbLog, Executable, Arguments, _exploitable, _gdbPid);
-			File.WriteAllText(_gdbCmd, cmd);
+			if (!NativeTriage)
+			{
+				string cmd = string.Format(template, _gdbLog, Executable, Arguments, _exploitable, _gdbPid);
+				File.WriteAllText(_gdbCmd, cmd);
 
-			logger.Debug("Wrote gdb commands to '{0}'", _gdbCmd);
+				logger.Debug("Wrote gdb commands to '{0}'", _gdbCmd);
+			}
 
 			if (StartOnCall == null && !RestartOnEachTest)
 				_Start();
@@ -0,0 +1,471 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+using System.Reflection;
+using System.Runtime.InteropServices;
+
+using Peach.Core;
+using Peach.Core.Agent;
+
+using NLog;
+
+namespace Peach.Core.OS.Linux.Agent.Monitors
+{
+	/// <summary>
+	/// Start the target once with the fork server (PeachForkServer) preloaded
+	/// and fork a fresh copy of it for every iteration.  The target stops at
+	/// main() after it has been loaded, so each iteration only costs a fork().
+	/// Crashes are reported with the signal and faulting address.
+	/// </summary>
+	[Monitor("LinuxForkServer", true)]
+	[Parameter("Executable", typeof(string), "Executable to launch")]
+	[Parameter("Arguments", typeof(string), "Optional command line arguments", "")]
+	[Parameter("StartOnCall", typeof(string), "Start command on state model call", "")]
+	[Parameter("WaitForExitOnCall", typeof(string), "Wait for process to exit on state model call and fault if timeout is reached", "")]
+	[Parameter("WaitForExitTimeout", typeof(int), "Wait for exit timeout value in milliseconds (-1 is infinite)", "10000")]
+	public class LinuxForkServer : Peach.Core.Agent.Monitor
+	{
+		static NLog.Logger logger = LogManager.GetCurrentClassLogger();
+
+		const string EnvironmentName = "PEACH_FORKSRV";
+		const string Library = "libPeachForkServer.so";
+
+		// ForkStatus from PeachForkServer.cpp
+		const int StatusSize = 16;
+
+		const int SIGKILL = 9;
+
+		static readonly Dictionary<uint, string> signals = new Dictionary<uint, string>()
+		{
+			{ 4, "SIGILL" },
+			{ 5, "SIGTRAP" },
+			{ 6, "SIGABRT" },
+			{ 7, "SIGBUS" },
+			{ 8, "SIGFPE" },
+			{ 11, "SIGSEGV" },
+		};
+
+		Process _server = null;
+		FileStream _serverCtl = null;
+		FileStream _serverStatus = null;
+		string _serverBase = null;
+		string _library = null;
+
+		// Reads survive a timeout, the status of a hung child arrives after it is killed
+		byte[] _buf = new byte[StatusSize];
+		int _offset = 0;
+		IAsyncResult _pending = null;
+
+		int _child = 0;
+		Fault _fault = null;
+		bool _messageExit = false;
+
+		public string Executable { get; private set; }
+		public string Arguments { get; private set; }
+		public string StartOnCall { get; private set; }
+		public string WaitForExitOnCall { get; private set; }
+		public int WaitForExitTimeout { get; private set; }
+
+		public LinuxForkServer(IAgent agent, string name, Dictionary<string, Variant> args)
+			: base(agent, name, args)
+		{
+			ParameterParser.Parse(this, args);
+
+			_library = FindLibrary();
+		}
+
+		string FindLibrary()
+		{
+			var dirs = new List<string> {
+				Path.GetDirectoryName(Assembly.GetExecutingAssembly().Location),
+				Directory.GetCurrentDirectory(),
+			};
+
+			string path = Environment.GetEnvironmentVariable("PATH");
+			if (!string.IsNullOrEmpty(path))
+				dirs.AddRange(path.Split(Path.PathSeparator));
+
+			foreach (var dir in dirs)
+			{
+				string full = Path.Combine(dir, Library);
+				if (File.Exists(full))
+					return full;
+			}
+
+			throw new PeachException("Error, LinuxForkServer could not find '" + Library + "' in search path.");
+		}
+
+		[DllImport("libc", SetLastError = true)]
+		static extern int mkfifo(string path, int mode);
+
+		[DllImport("libc", SetLastError = true)]
+		static extern int kill(int pid, int sig);
+
+		void _StartServer()
+		{
+			_StopServer();
+
+			_serverBase = Path.Combine(Path.GetTempPath(), "peach_forksrv_" + Guid.NewGuid().ToString("N"));
+
+			foreach (var fifo in new[] { _serverBase + ".ctl", _serverBase + ".st" })
+			{
+				// 0600
+				if (mkfifo(fifo, 0x180) != 0)
+					throw new PeachException("Failed to create fork server fifo '{0}', error {1}.".Fmt(fifo, Marshal.GetLastWin32Error()));
+			}
+
+			// Open both fifos read/write so neither side blocks waiting on the other
+			_serverCtl = new FileStream(_serverBase + ".ctl", FileMode.Open, FileAccess.ReadWrite);
+			_serverStatus = new FileStream(_serverBase + ".st", FileMode.Open, FileAccess.ReadWrite);
+
+			var si = new ProcessStartInfo();
+			si.FileName = Executable;
+			si.Arguments = Arguments ?? "";
+			si.UseShellExecute = false;
+			si.EnvironmentVariables["LD_PRELOAD"] = _library;
+			si.EnvironmentVariables[EnvironmentName] = _serverBase;
+
+			_server = new Process();
+			_server.StartInfo = si;
+
+			logger.Debug("_StartServer(): Starting fork server");
+
+			try
+			{
+				_server.Start();
+			}
+			catch (Exception ex)
+			{
+				_server.Dispose();
+				_server = null;
+				_StopServer();
+				throw new PeachException("Could not start process '" + Executable + "'.  " + ex.Message + ".", ex);
+			}
+
+			// Server writes its pid once main() has been reached
+			try
+			{
+				_ReadServer(4, -1);
+			}
+			catch (PeachException)
+			{
+				_StopServer();
+				throw new PeachException("Process '" + Executable + "' did not start the fork server.");
+			}
+
+			logger.Debug("Fork server started, pid: {0}", BitConverter.ToInt32(_buf, 0));
+		}
+
+		void _StopServer()
+		{
+			// The server is going away, how the child ends doesn't matter
+			if (_child != 0)
+			{
+				kill(_child, SIGKILL);
+				_child = 0;
+			}
+
+			// Closing the control fifo tells the server to exit
+			if (_serverCtl != null)
+			{
+				_serverCtl.Dispose();
+				_serverCtl = null;
+			}
+
+			if (_server != null)
+			{
+				try
+				{
+					if (!_server.HasExited && !_server.WaitForExit(5000))
+						_server.Kill();
+				}
+				catch (InvalidOperationException)
+				{
+				}
+
+				_server.Dispose();
+				_server = null;
+			}
+
+			if (_serverStatus != null)
+			{
+				_serverStatus.Dispose();
+				_serverStatus = null;
+			}
+
+			_pending = null;
+			_offset = 0;
+
+			if (_serverBase != null)
+			{
+				foreach (var file in new[] { _serverBase + ".ctl", _serverBase + ".st" })
+				{
+					try
+					{
+						File.Delete(file);
+					}
+					catch (IOException)
+					{
+					}
+				}
+
+				_serverBase = null;
+			}
+		}
+
+		/// <summary>
+		/// Read count bytes from the server into _buf.  Returns false if they
+		/// didn't arrive within timeout, the read is picked up by the next call.
+		/// </summary>
+		bool _ReadServer(int count, int timeout)
+		{
+			var sw = Stopwatch.StartNew();
+
+			while (_offset < count)
+			{
+				if (_pending == null)
+					_pending = _serverStatus.BeginRead(_buf, _offset, count - _offset, null, null);
+
+				// Data wakes us immediately, the steps are only to notice the server dying
+				while (!_pending.AsyncWaitHandle.WaitOne(timeout < 0 ? 250 : (int)Math.Max(0, Math.Min(250, timeout - sw.ElapsedMilliseconds))))
+				{
+					if (_server.HasExited)
+						throw new PeachException("Fork server exited unexpectedly.");
+
+					if (timeout >= 0 && sw.ElapsedMilliseconds >= timeout)
+						return false;
+				}
+
+				var len = _serverStatus.EndRead(_pending);
+				_pending = null;
+
+				if (len == 0)
+					throw new PeachException("Fork server closed the status fifo.");
+
+				_offset += len;
+			}
+
+			_offset = 0;
+			return true;
+		}
+
+		void _Start()
+		{
+			_KillChild();
+
+			if (_server == null || _server.HasExited)
+				_StartServer();
+
+			logger.Debug("_Start(): Forking process");
+
+			try
+			{
+				_serverCtl.Write(BitConverter.GetBytes(0), 0, 4);
+				_serverCtl.Flush();
+
+				_ReadServer(4, -1);
+			}
+			catch (Exception ex)
+			{
+				_StopServer();
+
+				if (ex is PeachException)
+					throw;
+
+				throw new PeachException("Failed to run '" + Executable + "' with the fork server.", ex);
+			}
+
+			_child = BitConverter.ToInt32(_buf, 0);
+
+			logger.Debug("_Start(): Child pid: {0}", _child);
+		}
+
+		/// <summary>
+		/// Wait for the child to exit and record any crash.  Returns false
+		/// if the child is still running after timeout milliseconds.
+		/// </summary>
+		bool _WaitForExit(int timeout)
+		{
+			if (_child == 0)
+				return true;
+
+			try
+			{
+				if (!_ReadServer(StatusSize, timeout))
+					return false;
+			}
+			catch (PeachException ex)
+			{
+				logger.Debug("_WaitForExit(): {0}", ex.Message);
+				_StopServer();
+				return true;
+			}
+
+			_child = 0;
+
+			var exitCode = BitConverter.ToUInt32(_buf, 0);
+			var signal = BitConverter.ToUInt32(_buf, 4);
+			var address = BitConverter.ToUInt64(_buf, 8);
+
+			string name;
+
+			if (signal == 0)
+			{
+				logger.Debug("Process exited, code: {0}", exitCode);
+			}
+			else if (!signals.TryGetValue(signal, out name))
+			{
+				logger.Debug("Process exited, signal: {0}", signal);
+			}
+			else if (_fault == null)
+			{
+				logger.Debug("Process crashed with {0} at 0x{1:x}.", name, address);
+
+				_fault = MakeFault(null, "Process crashed with " + name);
+				_fault.majorHash = name;
+				_fault.minorHash = "0x{0:x}".Fmt(address);
+				_fault.exploitability = "UNKNOWN";
+				_fault.description += "Address: 0x{0:x16}\n".Fmt(address);
+			}
+
+			return true;
+		}
+
+		void _KillChild()
+		{
+			if (_child == 0)
+				return;
+
+			// Pick up an exit that was already reported before killing the pid
+			if (_WaitForExit(0))
+				return;
+
+			logger.Debug("_KillChild(): Killing process");
+
+			kill(_child, SIGKILL);
+
+			// The server reaps the child and reports it
+			if (!_WaitForExit(5000))
+				_StopServer();
+		}
+
+		Fault MakeFault(string folder, string reason)
+		{
+			return new Fault()
+			{
+				type = FaultType.Fault,
+				detectionSource = "LinuxForkServer",
+				title = reason,
+				description = "{0}: {1} {2}\n".Fmt(reason, Executable, Arguments),
+				folderName = folder,
+			};
+		}
+
+		public override void IterationStarting(uint iterationCount, bool isReproduction)
+		{
+			_fault = null;
+			_messageExit = false;
+
+			if (StartOnCall == null)
+				_Start();
+		}
+
+		public override bool DetectedFault()
+		{
+			return _fault != null;
+		}
+
+		public override Fault GetMonitorData()
+		{
+			return _fault;
+		}
+
+		public override bool MustStop()
+		{
+			return false;
+		}
+
+		public override void StopMonitor()
+		{
+			_StopServer();
+		}
+
+		public override void SessionStarting()
+		{
+			// Keep loading the target out of the first iteration
+			_StartServer();
+		}
+
+		public override void SessionFinished()
+		{
+			_StopServer();
+		}
+
+		public override bool IterationFinished()
+		{
+			// Give a started command time to finish, anything else runs
+			// until the end of the iteration
+			if (!_messageExit && StartOnCall != null)
+				_WaitForExit(WaitForExitTimeout);
+
+			_KillChild();
+
+			return true;
+		}
+
+		public override Variant Message(string name, Variant data)
+		{
+			if (name == "Action.Call" && ((string)data) == StartOnCall)
+			{
+				_Start();
+			}
+			else if (name == "Action.Call" && ((string)data) == WaitForExitOnCall)
+			{
+				_messageExit = true;
+
+				logger.Debug("WaitForExit({0})", WaitForExitTimeout == -1 ? "INFINITE" : WaitForExitTimeout.ToString());
+
+				if (!_WaitForExit(WaitForExitTimeout))
+				{
+					logger.Debug("FAULT, WaitForExit ran out of time!");
+					_fault = MakeFault("ProcessFailedToExit", "Process did not exit in " + WaitForExitTimeout + "ms");
+				}
+
+				_KillChild();
+			}
+
+			return null;
+		}
+	}
+}
+
+// end
@@ -0,0 +1,89 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.Linq;
+
+using NUnit.Framework;
+
+using Peach.Core.Analysis;
+
+namespace Peach.Core.Test.Analysis
+{
+	[TestFixture]
+	class CoverageBitmapTests
+	{
+		// Opens the bitmap by name the same way the pin tool does
+		static MemoryMappedFile OpenLikePinTool(CoverageBitmap bitmap)
+		{
+			if (Platform.GetOS() == Platform.OS.Windows)
+				return MemoryMappedFile.OpenExisting(bitmap.Name);
+
+			return MemoryMappedFile.CreateFromFile(bitmap.Name, FileMode.Open, null, bitmap.Size, MemoryMappedFileAccess.ReadWrite);
+		}
+
+		// Same update EdgeExecuted in bblocks.cpp performs for every block
+		static void RunEdges(byte[] map, IEnumerable<uint> blocks)
+		{
+			uint prev = 0;
+
+			foreach (var cur in blocks)
+			{
+				map[prev ^ cur]++;
+				prev = cur >> 1;
+			}
+		}
+
+		[Test]
+		public void TestRoundTrip()
+		{
+			var blocks = new uint[] { 0x12, 0x80, 0xf3, 0x80, 0xf3, 0x80 };
+			var expected = new byte[256];
+
+			RunEdges(expected, blocks);
+
+			using (var bitmap = new CoverageBitmap(256))
+			{
+				Assert.AreEqual(256, bitmap.Size);
+				Assert.AreEqual(0, bitmap.Count);
+
+				using (var map = OpenLikePinTool(bitmap))
+				using (var view = map.CreateViewAccessor(0, bitmap.Size))
+				{
+					var edges = new byte[bitmap.Size];
+					RunEdges(edges, blocks);
+					view.WriteArray(0, edges, 0, edges.Length);
+					view.Flush();
+				}
+
+				Assert.AreEqual(expected, bitmap.ToArray());
+				Assert.AreEqual(expected.Count(b => b != 0), bitmap.Count);
+
+				bitmap.Clear();
+
+				Assert.AreEqual(new byte[256], bitmap.ToArray());
+				Assert.AreEqual(0, bitmap.Count);
+			}
+		}
+
+		[Test]
+		public void TestDispose()
+		{
+			var bitmap = new CoverageBitmap();
+			var name = bitmap.Name;
+
+			Assert.AreEqual(CoverageBitmap.DefaultSize, bitmap.Size);
+
+			bitmap.Dispose();
+
+			if (Platform.GetOS() != Platform.OS.Windows)
+				Assert.False(File.Exists(name));
+		}
+
+		[Test]
+		public void TestBadSize()
+		{
+			Assert.Throws<ArgumentException>(delegate() { new CoverageBitmap(1000); });
+		}
+	}
+}
@@ -0,0 +1,142 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+
+using NUnit.Framework;
+
+using Peach.Core.Analysis;
+
+namespace Peach.Core.Test.Analysis
+{
+	[TestFixture]
+	class MinsetDatabaseTests
+	{
+		string tmp;
+
+		[SetUp]
+		public void SetUp()
+		{
+			tmp = Path.Combine(Path.GetTempPath(), "MinsetDatabaseTests_" + Guid.NewGuid().ToString("N"));
+			Directory.CreateDirectory(tmp);
+		}
+
+		[TearDown]
+		public void TearDown()
+		{
+			Directory.Delete(tmp, true);
+		}
+
+		string MakeSample(string name, params ulong[] blocks)
+		{
+			var sample = Path.Combine(tmp, name);
+			File.WriteAllText(sample, name);
+
+			var trace = new Dictionary<string, IEnumerable<ulong>>();
+			trace["prog"] = blocks;
+			TraceFile.Write(sample + ".trace", trace);
+
+			return sample;
+		}
+
+		[Test]
+		public void TestRoundTrip()
+		{
+			var db = new MinsetDatabase();
+			var prog = db.GetModule("prog");
+			var libc = db.GetModule("libc.so");
+
+			db.Entries.Add(new MinsetEntry("a.bin", 1, new[] {
+				new TraceBlock(prog, 16), new TraceBlock(prog, 4096), new TraceBlock(libc, 1) }));
+			db.Entries.Add(new MinsetEntry("b.bin", 2.5, new TraceBlock[0]));
+
+			var file = Path.Combine(tmp, "minset.db");
+			db.Save(file);
+
+			var other = new MinsetDatabase(file);
+
+			Assert.AreEqual(new[] { "prog", "libc.so" }, other.Modules.ToArray());
+			Assert.AreEqual(2, other.Entries.Count);
+			Assert.AreEqual("a.bin", other.Entries[0].Sample);
+			Assert.AreEqual(1, other.Entries[0].Weight);
+			Assert.AreEqual(db.Entries[0].Blocks, other.Entries[0].Blocks);
+			Assert.AreEqual("b.bin", other.Entries[1].Sample);
+			Assert.AreEqual(2.5, other.Entries[1].Weight);
+			Assert.AreEqual(0, other.Entries[1].Blocks.Length);
+			Assert.AreEqual(3, other.CountBlocks());
+		}
+
+		[Test]
+		public void TestBadMagic()
+		{
+			var file = Path.Combine(tmp, "minset.db");
+			File.WriteAllText(file, "not a database");
+
+			Assert.Throws<PeachException>(delegate() { new MinsetDatabase(file); });
+		}
+
+		[Test]
+		public void TestUpdate()
+		{
+			var db = new MinsetDatabase();
+			var ms = new Minset();
+			string[] removed;
+
+			var a = MakeSample("a.bin", 1, 2);
+			var b = MakeSample("b.bin", 3, 4);
+
+			var added = ms.UpdateCoverage(db, new[] { a, b }, new[] { a + ".trace", b + ".trace" }, out removed);
+
+			Assert.AreEqual(new[] { a, b }, added);
+			Assert.AreEqual(0, removed.Length);
+			Assert.AreEqual(2, db.Entries.Count);
+
+			// Covers both kept samples and one more block
+			var c = MakeSample("c.bin", 1, 2, 3, 4, 5);
+
+			// The kept traces are gone, only the database knows about them
+			File.Delete(a + ".trace");
+			File.Delete(b + ".trace");
+
+			added = ms.UpdateCoverage(db, new[] { c }, new[] { c + ".trace" }, out removed);
+
+			Assert.AreEqual(new[] { c }, added);
+			Assert.AreEqual(new[] { "a.bin", "b.bin" }, removed);
+			Assert.AreEqual(1, db.Entries.Count);
+			Assert.AreEqual("c.bin", db.Entries[0].Sample);
+			Assert.AreEqual(5, db.CountBlocks());
+
+			// Nothing new, so nothing changes
+			var d = MakeSample("d.bin", 2, 3);
+
+			added = ms.UpdateCoverage(db, new[] { d }, new[] { d + ".trace" }, out removed);
+
+			Assert.AreEqual(0, added.Length);
+			Assert.AreEqual(0, removed.Length);
+			Assert.AreEqual("c.bin", db.Entries[0].Sample);
+		}
+
+		[Test]
+		public void TestUpdateBadTrace()
+		{
+			var db = new MinsetDatabase();
+			var ms = new Minset();
+			string[] removed;
+
+			var a = MakeSample("a.bin", 1, 2);
+
+			ms.UpdateCoverage(db, new[] { a }, new[] { a + ".trace" }, out removed);
+
+			// A new a.bin whose trace can't be read keeps the old one
+			File.WriteAllBytes(a + ".trace", new byte[] { 0x50, 0x54, 0x52, 0x43, 1 });
+
+			var added = ms.UpdateCoverage(db, new[] { a }, new[] { a + ".trace" }, out removed);
+
+			Assert.AreEqual(0, added.Length);
+			Assert.AreEqual(0, removed.Length);
+			Assert.AreEqual(1, db.Entries.Count);
+			Assert.AreEqual("a.bin", db.Entries[0].Sample);
+			Assert.AreEqual(2, db.CountBlocks());
+		}
+	}
+}
@@ -0,0 +1,106 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+
+using NUnit.Framework;
+
+using Peach.Core.Analysis;
+
+namespace Peach.Core.Test.Analysis
+{
+	[TestFixture]
+	class SetCoverTests
+	{
+		[Test]
+		public void TestGreedy()
+		{
+			// In order, 0 and 1 are both kept.  Only 2 is needed.
+			var cover = new SetCover();
+			cover.Add(new[] { 1, 2 }, 1);
+			cover.Add(new[] { 3, 4 }, 1);
+			cover.Add(new[] { 1, 2, 3, 4 }, 1);
+
+			Assert.AreEqual(new[] { 2 }, cover.Solve());
+		}
+
+		[Test]
+		public void TestDuplicates()
+		{
+			var cover = new SetCover();
+			cover.Add(new[] { 5, 5, 5, 5 }, 1);
+			cover.Add(new[] { 5, 6 }, 1);
+
+			Assert.AreEqual(new[] { 1 }, cover.Solve());
+		}
+
+		[Test]
+		public void TestWeighted()
+		{
+			// The big sample covers everything but costs more than the two small ones
+			var cover = new SetCover();
+			cover.Add(new[] { 0, 1, 2, 3 }, 100);
+			cover.Add(new[] { 0, 1 }, 10);
+			cover.Add(new[] { 2, 3 }, 10);
+
+			Assert.AreEqual(new[] { 1, 2 }, cover.Solve());
+		}
+
+		[Test]
+		public void TestCoversAll()
+		{
+			var rnd = new Random(1234);
+			var cover = new SetCover();
+			var sets = new List<int[]>();
+
+			for (int i = 0; i < 200; ++i)
+			{
+				var set = Enumerable.Range(0, rnd.Next(1, 50)).Select(x => rnd.Next(0, 1000)).ToArray();
+				sets.Add(set);
+				cover.Add(set, 1);
+			}
+
+			var picked = cover.Solve();
+			var all = new HashSet<int>(sets.SelectMany(x => x));
+			var got = new HashSet<int>(picked.SelectMany(x => sets[x]));
+
+			Assert.True(all.SetEquals(got));
+			Assert.Less(picked.Length, sets.Count);
+		}
+
+		[Test]
+		public void TestSpill()
+		{
+			var rnd = new Random(4321);
+			var tmp = Path.GetTempFileName();
+
+			using (var spilled = new SetCover(tmp))
+			{
+				var cover = new SetCover();
+
+				for (int i = 0; i < 200; ++i)
+				{
+					// Large ids and gaps exercise multi-byte varints
+					var set = Enumerable.Range(0, rnd.Next(0, 50)).Select(x => rnd.Next(0, 100000)).ToArray();
+					var weight = rnd.Next(1, 10);
+
+					cover.Add(set, weight);
+					spilled.Add(set, weight);
+				}
+
+				Assert.AreEqual(cover.Solve(), spilled.Solve());
+			}
+
+			Assert.False(File.Exists(tmp));
+		}
+
+		[Test]
+		public void TestEmpty()
+		{
+			var cover = new SetCover();
+			cover.Add(new int[0], 1);
+
+			Assert.AreEqual(0, cover.Solve().Length);
+		}
+	}
+}
@@ -0,0 +1,190 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+using NUnit.Framework;
+
+using Peach.Core.Analysis;
+
+namespace Peach.Core.Test.Analysis
+{
+	[TestFixture]
+	class TraceFileTests
+	{
+		string tmp;
+
+		[SetUp]
+		public void SetUp()
+		{
+			tmp = Path.GetTempFileName();
+		}
+
+		[TearDown]
+		public void TearDown()
+		{
+			File.Delete(tmp);
+		}
+
+		static void WriteUInt32(List<byte> buf, uint value)
+		{
+			buf.AddRange(BitConverter.GetBytes(value));
+		}
+
+		static void WriteVarInt(List<byte> buf, ulong value)
+		{
+			for (; value >= 0x80; value >>= 7)
+				buf.Add((byte)((value & 0x7f) | 0x80));
+
+			buf.Add((byte)value);
+		}
+
+		[Test]
+		public void TestBinary()
+		{
+			var buf = new List<byte>();
+
+			buf.AddRange(Encoding.ASCII.GetBytes("PTRC"));
+			WriteUInt32(buf, 1);
+			WriteUInt32(buf, 2);
+
+			WriteUInt32(buf, 7);
+			buf.AddRange(Encoding.ASCII.GetBytes("libc.so"));
+			WriteUInt32(buf, 3);
+
+			WriteUInt32(buf, 4);
+			buf.AddRange(Encoding.ASCII.GetBytes("prog"));
+			WriteUInt32(buf, 1);
+
+			WriteVarInt(buf, 16);
+			WriteVarInt(buf, 200);
+			WriteVarInt(buf, 100000);
+
+			WriteVarInt(buf, 0x401000);
+
+			File.WriteAllBytes(tmp, buf.ToArray());
+
+			Assert.True(TraceFile.IsBinary(tmp));
+
+			var trace = new TraceFile(tmp);
+
+			Assert.AreEqual(new[] { "libc.so", "prog" }, trace.Modules);
+			Assert.AreEqual(4, trace.Count);
+
+			var blocks = trace.Blocks.ToList();
+
+			Assert.AreEqual(4, blocks.Count);
+			Assert.AreEqual(new TraceBlock(0, 16), blocks[0]);
+			Assert.AreEqual(new TraceBlock(0, 216), blocks[1]);
+			Assert.AreEqual(new TraceBlock(0, 100216), blocks[2]);
+			Assert.AreEqual(new TraceBlock(1, 0x401000), blocks[3]);
+		}
+
+		[Test]
+		public void TestBadVersion()
+		{
+			var buf = new List<byte>();
+
+			buf.AddRange(Encoding.ASCII.GetBytes("PTRC"));
+			WriteUInt32(buf, 99);
+			WriteUInt32(buf, 0);
+
+			File.WriteAllBytes(tmp, buf.ToArray());
+
+			Assert.Throws<PeachException>(delegate() { new TraceFile(tmp); });
+		}
+
+		[Test]
+		public void TestVarIntTooLong()
+		{
+			var buf = new List<byte>();
+
+			buf.AddRange(Encoding.ASCII.GetBytes("PTRC"));
+			WriteUInt32(buf, 1);
+			WriteUInt32(buf, 1);
+
+			WriteUInt32(buf, 4);
+			buf.AddRange(Encoding.ASCII.GetBytes("prog"));
+			WriteUInt32(buf, 1);
+
+			for (int i = 0; i < 11; ++i)
+				buf.Add(0x80);
+
+			buf.Add(0);
+
+			File.WriteAllBytes(tmp, buf.ToArray());
+
+			var trace = new TraceFile(tmp);
+
+			Assert.Throws<PeachException>(delegate() { trace.Blocks.ToList(); });
+		}
+
+		[Test]
+		public void TestTruncated()
+		{
+			var buf = new List<byte>();
+
+			buf.AddRange(Encoding.ASCII.GetBytes("PTRC"));
+			WriteUInt32(buf, 1);
+			WriteUInt32(buf, 1);
+
+			WriteUInt32(buf, 4);
+			buf.AddRange(Encoding.ASCII.GetBytes("prog"));
+			WriteUInt32(buf, 2);
+
+			WriteVarInt(buf, 16);
+
+			File.WriteAllBytes(tmp, buf.ToArray());
+
+			var trace = new TraceFile(tmp);
+
+			var ex = Assert.Throws<PeachException>(delegate() { trace.Blocks.ToList(); });
+			StringAssert.Contains(tmp, ex.Message);
+		}
+
+		[Test]
+		public void TestText()
+		{
+			File.WriteAllText(tmp, "prog: 10\nlibc.so: 20\nprog: 5\n");
+
+			Assert.False(TraceFile.IsBinary(tmp));
+
+			var trace = new TraceFile(tmp);
+
+			Assert.AreEqual(new[] { "prog", "libc.so" }, trace.Modules);
+			Assert.AreEqual(3, trace.Count);
+
+			var blocks = trace.Blocks.ToList();
+
+			Assert.AreEqual(new TraceBlock(0, 10), blocks[0]);
+			Assert.AreEqual(new TraceBlock(1, 20), blocks[1]);
+			Assert.AreEqual(new TraceBlock(0, 5), blocks[2]);
+		}
+
+		[Test]
+		public void TestWrite()
+		{
+			var blocks = new Dictionary<string, IEnumerable<ulong>>();
+			blocks["prog"] = new ulong[] { 0x401000, 10, 10 };
+			blocks["libc.so"] = new ulong[] { 100216, 16, 216 };
+
+			TraceFile.Write(tmp, blocks);
+
+			Assert.True(TraceFile.IsBinary(tmp));
+
+			var trace = new TraceFile(tmp);
+
+			Assert.AreEqual(new[] { "libc.so", "prog" }, trace.Modules);
+			Assert.AreEqual(5, trace.Count);
+
+			var actual = trace.Blocks.ToList();
+
+			Assert.AreEqual(new TraceBlock(0, 16), actual[0]);
+			Assert.AreEqual(new TraceBlock(0, 216), actual[1]);
+			Assert.AreEqual(new TraceBlock(0, 100216), actual[2]);
+			Assert.AreEqual(new TraceBlock(1, 10), actual[3]);
+			Assert.AreEqual(new TraceBlock(1, 0x401000), actual[4]);
+		}
+	}
+}
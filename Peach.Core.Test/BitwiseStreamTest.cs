@@ -1,4 +1,5 @@
 using System;
+using System.Collections.Generic;
 using Peach.Core.IO;
 using NUnit.Framework;
 using System.Text;
@@ -578,6 +579,55 @@ namespace Peach.Core.Test
 			Assert.AreEqual(bits, cnt);
 		}
 
+		[Test]
+		public void TestSegments()
+		{
+			var lst = new BitStreamList();
+			lst.Add(new BitStream(Encoding.ASCII.GetBytes("Hello")));
+			lst.Add(new BitStream(Encoding.ASCII.GetBytes(" ")));
+			lst.Add(new BitStream(Encoding.ASCII.GetBytes("World")));
+
+			var segments = new List<ArraySegment<byte>>();
+			Assert.True(lst.TryGetSegments(segments));
+			Assert.AreEqual(3, segments.Count);
+			Assert.AreEqual(0, lst.PositionBits);
+
+			// Starts at the current position
+			lst.Seek(3, SeekOrigin.Begin);
+			segments.Clear();
+			Assert.True(lst.TryGetSegments(segments));
+			Assert.AreEqual(3, segments.Count);
+			Assert.AreEqual(2, segments[0].Count);
+			Assert.AreEqual(3, lst.Position);
+
+			var ms = new MemoryStream();
+			lst.CopyTo(ms);
+			Assert.AreEqual(Encoding.ASCII.GetBytes("lo World"), ms.ToArray());
+			Assert.AreEqual(lst.Length, lst.Position);
+
+			// Unaligned streams can't be handed out as is
+			var bs = new BitStream();
+			bs.WriteBits(0x7, 3);
+			lst.Add(bs);
+			Assert.AreEqual(91, lst.LengthBits);
+
+			lst.Seek(0, SeekOrigin.Begin);
+			segments.Clear();
+			Assert.False(lst.TryGetSegments(segments));
+			Assert.AreEqual(0, segments.Count);
+
+			// Falls back to reading, trailing bits are dropped
+			ms = new MemoryStream();
+			lst.CopyTo(ms);
+			Assert.AreEqual(Encoding.ASCII.GetBytes("Hello World"), ms.ToArray());
+
+			// Bitwise destinations get the trailing bits
+			var dst = new BitStream();
+			lst.Seek(0, SeekOrigin.Begin);
+			lst.CopyTo(dst);
+			Assert.AreEqual(91, dst.LengthBits);
+		}
+
 		[Test]
 		public void TestFind()
 		{
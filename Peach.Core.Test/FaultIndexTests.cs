@@ -0,0 +1,212 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+using NUnit.Framework;
+
+using Peach.Core.Analyzers;
+
+namespace Peach.Core.Test
+{
+	[TestFixture]
+	class FaultIndexTests
+	{
+		string tmp;
+
+		[SetUp]
+		public void SetUp()
+		{
+			tmp = Path.Combine(Path.GetTempPath(), "FaultIndexTests_" + Guid.NewGuid().ToString("N"));
+			Directory.CreateDirectory(tmp);
+		}
+
+		[TearDown]
+		public void TearDown()
+		{
+			Directory.Delete(tmp, true);
+		}
+
+		Fault MakeFault(string major, string minor, string module = null, ulong offset = 0)
+		{
+			return new Fault()
+			{
+				type = FaultType.Fault,
+				majorHash = major,
+				minorHash = minor,
+				faultingModule = module,
+				faultingOffset = offset,
+			};
+		}
+
+		[Test]
+		public void TestKey()
+		{
+			Assert.AreEqual("abc.1", FaultIndex.GetKey(MakeFault("0x0ABC", "001")));
+			Assert.AreEqual("abc.1", FaultIndex.GetKey(MakeFault(" abc ", "1")));
+			Assert.AreEqual("abc.1@libfoo.so+0x10", FaultIndex.GetKey(MakeFault("abc", "1", "/usr/lib/libfoo.so", 16)));
+			Assert.AreEqual("abc.1@foo.dll+0x10", FaultIndex.GetKey(MakeFault("abc", "1", "C:\\Windows\\FOO.DLL", 16)));
+			Assert.AreEqual(".@foo.dll+0x0", FaultIndex.GetKey(MakeFault(null, null, "foo.dll", 0)));
+			Assert.AreEqual("sigsegv.0", FaultIndex.GetKey(MakeFault("SIGSEGV", "0x0")));
+			Assert.Null(FaultIndex.GetKey(new Fault() { folderName = "Unknown" }));
+		}
+
+		[Test]
+		public void TestRoundTrip()
+		{
+			var file = Path.Combine(tmp, "faults.idx");
+
+			using (var index = new FaultIndex(file))
+			{
+				Assert.AreEqual(1, index.Add(MakeFault("a", "1"), 5).Count);
+				Assert.AreEqual(1, index.Add(MakeFault("b", "2", "prog", 0x400), 6).Count);
+				Assert.AreEqual(2, index.Add(MakeFault("A", "1"), 7).Count);
+				Assert.Null(index.Add(new Fault(), 8));
+			}
+
+			using (var index = new FaultIndex(file))
+			{
+				Assert.AreEqual(2, index.Buckets.Count);
+
+				var a = index.Find(MakeFault("a", "1"));
+				Assert.NotNull(a);
+				Assert.AreEqual(2, a.Count);
+				Assert.AreEqual(5, a.FirstIteration);
+				Assert.AreEqual(7, a.LastIteration);
+
+				Assert.Null(index.Find(MakeFault("b", "2")));
+				Assert.AreEqual(3, index.Add(MakeFault("a", "1"), 9).Count);
+			}
+
+			using (var index = new FaultIndex(file))
+			{
+				Assert.AreEqual(3, index.Buckets[0].Count);
+				Assert.AreEqual(1, index.Buckets[1].Count);
+				Assert.AreEqual("b.2@prog+0x400", index.Buckets[1].Key);
+			}
+		}
+
+		[Test]
+		public void TestTruncated()
+		{
+			var file = Path.Combine(tmp, "faults.idx");
+
+			using (var index = new FaultIndex(file))
+			{
+				index.Add(MakeFault("a", "1"), 1);
+				index.Add(MakeFault("a", "1"), 2);
+			}
+
+			// Lose the end of the last hit record
+			using (var fs = new FileStream(file, FileMode.Open))
+				fs.SetLength(fs.Length - 2);
+
+			using (var index = new FaultIndex(file))
+			{
+				Assert.AreEqual(1, index.Buckets[0].Count);
+				index.Add(MakeFault("b", "2"), 3);
+			}
+
+			using (var index = new FaultIndex(file))
+			{
+				Assert.AreEqual(2, index.Buckets.Count);
+				Assert.AreEqual(1, index.Buckets[0].Count);
+			}
+		}
+
+		int faults;
+		int reproFaults;
+		int reproFailed;
+		int duplicates;
+
+		void RunEngine(string reproIter)
+		{
+			string xml = @"
+<Peach>
+	<DataModel name='TheDataModel'>
+		<String value='Hello World'/>
+	</DataModel>
+
+	<StateModel name='TheState' initialState='Initial'>
+		<State name='Initial'>
+			<Action type='output'>
+				<DataModel ref='TheDataModel'/>
+			</Action>
+		</State>
+	</StateModel>
+
+	<Agent name='LocalAgent'>
+		<Monitor class='FaultingMonitor'>
+			<Param name='Iteration' value='3,5'/>
+			<Param name='Repro' value='{0}'/>
+			<Param name='Hash' value='abc'/>
+		</Monitor>
+	</Agent>
+
+	<Test name='Default' faultWaitTime='0' replayEnabled='true'>
+		<Agent ref='LocalAgent'/>
+		<StateModel ref='TheState'/>
+		<Publisher class='Null'/>
+	</Test>
+</Peach>".Fmt(reproIter);
+
+			faults = 0;
+			reproFaults = 0;
+			reproFailed = 0;
+			duplicates = 0;
+
+			PitParser parser = new PitParser();
+			Dom.Dom dom = parser.asParser(null, new MemoryStream(Encoding.ASCII.GetBytes(xml)));
+
+			RunConfiguration config = new RunConfiguration();
+			config.range = true;
+			config.rangeStart = 1;
+			config.rangeStop = 6;
+
+			Engine e = new Engine(null);
+			e.context.faultIndex = new FaultIndex();
+			e.Fault += delegate { ++faults; };
+			e.ReproFault += delegate { ++reproFaults; };
+			e.ReproFailed += delegate { ++reproFailed; };
+			e.DuplicateFault += delegate { ++duplicates; };
+			e.startFuzzing(dom, config);
+
+			Assert.AreEqual(1, e.context.faultIndex.Buckets.Count);
+			Assert.AreEqual(2, e.context.faultIndex.Buckets[0].Count);
+		}
+
+		[Test]
+		public void TestEngineDuplicate()
+		{
+			// Iteration 3 is reproduced and logged, 5 is only counted
+			RunEngine("3");
+
+			Assert.AreEqual(1, reproFaults);
+			Assert.AreEqual(1, faults);
+			Assert.AreEqual(0, reproFailed);
+			Assert.AreEqual(1, duplicates);
+		}
+
+		[Test]
+		public void TestEngineDuplicateNotReproduced()
+		{
+			// Iteration 3 is logged as not reproducible, 5 is only counted
+			RunEngine("0");
+
+			Assert.AreEqual(1, reproFaults);
+			Assert.AreEqual(0, faults);
+			Assert.AreEqual(1, reproFailed);
+			Assert.AreEqual(1, duplicates);
+		}
+
+		[Test]
+		public void TestBadMagic()
+		{
+			var file = Path.Combine(tmp, "faults.idx");
+			File.WriteAllText(file, "not an index");
+
+			Assert.Throws<PeachException>(delegate() { new FaultIndex(file); });
+		}
+	}
+}
@@ -34,6 +34,7 @@ namespace Peach.Core.Test.Monitors
         protected bool replay = false;
         protected bool fault = false;
         protected bool control = true;
+        protected string hash = null;
 
         public FaultingMonitor(IAgent agent, string name, Dictionary<string, Variant> args)
             : base(agent, name, args)
@@ -42,6 +43,8 @@ namespace Peach.Core.Test.Monitors
                 iters = ((string)args["Iteration"]).Split(',');
             if (args.ContainsKey("Repro"))
                 reproIters = ((string)args["Repro"]).Split(',');
+            if (args.ContainsKey("Hash"))
+                hash = (string)args["Hash"];
         }
 
         public override void StopMonitor()
@@ -89,6 +92,8 @@ namespace Peach.Core.Test.Monitors
             fault.detectionSource = "FaultingMonitor";
             fault.folderName = "FaultingMonitor";
             fault.type = FaultType.Fault;
+            fault.majorHash = hash;
+            fault.minorHash = hash;
 
             fault.collectedData.Add(new Fault.Data("Output", Encoding.ASCII.GetBytes("Faulted on Iteration: "+curIter.ToString())));
             return fault;
@@ -0,0 +1,133 @@
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+using NUnit.Framework;
+using Peach.Core.Agent.Monitors;
+using TheAgent = Peach.Core.Agent.Agent;
+
+namespace Peach.Core.Test.Monitors
+{
+	[TestFixture]
+	class PersistentProcessMonitorTests
+	{
+		string tmp;
+
+		[SetUp]
+		public void SetUp()
+		{
+			tmp = Path.GetTempFileName();
+		}
+
+		[TearDown]
+		public void TearDown()
+		{
+			File.Delete(tmp);
+		}
+
+		// Sends the ready status, then exits while reading the input
+		const string ExitingTarget = "-c \"head -c 16 /dev/zero; head -c 1 > /dev/null\"";
+
+		PersistentProcess MakeMonitor(string executable, string arguments = null, bool faultOnExit = true)
+		{
+			var args = new Dictionary<string, Variant>();
+			args["Executable"] = new Variant(executable);
+			args["InputFile"] = new Variant(tmp);
+			args["StartOnCall"] = new Variant("foo");
+			args["Timeout"] = new Variant("5000");
+			args["FaultOnExit"] = new Variant(faultOnExit.ToString());
+
+			if (arguments != null)
+				args["Arguments"] = new Variant(arguments);
+
+			return new PersistentProcess(new TheAgent("agent"), "name", args);
+		}
+
+		void RunInput(PersistentProcess p, uint iteration, byte[] input)
+		{
+			File.WriteAllBytes(tmp, input);
+
+			p.IterationStarting(iteration, false);
+			p.Message("Action.Call", new Variant("foo"));
+			p.IterationFinished();
+		}
+
+		[Test]
+		public void TestInputs()
+		{
+			var p = MakeMonitor("CrashingFileConsumer");
+
+			p.SessionStarting();
+
+			// Normal inputs run in the same process
+			for (uint i = 1; i <= 3; ++i)
+			{
+				RunInput(p, i, Encoding.ASCII.GetBytes("Hello"));
+
+				Assert.False(p.DetectedFault());
+				Assert.Null(p.GetMonitorData());
+			}
+
+			// Overflows the 20 byte stack buffer in Function2
+			RunInput(p, 4, Encoding.ASCII.GetBytes(new string('A', 100000)));
+
+			Assert.True(p.DetectedFault());
+
+			var fault = p.GetMonitorData();
+			Assert.NotNull(fault);
+			Assert.AreEqual(FaultType.Fault, fault.type);
+			Assert.AreEqual("PersistentProcessMonitor", fault.detectionSource);
+			StringAssert.StartsWith("Process crashed with ", fault.title);
+
+			// The process is restarted for the next input
+			RunInput(p, 5, Encoding.ASCII.GetBytes("Hello"));
+
+			Assert.False(p.DetectedFault());
+
+			p.SessionFinished();
+			p.StopMonitor();
+		}
+
+		[Test]
+		public void TestExitMidInput()
+		{
+			if (Platform.GetOS() == Platform.OS.Windows)
+				Assert.Ignore("Needs a posix shell.");
+
+			var p = MakeMonitor("sh", ExitingTarget);
+
+			p.SessionStarting();
+
+			RunInput(p, 1, Encoding.ASCII.GetBytes("Hello"));
+
+			Assert.True(p.DetectedFault());
+
+			var fault = p.GetMonitorData();
+			Assert.NotNull(fault);
+			Assert.AreEqual("PersistentProcessExit", fault.folderName);
+			Assert.AreEqual("Process exited while running the input", fault.title);
+
+			p.SessionFinished();
+			p.StopMonitor();
+		}
+
+		[Test]
+		public void TestExitMidInputNoFault()
+		{
+			if (Platform.GetOS() == Platform.OS.Windows)
+				Assert.Ignore("Needs a posix shell.");
+
+			var p = MakeMonitor("sh", ExitingTarget, false);
+
+			p.SessionStarting();
+
+			RunInput(p, 1, Encoding.ASCII.GetBytes("Hello"));
+
+			Assert.False(p.DetectedFault());
+
+			p.SessionFinished();
+			p.StopMonitor();
+		}
+	}
+}
@@ -82,7 +82,7 @@ namespace Peach.Core.Test
 			RunWaitTime("0.1", 0.09, 0.11);
 		}
 
-		public void RunTest(uint start, string faultIter, uint max = 100, string reproIter = "0")
+		public void RunTest(uint start, string faultIter, uint max = 100, string reproIter = "0", string replay = "")
 		{
 			string template = @"
 <Peach>
@@ -108,7 +108,7 @@ namespace Peach.Core.Test
 		</Monitor>
 	</Agent>
 
-	<Test name='Default' faultWaitTime='0' replayEnabled='true'>
+	<Test name='Default' faultWaitTime='0' replayEnabled='true' {2}>
 		<Agent ref='LocalAgent'/>
 		<StateModel ref='TheState'/>
 		<Publisher class='Null'/>
@@ -118,7 +118,7 @@ namespace Peach.Core.Test
 
 			iterationHistory.Clear();
 
-			string xml = string.Format(template, faultIter, reproIter);
+			string xml = string.Format(template, faultIter, reproIter, replay);
 
 			PitParser parser = new PitParser();
 
@@ -325,6 +325,72 @@ namespace Peach.Core.Test
 			Assert.AreEqual(expected, actual);
 		}
 
+		[Test]
+		public void TestBisectSearch()
+		{
+			RunTest(1, "10", 100, "6", "replayBisect='true'");
+
+			uint[] expected = new uint[] {
+				1,  // Control
+				1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+				10, // Initial replay
+				1, 2, 3, 4, 5, 6, // Whole window, repro
+				5, 6, // Bisect, repro
+				7, 8, 9, 10, // Bisect
+				6,  // Bisect, repro
+				7, 8, 9, 10,
+				10, // Initial replay
+				7, 8, 9, 10, // Whole window
+				11, 12 };
+
+			uint[] actual = iterationHistory.ToArray();
+			Assert.AreEqual(expected, actual);
+		}
+
+		[Test]
+		public void TestBisectNoRepro()
+		{
+			RunTest(1, "10", 100, "0", "replayBisect='true'");
+
+			uint[] expected = new uint[] {
+				1,  // Control
+				1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+				10, // Initial replay
+				1, 2, 3, 4, 5, 6, 7, 8, 9, 10, // Whole window
+				11, 12 };
+
+			uint[] actual = iterationHistory.ToArray();
+			Assert.AreEqual(expected, actual);
+		}
+
+		[Test]
+		public void TestReplayMaxIterations()
+		{
+			RunTest(1, "10", 100, "6", "replayBisect='true' replayMaxIterations='4'");
+
+			uint[] expected = new uint[] {
+				1,  // Control
+				1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+				10, // Initial replay
+				1, 2, 3, // Out of budget
+				11, 12 };
+
+			uint[] actual = iterationHistory.ToArray();
+			Assert.AreEqual(expected, actual);
+
+			RunTest(1, "10", 100, "0", "replayMaxIterations='2'");
+
+			expected = new uint[] {
+				1,  // Control
+				1, 2, 3, 4, 5, 6, 7, 8, 9, 10,
+				10, // Initial replay
+				9,  // Move back 1, out of budget
+				11, 12 };
+
+			actual = iterationHistory.ToArray();
+			Assert.AreEqual(expected, actual);
+		}
+
 		[Test, ExpectedException(typeof(PeachException), ExpectedMessage="Error, DataModel could not resolve ref 'foo'. XML:\n<DataModel ref=\"foo\" />")]
 		public void BadDataModelNoName()
 		{
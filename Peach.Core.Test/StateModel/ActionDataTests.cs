@@ -0,0 +1,111 @@
+﻿using System;
+using System.Collections.Generic;
+using System.Linq;
+using System.Text;
+using System.IO;
+
+using NUnit.Framework;
+using NUnit.Framework.Constraints;
+
+using Peach.Core;
+using Peach.Core.Dom;
+using Peach.Core.Analyzers;
+
+namespace Peach.Core.Test.StateModel
+{
+	[TestFixture]
+	class ActionDataTests : DataModelCollector
+	{
+		string xml = @"<?xml version='1.0' encoding='utf-8'?>
+<Peach>
+	<DataModel name='DM1'>
+		<String name='str1' value='Hello World'/>
+	</DataModel>
+
+	<DataModel name='DM2'>
+		<String name='str2' value='Not Mutated' mutable='false'/>
+	</DataModel>
+
+	<StateModel name='SM' initialState='Initial'>
+		<State name='Initial'>
+			<Action name='Out1' type='output'>
+				<DataModel ref='DM1'/>
+			</Action>
+			<Action name='Out2' type='output'>
+				<DataModel ref='DM2'/>
+			</Action>
+		</State>
+	</StateModel>
+
+	<Test name='Default'>
+		<StateModel ref='SM'/>
+		<Publisher class='Null'/>
+		<Strategy class='Sequential'/>
+	</Test>
+</Peach>";
+
+		void Run(MemoryStream output = null)
+		{
+			PitParser parser = new PitParser();
+			Dom.Dom dom = parser.asParser(null, new MemoryStream(ASCIIEncoding.ASCII.GetBytes(xml)));
+			dom.tests[0].includedMutators = new List<string>();
+			dom.tests[0].includedMutators.Add("StringCaseMutator");
+
+			if (output != null)
+				dom.tests[0].publishers[0] = new MemoryStreamPublisher(output);
+
+			RunConfiguration config = new RunConfiguration();
+
+			Engine e = new Engine(null);
+			e.startFuzzing(dom, config);
+
+			// Control iteration plus one per mutation, two models each
+			Assert.Greater(dataModels.Count, 2);
+			Assert.AreEqual(0, dataModels.Count % 2);
+		}
+
+		[Test]
+		public void ReuseUnmutated()
+		{
+			Run();
+
+			// The model that is never mutated is never cloned
+			for (int i = 1; i < dataModels.Count; i += 2)
+			{
+				Assert.AreSame(dataModels[1], dataModels[i]);
+				Assert.AreEqual("Not Mutated", (string)dataModels[i][0].InternalValue);
+			}
+		}
+
+		[Test]
+		public void CloneMutated()
+		{
+			Run();
+
+			// Every mutation works on its own copy
+			var mutated = dataModels.Where((dm, i) => i % 2 == 0).ToList();
+			Assert.AreEqual(mutated.Count, mutated.Distinct().Count());
+
+			// The control iteration's model is left untouched
+			Assert.AreEqual("Hello World", (string)mutated[0][0].InternalValue);
+			Assert.Null(mutated[0][0].MutatedValue);
+
+			for (int i = 1; i < mutated.Count; ++i)
+				Assert.NotNull(mutated[i][0].MutatedValue);
+		}
+
+		[Test]
+		public void OutputReused()
+		{
+			var stream = new MemoryStream();
+
+			Run(stream);
+
+			// The reused model is written out in full every iteration
+			var output = ASCIIEncoding.ASCII.GetString(stream.ToArray());
+			var count = output.Split(new[] { "Not Mutated" }, StringSplitOptions.None).Length - 1;
+
+			Assert.AreEqual(dataModels.Count / 2, count);
+		}
+	}
+}
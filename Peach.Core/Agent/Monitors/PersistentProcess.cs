@@ -0,0 +1,354 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.Diagnostics;
+using System.IO;
+
+using Peach.Core.Dom;
+
+using NLog;
+
+namespace Peach.Core.Agent.Monitors
+{
+	/// <summary>
+	/// Run every input in the same process.  The target links the persistent
+	/// harness (PersistentHarness/PersistentHarness.h), it is started once and
+	/// gets the input file over its standard input on each StartOnCall.
+	/// The process is only restarted after it crashes or hangs.
+	/// </summary>
+	[Monitor("PersistentProcess", true)]
+	[Parameter("Executable", typeof(string), "Executable to launch")]
+	[Parameter("Arguments", typeof(string), "Optional command line arguments", "")]
+	[Parameter("InputFile", typeof(string), "File the publisher writes the input to")]
+	[Parameter("StartOnCall", typeof(string), "Run the input on state model call")]
+	[Parameter("Timeout", typeof(int), "How many milliseconds to wait for an input to run (-1 is infinite)", "10000")]
+	[Parameter("FaultOnTimeout", typeof(bool), "Trigger fault if an input doesn't finish in time", "false")]
+	[Parameter("FaultOnExit", typeof(bool), "Trigger fault if the process exits while running an input", "true")]
+	[Parameter("RestartAfter", typeof(int), "Restart the process after this many inputs, 0 never restarts a running process", "0")]
+	public class PersistentProcess : Monitor
+	{
+		static NLog.Logger logger = LogManager.GetCurrentClassLogger();
+
+		// PersistentStatus from PersistentHarness.h
+		const uint StatusReady = 0;
+		const uint StatusOk = 1;
+		const uint StatusCrash = 2;
+		const int StatusSize = 16;
+
+		const string EnvironmentName = "PEACH_PERSISTENT";
+
+		static readonly Dictionary<uint, string> signals = new Dictionary<uint, string>()
+		{
+			{ 4, "SIGILL" },
+			{ 6, "SIGABRT" },
+			{ 7, "SIGBUS" },
+			{ 8, "SIGFPE" },
+			{ 10, "SIGBUS" },
+			{ 11, "SIGSEGV" },
+		};
+
+		enum Result { Ok, Exited, Timeout }
+
+		System.Diagnostics.Process _process = null;
+		Stream _input = null;
+		Stream _output = null;
+		Fault _fault = null;
+		int _inputs = 0;
+
+		public string Executable { get; private set; }
+		public string Arguments { get; private set; }
+		public string InputFile { get; private set; }
+		public string StartOnCall { get; private set; }
+		public int Timeout { get; private set; }
+		public bool FaultOnTimeout { get; private set; }
+		public bool FaultOnExit { get; private set; }
+		public int RestartAfter { get; private set; }
+
+		public PersistentProcess(IAgent agent, string name, Dictionary<string, Variant> args)
+			: base(agent, name, args)
+		{
+			ParameterParser.Parse(this, args);
+		}
+
+		void _Start()
+		{
+			if (_process != null && !_process.HasExited)
+				return;
+
+			_Stop();
+
+			_process = new System.Diagnostics.Process();
+			_process.StartInfo.FileName = Executable;
+			_process.StartInfo.UseShellExecute = false;
+			_process.StartInfo.RedirectStandardInput = true;
+			_process.StartInfo.RedirectStandardOutput = true;
+			_process.StartInfo.EnvironmentVariables[EnvironmentName] = "1";
+
+			if (!string.IsNullOrEmpty(Arguments))
+				_process.StartInfo.Arguments = Arguments;
+
+			logger.Debug("_Start(): Starting process");
+
+			try
+			{
+				_process.Start();
+			}
+			catch (Exception ex)
+			{
+				_process = null;
+				throw new PeachException("Could not start process '" + Executable + "'.  " + ex.Message + ".", ex);
+			}
+
+			_input = _process.StandardInput.BaseStream;
+			_output = _process.StandardOutput.BaseStream;
+			_inputs = 0;
+
+			uint status, code;
+			ulong address;
+
+			if (_ReadStatus(out status, out code, out address) != Result.Ok || status != StatusReady)
+			{
+				_Stop();
+				throw new PeachException("Process '" + Executable + "' did not start the persistent harness.");
+			}
+		}
+
+		void _Stop()
+		{
+			if (_process == null)
+				return;
+
+			logger.Debug("_Stop(): Stopping process");
+
+			try
+			{
+				// Closing stdin ends the harness loop
+				_input.Close();
+
+				if (!_process.WaitForExit(1000))
+				{
+					_process.Kill();
+					_process.WaitForExit();
+				}
+			}
+			catch (Exception ex)
+			{
+				logger.Debug("_Stop(): {0}", ex.Message);
+			}
+
+			_process.Close();
+			_process = null;
+			_input = null;
+			_output = null;
+		}
+
+		Result _ReadStatus(out uint status, out uint code, out ulong address)
+		{
+			var buf = new byte[StatusSize];
+			var sw = Stopwatch.StartNew();
+			int offset = 0;
+
+			status = code = 0;
+			address = 0;
+
+			while (offset < buf.Length)
+			{
+				int remain = Timeout;
+				if (Timeout >= 0)
+					remain = Math.Max(0, Timeout - (int)sw.ElapsedMilliseconds);
+
+				var ar = _output.BeginRead(buf, offset, buf.Length - offset, null, null);
+				if (!ar.AsyncWaitHandle.WaitOne(remain))
+					return Result.Timeout;
+
+				int len = _output.EndRead(ar);
+				if (len == 0)
+					return Result.Exited;
+
+				offset += len;
+			}
+
+			status = BitConverter.ToUInt32(buf, 0);
+			code = BitConverter.ToUInt32(buf, 4);
+			address = BitConverter.ToUInt64(buf, 8);
+
+			return Result.Ok;
+		}
+
+		void _RunInput()
+		{
+			var data = File.ReadAllBytes(InputFile);
+
+			uint status, code;
+			ulong address;
+
+			_Start();
+
+			try
+			{
+				_input.Write(BitConverter.GetBytes((uint)data.Length), 0, 4);
+				_input.Write(data, 0, data.Length);
+				_input.Flush();
+			}
+			catch (IOException ex)
+			{
+				// The status read below sees the process is gone
+				logger.Debug("_RunInput(): {0}", ex.Message);
+			}
+
+			var result = _ReadStatus(out status, out code, out address);
+
+			if (result == Result.Timeout)
+			{
+				logger.Debug("Input did not finish in {0}ms, stopping process.", Timeout);
+
+				if (FaultOnTimeout)
+					_fault = MakeFault("PersistentProcessHang", "Input did not finish in " + Timeout + "ms", null, null);
+
+				_Stop();
+			}
+			else if (result == Result.Exited)
+			{
+				logger.Debug("Process exited while running the input.");
+
+				// A crash the harness handler didn't see, e.g. a stack
+				// overflow, or the target calling exit() on the input
+				if (FaultOnExit)
+					_fault = MakeFault("PersistentProcessExit", "Process exited while running the input", null, null);
+
+				_Stop();
+			}
+			else if (status == StatusCrash)
+			{
+				var name = CodeName(code);
+
+				logger.Debug("Process crashed with {0} at 0x{1:x}.", name, address);
+
+				_fault = MakeFault("PersistentProcessCrash", "Process crashed with " + name, name, "0x{0:x}".Fmt(address));
+				_fault.description += "Address: 0x{0:x16}\n".Fmt(address);
+
+				_Stop();
+			}
+			else if (RestartAfter > 0 && ++_inputs >= RestartAfter)
+			{
+				logger.Debug("Restarting process after {0} inputs.", _inputs);
+				_Stop();
+			}
+		}
+
+		static string CodeName(uint code)
+		{
+			string name;
+
+			if (Platform.GetOS() != Platform.OS.Windows && signals.TryGetValue(code, out name))
+				return name;
+
+			return "0x{0:x8}".Fmt(code);
+		}
+
+		Fault MakeFault(string folder, string reason, string majorHash, string minorHash)
+		{
+			var fault = new Fault()
+			{
+				type = FaultType.Fault,
+				detectionSource = "PersistentProcessMonitor",
+				title = reason,
+				description = "{0}: {1} {2}\n".Fmt(reason, Executable, Arguments),
+			};
+
+			if (majorHash != null)
+			{
+				fault.majorHash = majorHash;
+				fault.minorHash = minorHash;
+				fault.exploitability = "UNKNOWN";
+			}
+			else
+			{
+				fault.folderName = folder;
+			}
+
+			return fault;
+		}
+
+		public override void IterationStarting(uint iterationCount, bool isReproduction)
+		{
+			_fault = null;
+
+			// Keep startup out of the timed call
+			_Start();
+		}
+
+		public override bool DetectedFault()
+		{
+			return _fault != null;
+		}
+
+		public override Fault GetMonitorData()
+		{
+			return _fault;
+		}
+
+		public override bool MustStop()
+		{
+			return false;
+		}
+
+		public override void StopMonitor()
+		{
+			_Stop();
+		}
+
+		public override void SessionStarting()
+		{
+			_Start();
+		}
+
+		public override void SessionFinished()
+		{
+			_Stop();
+		}
+
+		public override bool IterationFinished()
+		{
+			return true;
+		}
+
+		public override Variant Message(string name, Variant data)
+		{
+			if (name == "Action.Call" && ((string)data) == StartOnCall)
+				_RunInput();
+
+			return null;
+		}
+	}
+}
+
+// end
@@ -36,6 +36,7 @@ using System.Text;
 using NLog;
 using Peach.Core;
 using System.Collections;
+using System.Runtime.InteropServices;
 using System.Threading;
 
 namespace Peach.Core.Analysis
@@ -47,7 +48,7 @@ namespace Peach.Core.Analysis
 	/// <remarks>
 	/// So far only Windows has an implementation.
 	/// </remarks>
-	public class Coverage
+	public class Coverage : IDisposable
 	{
 		static NLog.Logger logger = LogManager.GetCurrentClassLogger();
 
@@ -66,14 +67,54 @@ namespace Peach.Core.Analysis
 		}
 
 		protected ProcessStartInfo StartInfo { get; private set; }
+		protected string Target { get; private set; }
 		protected bool NeedsKilling { get; private set; }
 
+		/// <summary>
+		/// Optional shared memory edge bitmap the pin tool will record into.
+		/// Must be set before calling Run.
+		/// </summary>
+		public CoverageBitmap Bitmap { get; set; }
+
+		/// <summary>
+		/// Start the target under pin once and fork a new child at main()
+		/// for every sample instead of relaunching pin.  Not supported on Windows.
+		/// </summary>
+		public bool ForkServer { get; set; }
+
+		/// <summary>
+		/// Optional trace file of blocks that are already covered.  The pin
+		/// tool skips instrumenting these blocks and the resulting trace
+		/// only contains new blocks, so it may be empty.
+		/// </summary>
+		public string Baseline { get; set; }
+
+		/// <summary>
+		/// Base file name the pin tool writes its .out, .pid and .log files to.
+		/// Give each instance its own base to run traces concurrently.
+		/// Defaults to "bblocks" in the current directory.
+		/// </summary>
+		public string OutputBase { get; set; }
+
+		/// <summary>
+		/// Milliseconds between the checks for an idle cpu when the target
+		/// needs killing.  Zero uses the pin tool default of 200ms.
+		/// </summary>
+		public uint IdleMs { get; set; }
+
+		Process server;
+		FileStream serverCtl;
+		FileStream serverStatus;
+		string serverBase;
+		string serverInput;
+
 		public Coverage(string executable, string arguments, bool needsKilling)
 		{
 			VerifyExists(executable, "target executable");
 
 			// Set 1st since it is used by Setup functions
 			NeedsKilling = needsKilling;
+			OutputBase = "bblocks";
 
 			if (!arguments.Contains("%s"))
 				throw new ArgumentException("Error, arguments must contain a '%s'.");
@@ -100,7 +141,9 @@ namespace Peach.Core.Analysis
 			StartInfo.UseShellExecute = false;
 			StartInfo.CreateNoWindow = true;
 
-			logger.Debug("Using: {0} {1}", StartInfo.FileName, StartInfo.Arguments);
+			Target = "{0} {1}".Fmt(Quote(executable), arguments);
+
+			logger.Debug("Using: {0} {1} -- {2}", StartInfo.FileName, StartInfo.Arguments, Target);
 		}
 
 		#region Platform Setup Functions
@@ -133,12 +176,7 @@ namespace Peach.Core.Analysis
 
 			var psi = new ProcessStartInfo();
 			psi.FileName = pinPath;
-			psi.Arguments = "-t {0} -cpukill {1} -debug {2} -- {3} {4}".Fmt(
-				Quote(pinTool),
-				NeedsKilling ? "1" : "0",
-				logger.IsDebugEnabled ? "1" : "0",
-				Quote(executable),
-				arguments);
+			psi.Arguments = "-t {0}".Fmt(Quote(pinTool));
 
 			return psi;
 		}
@@ -171,12 +209,7 @@ namespace Peach.Core.Analysis
 
 			var psi = new ProcessStartInfo();
 			psi.FileName = pinPath;
-			psi.Arguments = "-t {0} -cpukill {1} -debug {2} -- {3} {4}".Fmt(
-				Quote(pinTool),
-				NeedsKilling ? "1" : "0",
-				logger.IsDebugEnabled ? "1" : "0",
-				Quote(executable),
-				arguments);
+			psi.Arguments = "-t {0}".Fmt(Quote(pinTool));
 
 			foreach (DictionaryEntry de in Environment.GetEnvironmentVariables())
 				psi.EnvironmentVariables[de.Key.ToString()] = de.Value.ToString();
@@ -210,13 +243,7 @@ namespace Peach.Core.Analysis
 
 			var psi = new ProcessStartInfo();
 			psi.FileName = pin32;
-			psi.Arguments = "-p64 {0} -t {1} -cpukill {2} -debug {3} -- {4} {5}".Fmt(
-				Quote(pin64),
-				Quote(pinTool),
-				NeedsKilling ? "1" : "0",
-				logger.IsDebugEnabled ? "1" : "0",
-				Quote(executable),
-				arguments);
+			psi.Arguments = "-p64 {0} -t {1}".Fmt(Quote(pin64), Quote(pinTool));
 
 			foreach (DictionaryEntry de in Environment.GetEnvironmentVariables())
 				psi.EnvironmentVariables[de.Key.ToString()] = de.Value.ToString();
@@ -226,6 +253,28 @@ namespace Peach.Core.Analysis
 
 		#endregion
 
+		/// <summary>
+		/// Arguments passed to the pin tool for every run.
+		/// </summary>
+		protected string ToolArguments()
+		{
+			var args = "-cpukill {0} -debug {1} -o {2}".Fmt(
+				NeedsKilling ? "1" : "0",
+				logger.IsDebugEnabled ? "1" : "0",
+				Quote(OutputBase));
+
+			if (NeedsKilling && IdleMs != 0)
+				args += " -idlems {0}".Fmt(IdleMs);
+
+			if (Bitmap != null)
+				args += " -shm {0} -shmsize {1}".Fmt(Quote(Bitmap.Name), Bitmap.Size);
+
+			if (Baseline != null)
+				args += " -baseline {0}".Fmt(Quote(Baseline));
+
+			return args;
+		}
+
 		/// <summary>
 		/// Runs code coverage of sample file and saves results in a trace file.
 		/// Throws a PeachException on failure.
@@ -234,11 +283,58 @@ namespace Peach.Core.Analysis
 		/// <param name="traceFile">Name of result trace file to generate.</param>
 		public void Run(string sampleFile, string traceFile)
 		{
-			var outFile = "bblocks.out";
-			var pidFile = "bblocks.pid";
+			var outFile = OutputBase + ".out";
+
+			logger.Debug("Using sample {0}", sampleFile);
+
+			try
+			{
+				if (File.Exists(outFile))
+					File.Delete(outFile);
+			}
+			catch (Exception ex)
+			{
+				throw new PeachException("Failed to delete old output file '{0}'.".Fmt(outFile), ex);
+			}
+
+			if (ForkServer)
+				RunForkServer(sampleFile);
+			else
+				RunProcess(sampleFile);
+
+			if (!File.Exists(outFile))
+				throw new PeachException("Pin exited without creating output file.");
+
+			// Ensure outFile is not zero sized, unless everything was in the baseline
+			var fi = new System.IO.FileInfo(outFile);
+			if (fi.Length == 0 && Baseline == null)
+				throw new PeachException("Pin exited without creating any trace file entries. This usually means the target did not run to completion.");
+
+			try
+			{
+				if (File.Exists(traceFile))
+					File.Delete(traceFile);
+			}
+			catch (Exception ex)
+			{
+				throw new PeachException("Failed to delete old trace file '{0}'.".Fmt(traceFile), ex);
+			}
+
+			try
+			{
+				// Move pin output to target
+				File.Move(outFile, traceFile);
+			}
+			catch (Exception ex)
+			{
+				throw new PeachException("Failed to move pin outpout file into destination trace file.", ex);
+			}
+		}
 
+		ProcessStartInfo MakeStartInfo(string toolArguments, string target)
+		{
 			var psi = new ProcessStartInfo();
-			psi.Arguments = StartInfo.Arguments.Replace("%s", Quote(sampleFile));
+			psi.Arguments = "{0} {1} -- {2}".Fmt(StartInfo.Arguments, toolArguments, target);
 			psi.FileName = StartInfo.FileName;
 			psi.RedirectStandardError = StartInfo.RedirectStandardError;
 			psi.RedirectStandardOutput = StartInfo.RedirectStandardOutput;
@@ -248,19 +344,40 @@ namespace Peach.Core.Analysis
 			foreach (DictionaryEntry de in StartInfo.EnvironmentVariables)
 				psi.EnvironmentVariables[de.Key.ToString()] = de.Value.ToString();
 
-			logger.Debug("Using sample {0}", sampleFile);
 			logger.Debug("{0} {1}", psi.FileName, psi.Arguments);
 
+			return psi;
+		}
+
+		Process StartProcess(ProcessStartInfo psi)
+		{
+			var proc = new Process();
+			proc.StartInfo = psi;
+			proc.OutputDataReceived += proc_OutputDataReceived;
+			proc.ErrorDataReceived += proc_ErrorDataReceived;
+
 			try
 			{
-				if (File.Exists(outFile))
-					File.Delete(outFile);
+				proc.Start();
 			}
 			catch (Exception ex)
 			{
-				throw new PeachException("Failed to delete old output file '{0}'.".Fmt(outFile), ex);
+				proc.Dispose();
+				throw new PeachException("Failed to start pin process.", ex);
 			}
 
+			proc.BeginErrorReadLine();
+			proc.BeginOutputReadLine();
+
+			return proc;
+		}
+
+		void RunProcess(string sampleFile)
+		{
+			var pidFile = OutputBase + ".pid";
+
+			var psi = MakeStartInfo(ToolArguments(), Target.Replace("%s", Quote(sampleFile)));
+
 			try
 			{
 				if (File.Exists(pidFile))
@@ -271,24 +388,8 @@ namespace Peach.Core.Analysis
 				throw new PeachException("Failed to delete old pid file '{0}'.".Fmt(pidFile), ex);
 			}
 
-			using (var proc = new Process())
+			using (var proc = StartProcess(psi))
 			{
-				proc.StartInfo = psi;
-				proc.OutputDataReceived += proc_OutputDataReceived;
-				proc.ErrorDataReceived += proc_ErrorDataReceived;
-
-				try
-				{
-					proc.Start();
-				}
-				catch (Exception ex)
-				{
-					throw new PeachException("Failed to start pin process.", ex);
-				}
-
-				proc.BeginErrorReadLine();
-				proc.BeginOutputReadLine();
-
 				while (!File.Exists(pidFile) && !proc.HasExited)
 					Thread.Sleep(250);
 
@@ -301,36 +402,160 @@ namespace Peach.Core.Analysis
 
 				logger.Debug("Pin process exited.");
 			}
+		}
 
-			if (!File.Exists(outFile))
-				throw new PeachException("Pin exited without creating output file.");
+		#region Fork Server
 
-			// Ensure outFile is not zero sized
-			var fi = new System.IO.FileInfo(outFile);
-			if (fi.Length == 0)
-				throw new PeachException("Pin exited without creating any trace file entries. This usually means the target did not run to completion.");
+		[DllImport("libc", SetLastError = true)]
+		static extern int mkfifo(string path, int mode);
 
+		void RunForkServer(string sampleFile)
+		{
 			try
 			{
-				if (File.Exists(traceFile))
-					File.Delete(traceFile);
+				if (server == null)
+					StartForkServer(sampleFile);
+
+				// The target always reads the same input file
+				File.Copy(sampleFile, serverInput, true);
+
+				WriteServer(0);
+
+				var pid = ReadServer();
+				var status = ReadServer();
+
+				logger.Debug("Fork server child {0} exited, status: {1}", pid, status);
 			}
 			catch (Exception ex)
 			{
-				throw new PeachException("Failed to delete old trace file '{0}'.".Fmt(traceFile), ex);
+				StopForkServer();
+
+				if (ex is PeachException)
+					throw;
+
+				throw new PeachException("Failed to run sample with the pin fork server.", ex);
 			}
+		}
 
-			try
+		void StartForkServer(string sampleFile)
+		{
+			if (Platform.GetOS() == Platform.OS.Windows)
+				throw new PeachException("Error, the pin fork server is not supported on Windows.");
+
+			serverBase = Path.Combine(Path.GetTempPath(), "peach_bblocks_" + Guid.NewGuid().ToString("N"));
+			serverInput = serverBase + Path.GetExtension(sampleFile);
+
+			foreach (var fifo in new[] { serverBase + ".ctl", serverBase + ".st" })
 			{
-				// Move bblocks.out to target
-				File.Move(outFile, traceFile);
+				// 0600
+				if (mkfifo(fifo, 0x180) != 0)
+					throw new PeachException("Failed to create fork server fifo '{0}', error {1}.".Fmt(fifo, Marshal.GetLastWin32Error()));
 			}
-			catch (Exception ex)
+
+			// Open both fifos read/write so neither side blocks waiting on the other
+			serverCtl = new FileStream(serverBase + ".ctl", FileMode.Open, FileAccess.ReadWrite);
+			serverStatus = new FileStream(serverBase + ".st", FileMode.Open, FileAccess.ReadWrite);
+
+			var psi = MakeStartInfo(
+				"{0} -forksrv {1}".Fmt(ToolArguments(), Quote(serverBase)),
+				Target.Replace("%s", Quote(serverInput)));
+
+			server = StartProcess(psi);
+
+			// Server writes its pid once main() has been reached
+			var pid = ReadServer();
+
+			logger.Debug("Fork server started, pid: {0}", pid);
+		}
+
+		void StopForkServer()
+		{
+			// Closing the control fifo tells the server to exit
+			if (serverCtl != null)
 			{
-				throw new PeachException("Failed to move pin outpout file into destination trace file.", ex);
+				serverCtl.Dispose();
+				serverCtl = null;
+			}
+
+			if (server != null)
+			{
+				try
+				{
+					if (!server.HasExited && !server.WaitForExit(5000))
+						server.Kill();
+				}
+				catch (InvalidOperationException)
+				{
+				}
+
+				server.Dispose();
+				server = null;
+			}
+
+			if (serverStatus != null)
+			{
+				serverStatus.Dispose();
+				serverStatus = null;
+			}
+
+			if (serverBase != null)
+			{
+				foreach (var file in new[] { serverBase + ".ctl", serverBase + ".st", serverInput })
+				{
+					try
+					{
+						File.Delete(file);
+					}
+					catch (IOException)
+					{
+					}
+				}
+
+				serverBase = null;
+				serverInput = null;
 			}
 		}
 
+		void WriteServer(int value)
+		{
+			var buf = BitConverter.GetBytes(value);
+			serverCtl.Write(buf, 0, buf.Length);
+			serverCtl.Flush();
+		}
+
+		int ReadServer()
+		{
+			var buf = new byte[4];
+			var offset = 0;
+
+			while (offset < buf.Length)
+			{
+				var ar = serverStatus.BeginRead(buf, offset, buf.Length - offset, null, null);
+
+				// Data wakes us immediately, the timeout is only to notice pin dying
+				while (!ar.AsyncWaitHandle.WaitOne(250))
+				{
+					if (server.HasExited)
+						throw new PeachException("Pin fork server exited unexpectedly.");
+				}
+
+				var len = serverStatus.EndRead(ar);
+				if (len == 0)
+					throw new PeachException("Pin fork server closed the status fifo.");
+
+				offset += len;
+			}
+
+			return BitConverter.ToInt32(buf, 0);
+		}
+
+		#endregion
+
+		public void Dispose()
+		{
+			StopForkServer();
+		}
+
 		void proc_ErrorDataReceived(object sender, DataReceivedEventArgs e)
 		{
 			if (e.Data == null)
@@ -0,0 +1,173 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+
+namespace Peach.Core.Analysis
+{
+	/// <summary>
+	/// Shared memory edge coverage bitmap.  The bblocks pin tool hashes
+	/// each (previous block, current block) pair into this bitmap when it
+	/// is run with the -shm option, so coverage can be read after every
+	/// iteration without waiting for the target to exit.
+	/// </summary>
+	public class CoverageBitmap : IDisposable
+	{
+		public const int DefaultSize = 65536;
+
+		MemoryMappedFile map;
+		MemoryMappedViewAccessor view;
+		string backingFile;
+		byte[] zeros;
+
+		/// <summary>
+		/// Name passed to the pin tool.  On windows this is the name of the
+		/// file mapping object, otherwise it is the path to the backing file.
+		/// </summary>
+		public string Name { get; private set; }
+
+		/// <summary>
+		/// Size of the bitmap in bytes.
+		/// </summary>
+		public int Size { get; private set; }
+
+		public CoverageBitmap()
+			: this(DefaultSize)
+		{
+		}
+
+		public CoverageBitmap(int size)
+		{
+			if (size <= 0 || (size & (size - 1)) != 0)
+				throw new ArgumentException("Error, bitmap size must be a power of two.", "size");
+
+			Size = size;
+
+			var name = "peach_bblocks_" + Guid.NewGuid().ToString("N");
+
+			try
+			{
+				if (Platform.GetOS() == Platform.OS.Windows)
+				{
+					Name = name;
+					map = MemoryMappedFile.CreateNew(name, size);
+				}
+				else
+				{
+					// Prefer tmpfs so the bitmap is never written to disk
+					var dir = Directory.Exists("/dev/shm") ? "/dev/shm" : Path.GetTempPath();
+
+					backingFile = Path.Combine(dir, name);
+					Name = backingFile;
+
+					using (var fs = new FileStream(backingFile, FileMode.CreateNew, FileAccess.ReadWrite))
+						fs.SetLength(size);
+
+					map = MemoryMappedFile.CreateFromFile(backingFile, FileMode.Open, null, size, MemoryMappedFileAccess.ReadWrite);
+				}
+
+				view = map.CreateViewAccessor(0, size);
+			}
+			catch (Exception ex)
+			{
+				Dispose();
+				throw new PeachException("Error, unable to create coverage bitmap. " + ex.Message, ex);
+			}
+		}
+
+		/// <summary>
+		/// Reset all edge counters.  Call before each iteration.
+		/// </summary>
+		public void Clear()
+		{
+			if (zeros == null)
+				zeros = new byte[Size];
+
+			view.WriteArray(0, zeros, 0, Size);
+		}
+
+		/// <summary>
+		/// Copy of the current edge counters.
+		/// </summary>
+		public byte[] ToArray()
+		{
+			var ret = new byte[Size];
+			view.ReadArray(0, ret, 0, Size);
+			return ret;
+		}
+
+		/// <summary>
+		/// Number of edges that have been hit at least once.
+		/// </summary>
+		public int Count
+		{
+			get
+			{
+				int ret = 0;
+
+				foreach (var b in ToArray())
+				{
+					if (b != 0)
+						++ret;
+				}
+
+				return ret;
+			}
+		}
+
+		public void Dispose()
+		{
+			if (view != null)
+			{
+				view.Dispose();
+				view = null;
+			}
+
+			if (map != null)
+			{
+				map.Dispose();
+				map = null;
+			}
+
+			if (backingFile != null)
+			{
+				try
+				{
+					File.Delete(backingFile);
+				}
+				catch (IOException)
+				{
+				}
+
+				backingFile = null;
+			}
+		}
+	}
+}
@@ -32,6 +32,7 @@ using System.Collections.Generic;
 using System.Linq;
 using System.Text;
 using System.Reflection;
+using System.Threading;
 
 using Peach.Core;
 using NLog;
@@ -40,6 +41,22 @@ namespace Peach.Core.Analysis
 {
 	public delegate void TraceEventHandler(Minset sender, string fileName, int count, int totalCount);
 
+	/// <summary>
+	/// Cost of keeping a sample in the minimum set.
+	/// </summary>
+	public enum MinsetWeight
+	{
+		/// <summary>
+		/// Every sample costs the same, so the fewest samples are kept.
+		/// </summary>
+		None,
+
+		/// <summary>
+		/// Samples cost their size, so the smallest total size is kept.
+		/// </summary>
+		FileSize,
+	}
+
 	/// <summary>
 	/// Perform analysis on sample sets to identify the smallest sample set
 	/// that provides the largest code coverage.
@@ -52,6 +69,58 @@ namespace Peach.Core.Analysis
 		public event TraceEventHandler TraceCompleted;
 		public event TraceEventHandler TraceFailed;
 
+		/// <summary>
+		/// Trace samples using the pin fork server instead of
+		/// starting a new pin process for each sample.
+		/// </summary>
+		public bool ForkServer { get; set; }
+
+		/// <summary>
+		/// Milliseconds between the checks for an idle cpu when the target
+		/// needs killing.  Zero uses the pin tool default.
+		/// </summary>
+		public uint IdleMs { get; set; }
+
+		/// <summary>
+		/// Optional trace of blocks every sample is known to cover, such as
+		/// a trace of an empty file.  RunTraces leaves these blocks out of
+		/// the traces it collects.
+		/// </summary>
+		public string Baseline { get; set; }
+
+		/// <summary>
+		/// How RunCoverage weighs samples against each other.
+		/// </summary>
+		public MinsetWeight Weight { get; set; }
+
+		/// <summary>
+		/// Folder RunCoverage spills the coverage of every sample to, so
+		/// corpora larger than memory can be minimized.  When null all
+		/// coverage is kept in memory.  The result is the same either way.
+		/// </summary>
+		public string SpillFolder { get; set; }
+
+		/// <summary>
+		/// Number of traces to collect at the same time.  Defaults to 1.
+		/// </summary>
+		public int Parallelism
+		{
+			get
+			{
+				return parallelism;
+			}
+			set
+			{
+				if (value < 1)
+					throw new ArgumentOutOfRangeException("value", "Error, parallelism must be at least 1.");
+
+				parallelism = value;
+			}
+		}
+
+		int parallelism = 1;
+		object eventLock = new object();
+
 		protected void OnTraceStarting(string fileName, int count, int totalCount)
 		{
 			if (TraceStarting != null)
@@ -75,6 +144,8 @@ namespace Peach.Core.Analysis
 		/// </summary>
 		/// <remarks>
 		/// Note: The sample and trace collections must have matching indexes.
+		/// Picks samples with a weighted greedy set cover, so the result does
+		/// not depend on the order of the samples.
 		/// </remarks>
 		/// <param name="sampleFiles">Collection of sample files</param>
 		/// <param name="traceFiles">Collection of trace files for sample files</param>
@@ -85,30 +156,101 @@ namespace Peach.Core.Analysis
 			if (sampleFiles.Length != traceFiles.Length)
 				throw new ArgumentException();
 
-			var ret = new List<string>();
-			var lines = new HashSet<string>();
-			string line;
+			// Dense id of every block, by module and offset.  This grows
+			// with the size of the target, not the number of samples.
+			var ids = new Dictionary<string, Dictionary<ulong, int>>();
+			var samples = new List<string>();
+			var elements = new List<int>();
+			int blocks = 0;
 
-			for (int i = 0; i < traceFiles.Length; ++i)
+			using (var cover = CreateCover())
 			{
-				bool unique = false;
-
-				try
+				for (int i = 0; i < traceFiles.Length; ++i)
 				{
-					using (var rdr = new StreamReader(traceFiles[i]))
+					try
 					{
-						for (int cnt = 0; (line = rdr.ReadLine()) != null; ++cnt)
+						var trace = new TraceFile(traceFiles[i]);
+						var maps = new Dictionary<ulong, int>[trace.Modules.Length];
+
+						for (int m = 0; m < maps.Length; ++m)
 						{
-							if (lines.Add(line) && !unique)
+							if (!ids.TryGetValue(trace.Modules[m], out maps[m]))
 							{
-								logger.Debug("Including '{0}', unique at line #{1}: {2}", traceFiles[i], cnt + 1, line);
-								unique = true;
+								maps[m] = new Dictionary<ulong, int>();
+								ids.Add(trace.Modules[m], maps[m]);
 							}
 						}
+
+						elements.Clear();
+
+						foreach (var block in trace.Blocks)
+						{
+							var map = maps[block.Module];
+							int id;
+
+							if (!map.TryGetValue(block.Offset, out id))
+							{
+								id = blocks++;
+								map.Add(block.Offset, id);
+							}
+
+							elements.Add(id);
+						}
+
+						cover.Add(elements, GetWeight(sampleFiles[i]));
+						samples.Add(sampleFiles[i]);
+					}
+					catch (Exception ex)
+					{
+						logger.Debug("Error processing trace {0}\n{1}", traceFiles[i], ex);
 					}
+				}
+
+				var picked = cover.Solve();
+
+				logger.Debug("Selected {0} of {1} samples covering {2} blocks", picked.Length, samples.Count, blocks);
+
+				return picked.Select(i => samples[i]).ToArray();
+			}
+		}
+
+		/// <summary>
+		/// Fold newly traced samples into an existing minimum set.  Samples
+		/// already in the database are not traced again, their coverage is
+		/// read from the database.  Kept samples whose coverage is subsumed
+		/// by new samples are dropped.
+		/// </summary>
+		/// <remarks>
+		/// Note: The sample and trace collections must have matching indexes.
+		/// A new sample with the same file name as a kept one replaces it.
+		/// </remarks>
+		/// <param name="db">Database to update</param>
+		/// <param name="sampleFiles">Collection of new sample files</param>
+		/// <param name="traceFiles">Collection of trace files for the new sample files</param>
+		/// <param name="removed">File names of samples removed from the database</param>
+		/// <returns>Returns the new sample files added to the database.</returns>
+		public string[] UpdateCoverage(MinsetDatabase db, string[] sampleFiles, string[] traceFiles, out string[] removed)
+		{
+			// Expect samples and traces to correlate 1 <-> 1
+			if (sampleFiles.Length != traceFiles.Length)
+				throw new ArgumentException();
 
-					if (unique)
-						ret.Add(sampleFiles[i]);
+			// Dense id of every block, by database module and offset
+			var ids = new List<Dictionary<ulong, int>>();
+			var kept = new List<MinsetEntry>();
+			var traced = new List<int>();
+			var candidates = new List<MinsetEntry>();
+			var elements = new List<int>();
+			int blocks = 0;
+
+			// Every trace is only read once, up front.  A sample only replaces
+			// the kept one with the same name when its trace can be used.
+			for (int i = 0; i < traceFiles.Length; ++i)
+			{
+				try
+				{
+					candidates.Add(MakeEntry(db, sampleFiles[i], traceFiles[i]));
+					traced.Add(i);
 				}
 				catch (Exception ex)
 				{
@@ -116,7 +258,116 @@ namespace Peach.Core.Analysis
 				}
 			}
 
-			return ret.ToArray();
+			var replaced = new HashSet<string>(traced.Select(i => Path.GetFileName(sampleFiles[i])));
+
+			using (var cover = CreateCover())
+			{
+				foreach (var entry in db.Entries)
+				{
+					if (replaced.Contains(entry.Sample))
+						continue;
+
+					elements.Clear();
+
+					foreach (var block in entry.Blocks)
+						elements.Add(Intern(ids, block.Module, block.Offset, ref blocks));
+
+					cover.Add(elements, entry.Weight);
+					kept.Add(entry);
+				}
+
+				foreach (var entry in candidates)
+				{
+					elements.Clear();
+
+					foreach (var block in entry.Blocks)
+						elements.Add(Intern(ids, block.Module, block.Offset, ref blocks));
+
+					cover.Add(elements, entry.Weight);
+				}
+
+				var picked = cover.Solve();
+				var entries = new List<MinsetEntry>();
+				var added = new List<string>();
+
+				foreach (var index in picked)
+				{
+					if (index < kept.Count)
+					{
+						entries.Add(kept[index]);
+						continue;
+					}
+
+					var i = index - kept.Count;
+					entries.Add(candidates[i]);
+					added.Add(sampleFiles[traced[i]]);
+				}
+
+				logger.Debug("Minset database now has {0} samples covering {1} blocks, {2} added",
+					entries.Count, blocks, added.Count);
+
+				removed = db.Entries.Where(e => !entries.Contains(e)).Select(e => e.Sample).ToArray();
+
+				db.Entries.Clear();
+				db.Entries.AddRange(entries);
+
+				return added.ToArray();
+			}
+		}
+
+		MinsetEntry MakeEntry(MinsetDatabase db, string sampleFile, string traceFile)
+		{
+			var trace = new TraceFile(traceFile);
+			var modules = trace.Modules.Select(m => db.GetModule(m)).ToArray();
+			var blocks = trace.Blocks
+				.Select(b => new TraceBlock(modules[b.Module], b.Offset))
+				.Distinct()
+				.OrderBy(b => b.Module)
+				.ThenBy(b => b.Offset)
+				.ToArray();
+
+			return new MinsetEntry(Path.GetFileName(sampleFile), GetWeight(sampleFile), blocks);
+		}
+
+		static int Intern(List<Dictionary<ulong, int>> ids, int module, ulong offset, ref int next)
+		{
+			while (ids.Count <= module)
+				ids.Add(new Dictionary<ulong, int>());
+
+			int ret;
+
+			if (!ids[module].TryGetValue(offset, out ret))
+			{
+				ret = next++;
+				ids[module].Add(offset, ret);
+			}
+
+			return ret;
+		}
+
+		SetCover CreateCover()
+		{
+			if (SpillFolder == null)
+				return new SetCover();
+
+			var spillFile = Path.Combine(SpillFolder, "minset_" + Guid.NewGuid().ToString("N") + ".spill");
+
+			try
+			{
+				return new SetCover(spillFile);
+			}
+			catch (Exception ex)
+			{
+				throw new PeachException("Error, unable to create spill file '{0}'. {1}".Fmt(spillFile, ex.Message), ex);
+			}
+		}
+
+		double GetWeight(string sampleFile)
+		{
+			if (Weight == MinsetWeight.FileSize)
+				return Math.Max(1, new System.IO.FileInfo(sampleFile).Length);
+
+			return 1;
 		}
 
 		/// <summary>
@@ -124,7 +375,9 @@ namespace Peach.Core.Analysis
 		/// </summary>
 		/// <remarks>
 		/// This method will use the TraceStarting and TraceCompleted events
-		/// to report progress.
+		/// to report progress.  When Parallelism is more than one, events are
+		/// raised one at a time from worker threads and the count passed to
+		/// TraceCompleted and TraceFailed is the number of finished traces.
 		/// </remarks>
 		/// <param name="executable">Executable to run.</param>
 		/// <param name="arguments">Executable arguments.  Must contain a "%s" placeholder for the sampe filename.</param>
@@ -134,42 +387,153 @@ namespace Peach.Core.Analysis
 		/// <returns>Returns a collection of trace files</returns>
 		public string[] RunTraces(string executable, string arguments, string tracesFolder, string[] sampleFiles, bool needsKilling = false)
 		{
+			var workers = new List<Coverage>();
+			string workDir = null;
+
 			try
 			{
-				var cov = new Coverage(executable, arguments, needsKilling);
-				var ret = new List<string>();
+				try
+				{
+					var count = Math.Max(1, Math.Min(Parallelism, sampleFiles.Length));
+
+					// Every worker needs its own pin output files
+					if (count > 1)
+					{
+						workDir = Path.Combine(Path.GetTempPath(), "peach_minset_" + Guid.NewGuid().ToString("N"));
+						Directory.CreateDirectory(workDir);
+					}
 
-				for (int i = 0; i < sampleFiles.Length; ++i)
+					for (int i = 0; i < count; ++i)
+					{
+						var cov = new Coverage(executable, arguments, needsKilling);
+						workers.Add(cov);
+
+						cov.ForkServer = ForkServer;
+						cov.IdleMs = IdleMs;
+						cov.Baseline = Baseline;
+
+						if (workDir != null)
+							cov.OutputBase = Path.Combine(workDir, "bblocks" + i);
+					}
+				}
+				catch (Exception ex)
 				{
-					var sampleFile = sampleFiles[i];
-					var traceFile = Path.Combine(tracesFolder, Path.GetFileName(sampleFile) + ".trace");
+					logger.Debug("Failed to create coverage.\n{0}", ex);
 
-					logger.Debug("Starting trace [{0}:{1}] {2}", i + 1, sampleFiles.Length, sampleFile);
+					throw new PeachException(ex.Message, ex);
+				}
+
+				if (workers.Count == 1)
+					return RunTraces(workers[0], tracesFolder, sampleFiles);
 
-					OnTraceStarting(sampleFile, i + 1, sampleFiles.Length);
+				return RunTraces(workers, tracesFolder, sampleFiles);
+			}
+			finally
+			{
+				foreach (var cov in workers)
+					cov.Dispose();
 
+				if (workDir != null)
+				{
 					try
 					{
-						cov.Run(sampleFile, traceFile);
-						ret.Add(traceFile);
-						logger.Debug("Successfully created trace {0}", traceFile);
-						OnTraceCompleted(sampleFile, i + 1, sampleFiles.Length);
+						Directory.Delete(workDir, true);
 					}
-					catch (Exception ex)
+					catch (IOException ex)
 					{
-						logger.Debug("Failed to generate trace.\n{0}", ex);
-						OnTraceFaled(sampleFile, i + 1, sampleFiles.Length);
+						logger.Debug("Failed to remove '{0}'. {1}", workDir, ex.Message);
 					}
 				}
+			}
+		}
+
+		string[] RunTraces(Coverage cov, string tracesFolder, string[] sampleFiles)
+		{
+			var ret = new List<string>();
 
-				return ret.ToArray();
+			for (int i = 0; i < sampleFiles.Length; ++i)
+			{
+				var sampleFile = sampleFiles[i];
+				var traceFile = Path.Combine(tracesFolder, Path.GetFileName(sampleFile) + ".trace");
+
+				logger.Debug("Starting trace [{0}:{1}] {2}", i + 1, sampleFiles.Length, sampleFile);
+
+				OnTraceStarting(sampleFile, i + 1, sampleFiles.Length);
+
+				try
+				{
+					cov.Run(sampleFile, traceFile);
+					ret.Add(traceFile);
+					logger.Debug("Successfully created trace {0}", traceFile);
+					OnTraceCompleted(sampleFile, i + 1, sampleFiles.Length);
+				}
+				catch (Exception ex)
+				{
+					logger.Debug("Failed to generate trace.\n{0}", ex);
+					OnTraceFaled(sampleFile, i + 1, sampleFiles.Length);
+				}
 			}
-			catch (Exception ex)
+
+			return ret.ToArray();
+		}
+
+		string[] RunTraces(List<Coverage> workers, string tracesFolder, string[] sampleFiles)
+		{
+			var traces = new string[sampleFiles.Length];
+			var threads = new List<Thread>();
+			int next = -1;
+			int finished = 0;
+
+			foreach (var item in workers)
 			{
-				logger.Debug("Failed to create coverage.\n{0}", ex);
+				var cov = item;
+
+				var thread = new Thread(delegate()
+				{
+					int i;
+
+					while ((i = Interlocked.Increment(ref next)) < sampleFiles.Length)
+					{
+						var sampleFile = sampleFiles[i];
+						var traceFile = Path.Combine(tracesFolder, Path.GetFileName(sampleFile) + ".trace");
 
-				throw new PeachException(ex.Message, ex);
+						logger.Debug("Starting trace [{0}:{1}] {2}", i + 1, sampleFiles.Length, sampleFile);
+
+						lock (eventLock)
+							OnTraceStarting(sampleFile, i + 1, sampleFiles.Length);
+
+						try
+						{
+							cov.Run(sampleFile, traceFile);
+							traces[i] = traceFile;
+							logger.Debug("Successfully created trace {0}", traceFile);
+						}
+						catch (Exception ex)
+						{
+							logger.Debug("Failed to generate trace.\n{0}", ex);
+						}
+
+						lock (eventLock)
+						{
+							++finished;
+
+							if (traces[i] != null)
+								OnTraceCompleted(sampleFile, finished, sampleFiles.Length);
+							else
+								OnTraceFaled(sampleFile, finished, sampleFiles.Length);
+						}
+					}
+				});
+
+				threads.Add(thread);
+				thread.Start();
 			}
+
+			foreach (var thread in threads)
+				thread.Join();
+
+			// Keep traces in the same order as the samples
+			return traces.Where(t => t != null).ToArray();
 		}
 	}
 }
@@ -0,0 +1,247 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Text;
+
+using Peach.Core.IO;
+
+namespace Peach.Core.Analysis
+{
+	/// <summary>
+	/// A sample kept in a MinsetDatabase and the blocks it covers.
+	/// </summary>
+	public class MinsetEntry
+	{
+		public MinsetEntry(string sample, double weight, TraceBlock[] blocks)
+		{
+			Sample = sample;
+			Weight = weight;
+			Blocks = blocks;
+		}
+
+		/// <summary>
+		/// File name of the sample, without a directory.
+		/// </summary>
+		public string Sample { get; private set; }
+
+		/// <summary>
+		/// Weight the sample was picked with.
+		/// </summary>
+		public double Weight { get; private set; }
+
+		/// <summary>
+		/// Blocks covered by the sample.  Modules index into
+		/// MinsetDatabase.Modules and blocks are sorted.
+		/// </summary>
+		public TraceBlock[] Blocks { get; private set; }
+	}
+
+	/// <summary>
+	/// Persistent minimum set.  Keeps the coverage of every sample in the
+	/// set so new samples can be folded in with Minset.UpdateCoverage
+	/// without tracing the existing samples again.
+	/// </summary>
+	/// <remarks>
+	/// The file starts with the magic "PMDB" and a version, followed by the
+	/// module names and then every entry.  Blocks of an entry are written as
+	/// varint module index and offset delta pairs, where the delta restarts
+	/// from zero whenever the module changes.
+	/// </remarks>
+	public class MinsetDatabase
+	{
+		public const uint Version = 1;
+
+		static readonly byte[] Magic = Encoding.ASCII.GetBytes("PMDB");
+
+		List<string> modules = new List<string>();
+		Dictionary<string, int> moduleIndex = new Dictionary<string, int>();
+
+		/// <summary>
+		/// Creates an empty database.
+		/// </summary>
+		public MinsetDatabase()
+		{
+			Entries = new List<MinsetEntry>();
+		}
+
+		/// <summary>
+		/// Loads a database saved with Save.
+		/// </summary>
+		public MinsetDatabase(string fileName)
+			: this()
+		{
+			try
+			{
+				using (var fs = new FileStream(fileName, FileMode.Open, FileAccess.Read))
+				using (var rdr = new BinaryReader(fs, System.Text.Encoding.UTF8))
+				{
+					var magic = rdr.ReadBytes(Magic.Length);
+
+					for (int i = 0; i < Magic.Length; ++i)
+					{
+						if (magic.Length != Magic.Length || magic[i] != Magic[i])
+							throw new PeachException("Error, '{0}' is not a minset database.".Fmt(fileName));
+					}
+
+					var ver = rdr.ReadUInt32();
+					if (ver != Version)
+						throw new PeachException("Error, minset database '{0}' has unsupported version {1}.".Fmt(fileName, ver));
+
+					var cnt = rdr.ReadInt32();
+					for (int i = 0; i < cnt; ++i)
+						GetModule(rdr.ReadString());
+
+					cnt = rdr.ReadInt32();
+					for (int i = 0; i < cnt; ++i)
+					{
+						var sample = rdr.ReadString();
+						var weight = rdr.ReadDouble();
+						var blocks = new TraceBlock[rdr.ReadInt32()];
+
+						int module = -1;
+						ulong offset = 0;
+
+						for (int j = 0; j < blocks.Length; ++j)
+						{
+							var next = (int)VarInt.Read(rdr);
+							if (next != module)
+							{
+								if (next >= modules.Count)
+									throw new PeachException("Error, minset database '{0}' is corrupt.".Fmt(fileName));
+
+								module = next;
+								offset = 0;
+							}
+
+							offset += VarInt.Read(rdr);
+							blocks[j] = new TraceBlock(module, offset);
+						}
+
+						Entries.Add(new MinsetEntry(sample, weight, blocks));
+					}
+				}
+			}
+			catch (EndOfStreamException ex)
+			{
+				throw new PeachException("Error, minset database '{0}' is truncated.".Fmt(fileName), ex);
+			}
+		}
+
+		/// <summary>
+		/// Names of all modules referenced by entries.
+		/// </summary>
+		public IList<string> Modules { get { return modules.AsReadOnly(); } }
+
+		/// <summary>
+		/// Samples in the minimum set.
+		/// </summary>
+		public List<MinsetEntry> Entries { get; private set; }
+
+		/// <summary>
+		/// Returns the index of a module, adding it if needed.
+		/// </summary>
+		public int GetModule(string name)
+		{
+			int ret;
+
+			if (!moduleIndex.TryGetValue(name, out ret))
+			{
+				ret = modules.Count;
+				modules.Add(name);
+				moduleIndex.Add(name, ret);
+			}
+
+			return ret;
+		}
+
+		/// <summary>
+		/// Number of distinct blocks covered by all entries.
+		/// </summary>
+		public int CountBlocks()
+		{
+			var seen = new HashSet<TraceBlock>();
+
+			foreach (var entry in Entries)
+				seen.UnionWith(entry.Blocks);
+
+			return seen.Count;
+		}
+
+		/// <summary>
+		/// Writes the database.  The file is replaced only once
+		/// it has been written completely.
+		/// </summary>
+		public void Save(string fileName)
+		{
+			var tmp = fileName + ".tmp";
+
+			using (var fs = new FileStream(tmp, FileMode.Create, FileAccess.Write))
+			using (var wtr = new BinaryWriter(fs, System.Text.Encoding.UTF8))
+			{
+				wtr.Write(Magic);
+				wtr.Write(Version);
+
+				wtr.Write(modules.Count);
+				foreach (var name in modules)
+					wtr.Write(name);
+
+				wtr.Write(Entries.Count);
+				foreach (var entry in Entries)
+				{
+					wtr.Write(entry.Sample);
+					wtr.Write(entry.Weight);
+					wtr.Write(entry.Blocks.Length);
+
+					int module = -1;
+					ulong offset = 0;
+
+					foreach (var block in entry.Blocks)
+					{
+						if (block.Module != module)
+						{
+							module = block.Module;
+							offset = 0;
+						}
+
+						VarInt.Write(wtr, (ulong)module);
+						VarInt.Write(wtr, block.Offset - offset);
+						offset = block.Offset;
+					}
+				}
+			}
+
+			if (File.Exists(fileName))
+				File.Delete(fileName);
+
+			File.Move(tmp, fileName);
+		}
+	}
+}
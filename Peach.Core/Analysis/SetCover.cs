@@ -0,0 +1,365 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+
+using Peach.Core.IO;
+
+namespace Peach.Core.Analysis
+{
+	/// <summary>
+	/// Weighted greedy set cover.  Each candidate covers a set of dense
+	/// element ids, and the cover picks the candidate with the best ratio of
+	/// newly covered elements to weight until no candidate adds anything.
+	/// </summary>
+	/// <remarks>
+	/// Candidates are stored as sorted id arrays and covered elements in a
+	/// bitset.  Gains only ever shrink, so candidates are re-scored lazily
+	/// when they reach the top of the heap instead of after every pick.
+	///
+	/// For corpora that don't fit in memory, candidates can be spilled to a
+	/// file as delta encoded varints and read back through a memory mapped
+	/// view while solving.  The picked candidates are the same either way.
+	/// </remarks>
+	public class SetCover : IDisposable
+	{
+		List<int[]> sets;
+		List<int> counts = new List<int>();
+		List<double> weights = new List<double>();
+		int maxElement = -1;
+
+		string spillFile;
+		FileStream spill;
+		List<long> offsets;
+		MemoryMappedFile map;
+		MemoryMappedViewAccessor view;
+		byte[] raw;
+
+		/// <summary>
+		/// Keep all candidates in memory.
+		/// </summary>
+		public SetCover()
+		{
+			sets = new List<int[]>();
+		}
+
+		/// <summary>
+		/// Spill candidates to a file that is deleted when disposed.
+		/// </summary>
+		/// <param name="spillFile">Name of the file to create.</param>
+		public SetCover(string spillFile)
+		{
+			this.spillFile = spillFile;
+			this.spill = new FileStream(spillFile, FileMode.Create, FileAccess.ReadWrite);
+			this.offsets = new List<long>();
+		}
+
+		/// <summary>
+		/// Number of candidates added.
+		/// </summary>
+		public int Count { get { return counts.Count; } }
+
+		/// <summary>
+		/// Adds a candidate.  Returns the index of the candidate.
+		/// </summary>
+		/// <param name="elements">Element ids covered by the candidate, duplicates are ignored.</param>
+		/// <param name="weight">Cost of picking the candidate, must be positive.</param>
+		public int Add(IEnumerable<int> elements, double weight)
+		{
+			if (!(weight > 0))
+				throw new ArgumentOutOfRangeException("weight", "Error, weight must be positive.");
+
+			if (view != null)
+				throw new InvalidOperationException("Error, can not add candidates after solving a spilled cover.");
+
+			var list = new List<int>(elements);
+			list.Sort();
+
+			int len = 0;
+
+			for (int i = 0; i < list.Count; ++i)
+			{
+				if (list[i] < 0)
+					throw new ArgumentOutOfRangeException("elements", "Error, element ids can not be negative.");
+
+				if (len == 0 || list[len - 1] != list[i])
+					list[len++] = list[i];
+			}
+
+			if (len > 0)
+				maxElement = Math.Max(maxElement, list[len - 1]);
+
+			if (spill != null)
+			{
+				offsets.Add(spill.Position);
+
+				int last = 0;
+
+				for (int i = 0; i < len; ++i)
+				{
+					VarInt.Write(spill, (ulong)(list[i] - last));
+					last = list[i];
+				}
+			}
+			else
+			{
+				var arr = new int[len];
+				list.CopyTo(0, arr, 0, len);
+				sets.Add(arr);
+			}
+
+			counts.Add(len);
+			weights.Add(weight);
+
+			return counts.Count - 1;
+		}
+
+		/// <summary>
+		/// Computes the cover.  Returns the indexes of the picked
+		/// candidates in ascending order.
+		/// </summary>
+		public int[] Solve()
+		{
+			var covered = new ulong[(maxElement + 64) / 64];
+			var heap = new Heap(counts.Count);
+			var ret = new List<int>();
+			int[] buf = null;
+
+			for (int i = 0; i < counts.Count; ++i)
+			{
+				if (counts[i] > 0)
+					heap.Push(new Entry(i, counts[i] / weights[i]));
+			}
+
+			if (spill != null && heap.Count > 0 && view == null)
+			{
+				spill.Flush();
+
+				// Marks the end of the last candidate
+				offsets.Add(spill.Length);
+
+				map = MemoryMappedFile.CreateFromFile(spill, null, 0, MemoryMappedFileAccess.Read, null, HandleInheritability.None, true);
+				view = map.CreateViewAccessor(0, 0, MemoryMappedFileAccess.Read);
+			}
+
+			while (heap.Count > 0)
+			{
+				var top = heap.Pop();
+				var len = Elements(top.Index, ref buf);
+				var gain = Gain(buf, len, covered);
+
+				if (gain == 0)
+					continue;
+
+				var score = gain / weights[top.Index];
+
+				// Still the best after re-scoring, otherwise try again later
+				if (heap.Count > 0 && heap.Peek().CompareTo(new Entry(top.Index, score)) < 0)
+				{
+					heap.Push(new Entry(top.Index, score));
+					continue;
+				}
+
+				for (int i = 0; i < len; ++i)
+					covered[buf[i] >> 6] |= 1UL << (buf[i] & 63);
+
+				ret.Add(top.Index);
+			}
+
+			ret.Sort();
+
+			return ret.ToArray();
+		}
+
+		public void Dispose()
+		{
+			if (view != null)
+			{
+				view.Dispose();
+				view = null;
+			}
+
+			if (map != null)
+			{
+				map.Dispose();
+				map = null;
+			}
+
+			if (spill != null)
+			{
+				spill.Dispose();
+				spill = null;
+
+				try
+				{
+					File.Delete(spillFile);
+				}
+				catch (IOException)
+				{
+				}
+			}
+		}
+
+		// Elements of a candidate, buf is reused for spilled candidates
+		int Elements(int index, ref int[] buf)
+		{
+			if (sets != null)
+			{
+				buf = sets[index];
+				return buf.Length;
+			}
+
+			var count = counts[index];
+			var size = (int)(offsets[index + 1] - offsets[index]);
+
+			if (raw == null || raw.Length < size)
+				raw = new byte[Math.Max(size, 4096)];
+
+			if (buf == null || buf.Length < count)
+				buf = new int[Math.Max(count, 1024)];
+
+			view.ReadArray(offsets[index], raw, 0, size);
+
+			int pos = 0;
+			int last = 0;
+
+			for (int i = 0; i < count; ++i)
+			{
+				last += (int)VarInt.Read(raw, ref pos);
+				buf[i] = last;
+			}
+
+			return count;
+		}
+
+		static int Gain(int[] set, int len, ulong[] covered)
+		{
+			int ret = 0;
+
+			for (int i = 0; i < len; ++i)
+			{
+				if ((covered[set[i] >> 6] & (1UL << (set[i] & 63))) == 0)
+					++ret;
+			}
+
+			return ret;
+		}
+
+		struct Entry : IComparable<Entry>
+		{
+			public Entry(int index, double score)
+			{
+				Index = index;
+				Score = score;
+			}
+
+			public readonly int Index;
+			public readonly double Score;
+
+			// Orders best first, ties go to the earlier candidate
+			public int CompareTo(Entry other)
+			{
+				var ret = other.Score.CompareTo(Score);
+				return ret != 0 ? ret : Index.CompareTo(other.Index);
+			}
+		}
+
+		class Heap
+		{
+			List<Entry> items;
+
+			public Heap(int capacity)
+			{
+				items = new List<Entry>(capacity);
+			}
+
+			public int Count { get { return items.Count; } }
+
+			public Entry Peek()
+			{
+				return items[0];
+			}
+
+			public void Push(Entry item)
+			{
+				items.Add(item);
+
+				int i = items.Count - 1;
+
+				while (i > 0)
+				{
+					int parent = (i - 1) / 2;
+
+					if (items[parent].CompareTo(item) <= 0)
+						break;
+
+					items[i] = items[parent];
+					i = parent;
+				}
+
+				items[i] = item;
+			}
+
+			public Entry Pop()
+			{
+				var ret = items[0];
+				var last = items[items.Count - 1];
+
+				items.RemoveAt(items.Count - 1);
+
+				if (items.Count == 0)
+					return ret;
+
+				int i = 0;
+
+				for (;;)
+				{
+					int child = i * 2 + 1;
+					if (child >= items.Count)
+						break;
+
+					if (child + 1 < items.Count && items[child + 1].CompareTo(items[child]) < 0)
+						++child;
+
+					if (last.CompareTo(items[child]) <= 0)
+						break;
+
+					items[i] = items[child];
+					i = child;
+				}
+
+				items[i] = last;
+
+				return ret;
+			}
+		}
+	}
+}
@@ -0,0 +1,297 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.IO.MemoryMappedFiles;
+using System.Text;
+
+using Peach.Core.IO;
+
+namespace Peach.Core.Analysis
+{
+	/// <summary>
+	/// A basic block hit during a trace, as an offset into a module.
+	/// </summary>
+	public struct TraceBlock
+	{
+		public TraceBlock(int module, ulong offset)
+			: this()
+		{
+			Module = module;
+			Offset = offset;
+		}
+
+		/// <summary>
+		/// Index into TraceFile.Modules
+		/// </summary>
+		public int Module { get; private set; }
+
+		/// <summary>
+		/// Offset of the block from the module's low address
+		/// </summary>
+		public ulong Offset { get; private set; }
+	}
+
+	/// <summary>
+	/// Reads trace files produced by the bblocks pin tool.
+	/// </summary>
+	/// <remarks>
+	/// Binary traces are read through a memory mapped view.  Older text
+	/// traces containing "file: offset" lines are also supported.
+	/// See Peach.Core.Analysis.Pin.BasicBlocks/ReadMe.txt for the layout.
+	/// </remarks>
+	public class TraceFile
+	{
+		public const uint Version = 1;
+
+		static readonly byte[] Magic = Encoding.ASCII.GetBytes("PTRC");
+
+		string[] modules;
+		int[] counts;
+		List<TraceBlock> textBlocks;
+		string fileName;
+		long dataOffset;
+
+		/// <summary>
+		/// Names of all modules in the trace.
+		/// </summary>
+		public string[] Modules { get { return modules; } }
+
+		/// <summary>
+		/// Total number of blocks in the trace.
+		/// </summary>
+		public long Count { get; private set; }
+
+		public TraceFile(string fileName)
+		{
+			this.fileName = fileName;
+
+			if (IsBinary(fileName))
+				ReadHeader();
+			else
+				ReadText();
+		}
+
+		/// <summary>
+		/// Returns true if the file starts with the binary trace magic.
+		/// </summary>
+		public static bool IsBinary(string fileName)
+		{
+			var buf = new byte[Magic.Length];
+
+			using (var fs = new FileStream(fileName, FileMode.Open, FileAccess.Read))
+			{
+				if (fs.Read(buf, 0, buf.Length) != buf.Length)
+					return false;
+			}
+
+			for (int i = 0; i < buf.Length; ++i)
+			{
+				if (buf[i] != Magic[i])
+					return false;
+			}
+
+			return true;
+		}
+
+		/// <summary>
+		/// Writes a binary trace, such as a baseline for the pin tool's
+		/// -baseline option.  Offsets are sorted and duplicates removed.
+		/// </summary>
+		/// <param name="fileName">Name of the trace file to create.</param>
+		/// <param name="blocks">Block offsets keyed by module file name.</param>
+		public static void Write(string fileName, IDictionary<string, IEnumerable<ulong>> blocks)
+		{
+			var names = new List<string>(blocks.Keys);
+			names.Sort(StringComparer.Ordinal);
+
+			var offsets = new List<ulong[]>();
+
+			foreach (var name in names)
+			{
+				var set = new SortedSet<ulong>(blocks[name]);
+				var arr = new ulong[set.Count];
+				set.CopyTo(arr);
+				offsets.Add(arr);
+			}
+
+			using (var fs = new FileStream(fileName, FileMode.Create, FileAccess.Write))
+			using (var wtr = new BinaryWriter(fs))
+			{
+				wtr.Write(Magic);
+				wtr.Write(Version);
+				wtr.Write((uint)names.Count);
+
+				for (int i = 0; i < names.Count; ++i)
+				{
+					var name = Encoding.UTF8.GetBytes(names[i]);
+					wtr.Write((uint)name.Length);
+					wtr.Write(name);
+					wtr.Write((uint)offsets[i].Length);
+				}
+
+				foreach (var arr in offsets)
+				{
+					ulong last = 0;
+
+					foreach (var offset in arr)
+					{
+						VarInt.Write(wtr, offset - last);
+						last = offset;
+					}
+				}
+			}
+		}
+
+		/// <summary>
+		/// All blocks in the trace, sorted by module and offset
+		/// for binary traces, or in file order for text traces.
+		/// </summary>
+		public IEnumerable<TraceBlock> Blocks
+		{
+			get
+			{
+				if (textBlocks != null)
+					return textBlocks;
+
+				return ReadBlocks();
+			}
+		}
+
+		IEnumerable<TraceBlock> ReadBlocks()
+		{
+			var len = new System.IO.FileInfo(fileName).Length;
+
+			using (var map = MemoryMappedFile.CreateFromFile(fileName, FileMode.Open, null, 0, MemoryMappedFileAccess.Read))
+			using (var view = map.CreateViewStream(0, len, MemoryMappedFileAccess.Read))
+			using (var rdr = new BinaryReader(view))
+			{
+				view.Seek(dataOffset, SeekOrigin.Begin);
+
+				for (int i = 0; i < modules.Length; ++i)
+				{
+					ulong offset = 0;
+
+					for (int j = 0; j < counts[i]; ++j)
+					{
+						offset += ReadDelta(rdr);
+						yield return new TraceBlock(i, offset);
+					}
+				}
+			}
+		}
+
+		ulong ReadDelta(BinaryReader rdr)
+		{
+			try
+			{
+				return VarInt.Read(rdr);
+			}
+			catch (EndOfStreamException ex)
+			{
+				throw new PeachException("Error, trace file '{0}' is truncated.".Fmt(fileName), ex);
+			}
+		}
+
+		void ReadHeader()
+		{
+			using (var fs = new FileStream(fileName, FileMode.Open, FileAccess.Read))
+			using (var rdr = new BinaryReader(fs))
+			{
+				try
+				{
+					rdr.ReadBytes(Magic.Length);
+
+					var ver = rdr.ReadUInt32();
+					if (ver != Version)
+						throw new PeachException("Error, trace file '{0}' has unsupported version {1}.".Fmt(fileName, ver));
+
+					var cnt = rdr.ReadUInt32();
+
+					modules = new string[cnt];
+					counts = new int[cnt];
+
+					for (int i = 0; i < cnt; ++i)
+					{
+						var nameLen = rdr.ReadInt32();
+						modules[i] = Encoding.UTF8.GetString(rdr.ReadBytes(nameLen));
+						counts[i] = rdr.ReadInt32();
+						Count += counts[i];
+					}
+
+					dataOffset = fs.Position;
+				}
+				catch (EndOfStreamException ex)
+				{
+					throw new PeachException("Error, trace file '{0}' is truncated.".Fmt(fileName), ex);
+				}
+			}
+		}
+
+		void ReadText()
+		{
+			var names = new List<string>();
+			var index = new Dictionary<string, int>();
+
+			textBlocks = new List<TraceBlock>();
+
+			using (var rdr = new StreamReader(fileName))
+			{
+				string line;
+
+				while ((line = rdr.ReadLine()) != null)
+				{
+					var sep = line.LastIndexOf(": ");
+					if (sep == -1)
+						continue;
+
+					var name = line.Substring(0, sep);
+
+					ulong offset;
+					if (!ulong.TryParse(line.Substring(sep + 2), out offset))
+						continue;
+
+					int module;
+					if (!index.TryGetValue(name, out module))
+					{
+						module = names.Count;
+						names.Add(name);
+						index.Add(name, module);
+					}
+
+					textBlocks.Add(new TraceBlock(module, offset));
+				}
+			}
+
+			modules = names.ToArray();
+			Count = textBlocks.Count;
+		}
+	}
+}
@@ -1775,6 +1775,15 @@ namespace Peach.Core.Analyzers
 			if (node.hasAttr("replayEnabled"))
 				test.replayEnabled = node.getAttrBool("replayEnabled");
 
+			if (node.hasAttr("replayMaxIterations"))
+				test.replayMaxIterations = uint.Parse(node.getAttrString("replayMaxIterations"));
+
+			if (node.hasAttr("replayMaxTime"))
+				test.replayMaxTime = decimal.Parse(node.getAttrString("replayMaxTime"));
+
+			if (node.hasAttr("replayBisect"))
+				test.replayBisect = node.getAttrBool("replayBisect");
+
 			if (node.hasAttr("nonDeterministicActions"))
 				test.nonDeterministicActions = node.getAttrBool("nonDeterministicActions");
 
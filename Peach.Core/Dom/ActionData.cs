@@ -64,6 +64,21 @@ namespace Peach.Core.Dom
 		/// </summary>
 		public DataModel originalDataModel { get; private set; }
 
+		/// <summary>
+		/// The dataModel handed out by UpdateToOriginalDataModel for as long as
+		/// it is still identical to originalDataModel.  Any change to the model
+		/// (mutation, slurp, fixup state) invalidates its root which clears this.
+		/// </summary>
+		[NonSerialized]
+		private DataModel cleanDataModel;
+
+		/// <summary>
+		/// True when cleanDataModel was kept from a previous run instead of
+		/// being cloned for this one.
+		/// </summary>
+		[NonSerialized]
+		private bool sharedDataModel;
+
 		/// <summary>
 		/// The name of this record.
 		/// </summary>
@@ -133,16 +148,67 @@ namespace Peach.Core.Dom
 					System.Diagnostics.Debug.Assert(val != null);
 
 					originalDataModel = dataModel.Clone() as DataModel;
+
+					TrackDataModel(dataModel);
 				}
 			}
+			else if (cleanDataModel != null && cleanDataModel == dataModel)
+			{
+				// Nothing has changed the model since it was a copy of
+				// the original, so keep it instead of cloning again.
+				// The clone only happens if the model gets mutated.
+				sharedDataModel = true;
+
+				// Publishers copy the cached value from its current
+				// position, which the last output left at the end.
+				dataModel.Value.Seek(0, System.IO.SeekOrigin.Begin);
+			}
 			else
 			{
-				dataModel = originalDataModel.Clone() as DataModel;
+				TrackDataModel(originalDataModel.Clone() as DataModel);
 			}
 
 			dataModel.action = action;
 		}
 
+		/// <summary>
+		/// Make sure dataModel is not shared with a previous run before
+		/// it is mutated.  Mutation strategies call this prior to looking
+		/// up the element to mutate.
+		/// </summary>
+		public void UnshareDataModel()
+		{
+			if (!sharedDataModel)
+				return;
+
+			TrackDataModel(originalDataModel.Clone() as DataModel);
+
+			dataModel.action = action;
+		}
+
+		private void TrackDataModel(DataModel model)
+		{
+			UntrackDataModel();
+
+			dataModel = model;
+			cleanDataModel = model;
+			cleanDataModel.Invalidated += new InvalidatedEventHandler(cleanDataModel_Invalidated);
+		}
+
+		private void UntrackDataModel()
+		{
+			if (cleanDataModel != null)
+				cleanDataModel.Invalidated -= cleanDataModel_Invalidated;
+
+			cleanDataModel = null;
+			sharedDataModel = false;
+		}
+
+		void cleanDataModel_Invalidated(object sender, EventArgs e)
+		{
+			UntrackDataModel();
+		}
+
 		/// <summary>
 		/// Apply data from the dataSet to the data model.
 		/// </summary>
@@ -164,6 +230,9 @@ namespace Peach.Core.Dom
 			originalDataModel = copy;
 			selectedData = option;
 
+			// The current model is a copy of the previous original
+			UntrackDataModel();
+
 			UpdateToOriginalDataModel();
 		}
 
@@ -159,6 +159,35 @@ namespace Peach.Core.Dom
 		[DefaultValue(true)]
 		public bool replayEnabled { get; set; }
 
+		/// <summary>
+		/// Maximum number of iterations to replay when reproducing a fault.
+		/// Defaults to zero (0), no limit.
+		/// </summary>
+		[XmlAttribute]
+		[DefaultValue(0)]
+		public uint replayMaxIterations { get; set; }
+
+		/// <summary>
+		/// Maximum time in seconds to spend reproducing a fault. Value can be
+		/// fractional (0.25). Defaults to zero (0), no limit.
+		/// </summary>
+		[XmlAttribute]
+		[DefaultValue(0.0)]
+		public decimal replayMaxTime { get; set; }
+
+		/// <summary>
+		/// Reproduce faults by replaying runs of iterations leading up to the
+		/// fault and bisecting the shortest run that reproduces it, instead of
+		/// replaying single iterations further and further back.
+		/// </summary>
+		/// <remarks>
+		/// Finds faults that need several iterations to build up, at the
+		/// cost of replaying more iterations.
+		/// </remarks>
+		[XmlAttribute]
+		[DefaultValue(false)]
+		public bool replayBisect { get; set; }
+
 		/// <summary>
 		/// How often we should perform a control iteration.
 		/// </summary>
@@ -64,6 +64,7 @@ namespace Peach.Core
 		public delegate void FaultEventHandler(RunContext context, uint currentIteration, StateModel stateModel, Fault[] faultData);
 		public delegate void ReproFaultEventHandler(RunContext context, uint currentIteration, StateModel stateModel, Fault[] faultData);
 		public delegate void ReproFailedEventHandler(RunContext context, uint currentIteration);
+		public delegate void DuplicateFaultEventHandler(RunContext context, uint currentIteration, FaultBucket bucket, Fault[] faultData);
 		public delegate void TestFinishedEventHandler(RunContext context);
 		public delegate void TestWarningEventHandler(RunContext context, string msg);
 		public delegate void TestErrorEventHandler(RunContext context, Exception e);
@@ -94,6 +95,11 @@ namespace Peach.Core
 		/// </summary>
 		public event ReproFailedEventHandler ReproFailed;
 		/// <summary>
+		/// Fired when a Fault is detected that is already in the fault index.
+		/// The fault is only counted, it is not reproduced or reported as a Fault.
+		/// </summary>
+		public event DuplicateFaultEventHandler DuplicateFault;
+		/// <summary>
 		/// Fired when a Fault is detected.
 		/// </summary>
 		public event FaultEventHandler Fault;
@@ -152,6 +158,11 @@ namespace Peach.Core
 			if (ReproFailed != null)
 				ReproFailed(context, currentIteration);
 		}
+		public void OnDuplicateFault(RunContext context, uint currentIteration, FaultBucket bucket, Fault[] faultData)
+		{
+			if (DuplicateFault != null)
+				DuplicateFault(context, currentIteration, bucket, faultData);
+		}
 		public void OnTestFinished(RunContext context)
 		{
 			if (TestFinished != null)
@@ -329,6 +340,7 @@ namespace Peach.Core
 				iterationStart = Math.Max(1, iterationStart);
 
 				uint lastReproFault = iterationStart - 1;
+				Fault[] reproFaults = null;
 				uint iterationCount = iterationStart;
 				bool firstRun = true;
 
@@ -529,12 +541,46 @@ to execute same as initial control.  State " + state.name + "was not performed."
 							// when reproducing faults.
 							if (context.test.faultWaitTime > 0)
 								Thread.Sleep((int)(context.test.faultWaitTime * 1000));
+
+							context.reproducingIterationCount++;
 						}
 
 						// Collect any faults that were found
 						context.OnCollectFaults();
 
-						if (context.faults.Count > 0)
+						// Faults in a bucket that has already been logged are only counted
+						if (context.faults.Count > 0 && context.faultIndex != null &&
+							!context.reproducingFault && !context.controlIteration)
+						{
+							var coreFault = context.faults.FirstOrDefault(f => f.type == FaultType.Fault);
+
+							if (coreFault != null && context.faultIndex.Find(coreFault) != null)
+							{
+								var bucket = context.faultIndex.Add(coreFault, iterationCount);
+
+								logger.Debug("runTest: fault on iteration {0} is in known bucket {1}, seen {2} times",
+									iterationCount, bucket.Key, bucket.Count);
+
+								OnDuplicateFault(context, iterationCount, bucket, context.faults.ToArray());
+								context.faults.Clear();
+							}
+						}
+
+						// Bisection keeps narrowing down the run that reproduces
+						// the fault, only the fault of the final run is reported
+						uint nextRun = 0;
+
+						if (context.faults.Count > 0 && context.reproducingFault && test.replayBisect && !ReproBudgetSpent(context))
+							nextRun = NextBisectRun(context, lastReproFault, true);
+
+						if (nextRun != 0)
+						{
+							logger.Debug("runTest: Reproduced fault on iteration {0}, replaying iterations {1} to {2}.",
+								iterationCount, nextRun, context.reproducingInitialIteration);
+
+							iterationCount = nextRun - 1;
+						}
+						else if (context.faults.Count > 0)
 						{
 							logger.Debug("runTest: detected fault on iteration " + iterationCount);
 
@@ -546,9 +592,16 @@ to execute same as initial control.  State " + state.name + "was not performed."
 							}
 
 							if (context.reproducingFault || !test.replayEnabled)
+							{
 								OnFault(context, iterationCount, test.stateModel, context.faults.ToArray());
+
+								// The initial fault is logged along with the reproduced one
+								IndexFaults(context, context.reproducingFault ? reproFaults.Concat(context.faults) : context.faults);
+							}
 							else
+							{
 								OnReproFault(context, iterationCount, test.stateModel, context.faults.ToArray());
+							}
 
 							if (context.controlRecordingIteration && (!test.replayEnabled || context.reproducingFault))
 							{
@@ -583,6 +636,12 @@ to execute same as initial control.  State " + state.name + "was not performed."
 								context.reproducingFault = true;
 								context.reproducingInitialIteration = iterationCount;
 								context.reproducingIterationJumpCount = 1;
+								context.reproducingIterationCount = 0;
+								context.reproducingStartTime = DateTime.Now;
+								context.reproducingRunStart = iterationCount;
+								context.reproducingBisectGood = 0;
+								context.reproducingBisectBad = iterationCount;
+								reproFaults = context.faults.ToArray();
 
 								// User can specify a time to wait between iterations
 								// we can use that time to better detect faults
@@ -601,15 +660,38 @@ to execute same as initial control.  State " + state.name + "was not performed."
 						else if (context.reproducingFault)
 						{
 							uint maxJump = context.reproducingInitialIteration - lastReproFault - 1;
+							bool giveUp = false;
 
-							if (context.reproducingIterationJumpCount >= (maxJump * 2) || context.reproducingIterationJumpCount > context.reproducingMaxBacksearch)
+							if (ReproBudgetSpent(context))
 							{
-								logger.Debug("runTest: Giving up reproducing fault, reached max backsearch.");
+								logger.Debug("runTest: Giving up reproducing fault, replay budget is spent.");
+								giveUp = true;
+							}
+							else if (test.replayBisect)
+							{
+								// Runs always end at the initial iteration
+								if (iterationCount >= context.reproducingInitialIteration)
+								{
+									nextRun = NextBisectRun(context, lastReproFault, false);
 
-								context.reproducingFault = false;
-								iterationCount = context.reproducingInitialIteration;
+									if (nextRun == 0)
+									{
+										logger.Debug("runTest: Giving up reproducing fault, no run in the window reproduced it.");
+										giveUp = true;
+									}
+									else
+									{
+										iterationCount = nextRun - 1;
 
-								OnReproFailed(context, iterationCount);
+										logger.Debug("runTest: Replaying iterations {0} to {1} to reproduce fault.",
+											nextRun, context.reproducingInitialIteration);
+									}
+								}
+							}
+							else if (context.reproducingIterationJumpCount >= (maxJump * 2) || context.reproducingIterationJumpCount > context.reproducingMaxBacksearch)
+							{
+								logger.Debug("runTest: Giving up reproducing fault, reached max backsearch.");
+								giveUp = true;
 							}
 							else
 							{
@@ -620,6 +702,16 @@ to execute same as initial control.  State " + state.name + "was not performed."
 									"Moving backwards " + delta + " iterations to reproduce fault.");
 							}
 
+							if (giveUp)
+							{
+								context.reproducingFault = false;
+								iterationCount = context.reproducingInitialIteration;
+
+								OnReproFailed(context, iterationCount);
+
+								IndexFaults(context, reproFaults);
+							}
+
 							// Make next jump larger
 							context.reproducingIterationJumpCount *= context.reproducingSkipMultiple;
 						}
@@ -724,6 +816,111 @@ to execute same as initial control.  State " + state.name + "was not performed."
 			}
 		}
 
+		/// <summary>
+		/// Adds the buckets of faults that have been logged to the fault
+		/// index, so later faults in the same bucket are only counted.
+		/// </summary>
+		private void IndexFaults(RunContext context, IEnumerable<Fault> faults)
+		{
+			if (context.faultIndex == null || faults == null)
+				return;
+
+			var added = new HashSet<string>();
+
+			foreach (var fault in faults)
+			{
+				// Control iteration faults are never deduplicated
+				if (fault.type != FaultType.Fault || fault.controlIteration)
+					continue;
+
+				var key = FaultIndex.GetKey(fault);
+				if (key != null && added.Add(key))
+					context.faultIndex.Add(fault, fault.iteration);
+			}
+		}
+
+		/// <summary>
+		/// True once reproducing the current fault has used up the
+		/// replayMaxIterations or replayMaxTime of the test.
+		/// </summary>
+		private bool ReproBudgetSpent(RunContext context)
+		{
+			var test = context.test;
+
+			if (test.replayMaxIterations > 0 && context.reproducingIterationCount >= test.replayMaxIterations)
+				return true;
+
+			if (test.replayMaxTime > 0 && (DateTime.Now - context.reproducingStartTime).TotalSeconds >= (double)test.replayMaxTime)
+				return true;
+
+			return false;
+		}
+
+		/// <summary>
+		/// Records whether the run that started at reproducingRunStart
+		/// reproduced the fault and returns the first iteration of the next
+		/// run, or 0 when the search is over.
+		/// </summary>
+		/// <remarks>
+		/// Every run replays the iterations from its start up to the initial
+		/// iteration.  After the initial iteration fails on its own, the whole
+		/// window of up to reproducingMaxBacksearch iterations since the last
+		/// reproduced fault is replayed.  If that reproduces the fault, the
+		/// latest start that still reproduces it is bisected, so the reported
+		/// fault needs as little of the window as possible.
+		/// </remarks>
+		private uint NextBisectRun(RunContext context, uint lastReproFault, bool reproduced)
+		{
+			uint start = context.reproducingRunStart;
+			uint next;
+
+			if (reproduced)
+			{
+				context.reproducingBisectGood = start;
+
+				if (context.reproducingBisectBad - start <= 1)
+					return 0;
+
+				next = start + (context.reproducingBisectBad - start) / 2;
+			}
+			else
+			{
+				uint good = context.reproducingBisectGood;
+				context.reproducingBisectBad = start;
+
+				if (good == 0)
+				{
+					// Only the initial iteration has been replayed, try the whole window
+					if (start != context.reproducingInitialIteration)
+						return 0;
+
+					uint initial = context.reproducingInitialIteration;
+					next = Math.Max(lastReproFault + 1, initial > context.reproducingMaxBacksearch ? initial - context.reproducingMaxBacksearch : 1);
+
+					if (next >= initial)
+						return 0;
+				}
+				else if (start == good)
+				{
+					// The run that reproduced it before didn't this time
+					return 0;
+				}
+				else if (start - good <= 1)
+				{
+					// Replay the best run again, so the reported fault
+					// comes with the data of the run that caused it
+					next = good;
+				}
+				else
+				{
+					next = good + (start - good) / 2;
+				}
+			}
+
+			context.reproducingRunStart = next;
+			return next;
+		}
+
 		private void OnControlFault(RunContext context, uint iterationCount, string description)
 		{
 			// Don't tell the engine to stop, let the replay logic determine what to do
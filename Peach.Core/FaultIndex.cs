@@ -0,0 +1,370 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.Collections.Generic;
+using System.IO;
+using System.Linq;
+using System.Text;
+
+using Peach.Core.IO;
+
+namespace Peach.Core
+{
+	/// <summary>
+	/// Faults with the same stack hashes and faulting location.
+	/// </summary>
+	public class FaultBucket
+	{
+		public FaultBucket(string key, uint firstIteration)
+		{
+			Key = key;
+			FirstIteration = firstIteration;
+			LastIteration = firstIteration;
+			Count = 1;
+		}
+
+		/// <summary>
+		/// Normalized key, as returned by FaultIndex.GetKey.
+		/// </summary>
+		public string Key { get; private set; }
+
+		/// <summary>
+		/// Iteration the bucket was first seen on.
+		/// </summary>
+		public uint FirstIteration { get; private set; }
+
+		/// <summary>
+		/// Iteration the bucket was last seen on.
+		/// </summary>
+		public uint LastIteration { get; internal set; }
+
+		/// <summary>
+		/// Number of times a fault in this bucket has been seen.
+		/// </summary>
+		public ulong Count { get; internal set; }
+	}
+
+	/// <summary>
+	/// Index of the faults seen so far.  The engine only reproduces and
+	/// logs the first fault of every bucket, later ones are just counted.
+	/// </summary>
+	/// <remarks>
+	/// The file starts with the magic "PFDX" and a version, followed by
+	/// records which are only ever appended.  A bucket record holds the key
+	/// and first iteration of a new bucket, a hit record holds the varint
+	/// number of a bucket, in the order they were added, and the iteration
+	/// it was seen on again.  A record cut short when peach was killed is
+	/// dropped the next time the index is opened.
+	/// </remarks>
+	public class FaultIndex : IDisposable
+	{
+		public const uint Version = 1;
+
+		static readonly byte[] Magic = Encoding.ASCII.GetBytes("PFDX");
+
+		const byte BucketRecord = 1;
+		const byte HitRecord = 2;
+
+		List<FaultBucket> buckets = new List<FaultBucket>();
+		Dictionary<string, int> bucketIndex = new Dictionary<string, int>();
+		FileStream stream = null;
+		BinaryWriter writer = null;
+
+		/// <summary>
+		/// Creates an index that is kept in memory only.
+		/// </summary>
+		public FaultIndex()
+		{
+		}
+
+		/// <summary>
+		/// Opens the index in fileName, creating it if it doesn't exist.
+		/// </summary>
+		public FaultIndex(string fileName)
+		{
+			FileName = fileName;
+
+			try
+			{
+				stream = new FileStream(fileName, FileMode.OpenOrCreate, FileAccess.ReadWrite, FileShare.Read);
+			}
+			catch (Exception ex)
+			{
+				throw new PeachException("Error, could not open fault index '{0}'. {1}".Fmt(fileName, ex.Message), ex);
+			}
+
+			try
+			{
+				if (stream.Length != 0)
+					Load();
+
+				writer = new BinaryWriter(stream, System.Text.Encoding.UTF8);
+
+				if (stream.Length == 0)
+				{
+					writer.Write(Magic);
+					writer.Write(Version);
+					writer.Flush();
+				}
+			}
+			catch
+			{
+				stream.Dispose();
+				stream = null;
+				throw;
+			}
+		}
+
+		/// <summary>
+		/// File the index is kept in, null when it is in memory only.
+		/// </summary>
+		public string FileName { get; private set; }
+
+		/// <summary>
+		/// All buckets, in the order they were added.
+		/// </summary>
+		public IList<FaultBucket> Buckets { get { return buckets.AsReadOnly(); } }
+
+		/// <summary>
+		/// Returns the bucket of a fault, or null if it hasn't been seen.
+		/// </summary>
+		public FaultBucket Find(Fault fault)
+		{
+			var key = GetKey(fault);
+			int idx;
+
+			if (key == null || !bucketIndex.TryGetValue(key, out idx))
+				return null;
+
+			return buckets[idx];
+		}
+
+		/// <summary>
+		/// Counts a fault against its bucket, adding the bucket if it is new.
+		/// Returns null if the fault has nothing to bucket it on.
+		/// </summary>
+		public FaultBucket Add(Fault fault, uint iteration)
+		{
+			var key = GetKey(fault);
+			if (key == null)
+				return null;
+
+			int idx;
+
+			if (bucketIndex.TryGetValue(key, out idx))
+			{
+				var bucket = buckets[idx];
+				bucket.Count += 1;
+				bucket.LastIteration = iteration;
+
+				if (writer != null)
+				{
+					writer.Write(HitRecord);
+					VarInt.Write(writer, (ulong)idx);
+					writer.Write(iteration);
+					writer.Flush();
+				}
+
+				return bucket;
+			}
+			else
+			{
+				var bucket = AddBucket(key, iteration);
+
+				if (writer != null)
+				{
+					writer.Write(BucketRecord);
+					writer.Write(key);
+					writer.Write(iteration);
+					writer.Flush();
+				}
+
+				return bucket;
+			}
+		}
+
+		/// <summary>
+		/// Key a fault is bucketed on, made from its major and minor hash and
+		/// faulting module and offset.  Returns null if it has none of them.
+		/// </summary>
+		/// <remarks>
+		/// Hashes are lower cased and lose any 0x prefix and leading zeros
+		/// and the module loses its directory, so the same crash reported by
+		/// different monitors or platforms ends up in the same bucket.
+		/// </remarks>
+		public static string GetKey(Fault fault)
+		{
+			var major = NormalizeHash(fault.majorHash);
+			var minor = NormalizeHash(fault.minorHash);
+			var module = NormalizeModule(fault.faultingModule);
+
+			if (major == null && minor == null && module == null)
+				return null;
+
+			var sb = new StringBuilder();
+			sb.Append(major);
+			sb.Append(".");
+			sb.Append(minor);
+
+			if (module != null)
+				sb.AppendFormat("@{0}+0x{1:x}", module, fault.faultingOffset);
+
+			return sb.ToString();
+		}
+
+		static string NormalizeHash(string hash)
+		{
+			if (string.IsNullOrEmpty(hash))
+				return null;
+
+			hash = hash.Trim().ToLowerInvariant();
+
+			if (hash.StartsWith("0x"))
+				hash = hash.Substring(2);
+
+			if (hash.All(Uri.IsHexDigit))
+			{
+				hash = hash.TrimStart('0');
+				if (hash.Length == 0)
+					hash = "0";
+			}
+
+			return hash;
+		}
+
+		static string NormalizeModule(string module)
+		{
+			if (string.IsNullOrEmpty(module))
+				return null;
+
+			// Agents can run on another platform than the engine
+			module = module.Trim();
+			module = module.Substring(module.LastIndexOfAny(new[] { '/', '\\' }) + 1);
+
+			// Windows module names are case insensitive
+			return module.ToLowerInvariant();
+		}
+
+		FaultBucket AddBucket(string key, uint iteration)
+		{
+			var bucket = new FaultBucket(key, iteration);
+
+			bucketIndex.Add(key, buckets.Count);
+			buckets.Add(bucket);
+
+			return bucket;
+		}
+
+		void Load()
+		{
+			var rdr = new BinaryReader(stream, System.Text.Encoding.UTF8);
+			var magic = rdr.ReadBytes(Magic.Length);
+
+			for (int i = 0; i < Magic.Length; ++i)
+			{
+				if (magic.Length != Magic.Length || magic[i] != Magic[i])
+					throw new PeachException("Error, '{0}' is not a fault index.".Fmt(FileName));
+			}
+
+			try
+			{
+				var ver = rdr.ReadUInt32();
+				if (ver != Version)
+					throw new PeachException("Error, fault index '{0}' has unsupported version {1}.".Fmt(FileName, ver));
+			}
+			catch (EndOfStreamException ex)
+			{
+				throw new PeachException("Error, fault index '{0}' is truncated.".Fmt(FileName), ex);
+			}
+
+			long good = stream.Position;
+
+			try
+			{
+				while (stream.Position < stream.Length)
+				{
+					var type = rdr.ReadByte();
+
+					if (type == BucketRecord)
+					{
+						var key = rdr.ReadString();
+						var iteration = rdr.ReadUInt32();
+
+						if (bucketIndex.ContainsKey(key))
+							throw new PeachException("Error, fault index '{0}' is corrupt.".Fmt(FileName));
+
+						AddBucket(key, iteration);
+					}
+					else if (type == HitRecord)
+					{
+						var idx = VarInt.Read(rdr);
+						var iteration = rdr.ReadUInt32();
+
+						if (idx >= (ulong)buckets.Count)
+							throw new PeachException("Error, fault index '{0}' is corrupt.".Fmt(FileName));
+
+						var bucket = buckets[(int)idx];
+						bucket.Count += 1;
+						bucket.LastIteration = iteration;
+					}
+					else
+					{
+						throw new PeachException("Error, fault index '{0}' is corrupt.".Fmt(FileName));
+					}
+
+					good = stream.Position;
+				}
+			}
+			catch (EndOfStreamException)
+			{
+				// The last record was being appended when we went away
+				stream.SetLength(good);
+			}
+
+			stream.Seek(0, SeekOrigin.End);
+		}
+
+		public void Dispose()
+		{
+			if (writer != null)
+			{
+				writer.Flush();
+				writer = null;
+			}
+
+			if (stream != null)
+			{
+				stream.Dispose();
+				stream = null;
+			}
+		}
+	}
+}
+
+// end
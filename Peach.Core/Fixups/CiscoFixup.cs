@@ -48,8 +48,8 @@ namespace Peach.Core.Fixups.Libraries
 			var elem = elements["ref"];
 			var data = elem.Value;
 
-			System.Diagnostics.Debug.Assert((BitwiseStream.BlockCopySize % 2) == 0);
-			var buf = new byte[BitwiseStream.BlockCopySize];
+			System.Diagnostics.Debug.Assert((BitwiseStream.CopyBufferSize % 2) == 0);
+			var buf = BitwiseStream.RentBuffer();
 			var sum = new CiscoCDPChecksum();
 			data.Seek(0, System.IO.SeekOrigin.Begin);
 
@@ -57,6 +57,8 @@ namespace Peach.Core.Fixups.Libraries
 			while ((nread = data.Read(buf, 0, buf.Length)) != 0)
 				sum.Update(buf, 0, nread);
 
+			BitwiseStream.ReturnBuffer(buf);
+
 			return new Variant(sum.Final());
 		}
 
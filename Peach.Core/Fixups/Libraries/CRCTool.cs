@@ -208,23 +208,27 @@ namespace Peach.Core.Fixups.Libraries
 			}
 			if (refin == 0)
 			{
-				var buffer = new byte[BitwiseStream.BlockCopySize];
+				var buffer = BitwiseStream.RentBuffer();
 				int nread;
 				while ((nread = stream.Read(buffer, 0, buffer.Length)) != 0)
 				{
 					for (int i = 0; i < nread; ++i)
 						crc = (crc << 8) ^ crctab[((crc >> (order - 8)) & 0xff) ^ buffer[i]];
 				}
+
+				BitwiseStream.ReturnBuffer(buffer);
 			}
 			else
 			{
-				var buffer = new byte[BitwiseStream.BlockCopySize];
+				var buffer = BitwiseStream.RentBuffer();
 				int nread;
 				while ((nread = stream.Read(buffer, 0, buffer.Length)) != 0)
 				{
 					for (int i = 0; i < nread; ++i)
 						crc = (crc >> 8) ^ crctab[(crc & 0xff) ^ buffer[i]];
 				}
+
+				BitwiseStream.ReturnBuffer(buffer);
 			}
 			if ((refout ^ refin) != 0)
 			{
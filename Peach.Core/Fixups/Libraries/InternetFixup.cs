@@ -89,14 +89,16 @@ namespace Peach.Core.Fixups.Libraries
 			if (AddLength)
 				sum.Update((uint)data.Length);
 
-			System.Diagnostics.Debug.Assert((BitwiseStream.BlockCopySize % 2) == 0);
-			var buf = new byte[BitwiseStream.BlockCopySize];
+			System.Diagnostics.Debug.Assert((BitwiseStream.CopyBufferSize % 2) == 0);
+			var buf = BitwiseStream.RentBuffer();
 			data.Seek(0, System.IO.SeekOrigin.Begin);
 
 			int nread;
 			while ((nread = data.Read(buf, 0, buf.Length)) != 0)
 				sum.Update(buf, 0, nread);
 
+			BitwiseStream.ReturnBuffer(buf);
+
 			return new Variant(sum.Final());
 		}
 
@@ -59,6 +59,10 @@ namespace Peach.Core.Fixups
 		{
 			Core.Dom.Action.Starting -= Action_Starting;
 			Core.Dom.StateModel.Finished -= StateModel_Finished;
+
+			// The events are only subscribed to when the model is cloned.
+			// Make sure the next run clones the model instead of reusing it.
+			parent.Invalidate();
 		}
 
 		void Action_Starting(Action action)
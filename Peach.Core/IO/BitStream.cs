@@ -30,6 +30,7 @@
 using System;
 using System.IO;
 using System.Diagnostics;
+using System.Collections.Generic;
 
 namespace Peach.Core.IO
 {
@@ -139,6 +140,31 @@ namespace Peach.Core.IO
 			return ret;
 		}
 
+		public override bool TryGetSegments(List<ArraySegment<byte>> segments)
+		{
+			var ms = _stream as MemoryStream;
+
+			if (ms == null || ((_position + _offset) & 0x7) != 0 || ((_length - _position) & 0x7) != 0)
+				return false;
+
+			byte[] buffer;
+
+			try
+			{
+				buffer = ms.GetBuffer();
+			}
+			catch (UnauthorizedAccessException)
+			{
+				// MemoryStream was created over a buffer that isn't exposed
+				return false;
+			}
+
+			if (_length > _position)
+				segments.Add(new ArraySegment<byte>(buffer, (int)((_position + _offset) / 8), (int)((_length - _position) / 8)));
+
+			return true;
+		}
+
 		#endregion
 
 		#region Stream Interface
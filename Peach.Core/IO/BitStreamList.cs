@@ -15,6 +15,14 @@ namespace Peach.Core.IO
 		private List<BitwiseStream> _streams;
 		private long _position;
 
+		/// <summary>
+		/// Bit offset of each stream followed by the total length.
+		/// Rebuilt after the list changes, streams are expected to keep
+		/// their length once they are added.
+		/// </summary>
+		[NonSerialized]
+		private long[] _offsets;
+
 		#endregion
 
 		#region Constructor
@@ -36,6 +44,51 @@ namespace Peach.Core.IO
 
 		#endregion
 
+		#region Offsets
+
+		private long[] Offsets
+		{
+			get
+			{
+				if (_offsets == null)
+				{
+					var offsets = new long[_streams.Count + 1];
+
+					for (int i = 0; i < _streams.Count; ++i)
+						offsets[i + 1] = offsets[i] + _streams[i].LengthBits;
+
+					_offsets = offsets;
+				}
+
+				return _offsets;
+			}
+		}
+
+		/// <summary>
+		/// Index of the first stream that ends at or after the position.
+		/// Returns Count when the position is past the end of all streams.
+		/// </summary>
+		private int IndexOfPosition(long position)
+		{
+			var offsets = Offsets;
+			int lo = 0;
+			int hi = _streams.Count;
+
+			while (lo < hi)
+			{
+				int mid = lo + (hi - lo) / 2;
+
+				if (offsets[mid + 1] >= position)
+					hi = mid;
+				else
+					lo = mid + 1;
+			}
+
+			return lo;
+		}
+
+		#endregion
+
 		#region IDisposable
 
 		protected override void Dispose(bool disposing)
@@ -46,6 +99,7 @@ namespace Peach.Core.IO
 				item.Dispose();
 
 			_streams.Clear();
+			_offsets = null;
 		}
 
 		#endregion
@@ -54,7 +108,7 @@ namespace Peach.Core.IO
 
 		public override long LengthBits
 		{
-			get { return this.Sum(a => a.LengthBits); }
+			get { return Offsets[_streams.Count]; }
 		}
 
 		public override long PositionBits
@@ -101,30 +155,24 @@ namespace Peach.Core.IO
 			bits = 0;
 
 			int needed = count;
-			long pos = 0;
+			var offsets = Offsets;
 
-			foreach (var item in this)
+			for (int i = IndexOfPosition(PositionBits); i < _streams.Count; ++i)
 			{
-				long next = pos + item.LengthBits;
-
-				if (next >= PositionBits)
-				{
-					long offset = item.PositionBits;
-					item.PositionBits = PositionBits - pos;
-					ulong tmp;
-					int len = item.ReadBits(out tmp, needed);
-					item.PositionBits = offset;
-
-					bits <<= len;
-					bits |= tmp;
-					PositionBits += len;
-					needed -= len;
-
-					if (needed == 0)
-						break;
-				}
-
-				pos = next;
+				var item = _streams[i];
+				long offset = item.PositionBits;
+				item.PositionBits = PositionBits - offsets[i];
+				ulong tmp;
+				int len = item.ReadBits(out tmp, needed);
+				item.PositionBits = offset;
+
+				bits <<= len;
+				bits |= tmp;
+				PositionBits += len;
+				needed -= len;
+
+				if (needed == 0)
+					break;
 			}
 
 			return count - needed;
@@ -173,6 +221,33 @@ namespace Peach.Core.IO
 
 		#endregion
 
+		#region Segments
+
+		public override bool TryGetSegments(List<ArraySegment<byte>> segments)
+		{
+			int count = segments.Count;
+			var offsets = Offsets;
+
+			for (int i = IndexOfPosition(PositionBits); i < _streams.Count; ++i)
+			{
+				var item = _streams[i];
+				long restore = item.PositionBits;
+				item.PositionBits = Math.Max(0, PositionBits - offsets[i]);
+				bool ret = item.TryGetSegments(segments);
+				item.PositionBits = restore;
+
+				if (!ret)
+				{
+					segments.RemoveRange(count, segments.Count - count);
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		#endregion
+
 		#region Stream Interface
 
 		public override bool CanRead
@@ -224,63 +299,57 @@ namespace Peach.Core.IO
 
 			int bits = 0;
 			int needed = count;
-			long pos = 0;
 			ulong tmp = 0;
 			byte glue = 0;
+			var offsets = Offsets;
 
-			foreach (var item in this)
+			for (int i = IndexOfPosition(PositionBits); i < _streams.Count; ++i)
 			{
-				long next = pos + item.LengthBits;
+				var item = _streams[i];
+				long restore = item.PositionBits;
+				item.PositionBits = PositionBits - offsets[i];
 
-				if (next >= PositionBits)
+				// If we are not aligned reading into buffer, get back aligned
+				if (bits != 0)
 				{
-					long restore = item.PositionBits;
-					item.PositionBits = PositionBits - pos;
+					int len = item.ReadBits(out tmp, 8 - bits);
+					glue |= (byte)(tmp << (8 - bits - len));
+					PositionBits += len;
+					bits += len;
 
-					// If we are not aligned reading into buffer, get back aligned
-					if (bits != 0)
+					// Advance offset once buffer is aligned again
+					if (bits == 8)
 					{
-						int len = item.ReadBits(out tmp, 8 - bits);
-						glue |= (byte)(tmp << (8 - bits - len));
-						PositionBits += len;
-						bits += len;
-
-						// Advance offset once buffer is aligned again
-						if (bits == 8)
-						{
-							buffer[offset] = glue;
-							++offset;
-							--needed;
-							bits = 0;
-							glue = 0;
-						}
+						buffer[offset] = glue;
+						++offset;
+						--needed;
+						bits = 0;
+						glue = 0;
 					}
+				}
 
-					// If we are aligned, read directly into the buffer
-					if (bits == 0)
-					{
-						int len = item.Read(buffer, offset, needed);
-
-						offset += len;
-						needed -= len;
-						PositionBits += (len * 8);
-
-						// Ensure we read any leftover bits
-						if (needed > 0)
-						{
-							bits = item.ReadBits(out tmp, 7);
-							glue = (byte)(tmp << (8 - bits));
-							PositionBits += bits;
-						}
-					}
+				// If we are aligned, read directly into the buffer
+				if (bits == 0)
+				{
+					int len = item.Read(buffer, offset, needed);
 
-					item.PositionBits = restore;
+					offset += len;
+					needed -= len;
+					PositionBits += (len * 8);
 
-					if (bits == 0 && needed == 0)
-						break;
+					// Ensure we read any leftover bits
+					if (needed > 0)
+					{
+						bits = item.ReadBits(out tmp, 7);
+						glue = (byte)(tmp << (8 - bits));
+						PositionBits += bits;
+					}
 				}
 
-				pos = next;
+				item.PositionBits = restore;
+
+				if (bits == 0 && needed == 0)
+					break;
 			}
 
 			// If we have partial bits we failed to glue into a whole byte
@@ -317,11 +386,13 @@ namespace Peach.Core.IO
 		public void Insert(int index, BitwiseStream item)
 		{
 			_streams.Insert(index, item);
+			_offsets = null;
 		}
 
 		public void RemoveAt(int index)
 		{
 			_streams.RemoveAt(index);
+			_offsets = null;
 		}
 
 		public BitwiseStream this[int index]
@@ -333,17 +404,20 @@ namespace Peach.Core.IO
 			set
 			{
 				_streams[index] = value;
+				_offsets = null;
 			}
 		}
 
 		public void Add(BitwiseStream item)
 		{
 			_streams.Add(item);
+			_offsets = null;
 		}
 
 		public void Clear()
 		{
 			_streams.Clear();
+			_offsets = null;
 		}
 
 		public bool Contains(BitwiseStream item)
@@ -368,6 +442,7 @@ namespace Peach.Core.IO
 
 		public bool Remove(BitwiseStream item)
 		{
+			_offsets = null;
 			return _streams.Remove(item);
 		}
 
@@ -13,6 +13,37 @@ namespace Peach.Core.IO
 
 		public const int BlockCopySize = 4 * 1024 * 1024;
 
+		/// <summary>
+		/// Size of the buffers handed out by RentBuffer.  Stays below the
+		/// large object heap threshold.
+		/// </summary>
+		public const int CopyBufferSize = 0x14000;
+
+		#endregion
+
+		#region Copy Buffers
+
+		[ThreadStatic]
+		private static byte[] _copyBuffer;
+
+		/// <summary>
+		/// Get a buffer of CopyBufferSize bytes for copying streams in blocks.
+		/// Pass it to ReturnBuffer once done so the next copy on this thread
+		/// reuses it instead of allocating a new one.
+		/// </summary>
+		public static byte[] RentBuffer()
+		{
+			var ret = _copyBuffer ?? new byte[CopyBufferSize];
+			_copyBuffer = null;
+			return ret;
+		}
+
+		public static void ReturnBuffer(byte[] buffer)
+		{
+			if (buffer != null && buffer.Length == CopyBufferSize)
+				_copyBuffer = buffer;
+		}
+
 		#endregion
 
 		#region Constructor
@@ -43,6 +74,22 @@ namespace Peach.Core.IO
 
 		#endregion
 
+		#region Segments
+
+		/// <summary>
+		/// Add the memory buffers holding the rest of the stream to segments
+		/// so they can be written out without being copied first.
+		/// Returns false and leaves segments unchanged when any part of the
+		/// stream is not byte aligned or not backed by a memory buffer.
+		/// The position of the stream is not changed.
+		/// </summary>
+		public virtual bool TryGetSegments(List<ArraySegment<byte>> segments)
+		{
+			return false;
+		}
+
+		#endregion
+
 		#region Stream Specializations
 
 		public void CopyTo(BitwiseStream destination)
@@ -61,16 +108,64 @@ namespace Peach.Core.IO
 			if (bufferSize <= 0)
 				throw new ArgumentOutOfRangeException("bufferSize");
 
-			var buffer = new byte[bufferSize];
-			int nread;
-			while ((nread = Read(buffer, 0, bufferSize)) != 0)
-				destination.Write(buffer, 0, nread);
+			CopyBytes(destination, bufferSize);
 
 			ulong bits;
-			nread = ReadBits(out bits, 7);
+			int nread = ReadBits(out bits, 7);
 			destination.WriteBits(bits, nread);
 		}
 
+		public new void CopyTo(Stream destination)
+		{
+			CopyTo(destination, BlockCopySize);
+		}
+
+		/// <summary>
+		/// Copy the whole bytes of the stream to a regular stream.
+		/// Trailing bits that don't make up a byte are not copied.
+		/// </summary>
+		public new void CopyTo(Stream destination, int bufferSize)
+		{
+			if (destination == null)
+				throw new ArgumentNullException("destination");
+			if (!CanRead)
+				throw new NotSupportedException("This stream does not support reading");
+			if (!destination.CanWrite)
+				throw new NotSupportedException("This destination stream does not support writing");
+			if (bufferSize <= 0)
+				throw new ArgumentOutOfRangeException("bufferSize");
+
+			CopyBytes(destination, bufferSize);
+		}
+
+		private void CopyBytes(Stream destination, int bufferSize)
+		{
+			var segments = new List<ArraySegment<byte>>();
+
+			if (TryGetSegments(segments))
+			{
+				long total = 0;
+
+				foreach (var item in segments)
+				{
+					destination.Write(item.Array, item.Offset, item.Count);
+					total += item.Count;
+				}
+
+				SeekBits(total * 8, SeekOrigin.Current);
+				return;
+			}
+
+			var buffer = RentBuffer();
+			int count = Math.Min(bufferSize, buffer.Length);
+			int nread;
+
+			while ((nread = Read(buffer, 0, count)) != 0)
+				destination.Write(buffer, 0, nread);
+
+			ReturnBuffer(buffer);
+		}
+
 		#endregion
 
 		#region Helpers
@@ -0,0 +1,97 @@
+﻿
+//
+// Copyright (c) Michael Eddington
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy 
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights 
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell 
+// copies of the Software, and to permit persons to whom the Software is 
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in	
+// all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR 
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, 
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE 
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER 
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Authors:
+//   Michael Eddington (mike@dejavusecurity.com)
+
+// $Id$
+
+using System;
+using System.IO;
+
+namespace Peach.Core.IO
+{
+	/// <summary>
+	/// Unsigned LEB128 integers, seven bits per byte with the high bit set
+	/// on every byte but the last.  Shared by the trace, minset database,
+	/// fault index and set cover spill file formats.
+	/// </summary>
+	internal static class VarInt
+	{
+		/// <summary>
+		/// Longest encoding of a 64 bit value.
+		/// </summary>
+		const int MaxBytes = 10;
+
+		public static void Write(BinaryWriter wtr, ulong value)
+		{
+			for (; value >= 0x80; value >>= 7)
+				wtr.Write((byte)((value & 0x7f) | 0x80));
+
+			wtr.Write((byte)value);
+		}
+
+		public static void Write(Stream stream, ulong value)
+		{
+			for (; value >= 0x80; value >>= 7)
+				stream.WriteByte((byte)((value & 0x7f) | 0x80));
+
+			stream.WriteByte((byte)value);
+		}
+
+		public static ulong Read(BinaryReader rdr)
+		{
+			ulong ret = 0;
+
+			for (int shift = 0; shift < MaxBytes * 7; shift += 7)
+			{
+				var b = rdr.ReadByte();
+				ret |= (ulong)(b & 0x7f) << shift;
+
+				if ((b & 0x80) == 0)
+					return ret;
+			}
+
+			throw new PeachException("Error, variable length integer is longer than {0} bytes.".Fmt(MaxBytes));
+		}
+
+		/// <summary>
+		/// Reads a value from buf at pos and advances pos past it.
+		/// </summary>
+		public static ulong Read(byte[] buf, ref int pos)
+		{
+			ulong ret = 0;
+
+			for (int shift = 0; shift < MaxBytes * 7; shift += 7)
+			{
+				var b = buf[pos++];
+				ret |= (ulong)(b & 0x7f) << shift;
+
+				if ((b & 0x80) == 0)
+					return ret;
+			}
+
+			throw new PeachException("Error, variable length integer is longer than {0} bytes.".Fmt(MaxBytes));
+		}
+	}
+}
@@ -51,6 +51,8 @@ namespace Peach.Core.Loggers
 	[Logger("Filesystem", true)]
 	[Logger("logger.Filesystem")]
 	[Parameter("Path", typeof(string), "Log folder")]
+	[Parameter("FaultIndex", typeof(string), "Fault index file to share known faults between runs", "")]
+	[Parameter("Deduplicate", typeof(bool), "Only reproduce and log the first fault of every bucket", "false")]
 	public class FileLogger : Logger
 	{
 		private static NLog.Logger logger = LogManager.GetCurrentClassLogger();
@@ -58,10 +60,16 @@ namespace Peach.Core.Loggers
 		Fault reproFault = null;
 		TextWriter log = null;
 		List<Fault.State> states = null;
+		FaultIndex index = null;
 
 		public FileLogger(Dictionary<string, Variant> args)
 		{
 			Path = (string)args["Path"];
+
+			if (args.ContainsKey("FaultIndex"))
+				FaultIndexPath = (string)args["FaultIndex"];
+
+			Deduplicate = args.ContainsKey("Deduplicate") && ((string)args["Deduplicate"]).ToLower() == "true";
 		}
 
 		/// <summary>
@@ -73,6 +81,25 @@ namespace Peach.Core.Loggers
 			private set;
 		}
 
+		/// <summary>
+		/// The user configured fault index, if empty each test
+		/// keeps its own index in RootDir.
+		/// </summary>
+		public string FaultIndexPath
+		{
+			get;
+			private set;
+		}
+
+		/// <summary>
+		/// Faults in a known bucket are only counted.
+		/// </summary>
+		public bool Deduplicate
+		{
+			get;
+			private set;
+		}
+
 		/// <summary>
 		/// The specific path used to log faults for a given test.
 		/// </summary>
@@ -140,6 +167,13 @@ namespace Peach.Core.Loggers
 			SaveFault(Category.Faults, fault);
 		}
 
+		protected override void Engine_DuplicateFault(RunContext context, uint currentIteration, FaultBucket bucket, Fault[] faults)
+		{
+			log.WriteLine("! Known fault at iteration {0} : {1}, seen {2} times since iteration {3}",
+				currentIteration, bucket.Key, bucket.Count, bucket.FirstIteration);
+			log.Flush();
+		}
+
 		// TODO: Figure out how to not do this!
 		private static byte[] ToByteArray(BitwiseStream data)
 		{
@@ -377,6 +411,12 @@ namespace Peach.Core.Loggers
 
 		protected override void Engine_TestFinished(RunContext context)
 		{
+			if (index != null)
+			{
+				SaveBuckets();
+				CloseFaultIndex(context);
+			}
+
 			if (log != null)
 			{
 				log.WriteLine(". Test finished: " + context.test.name);
@@ -414,9 +454,54 @@ namespace Peach.Core.Loggers
 			log.WriteLine(". Test starting: " + context.test.name);
 			log.WriteLine("");
 
+			CloseFaultIndex(context);
+
+			if (Deduplicate)
+			{
+				var fileName = string.IsNullOrEmpty(FaultIndexPath) ? System.IO.Path.Combine(RootDir, "faults.idx") : FaultIndexPath;
+
+				index = new FaultIndex(fileName);
+				context.faultIndex = index;
+
+				log.WriteLine(". Fault index: {0} ({1} known buckets)", fileName, index.Buckets.Count);
+				log.WriteLine("");
+			}
+
 			log.Flush();
 		}
 
+		void CloseFaultIndex(RunContext context)
+		{
+			if (index == null)
+				return;
+
+			if (context.faultIndex == index)
+				context.faultIndex = null;
+
+			index.Dispose();
+			index = null;
+		}
+
+		/// <summary>
+		/// Write the count of every bucket in the fault index to buckets.txt.
+		/// </summary>
+		void SaveBuckets()
+		{
+			var sb = new StringBuilder();
+
+			foreach (var bucket in index.Buckets.OrderByDescending(b => b.Count))
+				sb.AppendFormat("{0}\t{1}\t{2}\t{3}", bucket.Count, bucket.FirstIteration, bucket.LastIteration, bucket.Key).AppendLine();
+
+			try
+			{
+				File.WriteAllText(System.IO.Path.Combine(RootDir, "buckets.txt"), sb.ToString());
+			}
+			catch (Exception e)
+			{
+				throw new PeachException(e.Message, e);
+			}
+		}
+
 		protected virtual TextWriter OpenStatusLog()
 		{
 			try
@@ -383,6 +383,9 @@ namespace Peach.Core.MutationStrategies
 				if (item.InstanceName != instanceName)
 					continue;
 
+				// Don't mutate a model that is shared with a previous iteration
+				data.UnshareDataModel();
+
 				var elem = data.dataModel.find(item.ElementName);
 				if (elem != null && elem.MutatedValue == null)
 				{
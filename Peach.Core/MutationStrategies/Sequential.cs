@@ -270,6 +270,9 @@ namespace Peach.Core.MutationStrategies
 			if (_enumerator.Current.Item3 != data.instanceName)
 				return;
 
+			// Don't mutate a model that is shared with a previous iteration
+			data.UnshareDataModel();
+
 			var fullName = _enumerator.Current.Item1;
 			var dataElement = data.dataModel.find(fullName);
 
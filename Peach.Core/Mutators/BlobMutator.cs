@@ -169,7 +169,7 @@ namespace Peach.Core.Mutators
 			if (length > src.Length)
 				throw new ArgumentOutOfRangeException("length");
 
-			var buf = new byte[BitwiseStream.BlockCopySize];
+			var buf = BitwiseStream.RentBuffer();
 			var ret = new BitStream();
 			src.Seek(0, SeekOrigin.Begin);
 
@@ -181,6 +181,8 @@ namespace Peach.Core.Mutators
 				length -= len;
 			}
 
+			BitwiseStream.ReturnBuffer(buf);
+
 			return ret;
 		}
 
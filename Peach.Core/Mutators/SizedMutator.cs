@@ -148,7 +148,7 @@ namespace Peach.Core.Mutators
 					tgtLen -= dataLen;
 				}
 
-				var buf = new byte[BitwiseStream.BlockCopySize];
+				var buf = BitwiseStream.RentBuffer();
 				var dst = new BitStream();
 
 				data.Seek(0, System.IO.SeekOrigin.Begin);
@@ -166,6 +166,8 @@ namespace Peach.Core.Mutators
 					tgtLen -= len;
 				}
 
+				BitwiseStream.ReturnBuffer(buf);
+
 				lst.Add(dst);
 
 				data = lst;
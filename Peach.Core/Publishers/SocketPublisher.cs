@@ -100,6 +100,7 @@ namespace Peach.Core.Publishers
 		private string _iface = null;
 		private Socket _socket = null;
 		private MemoryStream _recvBuffer = null;
+		private byte[] _sendBuffer = null;
 		private uint? _origMtu = null;
 		private uint? _mtu = null;
 
@@ -671,8 +672,12 @@ namespace Peach.Core.Publishers
 			if (Logger.IsDebugEnabled)
 				Logger.Debug("\n\n" + Utilities.HexDump(data));
 
+			// FilterOutput can modify the buffer so always copy into our own
+			if (_sendBuffer == null || _sendBuffer.Length != MaxSendSize)
+				_sendBuffer = new byte[MaxSendSize];
+
 			long count = data.Length;
-			var buffer = new byte[MaxSendSize];
+			var buffer = _sendBuffer;
 			int size = data.Read(buffer, 0, buffer.Length);
 
 			try
@@ -182,6 +182,15 @@ namespace Peach.Core
         /// </remarks>
         public List<Fault> faults = new List<Fault>();
 
+		/// <summary>
+		/// Buckets of the faults seen so far.  When set, only the first fault
+		/// of a bucket is reproduced and logged, later ones are counted.
+		/// </summary>
+		/// <remarks>
+		/// Set by a logger when the test starts.
+		/// </remarks>
+		public FaultIndex faultIndex = null;
+
 		/// <summary>
 		/// Controls if we continue fuzzing or exit
 		/// after current iteration.  This can be used
@@ -262,6 +271,32 @@ namespace Peach.Core
 		/// </remarks>
 		public uint reproducingIterationJumpCount = 1;
 
+		/// <summary>
+		/// Number of iterations replayed for the current fault.
+		/// </summary>
+		public uint reproducingIterationCount = 0;
+
+		/// <summary>
+		/// When reproducing the current fault started.
+		/// </summary>
+		public DateTime reproducingStartTime = DateTime.MinValue;
+
+		/// <summary>
+		/// First iteration of the run being replayed when bisecting.
+		/// </summary>
+		public uint reproducingRunStart = 0;
+
+		/// <summary>
+		/// Latest run start known to reproduce the fault when bisecting,
+		/// zero until a run has reproduced it.
+		/// </summary>
+		public uint reproducingBisectGood = 0;
+
+		/// <summary>
+		/// Earliest run start known not to reproduce the fault when bisecting.
+		/// </summary>
+		public uint reproducingBisectBad = 0;
+
 		#endregion
 	}
 
@@ -414,6 +449,19 @@ namespace Peach.Core
         /// </summary>
         public string folderName = null;
 
+        /// <summary>
+        /// Module the fault occured in, used for bucketting.
+        /// </summary>
+        /// <remarks>
+        /// Only the file name, without a directory.
+        /// </remarks>
+        public string faultingModule = null;
+
+        /// <summary>
+        /// Offset of the fault from the start of faultingModule, used for bucketting.
+        /// </summary>
+        public ulong faultingOffset = 0;
+
         /// <summary>
         /// Binary data collected about fault.  Key is filename, value is content.
         /// </summary>
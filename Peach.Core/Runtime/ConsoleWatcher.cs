@@ -74,6 +74,15 @@ namespace Peach.Core.Runtime
 			reproducing = false;
 		}
 
+		protected override void Engine_DuplicateFault(RunContext context, uint currentIteration, FaultBucket bucket, Fault[] faultData)
+		{
+			var color = Console.ForegroundColor;
+			Console.ForegroundColor = ConsoleColor.Yellow;
+			Console.WriteLine(string.Format("\n -- Known fault at iteration {0}, seen {1} times since iteration {2} --\n",
+				currentIteration, bucket.Count, bucket.FirstIteration));
+			Console.ForegroundColor = color;
+		}
+
 		protected override void Engine_HaveCount(RunContext context, uint totalIterations)
 		{
 			var color = Console.ForegroundColor;
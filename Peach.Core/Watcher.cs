@@ -57,6 +57,7 @@ namespace Peach.Core
 			engine.Fault += new Engine.FaultEventHandler(Engine_Fault);
 			engine.ReproFault += new Engine.ReproFaultEventHandler(Engine_ReproFault);
 			engine.ReproFailed += new Engine.ReproFailedEventHandler(Engine_ReproFailed);
+			engine.DuplicateFault += new Engine.DuplicateFaultEventHandler(Engine_DuplicateFault);
 			engine.HaveCount += new Engine.HaveCountEventHandler(Engine_HaveCount);
 			engine.HaveParallel += new Engine.HaveParallelEventHandler(Engine_HaveParallel);
 
@@ -140,6 +141,10 @@ namespace Peach.Core
 		{
 		}
 
+		protected virtual void Engine_DuplicateFault(RunContext context, uint currentIteration, FaultBucket bucket, Fault[] faultData)
+		{
+		}
+
 		protected virtual void Engine_IterationFinished(RunContext context, uint currentIteration)
 		{
 		}
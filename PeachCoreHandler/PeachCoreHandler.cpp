@@ -0,0 +1,1138 @@
+// Linux core_pattern handler
+//
+// Registered by the LinuxCrashMonitor in place of PeachLinuxCrashHandler.exe:
+//
+//   |/path/PeachCoreHandler -p=%p -P=%P -u=%u -g=%g -s=%s -t=%t -e=%e -l=logfolder
+//
+// The kernel writes the core to stdin.  Instead of copying all of it to
+// disk and running gdb on it afterwards, the core is filtered while it
+// streams past.  The ELF and program headers and the notes come first and
+// are buffered, the notes have the registers of every thread.  From those
+// the memory worth keeping is picked before any of it arrives:
+//
+//   - the live part of every thread's stack
+//   - a window around every register value that points into writable memory
+//   - segments of a page or less, the ELF headers gdb uses to find modules
+//
+// Everything else is skipped on the pipe.  The kept memory is written as
+// a smaller core with its own program headers (dropped ranges stay as
+// PT_LOAD with no file data, so gdb shows them as unavailable) and pages
+// of zeros are left as holes.  The crashing thread is then classified with
+// the gdb/exploitable rules (see PeachTriage/Triage.h), reading code from
+// the mapped files, and a summary is written next to the core.
+//
+// Options:
+//   -a         keep the whole core, only zero pages are dropped
+//   -w=<kb>    window kept around register values, default 64
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <elf.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Triage.h"
+
+#define PAGE_SIZE_CORE 4096
+#define STREAM_BUFFER (1024 * 1024)
+#define MAX_HEADERS (64 * 1024 * 1024)
+#define MAX_STACK (8 * 1024 * 1024)
+
+#ifndef NT_SIGINFO
+#define NT_SIGINFO 0x53494749
+#endif
+
+#ifndef NT_FILE
+#define NT_FILE 0x46494c45
+#endif
+
+struct Options
+{
+	std::string pid;
+	std::string globalPid;
+	std::string uid;
+	std::string gid;
+	std::string sig;
+	std::string time;
+	std::string host;
+	std::string exe;
+	std::string logFolder;
+	bool keepAll;
+	uint64_t window;
+};
+
+struct Thread
+{
+	int pid;
+	uint64_t regs[TRIAGE_COUNT];
+};
+
+// A load segment of the output core
+struct Load
+{
+	uint64_t vaddr;
+	uint64_t memsz;
+	uint64_t offset;
+	uint64_t filesz;
+	uint32_t flags;
+};
+
+struct FileMapping
+{
+	uint64_t start;
+	uint64_t end;
+	uint64_t offset;
+	std::string name;
+};
+
+// What the streaming pass learned about the core
+struct CoreSummary
+{
+	bool is64;
+	int signo;
+	int code;
+	uint64_t address;
+	std::vector<Thread> threads;
+	std::vector<Load> loads;
+	std::vector<FileMapping> files;
+	uint64_t inputSize;
+	uint64_t outputSize;
+	bool filtered;
+};
+
+static std::string Format(const char* fmt, ...)
+{
+	char buf[1024];
+	va_list ap;
+
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	return buf;
+}
+
+static std::string ReadFile(const std::string& path)
+{
+	std::string ret;
+	char buf[4096];
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return ret;
+
+	ssize_t len;
+	while ((len = read(fd, buf, sizeof(buf))) > 0)
+		ret.append(buf, len);
+
+	close(fd);
+	return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Input
+
+// Sequential reader for the core pipe, which can't seek
+class Input
+{
+public:
+	Input(int fd)
+		: m_fd(fd)
+		, m_pos(0)
+		, m_buf(STREAM_BUFFER)
+	{
+	}
+
+	uint64_t Position() const { return m_pos; }
+
+	// Append len bytes to out, returns false at EOF
+	bool Read(std::vector<unsigned char>& out, size_t len)
+	{
+		size_t start = out.size();
+		out.resize(start + len);
+
+		size_t got = Fill(&out[start], len);
+		out.resize(start + got);
+
+		return got == len;
+	}
+
+	bool Skip(uint64_t len)
+	{
+		while (len > 0)
+		{
+			size_t chunk = (size_t)std::min<uint64_t>(len, m_buf.size());
+			size_t got = Fill(&m_buf[0], chunk);
+
+			len -= got;
+
+			if (got != chunk)
+				return false;
+		}
+
+		return true;
+	}
+
+	// Copy len bytes to offset of out, pages of zeros become holes.
+	// A negative len copies to EOF.  Returns the number of bytes copied.
+	uint64_t Copy(int out, uint64_t offset, int64_t len)
+	{
+		uint64_t total = 0;
+
+		while (len < 0 || total < (uint64_t)len)
+		{
+			size_t chunk = len < 0 ? m_buf.size() : (size_t)std::min<uint64_t>(len - total, m_buf.size());
+			size_t got = Fill(&m_buf[0], chunk);
+
+			WriteSparse(out, offset + total, &m_buf[0], got);
+			total += got;
+
+			if (got != chunk)
+				break;
+		}
+
+		return total;
+	}
+
+	static bool WriteSparse(int out, uint64_t offset, const unsigned char* data, size_t len)
+	{
+		size_t pos = 0;
+
+		while (pos < len)
+		{
+			// Runs of pages are written in one call, blocks follow the output offset
+			size_t block = PAGE_SIZE_CORE - (size_t)((offset + pos) % PAGE_SIZE_CORE);
+			block = std::min(block, len - pos);
+
+			if (IsZero(data + pos, block))
+			{
+				pos += block;
+				continue;
+			}
+
+			size_t end = pos + block;
+			while (end < len)
+			{
+				size_t next = std::min((size_t)PAGE_SIZE_CORE, len - end);
+				if (IsZero(data + end, next))
+					break;
+				end += next;
+			}
+
+			if (!WriteAt(out, offset + pos, data + pos, end - pos))
+				return false;
+
+			pos = end;
+		}
+
+		return true;
+	}
+
+	static bool WriteAt(int out, uint64_t offset, const void* data, size_t len)
+	{
+		const unsigned char* p = (const unsigned char*)data;
+
+		while (len > 0)
+		{
+			ssize_t ret = pwrite(out, p, len, (off_t)offset);
+			if (ret == -1 && errno == EINTR)
+				continue;
+			if (ret <= 0)
+				return false;
+
+			p += ret;
+			offset += ret;
+			len -= ret;
+		}
+
+		return true;
+	}
+
+private:
+	int m_fd;
+	uint64_t m_pos;
+	std::vector<unsigned char> m_buf;
+
+	size_t Fill(unsigned char* buf, size_t len)
+	{
+		size_t got = 0;
+
+		while (got < len)
+		{
+			ssize_t ret = read(m_fd, buf + got, len - got);
+			if (ret == -1 && errno == EINTR)
+				continue;
+			if (ret <= 0)
+				break;
+
+			got += ret;
+		}
+
+		m_pos += got;
+		return got;
+	}
+
+	static bool IsZero(const unsigned char* data, size_t len)
+	{
+		for (size_t i = 0; i < len; ++i)
+		{
+			if (data[i])
+				return false;
+		}
+
+		return true;
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Notes
+
+// Offsets into struct elf_prstatus and its register set
+struct PrStatusLayout
+{
+	size_t cursig;
+	size_t pid;
+	size_t regs;
+	size_t regSize;
+	size_t regCount;
+	int order[TRIAGE_COUNT];  // Index of each TriageRegister in pr_reg, -1 if missing
+};
+
+// user_regs_struct: r15 r14 r13 r12 rbp rbx r11 r10 r9 r8 rax rcx rdx rsi rdi orig_rax rip ...
+static const PrStatusLayout s_prstatus64 =
+{
+	12, 32, 112, 8, 27,
+	{ 10, 11, 12, 5, 19, 4, 13, 14, 9, 8, 7, 6, 3, 2, 1, 0, 16 },
+};
+
+// user_regs_struct: ebx ecx edx esi edi ebp eax ds es fs gs orig_eax eip cs eflags esp ss
+static const PrStatusLayout s_prstatus32 =
+{
+	12, 24, 72, 4, 17,
+	{ 6, 1, 2, 0, 15, 5, 3, 4, -1, -1, -1, -1, -1, -1, -1, -1, 12 },
+};
+
+static uint64_t ReadWord(const unsigned char* p, size_t size)
+{
+	if (size == 8)
+	{
+		uint64_t v;
+		memcpy(&v, p, 8);
+		return v;
+	}
+
+	uint32_t v;
+	memcpy(&v, p, 4);
+	return v;
+}
+
+static void ParseNotes(const unsigned char* data, size_t size, CoreSummary& core)
+{
+	const PrStatusLayout& layout = core.is64 ? s_prstatus64 : s_prstatus32;
+	size_t word = core.is64 ? 8 : 4;
+	size_t pos = 0;
+
+	// Elf32_Nhdr and Elf64_Nhdr are the same
+	while (pos + sizeof(Elf64_Nhdr) <= size)
+	{
+		Elf64_Nhdr nhdr;
+		memcpy(&nhdr, data + pos, sizeof(nhdr));
+		pos += sizeof(nhdr);
+
+		size_t nameEnd = pos + ((nhdr.n_namesz + 3) & ~3);
+		size_t descEnd = nameEnd + ((nhdr.n_descsz + 3) & ~3);
+
+		if (descEnd > size || nameEnd < pos)
+			break;
+
+		const unsigned char* desc = data + nameEnd;
+		size_t len = nhdr.n_descsz;
+
+		if (nhdr.n_type == NT_PRSTATUS && len >= layout.regs + layout.regCount * layout.regSize)
+		{
+			Thread thread;
+			int32_t pid;
+
+			memcpy(&pid, desc + layout.pid, sizeof(pid));
+			thread.pid = pid;
+
+			for (int i = 0; i < TRIAGE_COUNT; ++i)
+			{
+				int idx = layout.order[i];
+				thread.regs[i] = idx < 0 ? 0 : ReadWord(desc + layout.regs + idx * layout.regSize, layout.regSize);
+			}
+
+			// The kernel writes the thread that dumped core first
+			if (core.threads.empty() && core.signo == 0)
+			{
+				int16_t cursig;
+				memcpy(&cursig, desc + layout.cursig, sizeof(cursig));
+				core.signo = cursig;
+			}
+
+			core.threads.push_back(thread);
+		}
+		else if (nhdr.n_type == NT_SIGINFO && len >= 12 + word)
+		{
+			int32_t signo, code;
+
+			memcpy(&signo, desc, 4);
+			memcpy(&code, desc + 8, 4);
+
+			core.signo = signo;
+			core.code = code;
+
+			// The union is aligned to a long
+			core.address = ReadWord(desc + (core.is64 ? 16 : 12), word);
+		}
+		else if (nhdr.n_type == NT_FILE && len >= 2 * word)
+		{
+			uint64_t count = ReadWord(desc, word);
+			uint64_t pageSize = ReadWord(desc + word, word);
+			size_t names = 2 * word + count * 3 * word;
+
+			if (count < len && names <= len)
+			{
+				const char* name = (const char*)desc + names;
+				const char* end = (const char*)desc + len;
+
+				for (uint64_t i = 0; i < count && name < end; ++i)
+				{
+					const unsigned char* entry = desc + 2 * word + i * 3 * word;
+					FileMapping map;
+
+					map.start = ReadWord(entry, word);
+					map.end = ReadWord(entry + word, word);
+					map.offset = ReadWord(entry + 2 * word, word) * pageSize;
+					map.name.assign(name, strnlen(name, end - name));
+
+					core.files.push_back(map);
+					name += map.name.size() + 1;
+				}
+			}
+		}
+
+		pos = descEnd;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Filtering
+
+struct Range
+{
+	uint64_t start;
+	uint64_t end;
+
+	bool operator<(const Range& other) const { return start < other.start; }
+};
+
+// Address ranges worth keeping, by the registers of every thread
+static std::vector<Range> KeepRanges(const CoreSummary& core, uint64_t window)
+{
+	std::vector<Range> ranges;
+
+	for (std::vector<Thread>::const_iterator it = core.threads.begin(); it != core.threads.end(); ++it)
+	{
+		for (int i = 0; i < TRIAGE_COUNT; ++i)
+		{
+			uint64_t value = it->regs[i];
+			Range r;
+
+			if (i == TRIAGE_SP)
+			{
+				// The live stack is above sp, below it is the red zone
+				r.start = value - PAGE_SIZE_CORE;
+				r.end = value + MAX_STACK;
+			}
+			else
+			{
+				r.start = value - window;
+				r.end = value + window;
+			}
+
+			// Clamp wrap arounds at either end of the address space
+			if (r.start > value)
+				r.start = 0;
+			if (r.end < value)
+				r.end = UINT64_MAX;
+
+			r.start &= ~(uint64_t)(PAGE_SIZE_CORE - 1);
+			ranges.push_back(r);
+		}
+	}
+
+	std::sort(ranges.begin(), ranges.end());
+
+	std::vector<Range> merged;
+
+	for (std::vector<Range>::const_iterator it = ranges.begin(); it != ranges.end(); ++it)
+	{
+		if (!merged.empty() && it->start <= merged.back().end)
+			merged.back().end = std::max(merged.back().end, it->end);
+		else
+			merged.push_back(*it);
+	}
+
+	return merged;
+}
+
+// A piece of an input segment in the output core
+struct Piece
+{
+	uint64_t inOffset;
+	uint64_t outOffset;
+	uint64_t vaddr;
+	uint64_t size;
+	bool keep;
+};
+
+static bool PieceByInput(const Piece& a, const Piece& b)
+{
+	return a.inOffset < b.inOffset;
+}
+
+static void SplitSegment(uint64_t offset, uint64_t vaddr, uint64_t filesz, uint64_t memsz, uint32_t flags,
+	const std::vector<Range>& ranges, std::vector<Piece>& pieces)
+{
+	Piece piece;
+
+	piece.outOffset = 0;
+
+	// Small segments are the ELF headers of mapped files, gdb needs them
+	// to find the modules, so are kept even when they aren't writable
+	if (filesz > 0 && filesz <= PAGE_SIZE_CORE)
+	{
+		piece.inOffset = offset;
+		piece.vaddr = vaddr;
+		piece.size = memsz;
+		piece.keep = true;
+		pieces.push_back(piece);
+		return;
+	}
+
+	uint64_t pos = 0;
+
+	if (filesz > 0 && (flags & PF_W))
+	{
+		for (std::vector<Range>::const_iterator it = ranges.begin(); it != ranges.end(); ++it)
+		{
+			if (it->end <= vaddr + pos || it->start >= vaddr + filesz)
+				continue;
+
+			uint64_t start = std::max(it->start, vaddr + pos) - vaddr;
+			uint64_t end = std::min(it->end, vaddr + filesz) - vaddr;
+
+			if (start > pos)
+			{
+				piece.inOffset = offset + pos;
+				piece.vaddr = vaddr + pos;
+				piece.size = start - pos;
+				piece.keep = false;
+				pieces.push_back(piece);
+			}
+
+			piece.inOffset = offset + start;
+			piece.vaddr = vaddr + start;
+			piece.size = end - start;
+			piece.keep = true;
+			pieces.push_back(piece);
+
+			pos = end;
+		}
+	}
+
+	if (pos < memsz)
+	{
+		piece.inOffset = offset + pos;
+		piece.vaddr = vaddr + pos;
+		piece.size = memsz - pos;
+		piece.keep = false;
+		pieces.push_back(piece);
+	}
+}
+
+static uint64_t AlignUp(uint64_t value, uint64_t align)
+{
+	return (value + align - 1) & ~(align - 1);
+}
+
+template<class Ehdr, class Phdr>
+static bool StreamCore(Input& in, std::vector<unsigned char>& head, int out, const Options& opt, CoreSummary& core)
+{
+	Ehdr ehdr;
+	memcpy(&ehdr, &head[0], sizeof(ehdr));
+
+	bool raw = opt.keepAll ||
+		ehdr.e_type != ET_CORE ||
+		ehdr.e_phnum == PN_XNUM ||
+		ehdr.e_phentsize != sizeof(Phdr) ||
+		(ehdr.e_phoff < sizeof(Ehdr)) ||
+		ehdr.e_phoff + (uint64_t)ehdr.e_phnum * sizeof(Phdr) > MAX_HEADERS;
+
+	std::vector<Phdr> phdrs;
+	uint64_t noteEnd = 0;
+
+	if (!raw && in.Read(head, (size_t)(ehdr.e_phoff + ehdr.e_phnum * sizeof(Phdr) - head.size())))
+	{
+		phdrs.resize(ehdr.e_phnum);
+		memcpy(&phdrs[0], &head[ehdr.e_phoff], ehdr.e_phnum * sizeof(Phdr));
+
+		for (size_t i = 0; i < phdrs.size(); ++i)
+		{
+			if (phdrs[i].p_type == PT_NOTE)
+				noteEnd = std::max<uint64_t>(noteEnd, phdrs[i].p_offset + phdrs[i].p_filesz);
+		}
+
+		// The notes have to arrive before the memory they decide about
+		for (size_t i = 0; i < phdrs.size(); ++i)
+		{
+			if (phdrs[i].p_type == PT_LOAD && phdrs[i].p_filesz > 0 && phdrs[i].p_offset < noteEnd)
+				raw = true;
+		}
+
+		if (noteEnd == 0 || noteEnd > MAX_HEADERS)
+			raw = true;
+
+		if (!raw && noteEnd > head.size() && !in.Read(head, (size_t)(noteEnd - head.size())))
+			raw = true;
+	}
+	else
+	{
+		raw = true;
+	}
+
+	if (!raw)
+	{
+		for (size_t i = 0; i < phdrs.size(); ++i)
+		{
+			if (phdrs[i].p_type == PT_NOTE)
+				ParseNotes(&head[phdrs[i].p_offset], phdrs[i].p_filesz, core);
+		}
+	}
+
+	if (raw)
+	{
+		// Unknown layout, keep everything where it is
+		Input::WriteSparse(out, 0, &head[0], head.size());
+		core.outputSize = head.size() + in.Copy(out, head.size(), -1);
+		core.inputSize = core.outputSize;
+		core.filtered = false;
+
+		for (size_t i = 0; i < phdrs.size(); ++i)
+		{
+			if (phdrs[i].p_type == PT_NOTE && phdrs[i].p_offset + phdrs[i].p_filesz <= core.outputSize && phdrs[i].p_filesz <= MAX_HEADERS)
+			{
+				std::vector<unsigned char> notes((size_t)phdrs[i].p_filesz);
+
+				if (pread(out, &notes[0], notes.size(), (off_t)phdrs[i].p_offset) == (ssize_t)notes.size())
+					ParseNotes(&notes[0], notes.size(), core);
+			}
+
+			if (phdrs[i].p_type == PT_LOAD)
+			{
+				Load load = { phdrs[i].p_vaddr, phdrs[i].p_memsz, phdrs[i].p_offset, phdrs[i].p_filesz, phdrs[i].p_flags };
+				core.loads.push_back(load);
+			}
+		}
+
+		return ftruncate(out, (off_t)core.outputSize) == 0;
+	}
+
+	// Lay out the output: headers, notes, then the kept memory page aligned
+	std::vector<Range> ranges = KeepRanges(core, opt.window);
+	std::vector<Phdr> outPhdrs;
+	std::vector<Piece> copies;
+	std::vector<std::vector<Piece> > split(phdrs.size());
+	size_t count = 0;
+
+	for (size_t i = 0; i < phdrs.size(); ++i)
+	{
+		const Phdr& p = phdrs[i];
+
+		if (p.p_type == PT_LOAD)
+			SplitSegment(p.p_offset, p.p_vaddr, p.p_filesz, p.p_memsz, p.p_flags, ranges, split[i]);
+
+		count += p.p_type == PT_LOAD ? split[i].size() : 1;
+	}
+
+	if (count >= PN_XNUM)
+		return false;
+
+	uint64_t offset = sizeof(Ehdr) + count * sizeof(Phdr);
+
+	for (size_t i = 0; i < phdrs.size(); ++i)
+	{
+		Phdr p = phdrs[i];
+
+		if (p.p_type == PT_NOTE)
+		{
+			offset = AlignUp(offset, 4);
+
+			if (!Input::WriteAt(out, offset, &head[p.p_offset], p.p_filesz))
+				return false;
+
+			p.p_offset = offset;
+			offset += p.p_filesz;
+		}
+		else if (p.p_type != PT_LOAD)
+		{
+			p.p_offset = 0;
+			p.p_filesz = 0;
+		}
+
+		if (p.p_type != PT_LOAD)
+			outPhdrs.push_back(p);
+	}
+
+	for (size_t i = 0; i < phdrs.size(); ++i)
+	{
+		const Phdr& src = phdrs[i];
+
+		for (std::vector<Piece>::const_iterator it = split[i].begin(); it != split[i].end(); ++it)
+		{
+			Phdr p = src;
+			uint64_t rel = it->vaddr - src.p_vaddr;
+
+			offset = AlignUp(offset, PAGE_SIZE_CORE);
+
+			p.p_vaddr = it->vaddr;
+			p.p_paddr = 0;
+			p.p_memsz = it->size;
+			p.p_offset = offset;
+			p.p_filesz = 0;
+
+			if (it->keep)
+			{
+				p.p_filesz = std::min<uint64_t>(it->size, src.p_filesz > rel ? src.p_filesz - rel : 0);
+
+				Piece copy = *it;
+				copy.size = p.p_filesz;
+				copy.outOffset = offset;
+				copies.push_back(copy);
+
+				offset += p.p_filesz;
+			}
+
+			Load load = { p.p_vaddr, p.p_memsz, p.p_offset, p.p_filesz, p.p_flags };
+			core.loads.push_back(load);
+
+			outPhdrs.push_back(p);
+		}
+	}
+
+	ehdr.e_phoff = sizeof(Ehdr);
+	ehdr.e_phnum = (uint16_t)outPhdrs.size();
+	ehdr.e_shoff = 0;
+	ehdr.e_shnum = 0;
+	ehdr.e_shstrndx = SHN_UNDEF;
+
+	if (!Input::WriteAt(out, 0, &ehdr, sizeof(ehdr)) ||
+		!Input::WriteAt(out, sizeof(ehdr), &outPhdrs[0], outPhdrs.size() * sizeof(Phdr)))
+		return false;
+
+	// The kernel writes segments in file order, so this is one pass over the pipe
+	std::sort(copies.begin(), copies.end(), PieceByInput);
+
+	for (std::vector<Piece>::const_iterator it = copies.begin(); it != copies.end(); ++it)
+	{
+		if (it->inOffset < in.Position())
+			continue;
+
+		if (!in.Skip(it->inOffset - in.Position()))
+			break;
+
+		if (in.Copy(out, it->outOffset, (int64_t)it->size) != it->size)
+			break;
+	}
+
+	// Nothing after the last kept segment is needed, the rest of the pipe
+	// isn't read so the kernel stops writing it
+
+	core.inputSize = 0;
+	for (size_t i = 0; i < phdrs.size(); ++i)
+		core.inputSize = std::max<uint64_t>(core.inputSize, phdrs[i].p_offset + phdrs[i].p_filesz);
+
+	core.outputSize = offset;
+	core.filtered = true;
+
+	return ftruncate(out, (off_t)offset) == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Triage
+
+// The crashing thread of the written core.  Memory the core doesn't have
+// is read from the mapped file when the mapping isn't writable, which
+// covers the code and unwind tables of every module.
+class CoreCrash : public CrashInfo
+{
+public:
+	CoreCrash(int fd, const CoreSummary& core)
+		: m_core(core)
+		, m_data(NULL)
+		, m_size(core.outputSize)
+	{
+		if (m_size > 0)
+		{
+			void* data = mmap(NULL, (size_t)m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (data != MAP_FAILED)
+				m_data = (const unsigned char*)data;
+		}
+	}
+
+	~CoreCrash()
+	{
+		if (m_data)
+			munmap((void*)m_data, (size_t)m_size);
+
+		for (std::map<std::string, int>::iterator it = m_files.begin(); it != m_files.end(); ++it)
+		{
+			if (it->second != -1)
+				close(it->second);
+		}
+	}
+
+	void Load(const Thread& thread, const std::string& procMaps)
+	{
+		signo = m_core.signo;
+		code = m_core.code;
+		address = m_core.address;
+		is64 = m_core.is64;
+
+		memcpy(regs, thread.regs, sizeof(regs));
+
+		// /proc/<pid>/maps names the stack and heap, the core only has files
+		if (!procMaps.empty() && LoadMaps(procMaps))
+			return;
+
+		maps.clear();
+
+		for (std::vector< ::Load>::const_iterator it = m_core.loads.begin(); it != m_core.loads.end(); ++it)
+		{
+			MapEntry map;
+
+			map.start = it->vaddr;
+			map.end = it->vaddr + it->memsz;
+			map.offset = 0;
+			map.perms = Format("%c%c%cp", it->flags & PF_R ? 'r' : '-', it->flags & PF_W ? 'w' : '-', it->flags & PF_X ? 'x' : '-');
+
+			for (std::vector<FileMapping>::const_iterator f = m_core.files.begin(); f != m_core.files.end(); ++f)
+			{
+				if (map.start >= f->start && map.start < f->end)
+				{
+					map.offset = f->offset + map.start - f->start;
+					map.name = f->name;
+					break;
+				}
+			}
+
+			// Split pieces of one mapping are merged back
+			if (!maps.empty() && maps.back().end == map.start && maps.back().name == map.name && maps.back().perms == map.perms &&
+				(map.name.empty() || maps.back().offset + (maps.back().end - maps.back().start) == map.offset))
+				maps.back().end = map.end;
+			else
+				maps.push_back(map);
+		}
+
+		// Without /proc the stacks are only known by the threads' sp
+		for (std::vector<MapEntry>::iterator it = maps.begin(); it != maps.end(); ++it)
+		{
+			for (std::vector<Thread>::const_iterator t = m_core.threads.begin(); t != m_core.threads.end(); ++t)
+			{
+				if (it->name.empty() && t->regs[TRIAGE_SP] >= it->start && t->regs[TRIAGE_SP] < it->end)
+					it->name = "[stack]";
+			}
+		}
+	}
+
+	virtual bool ReadMemory(uint64_t addr, void* buf, size_t len)
+	{
+		unsigned char* p = (unsigned char*)buf;
+
+		while (len > 0)
+		{
+			size_t got = ReadCore(addr, p, len);
+
+			if (got == 0)
+				got = ReadMapped(addr, p, len);
+
+			if (got == 0)
+				return false;
+
+			addr += got;
+			p += got;
+			len -= got;
+		}
+
+		return true;
+	}
+
+private:
+	const CoreSummary& m_core;
+	const unsigned char* m_data;
+	uint64_t m_size;
+	std::map<std::string, int> m_files;
+
+	size_t ReadCore(uint64_t addr, unsigned char* buf, size_t len)
+	{
+		if (!m_data)
+			return 0;
+
+		for (std::vector< ::Load>::const_iterator it = m_core.loads.begin(); it != m_core.loads.end(); ++it)
+		{
+			if (addr < it->vaddr || addr >= it->vaddr + it->filesz)
+				continue;
+
+			uint64_t rel = addr - it->vaddr;
+			size_t n = (size_t)std::min<uint64_t>(len, it->filesz - rel);
+
+			if (it->offset + rel + n > m_size)
+				return 0;
+
+			memcpy(buf, m_data + it->offset + rel, n);
+			return n;
+		}
+
+		return 0;
+	}
+
+	size_t ReadMapped(uint64_t addr, unsigned char* buf, size_t len)
+	{
+		const MapEntry* map = FindMap(addr);
+
+		// Writable mappings have changed since they were loaded from the file
+		if (!map || map->name.empty() || map->name[0] != '/' || map->perms.find('w') != std::string::npos)
+			return 0;
+
+		std::map<std::string, int>::iterator it = m_files.find(map->name);
+		if (it == m_files.end())
+			it = m_files.insert(std::make_pair(map->name, open(map->name.c_str(), O_RDONLY))).first;
+
+		if (it->second == -1)
+			return 0;
+
+		size_t n = (size_t)std::min<uint64_t>(len, map->end - addr);
+		ssize_t ret = pread(it->second, buf, n, (off_t)(map->offset + addr - map->start));
+
+		return ret > 0 ? ret : 0;
+	}
+};
+
+static std::string Summarize(int fd, const CoreSummary& core, const std::string& procMaps)
+{
+	if (core.threads.empty())
+		return "No threads found in the core.\n";
+
+	std::string ret;
+
+	{
+		CoreCrash crash(fd, core);
+		crash.Load(core.threads[0], procMaps);
+
+		Triage triage(crash);
+		ret += triage.Report();
+	}
+
+	for (size_t i = 0; i < core.threads.size(); ++i)
+	{
+		CoreCrash crash(fd, core);
+		crash.Load(core.threads[i], procMaps);
+
+		Triage triage(crash);
+		ret += Format("\nThread %d%s:\n", core.threads[i].pid, i == 0 ? " (crashed)" : "");
+		ret += triage.StackTrace();
+	}
+
+	return ret;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Main
+
+static void Usage()
+{
+	fprintf(stderr,
+		"\n"
+		"[[ Peach 3 Linux Core Handler\n"
+		"\n"
+		"This program is registered with the Linux kernel by the LinuxCrashMonitor\n"
+		"and called to collect the core file generated when a process crashes.\n"
+		"\n"
+		"Syntax: PeachCoreHandler -e=exe -p=pid [-l=logfolder] [-a] [-w=kb]\n"
+		"\n");
+	exit(1);
+}
+
+static bool ParseArgs(int argc, char** argv, Options& opt)
+{
+	opt.logFolder = "/var/peachcrash";
+	opt.keepAll = false;
+	opt.window = 64 * 1024;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		const char* arg = argv[i];
+
+		if (strcmp(arg, "-a") == 0)
+		{
+			opt.keepAll = true;
+			continue;
+		}
+
+		// Same -x=value form PeachLinuxCrashHandler.exe takes
+		if (arg[0] != '-' || arg[1] == '\0' || arg[2] != '=')
+			return false;
+
+		std::string value(arg + 3);
+
+		switch (arg[1])
+		{
+		case 'p': opt.pid = value; break;
+		case 'P': opt.globalPid = value; break;
+		case 'u': opt.uid = value; break;
+		case 'g': opt.gid = value; break;
+		case 's': opt.sig = value; break;
+		case 't': opt.time = value; break;
+		case 'h': opt.host = value; break;
+		case 'e': opt.exe = value; break;
+		case 'l': opt.logFolder = value; break;
+		case 'w': opt.window = strtoull(value.c_str(), NULL, 0) * 1024; break;
+		default:
+			return false;
+		}
+	}
+
+	return !opt.exe.empty();
+}
+
+static std::string TimeString(const std::string& seconds)
+{
+	time_t t = seconds.empty() ? time(NULL) : (time_t)strtoll(seconds.c_str(), NULL, 10);
+	char buf[64];
+	struct tm tm;
+
+	if (!localtime_r(&t, &tm) || !strftime(buf, sizeof(buf), "%c", &tm))
+		return seconds;
+
+	return buf;
+}
+
+int main(int argc, char** argv)
+{
+	Options opt;
+
+	if (!ParseArgs(argc, argv, opt))
+		Usage();
+
+	mkdir(opt.logFolder.c_str(), 0777);
+	chmod(opt.logFolder.c_str(), 0777);
+
+	// Files are moved into the log folder once complete, the monitor
+	// collects whatever it finds there
+	std::string partial = opt.logFolder + "/.partial";
+	mkdir(partial.c_str(), 0700);
+
+	std::string name = "peach_" + opt.exe.substr(opt.exe.rfind('/') + 1) + "_" + opt.pid;
+	std::string corePath = partial + "/" + name + ".core";
+	std::string infoPath = partial + "/" + name + ".info";
+
+	// The process stays around until the core has been read, its
+	// pid is only valid in the root namespace when %P is given
+	std::string pid = opt.globalPid.empty() ? opt.pid : opt.globalPid;
+	std::string procMaps = pid.empty() ? "" : ReadFile("/proc/" + pid + "/maps");
+
+	int out = open(corePath.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0666);
+	if (out == -1)
+		return 1;
+
+	Input in(0);
+	std::vector<unsigned char> head;
+	CoreSummary core;
+	bool ok = false;
+
+	core.is64 = false;
+	core.signo = 0;
+	core.code = 0;
+	core.address = 0;
+	core.inputSize = 0;
+	core.outputSize = 0;
+	core.filtered = false;
+
+	if (in.Read(head, EI_NIDENT) && memcmp(&head[0], ELFMAG, SELFMAG) == 0)
+	{
+		if (head[EI_CLASS] == ELFCLASS64 && in.Read(head, sizeof(Elf64_Ehdr) - EI_NIDENT))
+		{
+			core.is64 = true;
+			ok = StreamCore<Elf64_Ehdr, Elf64_Phdr>(in, head, out, opt, core);
+		}
+		else if (head[EI_CLASS] == ELFCLASS32 && in.Read(head, sizeof(Elf32_Ehdr) - EI_NIDENT))
+		{
+			ok = StreamCore<Elf32_Ehdr, Elf32_Phdr>(in, head, out, opt, core);
+		}
+	}
+
+	if (!ok)
+	{
+		// Still keep whatever arrived for a look with gdb
+		Input::WriteSparse(out, 0, &head[0], head.size());
+		core.outputSize = head.size() + in.Copy(out, head.size(), -1);
+		core.inputSize = core.outputSize;
+		ftruncate(out, (off_t)core.outputSize);
+	}
+
+	std::string info;
+
+	info += "\n";
+	info += "Linux Crash Handler -- Crash information\n";
+	info += "========================================\n";
+	info += "\n";
+	info += "PID: " + opt.pid + "\n";
+	info += "EXE: " + opt.exe + "\n";
+	info += "UID: " + opt.uid + "\n";
+	info += "GID: " + opt.gid + "\n";
+	info += "SIG: " + opt.sig + "\n";
+	info += "Host: " + opt.host + "\n";
+	info += "Time/date: " + TimeString(opt.time) + "\n";
+	info += Format("Core: %llu of %llu bytes kept%s\n", (unsigned long long)core.outputSize,
+		(unsigned long long)core.inputSize, core.filtered ? "" : " (unfiltered)");
+	info += "\n";
+	info += "Triage\n";
+	info += "------\n";
+	info += "\n";
+	info += ok ? Summarize(out, core, procMaps) : "The core could not be parsed.\n";
+
+	close(out);
+
+	int fd = open(infoPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0666);
+	if (fd != -1)
+	{
+		Input::WriteAt(fd, 0, info.data(), info.size());
+		close(fd);
+	}
+
+	chmod(corePath.c_str(), 0666);
+	chmod(infoPath.c_str(), 0666);
+
+	rename(corePath.c_str(), (opt.logFolder + "/" + name + ".core").c_str());
+	rename(infoPath.c_str(), (opt.logFolder + "/" + name + ".info").c_str());
+
+	return 0;
+}
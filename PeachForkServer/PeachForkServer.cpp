@@ -0,0 +1,210 @@
+// Linux fork server
+//
+// Preloaded into the target by the LinuxForkServer monitor:
+//
+//   PEACH_FORKSRV=/tmp/peach_forksrv_xxx LD_PRELOAD=libPeachForkServer.so target args
+//
+// The target is loaded, relocated and initialized once and then stops at
+// main().  Every request on the control fifo forks a child which runs the
+// real main() and the server reports back how the child exited, so each
+// iteration costs a fork() instead of starting the executable again.
+//
+// Protocol, all integers are little endian:
+//   server -> peach   uint32 pid of the server, once main() is reached
+//   peach -> server   uint32 0, run a child
+//   server -> peach   uint32 pid of the child, right after the fork
+//   server -> peach   ForkStatus, once the child has been reaped
+// Closing the control fifo tells the server to exit.  Peach stops a hung
+// child by killing its pid, the server then reports it like any other exit.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <dlfcn.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <string>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#define FORKSRV_ENV "PEACH_FORKSRV"
+
+typedef struct
+{
+	uint32_t exitCode; // Exit code of the child, when it wasn't signaled
+	uint32_t signal;   // Signal which terminated the child, 0 on a normal exit
+	uint64_t address;  // Faulting address of SIGSEGV, SIGBUS, SIGILL and SIGFPE
+} ForkStatus;
+
+typedef int (*MainFunc)(int, char**, char**);
+typedef int (*StartMainFunc)(MainFunc, int, char**, void (*)(void), void (*)(void), void (*)(void), void*);
+
+static MainFunc realMain = NULL;
+
+static int ctlFd = -1;
+static int stFd = -1;
+
+// Shared with the children, written by the fault handler before the child dies
+static volatile uint64_t* faultAddress = NULL;
+
+static const int faultSignals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE };
+
+static bool ReadAll(int fd, void* buf, size_t len)
+{
+	char* p = (char*)buf;
+
+	while (len > 0)
+	{
+		ssize_t ret = read(fd, p, len);
+		if (ret == -1 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+
+		p += ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
+static bool WriteAll(int fd, const void* buf, size_t len)
+{
+	const char* p = (const char*)buf;
+
+	while (len > 0)
+	{
+		ssize_t ret = write(fd, p, len);
+		if (ret == -1 && errno == EINTR)
+			continue;
+		if (ret <= 0)
+			return false;
+
+		p += ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
+static void FaultHandler(int sig, siginfo_t* info, void* context)
+{
+	*faultAddress = (uint64_t)(uintptr_t)info->si_addr;
+
+	// The handler was reset, returning re-runs the faulting instruction
+	// which kills the child.  Signals sent with kill() have to be raised again.
+	if (info->si_code <= 0)
+		raise(sig);
+}
+
+static void InstallFaultHandlers()
+{
+	struct sigaction sa;
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_sigaction = FaultHandler;
+	sa.sa_flags = SA_SIGINFO | SA_RESETHAND | SA_NODEFER;
+	sigemptyset(&sa.sa_mask);
+
+	for (size_t i = 0; i < sizeof(faultSignals) / sizeof(faultSignals[0]); ++i)
+		sigaction(faultSignals[i], &sa, NULL);
+}
+
+static bool ServerOpen(const std::string& base)
+{
+	// Peach holds both ends open, so neither of these block
+	ctlFd = open((base + ".ctl").c_str(), O_RDONLY | O_CLOEXEC);
+	stFd = open((base + ".st").c_str(), O_WRONLY | O_CLOEXEC);
+
+	void* page = mmap(NULL, sizeof(uint64_t), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (page != MAP_FAILED)
+		faultAddress = (volatile uint64_t*)page;
+
+	return ctlFd != -1 && stFd != -1 && faultAddress != NULL;
+}
+
+// Returns in the child, the server itself never returns
+static void ServerLoop()
+{
+	uint32_t value = getpid();
+
+	if (!WriteAll(stFd, &value, sizeof(value)))
+		_exit(1);
+
+	while (ReadAll(ctlFd, &value, sizeof(value)))
+	{
+		*faultAddress = 0;
+
+		pid_t pid = fork();
+		if (pid == -1)
+			break;
+
+		if (pid == 0)
+		{
+			close(ctlFd);
+			close(stFd);
+
+			InstallFaultHandlers();
+			return;
+		}
+
+		value = pid;
+		if (!WriteAll(stFd, &value, sizeof(value)))
+			break;
+
+		int status = 0;
+		while (waitpid(pid, &status, 0) == -1)
+		{
+			if (errno != EINTR)
+				_exit(1);
+		}
+
+		ForkStatus st;
+		st.exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 0;
+		st.signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+		st.address = *faultAddress;
+
+		if (!WriteAll(stFd, &st, sizeof(st)))
+			break;
+	}
+
+	// Don't run the target's atexit handlers, main() never ran in here
+	_exit(0);
+}
+
+static int ForkServerMain(int argc, char** argv, char** envp)
+{
+	const char* base = getenv(FORKSRV_ENV);
+
+	if (base != NULL)
+	{
+		std::string path(base);
+
+		// Anything the target runs should start normally
+		unsetenv(FORKSRV_ENV);
+		unsetenv("LD_PRELOAD");
+
+		if (!ServerOpen(path))
+			_exit(1);
+
+		ServerLoop();
+	}
+
+	return realMain(argc, argv, environ);
+}
+
+// glibc calls main() from here, stop at main() by swapping it for ours
+extern "C" int __libc_start_main(MainFunc main, int argc, char** argv, void (*init)(void), void (*fini)(void), void (*rtldFini)(void), void* stackEnd)
+{
+	StartMainFunc next = (StartMainFunc)dlsym(RTLD_NEXT, "__libc_start_main");
+
+	realMain = main;
+
+	return next(ForkServerMain, argc, argv, init, fini, rtldFini, stackEnd);
+}
@@ -98,18 +98,32 @@ namespace PeachMinset
 			string samples = null;
 			string traces = null;
 			bool kill = false;
+			bool forkServer = false;
+			uint idleMs = 0;
+			string baseline = null;
+			int jobs = 1;
+			var weight = MinsetWeight.None;
+			bool stream = false;
 			string executable = null;
 			string arguments = null;
 			string minset = null;
+			string database = null;
 
 			var p = new OptionSet()
 				{
 					{ "h|?|help", v => Syntax() },
 					{ "k", v => kill = true },
+					{ "f|forkserver", v => forkServer = true },
+					{ "idle=", v => idleMs = ParseIdle(v) },
+					{ "b|baseline=", v => baseline = v },
+					{ "j|jobs=", v => jobs = ParseJobs(v) },
+					{ "w|weight=", v => weight = ParseWeight(v) },
+					{ "stream", v => stream = true },
 					{ "v", v => verbose = 1 },
 					{ "s|samples=", v => samples = v },
 					{ "t|traces=", v => traces = v},
-					{ "m|minset=", v => minset = v }
+					{ "m|minset=", v => minset = v },
+					{ "d|database=", v => database = v }
 				};
 
 			var extra = p.Parse(args);
@@ -129,9 +143,15 @@ namespace PeachMinset
 			if (minset == null && executable == null)
 				throw new SyntaxException("Error, 'minset' or command argument is required.");
 
+			if (database != null && minset == null)
+				throw new SyntaxException("Error, 'database' argument requires the 'minset' argument.");
+
 			if (executable != null && arguments.IndexOf("%s") == -1)
 				throw new SyntaxException("Error, command argument missing '%s'.");
 
+			if (baseline != null && executable == null)
+				throw new SyntaxException("Error, 'baseline' argument requires the command argument.");
+
 			Peach.Core.Runtime.Program.ConfigureLogging(verbose);
 
 			var sampleFiles = GetFiles(samples, "sample");
@@ -144,11 +164,25 @@ namespace PeachMinset
 			if (minset != null)
 				VerifyDirectory(minset);
 
+			if (baseline != null && !File.Exists(baseline))
+				throw new PeachException("Error, baseline trace '{0}' does not exist.".Fmt(baseline));
+
 			var ms = new Minset();
+			ms.ForkServer = forkServer;
+			ms.IdleMs = idleMs;
+			ms.Baseline = baseline;
+			ms.Parallelism = jobs;
+			ms.Weight = weight;
 
 			sw.Start();
 
-			if (verbose == 0)
+			if (verbose == 0 && jobs > 1)
+			{
+				// Traces finish out of order, so print a whole line for each
+				ms.TraceCompleted += new TraceEventHandler(ms_ParallelTraceCompleted);
+				ms.TraceFailed += new TraceEventHandler(ms_ParallelTraceFailed);
+			}
+			else if (verbose == 0)
 			{
 				ms.TraceCompleted += new TraceEventHandler(ms_TraceCompleted);
 				ms.TraceStarting += new TraceEventHandler(ms_TraceStarting);
@@ -175,13 +209,35 @@ namespace PeachMinset
 
 				ValidateTraces(ref sampleFiles, ref traceFiles);
 
-				var minsetFiles = ms.RunCoverage(sampleFiles, traceFiles);
+				// Spill coverage next to the traces, temp is often in memory
+				if (stream)
+					ms.SpillFolder = traces.IndexOf("*") > -1 ? Path.GetDirectoryName(traces) : traces;
+
+				string[] minsetFiles;
+				string[] removed = null;
+				MinsetDatabase db = null;
+
+				if (database != null)
+				{
+					db = LoadDatabase(database);
+
+					minsetFiles = ms.UpdateCoverage(db, sampleFiles, traceFiles, out removed);
 
-				Console.WriteLine("[-]   {0} files were selected from a total of {1}.", minsetFiles.Length, sampleFiles.Length);
+					Console.WriteLine("[-]   {0} files were added and {1} removed, the minset now has {2} files.",
+						minsetFiles.Length, removed.Length, db.Entries.Count);
+				}
+				else
+				{
+					minsetFiles = ms.RunCoverage(sampleFiles, traceFiles);
+
+					Console.WriteLine("[-]   {0} files were selected from a total of {1}.", minsetFiles.Length, sampleFiles.Length);
+				}
 
 				if (minsetFiles.Length > 0)
 					Console.WriteLine("[*] Copying over selected files...");
 
+				int failed = 0;
+
 				foreach (var src in minsetFiles)
 				{
 					var file = Path.GetFileName(src);
@@ -197,13 +253,71 @@ namespace PeachMinset
 					catch (Exception ex)
 					{
 						Console.WriteLine(" failed: {0}", ex.Message);
+						++failed;
 					}
 				}
 
+				// Only touch the kept samples and save once every new one is in
+				// place, so the minset folder always matches a saved database
+				if (db != null)
+				{
+					if (failed > 0)
+						throw new PeachException("Error, {0} files could not be copied to the minset folder, the minset database '{1}' was not updated.".Fmt(failed, database));
+
+					var copied = new HashSet<string>(minsetFiles.Select(f => Path.GetFileName(f)));
+
+					foreach (var file in removed)
+					{
+						// Was just replaced by a new sample with the same name
+						if (copied.Contains(file))
+							continue;
+
+						var dst = Path.Combine(minset, file);
+
+						Console.Write("[-]   Removing {0}", dst);
+
+						try
+						{
+							File.Delete(dst);
+							Console.WriteLine();
+						}
+						catch (Exception ex)
+						{
+							Console.WriteLine(" failed: {0}", ex.Message);
+						}
+					}
+
+					try
+					{
+						db.Save(database);
+					}
+					catch (Exception ex)
+					{
+						throw new PeachException("Error, unable to save minset database '{0}'. {1}".Fmt(database, ex.Message), ex);
+					}
+
+					Console.WriteLine("[*] Saved minset database {0}", database);
+				}
+
 				Console.WriteLine("\n[{0}] Finished\n", sw.Elapsed);
 			}
 		}
 
+		static MinsetDatabase LoadDatabase(string fileName)
+		{
+			if (!File.Exists(fileName))
+				return new MinsetDatabase();
+
+			try
+			{
+				return new MinsetDatabase(fileName);
+			}
+			catch (IOException ex)
+			{
+				throw new PeachException("Error, unable to load minset database '{0}'. {1}".Fmt(fileName, ex.Message), ex);
+			}
+		}
+
 		bool ValidateTraces(ref string[] samples, ref string[] traces)
 		{
 			// Arrays are already sorted before this function
@@ -264,6 +378,51 @@ namespace PeachMinset
 			Console.WriteLine(" Failed");
 		}
 
+		void ms_ParallelTraceCompleted(Minset sender, string fileName, int count, int totalCount)
+		{
+			ms_TraceStarting(sender, fileName, count, totalCount);
+			ms_TraceCompleted(sender, fileName, count, totalCount);
+		}
+
+		void ms_ParallelTraceFailed(Minset sender, string fileName, int count, int totalCount)
+		{
+			ms_TraceStarting(sender, fileName, count, totalCount);
+			ms_TraceFailed(sender, fileName, count, totalCount);
+		}
+
+		static MinsetWeight ParseWeight(string value)
+		{
+			switch (value)
+			{
+				case "count":
+					return MinsetWeight.None;
+				case "size":
+					return MinsetWeight.FileSize;
+				default:
+					throw new SyntaxException("Error, 'weight' argument must be 'count' or 'size'.");
+			}
+		}
+
+		static int ParseJobs(string value)
+		{
+			int ret;
+
+			if (!int.TryParse(value, out ret) || ret < 1)
+				throw new SyntaxException("Error, 'jobs' argument must be a positive number.");
+
+			return ret;
+		}
+
+		static uint ParseIdle(string value)
+		{
+			uint ret;
+
+			if (!uint.TryParse(value, out ret) || ret < 1)
+				throw new SyntaxException("Error, 'idle' argument must be a positive number.");
+
+			return ret;
+		}
+
 		static string[] GetFiles(string path, string what)
 		{
 			string[] fileNames;
@@ -336,12 +495,18 @@ Perform code coverage using all files in the 'samples' folder.  Collect
 the .trace files in the 'traces' folder for later analysis.
 
 Syntax:
-  PeachMinset [-k -v] -s samples -t traces command.exe args %s
+  PeachMinset [-k -v -f -j N --idle ms -b baseline] -s samples -t traces command.exe args %s
 
 Note:
   %s will be replaced by sample filename.
   -k will terminate command.exe when CPU becomes idle.
+  --idle checks for an idle CPU every ms milliseconds with -k (default 200).
   -v will enable debug log messages.
+  -f will start command.exe once and fork it at main() for each
+     sample instead of restarting pin (Linux and OS X only).
+  -j will collect N traces at the same time, usually one per core.
+  -b leaves the blocks in the baseline trace file out of every trace,
+     such as the blocks hit by an empty sample.
 
 
 Compute Minimum Set
@@ -352,7 +517,13 @@ set of samples to use during fuzzing. The minimum set of samples will
 be copied from the 'samples' folder to the 'minset' folder.
 
 Syntax:
-  PeachMinset -s samples -t traces -m minset
+  PeachMinset [-w count|size --stream] -s samples -t traces -m minset
+
+Note:
+  -w count keeps the fewest samples (default).
+  -w size keeps the smallest total size of samples.
+  --stream keeps the coverage of each sample on disk in the traces
+     folder instead of in memory, for very large sample sets.
 
 
 All-In-One
@@ -361,12 +532,34 @@ All-In-One
 Both tracing and computing can be performed in a single step.
 
 Syntax:
-  PeachMinset [-k -v] -s samples -t traces -m minset command.exe args %s
+  PeachMinset [-k -v -f -j N --idle ms -b baseline -w count|size] -s samples -t traces -m minset command.exe args %s
 
 Note:
   %s will be replaced by sample filename.
   -k will terminate command.exe when CPU becomes idle.
+  --idle checks for an idle CPU every ms milliseconds with -k (default 200).
   -v will enable debug log messages.
+  -f will start command.exe once and fork it at main() for each
+     sample instead of restarting pin (Linux and OS X only).
+  -j will collect N traces at the same time, usually one per core.
+  -b leaves the blocks in the baseline trace file out of every trace.
+  -w picks the fewest samples (count) or smallest total size (size).
+
+
+Incremental Minset
+------------------
+
+A minset database remembers the coverage of every sample in the minimum
+set.  New samples only need to be traced once, they are folded into the
+existing minimum set without tracing it again.  Samples made redundant
+by the new ones are removed from the 'minset' folder.
+
+Syntax:
+  PeachMinset -s new_samples -t new_traces -m minset -d minset.db
+
+Note:
+  The database is created if it doesn't exist.  Only give it new
+  samples and traces, the 'minset' folder is maintained by Peach.
 
 
 Distributing Minset
@@ -0,0 +1,324 @@
+// Native crash triage
+//
+// Runs a target under ptrace and classifies the first crash with the rules
+// of gdb/exploitable, without starting gdb:
+//
+//   PeachTriage [-p pidfile] [-o logfile] [--] executable [args...]
+//
+// The pid of the target is written to pidfile once it has been exec'd.  On
+// a crash the report (see Triage.h) is written to logfile, or stdout, the
+// target is killed and PeachTriage exits with 128 + signal.  Otherwise the
+// exit code of the target is returned.
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ptrace.h>
+#include <sys/types.h>
+#include <sys/user.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <set>
+#include <string>
+
+#include "Triage.h"
+
+// Signals which are triaged, everything else is passed to the target
+static const int crashSignals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT, SIGSYS };
+
+static bool IsCrashSignal(int sig)
+{
+	for (size_t i = 0; i < sizeof(crashSignals) / sizeof(crashSignals[0]); ++i)
+	{
+		if (crashSignals[i] == sig)
+			return true;
+	}
+
+	return false;
+}
+
+static std::string ReadFile(const std::string& path)
+{
+	std::string ret;
+	char buf[4096];
+
+	int fd = open(path.c_str(), O_RDONLY);
+	if (fd == -1)
+		return ret;
+
+	ssize_t len;
+	while ((len = read(fd, buf, sizeof(buf))) > 0)
+		ret.append(buf, len);
+
+	close(fd);
+	return ret;
+}
+
+class PtraceCrash : public CrashInfo
+{
+public:
+	PtraceCrash(pid_t pid)
+		: m_pid(pid)
+		, m_mem(-1)
+	{
+		char path[64];
+		snprintf(path, sizeof(path), "/proc/%d/mem", pid);
+		m_mem = open(path, O_RDONLY);
+	}
+
+	~PtraceCrash()
+	{
+		if (m_mem != -1)
+			close(m_mem);
+	}
+
+	bool Load()
+	{
+		struct user_regs_struct ur;
+		siginfo_t si;
+
+		if (ptrace(PTRACE_GETREGS, m_pid, NULL, &ur) == -1)
+			return false;
+
+		if (ptrace(PTRACE_GETSIGINFO, m_pid, NULL, &si) == -1)
+			return false;
+
+		signo = si.si_signo;
+		code = si.si_code;
+		address = (uint64_t)(uintptr_t)si.si_addr;
+
+#if defined(__x86_64__)
+		// 0x23 is the 32 bit user code segment
+		is64 = ur.cs != 0x23;
+
+		regs[TRIAGE_AX] = ur.rax;
+		regs[TRIAGE_CX] = ur.rcx;
+		regs[TRIAGE_DX] = ur.rdx;
+		regs[TRIAGE_BX] = ur.rbx;
+		regs[TRIAGE_SP] = ur.rsp;
+		regs[TRIAGE_BP] = ur.rbp;
+		regs[TRIAGE_SI] = ur.rsi;
+		regs[TRIAGE_DI] = ur.rdi;
+		regs[TRIAGE_R8] = ur.r8;
+		regs[TRIAGE_R9] = ur.r9;
+		regs[TRIAGE_R10] = ur.r10;
+		regs[TRIAGE_R11] = ur.r11;
+		regs[TRIAGE_R12] = ur.r12;
+		regs[TRIAGE_R13] = ur.r13;
+		regs[TRIAGE_R14] = ur.r14;
+		regs[TRIAGE_R15] = ur.r15;
+		regs[TRIAGE_IP] = ur.rip;
+#else
+		is64 = false;
+
+		regs[TRIAGE_AX] = (uint32_t)ur.eax;
+		regs[TRIAGE_CX] = (uint32_t)ur.ecx;
+		regs[TRIAGE_DX] = (uint32_t)ur.edx;
+		regs[TRIAGE_BX] = (uint32_t)ur.ebx;
+		regs[TRIAGE_SP] = (uint32_t)ur.esp;
+		regs[TRIAGE_BP] = (uint32_t)ur.ebp;
+		regs[TRIAGE_SI] = (uint32_t)ur.esi;
+		regs[TRIAGE_DI] = (uint32_t)ur.edi;
+		regs[TRIAGE_IP] = (uint32_t)ur.eip;
+#endif
+
+		char path[64];
+		snprintf(path, sizeof(path), "/proc/%d/maps", m_pid);
+
+		return LoadMaps(ReadFile(path));
+	}
+
+	virtual bool ReadMemory(uint64_t addr, void* buf, size_t len)
+	{
+		if (m_mem == -1)
+			return false;
+
+		return pread(m_mem, buf, len, (off_t)addr) == (ssize_t)len;
+	}
+
+private:
+	pid_t m_pid;
+	int m_mem;
+};
+
+static void Usage()
+{
+	fprintf(stderr, "Usage: PeachTriage [-p pidfile] [-o logfile] [--] executable [args...]\n");
+	exit(1);
+}
+
+static int Report(pid_t pid, const char* logFile)
+{
+	PtraceCrash crash(pid);
+
+	if (!crash.Load())
+	{
+		fprintf(stderr, "PeachTriage: failed to read the state of pid %d: %s\n", pid, strerror(errno));
+		return 1;
+	}
+
+	Triage triage(crash);
+	std::string report = triage.Report();
+
+	if (!logFile)
+	{
+		fputs(report.c_str(), stdout);
+		fflush(stdout);
+		return 0;
+	}
+
+	// The monitor polls for the log, it must never see half of it
+	std::string tmp = std::string(logFile) + ".tmp";
+
+	FILE* out = fopen(tmp.c_str(), "w");
+	if (!out)
+	{
+		fprintf(stderr, "PeachTriage: failed to open '%s': %s\n", tmp.c_str(), strerror(errno));
+		return 1;
+	}
+
+	fputs(report.c_str(), out);
+	fclose(out);
+
+	if (rename(tmp.c_str(), logFile) == -1)
+	{
+		fprintf(stderr, "PeachTriage: failed to write '%s': %s\n", logFile, strerror(errno));
+		return 1;
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	const char* pidFile = NULL;
+	const char* logFile = NULL;
+	int opt;
+
+	// Stop at the first non-option, the rest is the target's command line
+	while ((opt = getopt(argc, argv, "+p:o:")) != -1)
+	{
+		switch (opt)
+		{
+		case 'p':
+			pidFile = optarg;
+			break;
+		case 'o':
+			logFile = optarg;
+			break;
+		default:
+			Usage();
+		}
+	}
+
+	if (optind >= argc)
+		Usage();
+
+	pid_t pid = fork();
+	if (pid == -1)
+	{
+		perror("PeachTriage: fork");
+		return 1;
+	}
+
+	if (pid == 0)
+	{
+		ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+		execvp(argv[optind], argv + optind);
+		fprintf(stderr, "PeachTriage: failed to run '%s': %s\n", argv[optind], strerror(errno));
+		_exit(127);
+	}
+
+	int status;
+	if (waitpid(pid, &status, 0) == -1 || !WIFSTOPPED(status))
+	{
+		fprintf(stderr, "PeachTriage: failed to start '%s'\n", argv[optind]);
+		return 1;
+	}
+
+	// The target is stopped right after the exec
+	ptrace(PTRACE_SETOPTIONS, pid, NULL, PTRACE_O_TRACECLONE | PTRACE_O_TRACEEXEC | PTRACE_O_EXITKILL);
+
+	if (pidFile)
+	{
+		FILE* fp = fopen(pidFile, "w");
+		if (fp)
+		{
+			fprintf(fp, "%d", pid);
+			fclose(fp);
+		}
+	}
+
+	std::set<pid_t> threads;
+	threads.insert(pid);
+
+	ptrace(PTRACE_CONT, pid, NULL, NULL);
+
+	int exitCode = 0;
+
+	while (!threads.empty())
+	{
+		pid_t tid = waitpid(-1, &status, __WALL);
+
+		if (tid == -1)
+		{
+			if (errno == EINTR)
+				continue;
+			break;
+		}
+
+		if (WIFEXITED(status) || WIFSIGNALED(status))
+		{
+			threads.erase(tid);
+
+			if (tid == pid)
+				exitCode = WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+
+			continue;
+		}
+
+		if (!WIFSTOPPED(status))
+			continue;
+
+		int sig = WSTOPSIG(status);
+		int event = status >> 16;
+
+		// New threads start with a SIGSTOP which must not be passed on
+		threads.insert(tid);
+
+		if (event != 0 || sig == SIGTRAP)
+		{
+			ptrace(PTRACE_CONT, tid, NULL, NULL);
+			continue;
+		}
+
+		if (sig == SIGSTOP)
+		{
+			ptrace(PTRACE_CONT, tid, NULL, NULL);
+			continue;
+		}
+
+		if (!IsCrashSignal(sig))
+		{
+			ptrace(PTRACE_CONT, tid, NULL, (void*)(intptr_t)sig);
+			continue;
+		}
+
+		int ret = Report(tid, logFile);
+
+		kill(pid, SIGKILL);
+		ptrace(PTRACE_KILL, tid, NULL, NULL);
+
+		return ret ? ret : 128 + sig;
+	}
+
+	return exitCode;
+}
@@ -0,0 +1,2095 @@
+#include "Triage.h"
+
+#include <ctype.h>
+#include <cxxabi.h>
+#include <elf.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <map>
+
+#include "distorm.h"
+
+#ifndef PT_GNU_EH_FRAME
+#define PT_GNU_EH_FRAME 0x6474e550
+#endif
+
+// Same as !exploitable and exploitable.py
+#define NEAR_NULL 0x10000
+
+// Frames hashed into the major hash, see Classifier._major_hash_depth
+#define MAJOR_HASH_DEPTH 5
+
+// Limit for runaway unwinds
+#define MAX_FRAMES 256
+
+// Longest x86 instruction
+#define MAX_INSTRUCTION_SIZE 15
+
+///////////////////////////////////////////////////////////////////////////////
+// Signals
+
+static const struct { int sig; const char* name; } s_signals[] =
+{
+	{ SIGHUP, "SIGHUP" }, { SIGINT, "SIGINT" }, { SIGQUIT, "SIGQUIT" },
+	{ SIGILL, "SIGILL" }, { SIGTRAP, "SIGTRAP" }, { SIGABRT, "SIGABRT" },
+	{ SIGBUS, "SIGBUS" }, { SIGFPE, "SIGFPE" }, { SIGKILL, "SIGKILL" },
+	{ SIGUSR1, "SIGUSR1" }, { SIGSEGV, "SIGSEGV" }, { SIGUSR2, "SIGUSR2" },
+	{ SIGPIPE, "SIGPIPE" }, { SIGALRM, "SIGALRM" }, { SIGTERM, "SIGTERM" },
+	{ SIGCHLD, "SIGCHLD" }, { SIGCONT, "SIGCONT" }, { SIGSTOP, "SIGSTOP" },
+	{ SIGTSTP, "SIGTSTP" }, { SIGTTIN, "SIGTTIN" }, { SIGTTOU, "SIGTTOU" },
+	{ SIGURG, "SIGURG" }, { SIGXCPU, "SIGXCPU" }, { SIGXFSZ, "SIGXFSZ" },
+	{ SIGVTALRM, "SIGVTALRM" }, { SIGPROF, "SIGPROF" }, { SIGWINCH, "SIGWINCH" },
+	{ SIGIO, "SIGIO" }, { SIGSYS, "SIGSYS" },
+};
+
+const char* SignalName(int sig)
+{
+	for (size_t i = 0; i < sizeof(s_signals) / sizeof(s_signals[0]); ++i)
+	{
+		if (s_signals[i].sig == sig)
+			return s_signals[i].name;
+	}
+
+	return NULL;
+}
+
+static bool IsSignalInList(int sig, const int* list, size_t count)
+{
+	return sig != 0 && std::find(list, list + count, sig) != list + count;
+}
+
+static std::string Format(const char* fmt, ...)
+{
+	char buf[512];
+
+	va_list ap;
+	va_start(ap, fmt);
+	vsnprintf(buf, sizeof(buf), fmt, ap);
+	va_end(ap);
+
+	return buf;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// CrashInfo
+
+CrashInfo::CrashInfo()
+	: signo(0)
+	, code(0)
+	, address(0)
+	, is64(true)
+{
+	memset(regs, 0, sizeof(regs));
+}
+
+CrashInfo::~CrashInfo()
+{
+}
+
+bool CrashInfo::LoadMaps(const std::string& text)
+{
+	size_t pos = 0;
+
+	maps.clear();
+
+	while (pos < text.size())
+	{
+		size_t end = text.find('\n', pos);
+		if (end == std::string::npos)
+			end = text.size();
+
+		std::string line = text.substr(pos, end - pos);
+		pos = end + 1;
+
+		unsigned long long start, stop, offset;
+		char perms[8];
+		int name = 0;
+
+		// 00400000-0040b000 r-xp 00000000 08:01 1234    /bin/cat
+		if (sscanf(line.c_str(), "%llx-%llx %7s %llx %*s %*s %n", &start, &stop, perms, &offset, &name) < 4)
+			continue;
+
+		MapEntry entry;
+		entry.start = start;
+		entry.end = stop;
+		entry.offset = offset;
+		entry.perms = perms;
+
+		if (name > 0 && (size_t)name < line.size())
+			entry.name = line.substr(name);
+
+		maps.push_back(entry);
+	}
+
+	return !maps.empty();
+}
+
+const MapEntry* CrashInfo::FindMap(uint64_t addr) const
+{
+	for (std::vector<MapEntry>::const_iterator it = maps.begin(); it != maps.end(); ++it)
+	{
+		if (addr >= it->start && addr < it->end)
+			return &(*it);
+	}
+
+	return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Symbols, read from the files backing the mappings
+
+namespace
+{
+	struct Symbol
+	{
+		uint64_t value;
+		uint64_t size;
+		std::string name;
+
+		bool operator<(const Symbol& other) const { return value < other.value; }
+	};
+
+	struct Segment
+	{
+		uint64_t offset;
+		uint64_t size;
+		uint64_t vaddr;
+	};
+
+	struct Module
+	{
+		std::vector<Symbol> symbols;
+		std::vector<Segment> segments;
+	};
+
+	std::map<std::string, Module> s_modules;
+
+	size_t Underscores(const std::string& name)
+	{
+		size_t n = 0;
+		while (n < name.size() && name[n] == '_')
+			++n;
+		return n;
+	}
+
+	// Order by address, then the name a user would call first
+	bool PreferredSymbol(const Symbol& a, const Symbol& b)
+	{
+		if (a.value != b.value)
+			return a.value < b.value;
+
+		if (Underscores(a.name) != Underscores(b.name))
+			return Underscores(a.name) < Underscores(b.name);
+
+		if (a.name.size() != b.name.size())
+			return a.name.size() < b.name.size();
+
+		return a.name < b.name;
+	}
+
+	bool SameAddress(const Symbol& a, const Symbol& b)
+	{
+		return a.value == b.value;
+	}
+
+	template<class Ehdr, class Phdr, class Shdr, class Sym>
+	void LoadElf(const unsigned char* data, size_t size, Module& mod)
+	{
+		const Ehdr* ehdr = (const Ehdr*)data;
+
+		if (ehdr->e_phoff + (uint64_t)ehdr->e_phnum * sizeof(Phdr) <= size)
+		{
+			const Phdr* phdr = (const Phdr*)(data + ehdr->e_phoff);
+
+			for (int i = 0; i < ehdr->e_phnum; ++i)
+			{
+				if (phdr[i].p_type != PT_LOAD)
+					continue;
+
+				Segment seg = { phdr[i].p_offset, phdr[i].p_filesz, phdr[i].p_vaddr };
+				mod.segments.push_back(seg);
+			}
+		}
+
+		if (ehdr->e_shoff + (uint64_t)ehdr->e_shnum * sizeof(Shdr) > size)
+			return;
+
+		const Shdr* shdr = (const Shdr*)(data + ehdr->e_shoff);
+
+		for (int i = 0; i < ehdr->e_shnum; ++i)
+		{
+			if (shdr[i].sh_type != SHT_SYMTAB && shdr[i].sh_type != SHT_DYNSYM)
+				continue;
+
+			if (shdr[i].sh_link >= ehdr->e_shnum)
+				continue;
+
+			const Shdr& strtab = shdr[shdr[i].sh_link];
+
+			if (shdr[i].sh_offset + shdr[i].sh_size > size || strtab.sh_offset + strtab.sh_size > size)
+				continue;
+
+			const Sym* sym = (const Sym*)(data + shdr[i].sh_offset);
+			const char* str = (const char*)(data + strtab.sh_offset);
+			size_t count = shdr[i].sh_size / sizeof(Sym);
+
+			for (size_t j = 0; j < count; ++j)
+			{
+				int type = sym[j].st_info & 0xf;
+
+				if ((type != STT_FUNC && type != STT_GNU_IFUNC) || sym[j].st_shndx == SHN_UNDEF || sym[j].st_value == 0)
+					continue;
+
+				if (sym[j].st_name >= strtab.sh_size)
+					continue;
+
+				Symbol s;
+				s.value = sym[j].st_value;
+				s.size = sym[j].st_size;
+				s.name = str + sym[j].st_name;
+
+				mod.symbols.push_back(s);
+			}
+		}
+
+		// Keep one name per address, aliases like cfree/free or
+		// __libc_malloc/malloc would make the hashes unstable
+		std::sort(mod.symbols.begin(), mod.symbols.end(), PreferredSymbol);
+		mod.symbols.erase(std::unique(mod.symbols.begin(), mod.symbols.end(), SameAddress), mod.symbols.end());
+	}
+
+	Module& GetModule(const std::string& path)
+	{
+		std::map<std::string, Module>::iterator it = s_modules.find(path);
+		if (it != s_modules.end())
+			return it->second;
+
+		Module& mod = s_modules[path];
+
+		int fd = open(path.c_str(), O_RDONLY);
+		if (fd == -1)
+			return mod;
+
+		struct stat st;
+		if (fstat(fd, &st) == 0 && (size_t)st.st_size > EI_NIDENT)
+		{
+			void* data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+			if (data != MAP_FAILED)
+			{
+				const unsigned char* ident = (const unsigned char*)data;
+
+				if (memcmp(ident, ELFMAG, SELFMAG) == 0)
+				{
+					if (ident[EI_CLASS] == ELFCLASS64 && (size_t)st.st_size >= sizeof(Elf64_Ehdr))
+						LoadElf<Elf64_Ehdr, Elf64_Phdr, Elf64_Shdr, Elf64_Sym>(ident, st.st_size, mod);
+					else if (ident[EI_CLASS] == ELFCLASS32 && (size_t)st.st_size >= sizeof(Elf32_Ehdr))
+						LoadElf<Elf32_Ehdr, Elf32_Phdr, Elf32_Shdr, Elf32_Sym>(ident, st.st_size, mod);
+				}
+
+				munmap(data, st.st_size);
+			}
+		}
+
+		close(fd);
+		return mod;
+	}
+
+	// Like gdb, only names with the C++ ABI prefix are mangled.  Anything
+	// else is a C symbol, which __cxa_demangle would turn 'f' into 'float'.
+	std::string Demangle(const std::string& name)
+	{
+		if (name.compare(0, 2, "_Z") != 0)
+			return name;
+
+		int status = 0;
+		char* ret = abi::__cxa_demangle(name.c_str(), NULL, NULL, &status);
+
+		if (ret == NULL)
+			return name;
+
+		std::string demangled(ret);
+		free(ret);
+		return demangled;
+	}
+
+	std::string BaseName(const std::string& path)
+	{
+		size_t pos = path.rfind('/');
+		return pos == std::string::npos ? path : path.substr(pos + 1);
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Unwinding with the .eh_frame tables of the loaded modules
+
+namespace
+{
+	// DWARF register numbers to TriageRegister
+	const int s_dwarf64[] =
+	{
+		TRIAGE_AX, TRIAGE_DX, TRIAGE_CX, TRIAGE_BX, TRIAGE_SI, TRIAGE_DI, TRIAGE_BP, TRIAGE_SP,
+		TRIAGE_R8, TRIAGE_R9, TRIAGE_R10, TRIAGE_R11, TRIAGE_R12, TRIAGE_R13, TRIAGE_R14, TRIAGE_R15,
+		TRIAGE_IP,
+	};
+
+	const int s_dwarf32[] =
+	{
+		TRIAGE_AX, TRIAGE_CX, TRIAGE_DX, TRIAGE_BX, TRIAGE_SP, TRIAGE_BP, TRIAGE_SI, TRIAGE_DI,
+		TRIAGE_IP,
+	};
+
+	enum
+	{
+		DW_EH_PE_absptr = 0x00,
+		DW_EH_PE_uleb128 = 0x01,
+		DW_EH_PE_udata2 = 0x02,
+		DW_EH_PE_udata4 = 0x03,
+		DW_EH_PE_udata8 = 0x04,
+		DW_EH_PE_sleb128 = 0x09,
+		DW_EH_PE_sdata2 = 0x0a,
+		DW_EH_PE_sdata4 = 0x0b,
+		DW_EH_PE_sdata8 = 0x0c,
+		DW_EH_PE_pcrel = 0x10,
+		DW_EH_PE_datarel = 0x30,
+		DW_EH_PE_indirect = 0x80,
+		DW_EH_PE_omit = 0xff,
+	};
+
+	struct Registers
+	{
+		uint64_t value[TRIAGE_COUNT];
+		bool valid[TRIAGE_COUNT];
+	};
+
+	enum RuleType { RULE_SAME, RULE_UNDEFINED, RULE_OFFSET, RULE_VAL_OFFSET, RULE_REGISTER, RULE_EXPRESSION, RULE_VAL_EXPRESSION };
+
+	struct RegisterRule
+	{
+		RuleType type;
+		int64_t value;
+		uint64_t expr;     // Target address of the expression block
+		uint64_t exprLen;
+	};
+
+	struct CfaState
+	{
+		int cfaRegister;   // TriageRegister, -1 when the CFA is an expression
+		int64_t cfaOffset;
+		uint64_t cfaExpr;
+		uint64_t cfaExprLen;
+		RegisterRule rules[TRIAGE_COUNT];
+	};
+
+	// Bounded reader over a copy of target memory
+	class Reader
+	{
+	public:
+		Reader(CrashInfo& crash, uint64_t address)
+			: m_crash(crash), m_address(address), m_ok(true)
+		{
+		}
+
+		uint64_t Address() const { return m_address; }
+		bool Ok() const { return m_ok; }
+		void Seek(uint64_t address) { m_address = address; }
+
+		bool Read(void* buf, size_t len)
+		{
+			if (m_ok && !m_crash.ReadMemory(m_address, buf, len))
+				m_ok = false;
+
+			if (!m_ok)
+				memset(buf, 0, len);
+
+			m_address += len;
+			return m_ok;
+		}
+
+		uint8_t U8() { uint8_t v; Read(&v, 1); return v; }
+		uint16_t U16() { uint16_t v; Read(&v, 2); return v; }
+		uint32_t U32() { uint32_t v; Read(&v, 4); return v; }
+		uint64_t U64() { uint64_t v; Read(&v, 8); return v; }
+
+		uint64_t Uleb()
+		{
+			uint64_t ret = 0;
+			unsigned shift = 0;
+			uint8_t b;
+
+			do
+			{
+				b = U8();
+				if (shift < 64)
+					ret |= (uint64_t)(b & 0x7f) << shift;
+				shift += 7;
+			}
+			while ((b & 0x80) && m_ok);
+
+			return ret;
+		}
+
+		int64_t Sleb()
+		{
+			int64_t ret = 0;
+			unsigned shift = 0;
+			uint8_t b;
+
+			do
+			{
+				b = U8();
+				if (shift < 64)
+					ret |= (int64_t)(b & 0x7f) << shift;
+				shift += 7;
+			}
+			while ((b & 0x80) && m_ok);
+
+			if (shift < 64 && (b & 0x40))
+				ret |= -((int64_t)1 << shift);
+
+			return ret;
+		}
+
+		uint64_t Pointer(uint8_t enc, unsigned ptrSize, uint64_t dataBase)
+		{
+			uint64_t start = m_address;
+			uint64_t ret = 0;
+
+			if (enc == DW_EH_PE_omit)
+				return 0;
+
+			switch (enc & 0x0f)
+			{
+			case DW_EH_PE_absptr: ret = ptrSize == 8 ? U64() : U32(); break;
+			case DW_EH_PE_uleb128: ret = Uleb(); break;
+			case DW_EH_PE_udata2: ret = U16(); break;
+			case DW_EH_PE_udata4: ret = U32(); break;
+			case DW_EH_PE_udata8: ret = U64(); break;
+			case DW_EH_PE_sleb128: ret = Sleb(); break;
+			case DW_EH_PE_sdata2: ret = (int16_t)U16(); break;
+			case DW_EH_PE_sdata4: ret = (int32_t)U32(); break;
+			case DW_EH_PE_sdata8: ret = U64(); break;
+			default: m_ok = false; return 0;
+			}
+
+			switch (enc & 0x70)
+			{
+			case 0: break;
+			case DW_EH_PE_pcrel: ret += start; break;
+			case DW_EH_PE_datarel: ret += dataBase; break;
+			default: m_ok = false; return 0;
+			}
+
+			if (ptrSize == 4)
+				ret &= 0xffffffff;
+
+			if (enc & DW_EH_PE_indirect)
+			{
+				Reader ind(m_crash, ret);
+				ret = ptrSize == 8 ? ind.U64() : ind.U32();
+				if (!ind.Ok())
+					m_ok = false;
+			}
+
+			return ret;
+		}
+
+	private:
+		CrashInfo& m_crash;
+		uint64_t m_address;
+		bool m_ok;
+	};
+
+	struct Fde
+	{
+		uint64_t pcBegin;
+		uint64_t pcEnd;
+		uint64_t instructions;
+		uint64_t instructionsEnd;
+
+		// From the CIE
+		uint64_t initial;
+		uint64_t initialEnd;
+		uint64_t codeAlign;
+		int64_t dataAlign;
+		int raColumn;
+		uint8_t fdeEncoding;
+		bool hasAugData;
+	};
+
+	class Unwinder
+	{
+	public:
+		Unwinder(CrashInfo& crash)
+			: m_crash(crash)
+			, m_ptrSize(crash.PointerSize())
+			, m_dwarf(crash.is64 ? s_dwarf64 : s_dwarf32)
+			, m_dwarfCount(crash.is64 ? sizeof(s_dwarf64) / sizeof(s_dwarf64[0]) : sizeof(s_dwarf32) / sizeof(s_dwarf32[0]))
+		{
+		}
+
+		enum Result { UNWIND_OK, UNWIND_END, UNWIND_ERROR };
+
+		// Unwind regs to the caller's frame
+		Result Step(Registers& regs, bool first)
+		{
+			uint64_t pc = regs.value[TRIAGE_IP];
+			Registers caller = regs;
+			Fde fde;
+
+			// Return addresses point after the call, which may be past the end of the caller
+			if (FindFde(first ? pc : pc - 1, fde))
+			{
+				if (!ApplyFde(fde, first ? pc : pc - 1, regs, caller))
+					return UNWIND_ERROR;
+			}
+			else if (first && !IsExecutable(pc))
+			{
+				// Called a bad pointer, the return address is on top of the stack
+				uint64_t ra;
+				if (!ReadPointer(regs.value[TRIAGE_SP], ra))
+					return UNWIND_ERROR;
+
+				caller.value[TRIAGE_IP] = ra;
+				caller.value[TRIAGE_SP] = regs.value[TRIAGE_SP] + m_ptrSize;
+			}
+			else
+			{
+				// No unwind info, follow the frame pointer chain
+				uint64_t bp = regs.value[TRIAGE_BP], next, ra;
+
+				if (!regs.valid[TRIAGE_BP] || bp == 0)
+					return UNWIND_END;
+
+				if (!ReadPointer(bp, next) || !ReadPointer(bp + m_ptrSize, ra))
+					return UNWIND_ERROR;
+
+				caller.value[TRIAGE_BP] = next;
+				caller.value[TRIAGE_IP] = ra;
+				caller.value[TRIAGE_SP] = bp + 2 * m_ptrSize;
+			}
+
+			if (!caller.valid[TRIAGE_IP] || caller.value[TRIAGE_IP] == 0)
+				return UNWIND_END;
+
+			// Previous frame inner to this frame (corrupt stack?)
+			if (caller.value[TRIAGE_SP] < regs.value[TRIAGE_SP])
+				return UNWIND_ERROR;
+
+			// Previous frame identical to this frame (corrupt stack?)
+			if (caller.value[TRIAGE_SP] == regs.value[TRIAGE_SP] && caller.value[TRIAGE_IP] == pc)
+				return UNWIND_ERROR;
+
+			regs = caller;
+			return UNWIND_OK;
+		}
+
+	private:
+		bool IsExecutable(uint64_t pc)
+		{
+			const MapEntry* map = m_crash.FindMap(pc);
+			return map && map->perms.find('x') != std::string::npos;
+		}
+
+		CrashInfo& m_crash;
+		unsigned m_ptrSize;
+		const int* m_dwarf;
+		size_t m_dwarfCount;
+
+		int Register(uint64_t dwarf)
+		{
+			return dwarf < m_dwarfCount ? m_dwarf[dwarf] : -1;
+		}
+
+		bool ReadPointer(uint64_t address, uint64_t& value)
+		{
+			value = 0;
+			return m_crash.ReadMemory(address, &value, m_ptrSize);
+		}
+
+		// Find the .eh_frame_hdr of the module containing pc
+		bool FindEhFrameHdr(uint64_t pc, uint64_t& hdr)
+		{
+			const MapEntry* map = m_crash.FindMap(pc);
+			if (!map || map->name.empty() || map->name[0] != '/')
+				return false;
+
+			// The ELF headers are in the first mapping of the file
+			const MapEntry* base = NULL;
+			for (std::vector<MapEntry>::const_iterator it = m_crash.maps.begin(); it != m_crash.maps.end(); ++it)
+			{
+				if (it->name == map->name && it->offset == 0)
+				{
+					base = &(*it);
+					break;
+				}
+			}
+
+			if (!base)
+				return false;
+
+			Reader r(m_crash, base->start);
+			unsigned char ident[EI_NIDENT];
+
+			if (!r.Read(ident, sizeof(ident)) || memcmp(ident, ELFMAG, SELFMAG) != 0)
+				return false;
+
+			bool is64 = ident[EI_CLASS] == ELFCLASS64;
+			uint64_t phoff;
+			unsigned phnum, phentsize;
+
+			if (is64)
+			{
+				Elf64_Ehdr ehdr;
+				if (!m_crash.ReadMemory(base->start, &ehdr, sizeof(ehdr)))
+					return false;
+				phoff = ehdr.e_phoff;
+				phnum = ehdr.e_phnum;
+				phentsize = ehdr.e_phentsize;
+			}
+			else
+			{
+				Elf32_Ehdr ehdr;
+				if (!m_crash.ReadMemory(base->start, &ehdr, sizeof(ehdr)))
+					return false;
+				phoff = ehdr.e_phoff;
+				phnum = ehdr.e_phnum;
+				phentsize = ehdr.e_phentsize;
+			}
+
+			uint64_t bias = 0, ehVaddr = 0;
+			bool haveBias = false, haveEh = false;
+
+			for (unsigned i = 0; i < phnum; ++i)
+			{
+				uint64_t type, offset, vaddr;
+
+				if (is64)
+				{
+					Elf64_Phdr phdr;
+					if (!m_crash.ReadMemory(base->start + phoff + i * phentsize, &phdr, sizeof(phdr)))
+						return false;
+					type = phdr.p_type;
+					offset = phdr.p_offset;
+					vaddr = phdr.p_vaddr;
+				}
+				else
+				{
+					Elf32_Phdr phdr;
+					if (!m_crash.ReadMemory(base->start + phoff + i * phentsize, &phdr, sizeof(phdr)))
+						return false;
+					type = phdr.p_type;
+					offset = phdr.p_offset;
+					vaddr = phdr.p_vaddr;
+				}
+
+				if (type == PT_LOAD && offset == 0 && !haveBias)
+				{
+					bias = base->start - (vaddr & ~(uint64_t)0xfff);
+					haveBias = true;
+				}
+				else if (type == PT_GNU_EH_FRAME)
+				{
+					ehVaddr = vaddr;
+					haveEh = true;
+				}
+			}
+
+			if (!haveBias || !haveEh)
+				return false;
+
+			hdr = bias + ehVaddr;
+			return true;
+		}
+
+		bool FindFde(uint64_t pc, Fde& fde)
+		{
+			uint64_t hdr;
+			if (!FindEhFrameHdr(pc, hdr))
+				return false;
+
+			Reader r(m_crash, hdr);
+
+			uint8_t version = r.U8();
+			uint8_t ehFramePtrEnc = r.U8();
+			uint8_t fdeCountEnc = r.U8();
+			uint8_t tableEnc = r.U8();
+
+			if (!r.Ok() || version != 1 || tableEnc != (DW_EH_PE_datarel | DW_EH_PE_sdata4))
+				return false;
+
+			r.Pointer(ehFramePtrEnc, m_ptrSize, hdr);
+			uint64_t count = r.Pointer(fdeCountEnc, m_ptrSize, hdr);
+			uint64_t table = r.Address();
+
+			if (!r.Ok() || count == 0)
+				return false;
+
+			// Binary search of the sorted initial locations
+			uint64_t lo = 0, hi = count;
+			while (hi - lo > 1)
+			{
+				uint64_t mid = (lo + hi) / 2;
+				int32_t loc;
+
+				if (!m_crash.ReadMemory(table + mid * 8, &loc, 4))
+					return false;
+
+				if (hdr + loc <= pc)
+					lo = mid;
+				else
+					hi = mid;
+			}
+
+			int32_t entry[2];
+			if (!m_crash.ReadMemory(table + lo * 8, entry, sizeof(entry)))
+				return false;
+
+			if (!ParseFde(hdr + entry[1], fde))
+				return false;
+
+			return pc >= fde.pcBegin && pc < fde.pcEnd;
+		}
+
+		bool ParseFde(uint64_t address, Fde& fde)
+		{
+			Reader r(m_crash, address);
+
+			uint64_t length = r.U32();
+			if (length == 0xffffffff)
+				length = r.U64();
+
+			uint64_t end = r.Address() + length;
+			uint64_t ciePtr = r.Address();
+			uint32_t cieOffset = r.U32();
+
+			if (!r.Ok() || cieOffset == 0)
+				return false;
+
+			if (!ParseCie(ciePtr - cieOffset, fde))
+				return false;
+
+			fde.pcBegin = r.Pointer(fde.fdeEncoding, m_ptrSize, 0);
+			fde.pcEnd = fde.pcBegin + r.Pointer(fde.fdeEncoding & 0x0f, m_ptrSize, 0);
+
+			// Augmentation data, the LSDA isn't needed
+			if (fde.hasAugData)
+			{
+				uint64_t len = r.Uleb();
+				r.Seek(r.Address() + len);
+			}
+
+			fde.instructions = r.Address();
+			fde.instructionsEnd = end;
+
+			return r.Ok();
+		}
+
+		bool ParseCie(uint64_t address, Fde& fde)
+		{
+			Reader r(m_crash, address);
+
+			uint64_t length = r.U32();
+			if (length == 0xffffffff)
+				length = r.U64();
+
+			uint64_t end = r.Address() + length;
+
+			if (r.U32() != 0)
+				return false;
+
+			uint8_t version = r.U8();
+
+			char aug[16];
+			size_t augLen = 0;
+			for (;;)
+			{
+				char c = (char)r.U8();
+				if (!r.Ok() || c == 0)
+					break;
+				if (augLen + 1 < sizeof(aug))
+					aug[augLen++] = c;
+			}
+			aug[augLen] = 0;
+
+			if (version >= 4)
+			{
+				r.U8(); // address_size
+				r.U8(); // segment_size
+			}
+
+			fde.codeAlign = r.Uleb();
+			fde.dataAlign = r.Sleb();
+			fde.raColumn = version == 1 ? r.U8() : (int)r.Uleb();
+			fde.fdeEncoding = DW_EH_PE_absptr;
+			fde.hasAugData = aug[0] == 'z';
+
+			if (aug[0] == 'z')
+			{
+				uint64_t len = r.Uleb();
+				uint64_t next = r.Address() + len;
+
+				for (size_t i = 1; i < augLen; ++i)
+				{
+					switch (aug[i])
+					{
+					case 'L': r.U8(); break;
+					case 'R': fde.fdeEncoding = r.U8(); break;
+					case 'P': r.Pointer(r.U8(), m_ptrSize, 0); break;
+					case 'S': break;
+					default: i = augLen; break;
+					}
+				}
+
+				r.Seek(next);
+			}
+			else if (augLen != 0)
+			{
+				// Unknown augmentation without a length, can't be skipped
+				return false;
+			}
+
+			fde.initial = r.Address();
+			fde.initialEnd = end;
+
+			return r.Ok();
+		}
+
+		bool Execute(const Fde& fde, uint64_t start, uint64_t end, uint64_t pc, CfaState& state, const CfaState* initial)
+		{
+			Reader r(m_crash, start);
+			std::vector<CfaState> stack;
+			uint64_t loc = fde.pcBegin;
+
+			while (r.Address() < end && r.Ok())
+			{
+				uint8_t op = r.U8();
+				uint64_t reg, delta = (uint64_t)-1;
+
+				switch (op & 0xc0)
+				{
+				case 0x40:
+					delta = (op & 0x3f) * fde.codeAlign;
+					break;
+				case 0x80:
+					SetRule(state, op & 0x3f, RULE_OFFSET, (int64_t)r.Uleb() * fde.dataAlign);
+					continue;
+				case 0xc0:
+					Restore(state, initial, op & 0x3f);
+					continue;
+				}
+
+				switch (op)
+				{
+				case 0x00: // DW_CFA_nop
+					break;
+				case 0x01: // DW_CFA_set_loc
+					loc = r.Pointer(fde.fdeEncoding, m_ptrSize, 0);
+					if (loc > pc)
+						return true;
+					break;
+				case 0x02: delta = r.U8() * fde.codeAlign; break;
+				case 0x03: delta = r.U16() * fde.codeAlign; break;
+				case 0x04: delta = r.U32() * fde.codeAlign; break;
+				case 0x05: // DW_CFA_offset_extended
+					reg = r.Uleb();
+					SetRule(state, reg, RULE_OFFSET, (int64_t)r.Uleb() * fde.dataAlign);
+					break;
+				case 0x06: // DW_CFA_restore_extended
+					Restore(state, initial, r.Uleb());
+					break;
+				case 0x07: // DW_CFA_undefined
+					SetRule(state, r.Uleb(), RULE_UNDEFINED, 0);
+					break;
+				case 0x08: // DW_CFA_same_value
+					SetRule(state, r.Uleb(), RULE_SAME, 0);
+					break;
+				case 0x09: // DW_CFA_register
+					reg = r.Uleb();
+					SetRule(state, reg, RULE_REGISTER, (int64_t)r.Uleb());
+					break;
+				case 0x0a: // DW_CFA_remember_state
+					stack.push_back(state);
+					break;
+				case 0x0b: // DW_CFA_restore_state
+					if (stack.empty())
+						return false;
+					state = stack.back();
+					stack.pop_back();
+					break;
+				case 0x0c: // DW_CFA_def_cfa
+					state.cfaRegister = Register(r.Uleb());
+					state.cfaOffset = (int64_t)r.Uleb();
+					break;
+				case 0x0d: // DW_CFA_def_cfa_register
+					state.cfaRegister = Register(r.Uleb());
+					break;
+				case 0x0e: // DW_CFA_def_cfa_offset
+					state.cfaOffset = (int64_t)r.Uleb();
+					break;
+				case 0x0f: // DW_CFA_def_cfa_expression
+					state.cfaRegister = -1;
+					state.cfaExprLen = r.Uleb();
+					state.cfaExpr = r.Address();
+					r.Seek(state.cfaExpr + state.cfaExprLen);
+					break;
+				case 0x10: // DW_CFA_expression
+				case 0x16: // DW_CFA_val_expression
+				{
+					reg = r.Uleb();
+					uint64_t len = r.Uleb();
+					int col = Register(reg);
+					if (col >= 0)
+					{
+						state.rules[col].type = op == 0x10 ? RULE_EXPRESSION : RULE_VAL_EXPRESSION;
+						state.rules[col].expr = r.Address();
+						state.rules[col].exprLen = len;
+					}
+					r.Seek(r.Address() + len);
+					break;
+				}
+				case 0x11: // DW_CFA_offset_extended_sf
+					reg = r.Uleb();
+					SetRule(state, reg, RULE_OFFSET, r.Sleb() * fde.dataAlign);
+					break;
+				case 0x12: // DW_CFA_def_cfa_sf
+					state.cfaRegister = Register(r.Uleb());
+					state.cfaOffset = r.Sleb() * fde.dataAlign;
+					break;
+				case 0x13: // DW_CFA_def_cfa_offset_sf
+					state.cfaOffset = r.Sleb() * fde.dataAlign;
+					break;
+				case 0x14: // DW_CFA_val_offset
+					reg = r.Uleb();
+					SetRule(state, reg, RULE_VAL_OFFSET, (int64_t)r.Uleb() * fde.dataAlign);
+					break;
+				case 0x15: // DW_CFA_val_offset_sf
+					reg = r.Uleb();
+					SetRule(state, reg, RULE_VAL_OFFSET, r.Sleb() * fde.dataAlign);
+					break;
+				case 0x2e: // DW_CFA_GNU_args_size
+					r.Uleb();
+					break;
+				case 0x2f: // DW_CFA_GNU_negative_offset_extended
+					reg = r.Uleb();
+					SetRule(state, reg, RULE_OFFSET, -(int64_t)r.Uleb() * fde.dataAlign);
+					break;
+				default:
+					if ((op & 0xc0) == 0)
+						return false;
+					break;
+				}
+
+				if (delta != (uint64_t)-1)
+				{
+					if (loc + delta > pc)
+						return true;
+					loc += delta;
+				}
+			}
+
+			return r.Ok();
+		}
+
+		void SetRule(CfaState& state, uint64_t dwarf, RuleType type, int64_t value)
+		{
+			int col = Register(dwarf);
+			if (col < 0)
+				return;
+
+			state.rules[col].type = type;
+			state.rules[col].value = value;
+		}
+
+		void Restore(CfaState& state, const CfaState* initial, uint64_t dwarf)
+		{
+			int col = Register(dwarf);
+			if (col < 0)
+				return;
+
+			if (initial)
+				state.rules[col] = initial->rules[col];
+			else
+				state.rules[col].type = RULE_SAME;
+		}
+
+		// Subset of DWARF expressions, enough for the PLT and signal frames
+		bool Evaluate(uint64_t expr, uint64_t len, const Registers& regs, uint64_t& result, bool pushCfa, uint64_t cfa)
+		{
+			std::vector<uint64_t> st;
+			Reader r(m_crash, expr);
+			uint64_t end = expr + len;
+
+			if (pushCfa)
+				st.push_back(cfa);
+
+			while (r.Address() < end && r.Ok())
+			{
+				uint8_t op = r.U8();
+				uint64_t a, b;
+
+				if (op >= 0x30 && op <= 0x4f) // DW_OP_lit0-31
+				{
+					st.push_back(op - 0x30);
+					continue;
+				}
+
+				if (op >= 0x70 && op <= 0x8f) // DW_OP_breg0-31
+				{
+					int col = Register(op - 0x70);
+					int64_t off = r.Sleb();
+					if (col < 0 || !regs.valid[col])
+						return false;
+					st.push_back(regs.value[col] + off);
+					continue;
+				}
+
+				switch (op)
+				{
+				case 0x06: // DW_OP_deref
+					if (st.empty() || !ReadPointer(st.back(), a))
+						return false;
+					st.back() = a;
+					continue;
+				case 0x08: st.push_back(r.U8()); continue;
+				case 0x09: st.push_back((int8_t)r.U8()); continue;
+				case 0x0a: st.push_back(r.U16()); continue;
+				case 0x0b: st.push_back((int16_t)r.U16()); continue;
+				case 0x0c: st.push_back(r.U32()); continue;
+				case 0x0d: st.push_back((int32_t)r.U32()); continue;
+				case 0x0e: st.push_back(r.U64()); continue;
+				case 0x0f: st.push_back(r.U64()); continue;
+				case 0x10: st.push_back(r.Uleb()); continue;
+				case 0x11: st.push_back(r.Sleb()); continue;
+				case 0x12: // DW_OP_dup
+					if (st.empty())
+						return false;
+					st.push_back(st.back());
+					continue;
+				case 0x13: // DW_OP_drop
+					if (st.empty())
+						return false;
+					st.pop_back();
+					continue;
+				case 0x23: // DW_OP_plus_uconst
+					if (st.empty())
+						return false;
+					st.back() += r.Uleb();
+					continue;
+				}
+
+				if (st.size() < 2)
+					return false;
+
+				b = st.back();
+				st.pop_back();
+				a = st.back();
+
+				switch (op)
+				{
+				case 0x1a: a &= b; break;                     // DW_OP_and
+				case 0x1c: a -= b; break;                     // DW_OP_minus
+				case 0x1e: a *= b; break;                     // DW_OP_mul
+				case 0x21: a |= b; break;                     // DW_OP_or
+				case 0x22: a += b; break;                     // DW_OP_plus
+				case 0x24: a <<= b; break;                    // DW_OP_shl
+				case 0x25: a >>= b; break;                    // DW_OP_shr
+				case 0x26: a = (int64_t)a >> b; break;        // DW_OP_shra
+				case 0x27: a ^= b; break;                     // DW_OP_xor
+				case 0x29: a = a == b; break;                 // DW_OP_eq
+				case 0x2a: a = (int64_t)a >= (int64_t)b; break; // DW_OP_ge
+				case 0x2b: a = (int64_t)a > (int64_t)b; break;  // DW_OP_gt
+				case 0x2c: a = (int64_t)a <= (int64_t)b; break; // DW_OP_le
+				case 0x2d: a = (int64_t)a < (int64_t)b; break;  // DW_OP_lt
+				case 0x2e: a = a != b; break;                 // DW_OP_ne
+				default: return false;
+				}
+
+				st.back() = a;
+			}
+
+			if (!r.Ok() || st.empty())
+				return false;
+
+			result = st.back();
+			return true;
+		}
+
+		bool ApplyFde(const Fde& fde, uint64_t pc, const Registers& regs, Registers& caller)
+		{
+			CfaState state;
+			memset(&state, 0, sizeof(state));
+			state.cfaRegister = -1;
+
+			for (int i = 0; i < TRIAGE_COUNT; ++i)
+				state.rules[i].type = RULE_SAME;
+
+			if (!Execute(fde, fde.initial, fde.initialEnd, (uint64_t)-1, state, NULL))
+				return false;
+
+			CfaState initial = state;
+
+			if (!Execute(fde, fde.instructions, fde.instructionsEnd, pc, state, &initial))
+				return false;
+
+			uint64_t cfa;
+
+			if (state.cfaRegister >= 0)
+			{
+				if (!regs.valid[state.cfaRegister])
+					return false;
+				cfa = regs.value[state.cfaRegister] + state.cfaOffset;
+			}
+			else if (state.cfaExprLen == 0 || !Evaluate(state.cfaExpr, state.cfaExprLen, regs, cfa, false, 0))
+			{
+				return false;
+			}
+
+			if (m_ptrSize == 4)
+				cfa &= 0xffffffff;
+
+			// Both ABIs keep the return address in the IP column
+			if (Register(fde.raColumn) != TRIAGE_IP)
+				return false;
+
+			for (int i = 0; i < TRIAGE_COUNT; ++i)
+			{
+				const RegisterRule& rule = state.rules[i];
+				int dst = i;
+				uint64_t value = 0, addr;
+
+				switch (rule.type)
+				{
+				case RULE_SAME:
+					break;
+				case RULE_UNDEFINED:
+					caller.valid[dst] = false;
+					break;
+				case RULE_OFFSET:
+					if (!ReadPointer(cfa + rule.value, value))
+						return false;
+					caller.value[dst] = value;
+					caller.valid[dst] = true;
+					break;
+				case RULE_VAL_OFFSET:
+					caller.value[dst] = cfa + rule.value;
+					caller.valid[dst] = true;
+					break;
+				case RULE_REGISTER:
+				{
+					int src = Register(rule.value);
+					if (src < 0)
+						return false;
+					caller.value[dst] = regs.value[src];
+					caller.valid[dst] = regs.valid[src];
+					break;
+				}
+				case RULE_EXPRESSION:
+					if (!Evaluate(rule.expr, rule.exprLen, regs, addr, true, cfa) || !ReadPointer(addr, value))
+						return false;
+					caller.value[dst] = value;
+					caller.valid[dst] = true;
+					break;
+				case RULE_VAL_EXPRESSION:
+					if (!Evaluate(rule.expr, rule.exprLen, regs, value, true, cfa))
+						return false;
+					caller.value[dst] = value;
+					caller.valid[dst] = true;
+					break;
+				}
+			}
+
+			caller.value[TRIAGE_SP] = cfa;
+			caller.valid[TRIAGE_SP] = true;
+
+			return true;
+		}
+	};
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Disassembly
+
+static bool DecodeOne(uint64_t address, const unsigned char* code, size_t len, bool is64, Instruction& out)
+{
+	_DecodeType dt = is64 ? Decode64Bits : Decode32Bits;
+	_DecodedInst decoded[MAX_INSTRUCTION_SIZE];
+	_DInst decomposed[MAX_INSTRUCTION_SIZE];
+	unsigned int count = 0;
+
+	distorm_decode(address, code, (int)len, dt, decoded, MAX_INSTRUCTION_SIZE, &count);
+	if (count == 0)
+		return false;
+
+	out.address = address;
+	out.size = decoded[0].size;
+	out.text = (const char*)decoded[0].mnemonic.p;
+	out.mnemonic = out.text;
+	out.operands.clear();
+
+	std::transform(out.mnemonic.begin(), out.mnemonic.end(), out.mnemonic.begin(), ::tolower);
+
+	std::string operands((const char*)decoded[0].operands.p);
+	if (!operands.empty())
+	{
+		out.text += " " + operands;
+
+		size_t pos = 0, next;
+		while ((next = operands.find(", ", pos)) != std::string::npos)
+		{
+			out.operands.push_back(operands.substr(pos, next - pos));
+			pos = next + 2;
+		}
+		out.operands.push_back(operands.substr(pos));
+	}
+
+	count = 0;
+	distorm_decompose(address, code, (int)len, dt, decomposed, MAX_INSTRUCTION_SIZE, &count);
+	out.flowControl = count ? decomposed[0].flowControl : FC_NONE;
+
+	// diStorm leaves out the implicit operands of string instructions, gdb
+	// shows them and the rules need them (dest first, like intel syntax)
+	if (out.operands.empty())
+	{
+		std::string m = out.mnemonic.substr(out.mnemonic.rfind(' ') + 1);
+		const char* di = is64 ? "[RDI]" : "[EDI]";
+		const char* si = is64 ? "[RSI]" : "[ESI]";
+
+		if (m.size() == 5)
+			m.resize(4);
+
+		if (m == "movs") { out.operands.push_back(di); out.operands.push_back(si); }
+		else if (m == "stos") { out.operands.push_back(di); out.operands.push_back("AL"); }
+		else if (m == "lods") { out.operands.push_back("AL"); out.operands.push_back(si); }
+		else if (m == "scas") { out.operands.push_back("AL"); out.operands.push_back(di); }
+		else if (m == "cmps") { out.operands.push_back(si); out.operands.push_back(di); }
+		else if (m == "inss" || m == "insb" || m == "insw" || m == "insd") { out.operands.push_back(di); out.operands.push_back("DX"); }
+		else if (m == "outs") { out.operands.push_back("DX"); out.operands.push_back(si); }
+	}
+
+	return true;
+}
+
+void Triage::Disassemble()
+{
+	unsigned char code[MAX_INSTRUCTION_SIZE];
+	size_t len = 0;
+
+	// The instruction can end right before an unmapped page
+	while (len < sizeof(code) && m_crash.ReadMemory(m_crash.Pc() + len, code + len, 1))
+		++len;
+
+	if (len > 0)
+		m_hasInstruction = DecodeOne(m_crash.Pc(), code, len, m_crash.is64, m_instruction);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Backtrace
+
+static const char* const s_blacklist[] =
+{
+	"__kernel_vsyscall", "abort", "raise", "malloc", "free", "*__GI_abort",
+	"*__GI_raise", "malloc_printerr", "__libc_message", "_int_malloc", "_int_free",
+};
+
+Triage::Triage(CrashInfo& crash)
+	: m_crash(crash)
+	, m_abnormal(false)
+	, m_hasInstruction(false)
+{
+	Disassemble();
+	Unwind();
+	Hash();
+	Classify();
+}
+
+void Triage::Symbolize(Frame& frame, bool caller)
+{
+	// Return addresses can point past the end of the calling function
+	// when it ends in a call to a noreturn function, so look up the call
+	uint64_t adjust = caller ? 1 : 0;
+	const MapEntry* map = m_crash.FindMap(frame.pc - adjust);
+
+	frame.offset = 0;
+	frame.vaddr = frame.pc;
+	frame.mapped = map != NULL;
+	frame.region = map ? map->name : "";
+
+	if (!map)
+		return;
+
+	frame.vaddr = frame.pc - map->start + map->offset;
+
+	if (map->name.empty() || map->name[0] != '/')
+		return;
+
+	Module& mod = GetModule(map->name);
+	uint64_t fileOffset = frame.vaddr - adjust;
+	bool found = false;
+
+	for (std::vector<Segment>::const_iterator it = mod.segments.begin(); it != mod.segments.end(); ++it)
+	{
+		if (fileOffset >= it->offset && fileOffset < it->offset + it->size)
+		{
+			frame.vaddr = it->vaddr + fileOffset - it->offset + adjust;
+			found = true;
+			break;
+		}
+	}
+
+	if (!found || mod.symbols.empty())
+		return;
+
+	// Nearest symbol at or below the address, same as gdb without debug info
+	Symbol key;
+	key.value = frame.vaddr - adjust;
+
+	std::vector<Symbol>::const_iterator it = std::upper_bound(mod.symbols.begin(), mod.symbols.end(), key);
+	if (it == mod.symbols.begin())
+		return;
+
+	--it;
+	frame.name = Demangle(it->name);
+	frame.offset = frame.vaddr - it->value;
+}
+
+void Triage::Unwind()
+{
+	Registers regs;
+
+	for (int i = 0; i < TRIAGE_COUNT; ++i)
+	{
+		regs.value[i] = m_crash.regs[i];
+		regs.valid[i] = true;
+	}
+
+	Unwinder unwinder(m_crash);
+
+	for (size_t i = 0; i < MAX_FRAMES; ++i)
+	{
+		Frame frame;
+		frame.pc = regs.value[TRIAGE_IP];
+
+		Symbolize(frame, i != 0);
+
+		// Workaround for runaway backtraces, same as exploitable.py
+		if (frame.name.find("libc_start_main") != std::string::npos)
+			break;
+
+		frame.blacklisted =
+			std::find(s_blacklist, s_blacklist + sizeof(s_blacklist) / sizeof(s_blacklist[0]), frame.name) != s_blacklist + sizeof(s_blacklist) / sizeof(s_blacklist[0]) ||
+			frame.region.find("/libc") != std::string::npos ||
+			frame.region.find("/libm") != std::string::npos ||
+			(frame.name.empty() && frame.region.empty());
+
+		m_frames.push_back(frame);
+
+		// gdb doesn't unwind past main
+		if (frame.name == "main")
+			break;
+
+		Unwinder::Result res = unwinder.Step(regs, i == 0);
+
+		if (res == Unwinder::UNWIND_END)
+			break;
+
+		if (res == Unwinder::UNWIND_ERROR)
+		{
+			m_abnormal = true;
+			break;
+		}
+	}
+}
+
+static std::string FrameKey(const Frame& frame)
+{
+	// Module relative so hashes survive ASLR
+	if (!frame.name.empty())
+		return Format("%s+0x%llx", frame.name.c_str(), (unsigned long long)frame.offset);
+
+	if (!frame.region.empty())
+		return Format("%s+0x%llx", BaseName(frame.region).c_str(), (unsigned long long)frame.vaddr);
+
+	return Format("0x%llx", (unsigned long long)frame.pc);
+}
+
+static uint32_t Fnv1a(const std::string& str)
+{
+	uint32_t hash = 2166136261u;
+
+	for (size_t i = 0; i < str.size(); ++i)
+	{
+		hash ^= (unsigned char)str[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+void Triage::Hash()
+{
+	std::string maj = "0", min = "0";
+	size_t hashed = 0;
+
+	for (std::vector<Frame>::const_iterator it = m_frames.begin(); it != m_frames.end(); ++it)
+	{
+		if (it->blacklisted)
+			continue;
+
+		std::string key = FrameKey(*it);
+
+		if (hashed < MAJOR_HASH_DEPTH)
+			maj = Format("%08x", Fnv1a(maj + key));
+
+		min = Format("%08x", Fnv1a(min + key));
+		++hashed;
+	}
+
+	m_major = maj;
+	m_minor = min;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Operands
+
+static const char* const s_regs64[] = { "RAX", "RCX", "RDX", "RBX", "RSP", "RBP", "RSI", "RDI", "R8", "R9", "R10", "R11", "R12", "R13", "R14", "R15" };
+static const char* const s_regs32[] = { "EAX", "ECX", "EDX", "EBX", "ESP", "EBP", "ESI", "EDI", "R8D", "R9D", "R10D", "R11D", "R12D", "R13D", "R14D", "R15D" };
+static const char* const s_regs16[] = { "AX", "CX", "DX", "BX", "SP", "BP", "SI", "DI", "R8W", "R9W", "R10W", "R11W", "R12W", "R13W", "R14W", "R15W" };
+
+// Value of an operand, for memory operands the address.  Returns false for
+// registers which aren't tracked (xmm, x87), exploitable.py never matches those.
+bool Triage::Evaluate(const std::string& operand, uint64_t& value, bool& pointer)
+{
+	std::string expr = operand;
+
+	value = 0;
+	pointer = false;
+
+	size_t lb = expr.find('[');
+	if (lb != std::string::npos)
+	{
+		size_t rb = expr.find(']', lb);
+		if (rb == std::string::npos)
+			return false;
+
+		// Segment overrides are ignored, same as exploitable.py
+		expr = expr.substr(lb + 1, rb - lb - 1);
+		pointer = true;
+	}
+
+	uint64_t total = 0;
+	size_t pos = 0;
+	bool negate = false;
+
+	while (pos < expr.size())
+	{
+		char c = expr[pos];
+
+		if (c == '+' || c == '-' || c == ' ')
+		{
+			if (c == '-')
+				negate = true;
+			++pos;
+			continue;
+		}
+
+		size_t end = expr.find_first_of("+- ", pos);
+		if (end == std::string::npos)
+			end = expr.size();
+
+		std::string term = expr.substr(pos, end - pos);
+		uint64_t product = 1;
+		size_t fpos = 0;
+
+		while (fpos <= term.size())
+		{
+			size_t fend = term.find('*', fpos);
+			if (fend == std::string::npos)
+				fend = term.size();
+
+			std::string factor = term.substr(fpos, fend - fpos);
+			uint64_t v = 0;
+			bool found = false;
+
+			if (!factor.empty() && isdigit((unsigned char)factor[0]))
+			{
+				v = strtoull(factor.c_str(), NULL, 0);
+				found = true;
+			}
+			else if (factor == "RIP" || factor == "EIP")
+			{
+				v = m_instruction.address + m_instruction.size;
+				found = true;
+			}
+			else
+			{
+				for (int i = 0; i < 16 && !found; ++i)
+				{
+					if (factor == s_regs64[i] && m_crash.is64) { v = m_crash.regs[i]; found = true; }
+					else if (factor == s_regs32[i]) { v = m_crash.regs[i] & 0xffffffff; found = true; }
+					else if (factor == s_regs16[i]) { v = m_crash.regs[i] & 0xffff; found = true; }
+				}
+			}
+
+			if (!found)
+				return false;
+
+			product *= v;
+			fpos = fend + 1;
+		}
+
+		total += negate ? (uint64_t)0 - product : product;
+		negate = false;
+		pos = end;
+	}
+
+	if (!m_crash.is64)
+		total &= 0xffffffff;
+
+	value = total;
+	return true;
+}
+
+bool Triage::EvaluateOperand(size_t index, uint64_t& value, bool& pointer)
+{
+	if (!m_hasInstruction || index >= m_instruction.operands.size())
+		return false;
+
+	return Evaluate(m_instruction.operands[index], value, pointer);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Rules, in the order of rules.py
+
+const Triage::Rule Triage::s_rules[] =
+{
+	{ "EXPLOITABLE", &Triage::isReturnAv,
+		"Access violation during return instruction", "ReturnAv",
+		"The target crashed on a return instruction, which likely indicates stack corruption." },
+	{ "EXPLOITABLE", &Triage::isSegFaultOnPcNotNearNull,
+		"Segmentation fault on program counter", "SegFaultOnPc",
+		"The target tried to access data at an address that matches the program counter. "
+		"This is likely due to the execution of a branch instruction (ex: 'call') with a bad argument, "
+		"but it could also be due to execution continuing past the end of a memory region or another cause. "
+		"Regardless this likely indicates that the program counter contents are tainted and can be controlled by an attacker." },
+	{ "EXPLOITABLE", &Triage::isBranchAvNotNearNull,
+		"Access violation during branch instruction", "BranchAv",
+		"The target crashed on a branch instruction, which may indicate that the control flow is tainted." },
+	{ "EXPLOITABLE", &Triage::isErrorWhileExecutingFromStack,
+		"Executing from stack", "StackCodeExection",
+		"The target stopped on an error while executing code within the process's stack region." },
+	{ "EXPLOITABLE", &Triage::isStackBufferOverflow,
+		"Stack buffer overflow", "StackBufferOverflow",
+		"The target stopped while handling a signal that was generated by libc due to detection of a stack buffer overflow. "
+		"Stack buffer overflows are generally considered exploitable." },
+	{ "EXPLOITABLE", &Triage::isPossibleStackCorruption,
+		"Possible stack corruption", "PossibleStackCorruption",
+		"GDB generated an error while unwinding the stack and/or the stack contained return addresses that were not mapped "
+		"in the inferior's process address space and/or the stack pointer is pointing to a location outside the default stack region. "
+		"These conditions likely indicate stack corruption, which is generally considered exploitable." },
+	{ "EXPLOITABLE", &Triage::isDestAvNotNearNull,
+		"Access violation on destination operand", "DestAv",
+		"The target crashed on an access violation at an address matching the destination operand of the instruction. "
+		"This likely indicates a write access violation, which means the attacker may control the write address and/or value." },
+	{ "EXPLOITABLE", &Triage::isMalformedInstructionSignal,
+		"Bad instruction", "BadInstruction",
+		"The target tried to execute a malformed or privileged instruction. This may indicate that the control flow is tainted." },
+	{ "EXPLOITABLE", &Triage::isHeapError,
+		"Heap error", "HeapError",
+		"The target's backtrace indicates that libc has detected a heap error or that the target was executing a heap function when it stopped. "
+		"This could be due to heap corruption, passing a bad pointer to a heap function such as free(), etc. "
+		"Since heap errors might include buffer overflows, use-after-free situations, etc. they are generally considered exploitable." },
+	{ "PROBABLY_EXPLOITABLE", &Triage::isStackOverflow,
+		"Stack overflow", "StackOverflow",
+		"The target crashed on an access violation where the faulting instruction's mnemonic and the stack pointer seem to indicate a stack overflow." },
+	{ "PROBABLY_EXPLOITABLE", &Triage::isSegFaultOnPcNearNull,
+		"Segmentation fault on program counter near NULL", "SegFaultOnPcNearNull",
+		"The target tried to access data at an address that matches the program counter. "
+		"This may indicate that the program counter contents are tainted, however, it may also indicate a simple NULL deference." },
+	{ "PROBABLY_EXPLOITABLE", &Triage::isBranchAvNearNull,
+		"Access violation near NULL during branch instruction", "BranchAvNearNull",
+		"The target crashed on a branch instruction, which may indicate that the control flow is tainted. "
+		"However, there is a chance it could be a NULL dereference." },
+	{ "PROBABLY_EXPLOITABLE", &Triage::isBlockMove,
+		"Access violation during block move", "BlockMoveAv",
+		"The target crashed during a block move, which may indicate that the attacker can control a buffer overflow." },
+	{ "PROBABLY_EXPLOITABLE", &Triage::isDestAvNearNull,
+		"Access violation near NULL on destination operand", "DestAvNearNull",
+		"The target crashed on an access violation at an address matching the destination operand of the instruction. "
+		"This likely indicates a write access violation, which means the attacker may control write address and/or value. "
+		"However, it there is a chance it could be a NULL dereference." },
+	{ "PROBABLY_NOT_EXPLOITABLE", &Triage::isSourceAvNearNull,
+		"Access violation near NULL on source operand", "SourceAvNearNull",
+		"The target crashed on an access violation at an address matching the source operand of the current instruction. "
+		"This likely indicates a read access violation, which may mean the application crashed on a simple NULL dereference "
+		"to data structure that has no immediate effect on control of the processor." },
+	{ "PROBABLY_NOT_EXPLOITABLE", &Triage::isFloatingPointException,
+		"Floating point exception signal", "FloatingPointException",
+		"The target crashed on a floating point exception. This may indicate a division by zero or a number of other floating point errors. "
+		"It is generally difficult to leverage these types of errors to gain control of the processor." },
+	{ "PROBABLY_NOT_EXPLOITABLE", &Triage::isBenignSignal,
+		"Benign signal", "BenignSignal",
+		"The target is stopped on a signal that either does not indicate an error or indicates an error that is generally not considered exploitable." },
+	{ "UNKNOWN", &Triage::isSourceAvNotNearNull,
+		"Access violation on source operand", "SourceAv",
+		"The target crashed on an access violation at an address matching the source operand of the current instruction. "
+		"This likely indicates a read access violation." },
+	{ "UNKNOWN", &Triage::isAbortSignal,
+		"Abort signal", "AbortSignal",
+		"The target is stopped on a SIGABRT. SIGABRTs are often generated by libc and compiled check-code to indicate potentially exploitable conditions. "
+		"Unfortunately this command does not yet further analyze these crashes." },
+	{ "UNKNOWN", &Triage::isAccessViolationSignal,
+		"Access violation", "AccessViolation",
+		"The target crashed due to an access violation but there is not enough additional information available to determine exploitability." },
+	{ "UNKNOWN", &Triage::isUncategorizedSignal,
+		"Uncategorized signal", "UncategorizedSignal",
+		"The target is stopped on a signal. This may be an exploitable condition, but this command was unable to categorize it." },
+};
+
+#define RULE_COUNT (sizeof(s_rules) / sizeof(s_rules[0]))
+
+void Triage::Classify()
+{
+	for (size_t i = 0; i < RULE_COUNT; ++i)
+	{
+		if ((this->*s_rules[i].analyzer)())
+			m_tags.push_back(i);
+	}
+}
+
+std::string Triage::Category() const
+{
+	return m_tags.empty() ? "" : s_rules[m_tags[0]].category;
+}
+
+std::string Triage::ShortDescription() const
+{
+	return m_tags.empty() ? "" : s_rules[m_tags[0]].shortDesc;
+}
+
+// EXPLOITABLE
+
+bool Triage::isBranchAvNotNearNull()
+{
+	return isBranchAv() && FaultingAddress() >= NEAR_NULL;
+}
+
+bool Triage::isReturnAv()
+{
+	return isAccessViolationSignal() && m_hasInstruction && m_instruction.flowControl == FC_RET;
+}
+
+bool Triage::isSegFaultOnPcNotNearNull()
+{
+	return isSegFaultOnPc() && !isFaNearNull();
+}
+
+bool Triage::isErrorWhileExecutingFromStack()
+{
+	if (isBenign())
+		return false;
+
+	return IsStackRegion(m_crash.Pc());
+}
+
+bool Triage::isStackBufferOverflow()
+{
+	// Some versions of libc segfault printing the backtrace of
+	// __stack_chk_fail (CVE 2010-3192), so the signal isn't checked
+	static const char* const frames[] = { "__fortify_fail", "__stack_chk_fail" };
+	return isInBacktrace(frames, 2, NULL);
+}
+
+bool Triage::isPossibleStackCorruption()
+{
+	if (isBenign())
+		return false;
+
+	if (isStackOverflow())
+		return false;
+
+	if (m_abnormal)
+		return true;
+
+	for (size_t i = 1; i < m_frames.size(); ++i)
+	{
+		if (!m_frames[i].mapped)
+			return true;
+	}
+
+	return !IsStackRegion(m_crash.Sp());
+}
+
+bool Triage::isDestAvNotNearNull()
+{
+	return isDestAv() && !isFaNearNull();
+}
+
+bool Triage::isHeapError()
+{
+	static const char* const mcheckPrint[] = { "abort", "__libc_message", "malloc_printerr" };
+	static const char* const mcheckNoPrint[] = { "abort", "malloc_printerr" };
+	static const char* const freeFrame[] = { "free" };
+	static const char* const mallocFrame[] = { "malloc" };
+	static const char* const mallocAssert[] = { "__malloc_assert" };
+
+	return isInBacktrace(mcheckPrint, 3, "/libc") ||
+		isInBacktrace(mcheckNoPrint, 2, "/libc") ||
+		isInBacktrace(freeFrame, 1, "/libc") ||
+		isInBacktrace(mallocFrame, 1, "/libc") ||
+		isInBacktrace(mallocAssert, 1, "/libc");
+}
+
+// PROBABLY_EXPLOITABLE
+
+bool Triage::isStackOverflow()
+{
+	if (!isAccessViolationSignal() || !m_hasInstruction)
+		return false;
+
+	// A push, or a call where the access violation is due to the push
+	if (m_instruction.mnemonic.find("push") == std::string::npos)
+	{
+		uint64_t dest;
+		bool pointer;
+
+		if (m_instruction.flowControl != FC_CALL)
+			return false;
+
+		if (EvaluateOperand(0, dest, pointer) && FaultingAddress() == dest)
+			return false;
+
+		if (FaultingAddress() + m_crash.PointerSize() != m_crash.Sp())
+			return false;
+	}
+
+	// The stack pointer is outside the default stack region
+	return !IsStackRegion(m_crash.Sp());
+}
+
+bool Triage::isMalformedInstructionSignal()
+{
+	static const int sigs[] = { SIGILL, SIGSYS };
+	return IsSignalInList(m_crash.signo, sigs, 2);
+}
+
+bool Triage::isSegFaultOnPcNearNull()
+{
+	return isSegFaultOnPc() && isFaNearNull();
+}
+
+bool Triage::isBranchAvNearNull()
+{
+	return isBranchAv() && FaultingAddress() < NEAR_NULL;
+}
+
+bool Triage::isBlockMove()
+{
+	if (isBenign() || !m_hasInstruction)
+		return false;
+
+	const std::string& m = m_instruction.mnemonic;
+	return m.compare(0, 3, "rep") == 0 && m.find("mov", 3) != std::string::npos;
+}
+
+bool Triage::isDestAvNearNull()
+{
+	return isDestAv() && isFaNearNull();
+}
+
+// PROBABLY_NOT_EXPLOITABLE
+
+bool Triage::isBenignSignal()
+{
+	static const int sigs[] =
+	{
+		SIGTERM, SIGINT, SIGQUIT, SIGKILL, SIGHUP, SIGALRM, SIGVTALRM, SIGPROF, SIGIO,
+		SIGURG, SIGPOLL, SIGUSR1, SIGUSR2, SIGWINCH, SIGCHLD, SIGCONT, SIGSTOP, SIGTSTP,
+	};
+	return IsSignalInList(m_crash.signo, sigs, sizeof(sigs) / sizeof(sigs[0]));
+}
+
+bool Triage::isSourceAvNotNearNull()
+{
+	return isSourceAv() && !isFaNearNull();
+}
+
+bool Triage::isFloatingPointException()
+{
+	static const int sigs[] = { SIGFPE };
+	return IsSignalInList(m_crash.signo, sigs, 1);
+}
+
+// UNKNOWN
+
+bool Triage::isSourceAvNearNull()
+{
+	return isSourceAv() && isFaNearNull();
+}
+
+bool Triage::isAbortSignal()
+{
+	return m_crash.signo == SIGABRT;
+}
+
+bool Triage::isAccessViolationSignal()
+{
+	static const int sigs[] = { SIGSEGV, SIGBUS };
+	return IsSignalInList(m_crash.signo, sigs, 2);
+}
+
+bool Triage::isUncategorizedSignal()
+{
+	return !(isAccessViolationSignal() || isAbortSignal() || isBenignSignal() ||
+		isFloatingPointException() || isMalformedInstructionSignal());
+}
+
+// Helpers
+
+bool Triage::isBenign()
+{
+	return isBenignSignal();
+}
+
+bool Triage::isJumpInstruction()
+{
+	return m_hasInstruction && (m_instruction.flowControl == FC_UNC_BRANCH || m_instruction.flowControl == FC_CND_BRANCH);
+}
+
+bool Triage::isBranchAv()
+{
+	if (!isAccessViolationSignal())
+		return false;
+
+	return isJumpInstruction() || (m_hasInstruction && m_instruction.flowControl == FC_CALL);
+}
+
+uint64_t Triage::FaultingAddress()
+{
+	// si_addr isn't always the faulting address of a jump, but jumps always
+	// access their destination operand
+	if (isJumpInstruction())
+	{
+		uint64_t value;
+		bool pointer;
+
+		if (!EvaluateOperand(0, value, pointer))
+			return 0xDEADBEEF;
+
+		return value;
+	}
+
+	return m_crash.address;
+}
+
+bool Triage::isSegFaultOnPc()
+{
+	return isAccessViolationSignal() && FaultingAddress() == m_crash.Pc();
+}
+
+bool Triage::isDestAv()
+{
+	uint64_t value;
+	bool pointer;
+
+	if (!isAccessViolationSignal())
+		return false;
+
+	return EvaluateOperand(0, value, pointer) && pointer && value == FaultingAddress();
+}
+
+bool Triage::isSourceAv()
+{
+	uint64_t value;
+	bool pointer;
+
+	if (!isAccessViolationSignal())
+		return false;
+
+	return EvaluateOperand(1, value, pointer) && pointer && value == FaultingAddress();
+}
+
+bool Triage::isFaNearNull()
+{
+	return FaultingAddress() < NEAR_NULL;
+}
+
+bool Triage::isInBacktrace(const char* const* names, size_t count, const char* region)
+{
+	size_t i = 0;
+
+	for (std::vector<Frame>::const_iterator it = m_frames.begin(); it != m_frames.end(); ++it)
+	{
+		if (!it->name.empty() && it->name == names[i] && (!region || it->region.find(region) != std::string::npos))
+		{
+			if (++i == count)
+				return true;
+		}
+		else
+		{
+			i = 0;
+		}
+	}
+
+	return false;
+}
+
+bool Triage::IsStackRegion(uint64_t addr) const
+{
+	const MapEntry* map = m_crash.FindMap(addr);
+	// Older kernels name thread stacks [stack:tid]
+	return map && map->name.compare(0, 6, "[stack") == 0;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Report
+
+static std::string FrameString(size_t index, const Frame& frame)
+{
+	std::string name = frame.name.empty() ? "??" : Format("%s+0x%llx", frame.name.c_str(), (unsigned long long)frame.offset);
+	std::string ret = Format("#%3u %s at 0x%llx in %s", (unsigned)index, name.c_str(), (unsigned long long)frame.pc,
+		frame.region.empty() ? "??" : frame.region.c_str());
+
+	if (frame.blacklisted)
+		ret += " (BL)";
+
+	return ret;
+}
+
+std::string Triage::Classification()
+{
+	if (m_tags.empty())
+		return "No matches\n";
+
+	const Rule& rule = s_rules[m_tags[0]];
+	std::string ret;
+
+	ret += Format("Description: %s\n", rule.desc);
+	ret += Format("Short description: %s (%u/%u)\n", rule.shortDesc, (unsigned)m_tags[0] + 1, (unsigned)RULE_COUNT);
+	ret += Format("Hash: %s.%s\n", m_major.c_str(), m_minor.c_str());
+	ret += Format("Exploitability Classification: %s\n", rule.category);
+	ret += "Explanation: " + std::string(rule.explanation) + "\n";
+
+	if (m_tags.size() > 1)
+	{
+		ret += "Other tags: ";
+
+		for (size_t i = 1; i < m_tags.size(); ++i)
+		{
+			if (i > 1)
+				ret += ", ";
+			ret += Format("%s (%u/%u)", s_rules[m_tags[i]].shortDesc, (unsigned)m_tags[i] + 1, (unsigned)RULE_COUNT);
+		}
+
+		ret += "\n";
+	}
+
+	return ret;
+}
+
+std::string Triage::StackTrace()
+{
+	std::string ret;
+
+	for (size_t i = 0; i < m_frames.size(); ++i)
+		ret += FrameString(i, m_frames[i]) + "\n";
+
+	if (m_abnormal)
+		ret += "abnormal stack unwind termination\n";
+
+	return ret;
+}
+
+std::string Triage::Report()
+{
+	std::string ret;
+	const char* name = SignalName(m_crash.signo);
+
+	ret += Format("Signal si_signo: %d (%s) Signal si_code: %d Signal si_addr: 0x%llx\n",
+		m_crash.signo, name ? name : "?", m_crash.code, (unsigned long long)m_crash.address);
+
+	ret += "Nearby code:\n";
+
+	// Sweep from the start of the function so the instructions before pc can be shown
+	std::vector<Instruction> code;
+	if (!m_frames.empty() && !m_frames[0].name.empty() && m_frames[0].offset < 0x4000)
+	{
+		uint64_t start = m_crash.Pc() - m_frames[0].offset;
+		std::vector<unsigned char> buf(m_frames[0].offset + 5 * MAX_INSTRUCTION_SIZE);
+
+		if (m_crash.ReadMemory(start, &buf[0], buf.size()))
+		{
+			Instruction inst;
+			size_t pos = 0;
+
+			while (pos < buf.size() && DecodeOne(start + pos, &buf[pos], buf.size() - pos, m_crash.is64, inst))
+			{
+				code.push_back(inst);
+				pos += inst.size;
+			}
+		}
+	}
+
+	size_t at = code.size();
+	for (size_t i = 0; i < code.size(); ++i)
+	{
+		if (code[i].address == m_crash.Pc())
+			at = i;
+	}
+
+	if (at == code.size())
+	{
+		code.clear();
+		at = 0;
+		if (m_hasInstruction)
+			code.push_back(m_instruction);
+	}
+
+	for (size_t i = at > 5 ? at - 5 : 0; i < code.size() && i < at + 5; ++i)
+		ret += Format("%s 0x%llx: %s\n", i == at ? "=>" : "  ", (unsigned long long)code[i].address, code[i].text.c_str());
+
+	if (code.empty())
+		ret += Format("=> 0x%llx: Cannot access memory\n", (unsigned long long)m_crash.Pc());
+
+	ret += "Registers:\n";
+
+	for (int i = 0; i < (m_crash.is64 ? 16 : 8); ++i)
+	{
+		std::string reg = m_crash.is64 ? s_regs64[i] : s_regs32[i];
+		std::transform(reg.begin(), reg.end(), reg.begin(), ::tolower);
+		ret += Format("%-4s 0x%0*llx\n", reg.c_str(), m_crash.is64 ? 16 : 8, (unsigned long long)m_crash.regs[i]);
+	}
+
+	ret += Format("%-4s 0x%0*llx\n", m_crash.is64 ? "rip" : "eip", m_crash.is64 ? 16 : 8, (unsigned long long)m_crash.Pc());
+
+	ret += "Stack trace:\n";
+	ret += StackTrace();
+
+	ret += "Faulting frame: ";
+
+	size_t faulting = 0;
+	while (faulting < m_frames.size() && m_frames[faulting].blacklisted)
+		++faulting;
+
+	if (faulting < m_frames.size())
+		ret += FrameString(faulting, m_frames[faulting]) + "\n";
+	else
+		ret += "None\n";
+
+	// Module relative, for bucketing crashes across runs
+	if (faulting < m_frames.size() && !m_frames[faulting].region.empty())
+		ret += Format("Faulting location: %s+0x%llx\n", BaseName(m_frames[faulting].region).c_str(), (unsigned long long)m_frames[faulting].vaddr);
+
+	ret += Classification();
+
+	return ret;
+}
@@ -0,0 +1,187 @@
+#ifndef TRIAGE_H
+#define TRIAGE_H
+
+// Native crash triage
+//
+// Classifies the state of a crashed x86/x86_64 linux process with the rules
+// of gdb/exploitable (Peach.Core.OS.Linux/gdb/exploitable/lib/rules.py)
+// without starting gdb.  The faulting instruction is disassembled with
+// diStorm, the stack is unwound with the .eh_frame unwind tables of the
+// loaded modules (falling back to the frame pointer chain) and frames are
+// named from the ELF symbol tables of the mapped files.
+//
+// The crashed process is described by a subclass of CrashInfo, which only
+// has to fill in the registers, signal and mappings and read its memory.
+// The report ends with the same lines "exploitable -v" prints, so it can
+// be parsed the same way:
+//
+//   Description: ...
+//   Short description: ...
+//   Hash: major.minor
+//   Exploitability Classification: ...
+//   Explanation: ...
+//   Other tags: ...
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+// Registers in x86 encoding order, so the index is the register number
+// used in instructions: RAX RCX RDX RBX RSP RBP RSI RDI R8-R15
+enum TriageRegister
+{
+	TRIAGE_AX = 0, TRIAGE_CX, TRIAGE_DX, TRIAGE_BX, TRIAGE_SP, TRIAGE_BP, TRIAGE_SI, TRIAGE_DI,
+	TRIAGE_R8, TRIAGE_R9, TRIAGE_R10, TRIAGE_R11, TRIAGE_R12, TRIAGE_R13, TRIAGE_R14, TRIAGE_R15,
+	TRIAGE_IP,
+	TRIAGE_COUNT
+};
+
+struct MapEntry
+{
+	uint64_t start;
+	uint64_t end;
+	uint64_t offset;
+	std::string perms;
+	std::string name;
+};
+
+struct Frame
+{
+	uint64_t pc;
+	std::string name;    // Symbol, empty if unknown
+	uint64_t offset;     // pc - symbol
+	uint64_t vaddr;      // pc relative to the module's load address
+	std::string region;  // Mapping that contains pc, empty if anonymous or unmapped
+	bool mapped;
+	bool blacklisted;
+};
+
+struct Instruction
+{
+	uint64_t address;
+	unsigned size;
+	unsigned flowControl;  // _FlowControlType
+	std::string mnemonic;  // Lower case, including a rep prefix
+	std::string text;      // As diStorm formats it
+	std::vector<std::string> operands;
+};
+
+class CrashInfo
+{
+public:
+	CrashInfo();
+	virtual ~CrashInfo();
+
+	// Read target memory, returns false unless all of len was read.
+	virtual bool ReadMemory(uint64_t address, void* buf, size_t len) = 0;
+
+	// Load the process mappings in /proc/<pid>/maps format.
+	bool LoadMaps(const std::string& text);
+
+	int signo;          // 0 if the process did not stop on a signal
+	int code;           // si_code
+	uint64_t address;   // si_addr
+	bool is64;
+	uint64_t regs[TRIAGE_COUNT];
+	std::vector<MapEntry> maps;
+
+	const MapEntry* FindMap(uint64_t address) const;
+	unsigned PointerSize() const { return is64 ? 8 : 4; }
+	uint64_t Pc() const { return regs[TRIAGE_IP]; }
+	uint64_t Sp() const { return regs[TRIAGE_SP]; }
+};
+
+class Triage
+{
+public:
+	explicit Triage(CrashInfo& crash);
+
+	// Full report: signal, registers, instruction, backtrace, mappings and classification.
+	std::string Report();
+
+	// Classification lines only, as printed by "exploitable -v".
+	std::string Classification();
+
+	// One line per frame, with the abnormal termination marker.
+	std::string StackTrace();
+
+	const std::vector<Frame>& Backtrace() const { return m_frames; }
+	bool AbnormalTermination() const { return m_abnormal; }
+	const Instruction* CurrentInstruction() const { return m_hasInstruction ? &m_instruction : NULL; }
+
+	std::string MajorHash() const { return m_major; }
+	std::string MinorHash() const { return m_minor; }
+	std::string Category() const;
+	std::string ShortDescription() const;
+
+private:
+	struct Rule
+	{
+		const char* category;
+		bool (Triage::*analyzer)();
+		const char* desc;
+		const char* shortDesc;
+		const char* explanation;
+	};
+
+	static const Rule s_rules[];
+
+	CrashInfo& m_crash;
+	std::vector<Frame> m_frames;
+	bool m_abnormal;
+	Instruction m_instruction;
+	bool m_hasInstruction;
+	std::string m_major;
+	std::string m_minor;
+	std::vector<size_t> m_tags;
+
+	void Disassemble();
+	void Unwind();
+	void Symbolize(Frame& frame, bool caller);
+	void Hash();
+	void Classify();
+
+	bool Evaluate(const std::string& operand, uint64_t& value, bool& pointer);
+	bool EvaluateOperand(size_t index, uint64_t& value, bool& pointer);
+
+	// Analyzers, named as in analyzers.py
+	bool isReturnAv();
+	bool isSegFaultOnPcNotNearNull();
+	bool isBranchAvNotNearNull();
+	bool isErrorWhileExecutingFromStack();
+	bool isStackBufferOverflow();
+	bool isPossibleStackCorruption();
+	bool isDestAvNotNearNull();
+	bool isMalformedInstructionSignal();
+	bool isHeapError();
+	bool isStackOverflow();
+	bool isSegFaultOnPcNearNull();
+	bool isBranchAvNearNull();
+	bool isBlockMove();
+	bool isDestAvNearNull();
+	bool isSourceAvNearNull();
+	bool isFloatingPointException();
+	bool isBenignSignal();
+	bool isSourceAvNotNearNull();
+	bool isAbortSignal();
+	bool isAccessViolationSignal();
+	bool isUncategorizedSignal();
+
+	// Helpers
+	bool isBenign();
+	bool isJumpInstruction();
+	bool isBranchAv();
+	bool isSegFaultOnPc();
+	bool isDestAv();
+	bool isSourceAv();
+	bool isFaNearNull();
+	bool isInBacktrace(const char* const* names, size_t count, const char* region);
+	uint64_t FaultingAddress();
+	bool IsStackRegion(uint64_t address) const;
+};
+
+const char* SignalName(int sig);
+
+#endif // TRIAGE_H
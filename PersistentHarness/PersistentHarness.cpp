@@ -0,0 +1,198 @@
+#ifdef WIN32
+
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+
+#define open _open
+#define close _close
+#define dup _dup
+#define dup2 _dup2
+#define read _read
+#define write _write
+#define DEV_NULL "NUL"
+
+#else
+
+#include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
+
+#define O_BINARY 0
+#define DEV_NULL "/dev/null"
+
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "PersistentHarness.h"
+
+// Private copies of the original stdin/stdout, the target's own
+// output goes to stderr so it can't corrupt the status records.
+static int ctlIn = -1;
+static int ctlOut = -1;
+
+static bool ReadAll(int fd, void* buf, size_t len)
+{
+	char* p = (char*)buf;
+
+	while (len > 0) {
+		int ret = read(fd, p, (unsigned int)len);
+		if (ret <= 0)
+			return false;
+
+		p += ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
+// Also called from the crash handlers, so only write() is used
+static bool WriteStatus(uint32_t status, uint32_t code, uint64_t address)
+{
+	PersistentStatus st;
+	const char* p = (const char*)&st;
+	size_t len = sizeof(st);
+
+	st.status = status;
+	st.code = code;
+	st.address = address;
+
+	while (len > 0) {
+		int ret = write(ctlOut, p, (unsigned int)len);
+		if (ret <= 0)
+			return false;
+
+		p += ret;
+		len -= ret;
+	}
+
+	return true;
+}
+
+#ifdef WIN32
+
+static LONG WINAPI CrashFilter(EXCEPTION_POINTERS* info)
+{
+	EXCEPTION_RECORD* rec = info->ExceptionRecord;
+	uint64_t address = (uint64_t)(ULONG_PTR)rec->ExceptionAddress;
+
+	// Report the data address of access violations, like si_addr
+	if (rec->ExceptionCode == EXCEPTION_ACCESS_VIOLATION && rec->NumberParameters >= 2)
+		address = (uint64_t)rec->ExceptionInformation[1];
+
+	WriteStatus(PERSISTENT_CRASH, rec->ExceptionCode, address);
+
+	return EXCEPTION_CONTINUE_SEARCH;
+}
+
+static void InstallCrashHandlers()
+{
+	SetUnhandledExceptionFilter(CrashFilter);
+}
+
+#else
+
+static const int crashSignals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+
+static void CrashHandler(int sig, siginfo_t* info, void* context)
+{
+	WriteStatus(PERSISTENT_CRASH, sig, (uint64_t)(uintptr_t)info->si_addr);
+
+	// Die from the same signal once the handler returns
+	signal(sig, SIG_DFL);
+	raise(sig);
+}
+
+static void InstallCrashHandlers()
+{
+	struct sigaction sa;
+	stack_t ss;
+	size_t i;
+
+	// Stack overflows need a stack to report on
+	ss.ss_sp = malloc(SIGSTKSZ);
+	ss.ss_size = SIGSTKSZ;
+	ss.ss_flags = 0;
+	if (ss.ss_sp != NULL)
+		sigaltstack(&ss, NULL);
+
+	memset(&sa, 0, sizeof(sa));
+	sa.sa_sigaction = CrashHandler;
+	sa.sa_flags = SA_SIGINFO | SA_ONSTACK;
+	sigemptyset(&sa.sa_mask);
+
+	for (i = 0; i < sizeof(crashSignals) / sizeof(crashSignals[0]); ++i)
+		sigaction(crashSignals[i], &sa, NULL);
+}
+
+#endif
+
+int persistent_loop(void)
+{
+	unsigned char* buf = NULL;
+	size_t size = 0;
+	uint32_t len;
+	int devnull;
+
+	if (getenv(PERSISTENT_ENV) == NULL)
+		return 0;
+
+	fflush(stdout);
+
+	ctlIn = dup(0);
+	ctlOut = dup(1);
+	devnull = open(DEV_NULL, O_RDONLY | O_BINARY);
+
+	if (ctlIn == -1 || ctlOut == -1 || devnull == -1) {
+		fprintf(stderr, "Error, unable to set up the persistent harness.\n");
+		exit(1);
+	}
+
+#ifdef WIN32
+	_setmode(ctlIn, _O_BINARY);
+	_setmode(ctlOut, _O_BINARY);
+#endif
+
+	// The target keeps its stdio, but reads nothing and writes to stderr
+	dup2(devnull, 0);
+	dup2(2, 1);
+	close(devnull);
+
+	InstallCrashHandlers();
+
+	if (!WriteStatus(PERSISTENT_READY, 0, 0))
+		return 1;
+
+	while (ReadAll(ctlIn, &len, sizeof(len))) {
+		int ret;
+
+		if (len > size) {
+			unsigned char* tmp = (unsigned char*)realloc(buf, len);
+			if (tmp == NULL) {
+				fprintf(stderr, "Error, unable to allocate %u bytes for the input.\n", len);
+				break;
+			}
+
+			buf = tmp;
+			size = len;
+		}
+
+		if (len > 0 && !ReadAll(ctlIn, buf, len))
+			break;
+
+		ret = fuzz_one(buf, len);
+
+		fflush(stdout);
+		fflush(stderr);
+
+		if (!WriteStatus(PERSISTENT_OK, (uint32_t)ret, 0))
+			break;
+	}
+
+	free(buf);
+	return 1;
+}
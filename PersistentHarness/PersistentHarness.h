@@ -0,0 +1,68 @@
+#ifndef PERSISTENT_HARNESS_H
+#define PERSISTENT_HARNESS_H
+
+// Persistent mode harness
+//
+// Instead of starting a new process for every input, the PersistentProcess
+// monitor starts the target once and sends it every input over its standard
+// input.  The target links this library, implements fuzz_one() and calls
+// persistent_loop() first thing in main():
+//
+//   int main(int argc, char* argv[])
+//   {
+//       if (persistent_loop())
+//           return 0;
+//
+//       // Not started by peach, load argv[1] and call fuzz_one() once
+//   }
+//
+// The process is only restarted after a crash (or a hang), so fuzz_one()
+// must not leave state behind which changes how the next input is handled.
+//
+// Protocol, all integers are little endian:
+//   peach -> target   uint32 length, followed by length bytes of input
+//   target -> peach   PersistentStatus, once on startup and once per input
+// Closing the target's standard input ends the loop.
+
+#include <stddef.h>
+
+#ifdef _MSC_VER
+typedef unsigned __int32 uint32_t;
+typedef unsigned __int64 uint64_t;
+#else
+#include <stdint.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Environment variable the monitor sets for the target
+#define PERSISTENT_ENV "PEACH_PERSISTENT"
+
+enum PersistentStatusCode
+{
+	PERSISTENT_READY = 0, // Harness is waiting for inputs
+	PERSISTENT_OK = 1,    // fuzz_one() returned, code is its return value
+	PERSISTENT_CRASH = 2  // Process is going down, code is the signal or exception code
+};
+
+typedef struct
+{
+	uint32_t status;
+	uint32_t code;
+	uint64_t address; // Faulting address of a crash
+} PersistentStatus;
+
+// Implemented by the target, called for every input.
+int fuzz_one(const unsigned char* buf, size_t len);
+
+// Runs the loop when the process was started by the PersistentProcess monitor
+// and returns 1 when peach is done with it.  Returns 0 right away otherwise.
+int persistent_loop(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // PERSISTENT_HARNESS_H